@@ -19,6 +19,7 @@
 #include <gui/Window.h>
 #include <gui/ZoomView.h>
 #include <inference/io/RandomForestHdf5Writer.h>
+#include <inference/SolverStatistics.h>
 #include <imageprocessing/SubStackSelector.h>
 #include <imageprocessing/gui/ImageStackView.h>
 #include <imageprocessing/io/ImageStackHdf5Reader.h>
@@ -35,7 +36,6 @@
 #include <sopnet/gui/SopnetDialog.h>
 #include <sopnet/io/IdMapCreator.h>
 #include <sopnet/io/NeuronsImageWriter.h>
-#include <sopnet/inference/GridSearch.h>
 #include <sopnet/neurons/NeuronExtractor.h>
 #include <util/ProgramOptions.h>
 #include <util/SignalHandler.h>
@@ -413,7 +413,7 @@ int main(int optionc, char** optionv) {
 		// anyone
 		boost::shared_ptr<ErrorReport>            errorReport;
 
-		if (optionShowErrors || optionGridSearch) {
+		if (optionShowErrors) {
 
 			errorReport = boost::make_shared<ErrorReport>();
 
@@ -515,7 +515,11 @@ int main(int optionc, char** optionv) {
 				boost::shared_ptr<ImageStackView>                 sectionsView = boost::make_shared<ImageStackView>();
 				boost::shared_ptr<NamedView>                      namedView    = boost::make_shared<NamedView>("Result:");
 
-				resultView->setInput(neuronExtractor->getOutput("neurons"));
+				// show the incumbents while the solver is running
+				boost::shared_ptr<NeuronExtractor> incumbentNeuronExtractor = boost::make_shared<NeuronExtractor>();
+				incumbentNeuronExtractor->setInput("segments", sopnet->getOutput("incumbent solution"));
+
+				resultView->setInput(incumbentNeuronExtractor->getOutput("neurons"));
 				sectionsView->setInput(rawSectionsReader->getOutput());
 				overlay->addInput(resultView->getOutput());
 				overlay->addInput(sectionsView->getOutput());
@@ -646,6 +650,16 @@ int main(int optionc, char** optionv) {
 
 			LOG_USER(out) << *reportHeader << std::endl;
 			LOG_USER(out) << *reportLine   << std::endl;
+
+			if (sopnet->hasSolverStatistics()) {
+
+				pipeline::Value<SolverStatistics> statistics = sopnet->getOutput("solver statistics");
+
+				LOG_USER(out)
+						<< "solver stopped after " << statistics->getRuntime() << "s with value "
+						<< statistics->getValue() << " and gap " << statistics->getGap() << ", "
+						<< statistics->getIncumbents().size() << " incumbents were found" << std::endl;
+			}
 		}
 
 		// Compute gold standard error in headless mode if show gold standard option is set
@@ -695,31 +709,7 @@ int main(int optionc, char** optionv) {
 
 			LOG_USER(out) << "[main] performing grid search" << std::endl;
 
-			boost::shared_ptr<GridSearch> gridSearch = boost::make_shared<GridSearch>();
-
-			sopnet->setInput("prior cost parameters", gridSearch->getOutput("prior cost parameters"));
-			sopnet->setInput("segmentation cost parameters", gridSearch->getOutput("segmentation cost parameters"));
-
-			pipeline::Value<std::string> reportHeader = errorReport->getOutput("error report header");
-			pipeline::Value<std::string> reportLine   = errorReport->getOutput("error report");
-
-			// open file for grid search results
-			std::ofstream gridSearchFile("grid_search.txt");
-			gridSearchFile
-					<< "# end\tcont\tbranch\tseg_w\tseg_p\tseg_f:\t"
-					<< *reportHeader << std::endl;
-
-			while (true) {
-
-				std::string parameterString = gridSearch->currentParameters();
-
-				LOG_USER(out) << "[main] performing grid search with " << parameterString << std::endl;
-
-				gridSearchFile << parameterString << "\t" << *reportLine << std::endl;
-
-				if (!gridSearch->next())
-					break;
-			}
+			sopnet->gridSearch("grid_search.txt");
 
 			LOG_USER(out) << "[main] grid search done." << std::endl;
 		}
@@ -0,0 +1,192 @@
+#ifndef TESTS_BRUTE_FORCE_BACKEND_H__
+#define TESTS_BRUTE_FORCE_BACKEND_H__
+
+#include <cmath>
+#include <limits>
+#include <map>
+
+#include <inference/LinearSolverBackend.h>
+#include <inference/LinearSolverBackendFactory.h>
+#include <util/foreach.h>
+
+/**
+ * A linear solver backend for small binary problems that tries all
+ * assignments of the variables. Used as a reference for the solvers and
+ * problem transformations in the tests.
+ */
+class BruteForceBackend : public LinearSolverBackend {
+
+public:
+
+	// the largest number of variables we are willing to enumerate
+	static const unsigned int MaxVariables = 24;
+
+	BruteForceBackend() :
+		_numVariables(0) {}
+
+	void initialize(
+			unsigned int numVariables,
+			VariableType variableType) {
+
+		initialize(numVariables, variableType, std::map<unsigned int, VariableType>());
+	}
+
+	void initialize(
+			unsigned int                                numVariables,
+			VariableType                                /*defaultVariableType*/,
+			const std::map<unsigned int, VariableType>& /*specialVariableTypes*/) {
+
+		_numVariables = numVariables;
+		_constraints.clear();
+		_pinned.clear();
+	}
+
+	void setObjective(const LinearObjective& objective) {
+
+		_objective = objective;
+	}
+
+	void setConstraints(const LinearConstraints& constraints) {
+
+		_constraints = constraints;
+	}
+
+	void addConstraints(const LinearConstraints& constraints) {
+
+		_constraints.addAll(constraints);
+	}
+
+	void pinVariable(unsigned int varNum, double value) {
+
+		_pinned[varNum] = value;
+	}
+
+	bool unpinVariable(unsigned int varNum) {
+
+		return _pinned.erase(varNum) > 0;
+	}
+
+	bool solve(Solution& solution, double& value, std::string& message) {
+
+		if (_numVariables > MaxVariables) {
+
+			message = "too many variables to enumerate";
+			return false;
+		}
+
+		Solution     current(_numVariables);
+		bool         found = false;
+		const double sign  = (_objective.getSense() == Minimize ? 1.0 : -1.0);
+
+		for (unsigned long assignment = 0; assignment < (1ul << _numVariables); assignment++) {
+
+			for (unsigned int i = 0; i < _numVariables; i++)
+				current[i] = ((assignment >> i) & 1);
+
+			if (!isFeasible(current))
+				continue;
+
+			double currentValue = getValue(_objective, current);
+
+			if (!found || sign*currentValue < sign*value) {
+
+				solution = current;
+				value    = currentValue;
+				found    = true;
+			}
+		}
+
+		if (!found) {
+
+			message = "problem is infeasible";
+			return false;
+		}
+
+		message = "optimal solution found";
+		return true;
+	}
+
+	/**
+	 * Get the value of the objective for the given solution. Variables with
+	 * infinite costs do not contribute, if they are not selected.
+	 */
+	static double getValue(const LinearObjective& objective, const Solution& solution) {
+
+		double value = objective.getConstant();
+
+		const std::vector<double>& coefs = objective.getCoefficients();
+		for (unsigned int i = 0; i < coefs.size() && i < solution.size(); i++)
+			if (solution[i] != 0)
+				value += coefs[i]*solution[i];
+
+		return value;
+	}
+
+	/**
+	 * Test whether the given solution satisfies all of the given
+	 * constraints.
+	 */
+	static bool isFeasible(const LinearConstraints& constraints, const Solution& solution) {
+
+		foreach (const LinearConstraint& constraint, constraints) {
+
+			double activity = 0;
+
+			unsigned int varNum;
+			double coef;
+			foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+				activity += coef*(varNum < solution.size() ? solution[varNum] : 0.0);
+
+			bool satisfied = true;
+			switch (constraint.getRelation()) {
+
+				case LessEqual:
+					satisfied = (activity <= constraint.getValue() + 1e-6);
+					break;
+				case Equal:
+					satisfied = (std::abs(activity - constraint.getValue()) <= 1e-6);
+					break;
+				case GreaterEqual:
+					satisfied = (activity >= constraint.getValue() - 1e-6);
+					break;
+			}
+
+			if (!satisfied)
+				return false;
+		}
+
+		return true;
+	}
+
+private:
+
+	bool isFeasible(const Solution& solution) {
+
+		unsigned int varNum;
+		double value;
+		foreach (boost::tie(varNum, value), _pinned)
+			if (varNum < solution.size() && solution[varNum] != value)
+				return false;
+
+		return isFeasible(_constraints, solution);
+	}
+
+	unsigned int _numVariables;
+
+	LinearObjective   _objective;
+	LinearConstraints _constraints;
+
+	std::map<unsigned int, double> _pinned;
+};
+
+class BruteForceFactory : public LinearSolverBackendFactory {
+
+public:
+
+	LinearSolverBackend* createLinearSolverBackend() const {
+
+		return new BruteForceBackend();
+	}
+};
+
+#endif // TESTS_BRUTE_FORCE_BACKEND_H__
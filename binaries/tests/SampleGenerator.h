@@ -0,0 +1,34 @@
+#ifndef TESTS_SAMPLE_GENERATOR_H__
+#define TESTS_SAMPLE_GENERATOR_H__
+
+/**
+ * A small linear congruential generator, such that the random test data are
+ * the same on each platform.
+ */
+class SampleGenerator {
+
+public:
+
+	SampleGenerator(unsigned int seed) :
+		_state(seed) {}
+
+	// a value in [0, 1)
+	double next() {
+
+		_state = _state*1664525u + 1013904223u;
+
+		return static_cast<double>(_state >> 8)/static_cast<double>(1u << 24);
+	}
+
+	// a value in [0, n)
+	unsigned int next(unsigned int n) {
+
+		return static_cast<unsigned int>(next()*n);
+	}
+
+private:
+
+	unsigned int _state;
+};
+
+#endif // TESTS_SAMPLE_GENERATOR_H__
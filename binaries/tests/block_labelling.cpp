@@ -0,0 +1,277 @@
+/**
+ * Checks the block-wise extraction of cells of the LocalToleranceFunction:
+ * the blocks are labelled independently and their components are merged with
+ * a union-find across block faces. The resulting cells have to be the same as
+ * the connected components of the whole volume, found by a flood fill.
+ *
+ * Run with small blocks (e.g., --tedBlockSize=16 --tedBlockDepth=3), such that
+ * most cells span several blocks.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <imageprocessing/ImageStack.h>
+#include <sopnet/evaluation/LocalToleranceFunction.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "SampleGenerator.h"
+
+const unsigned int Width  = 150;
+const unsigned int Height = 100;
+const unsigned int Depth  = 8;
+
+/**
+ * A tolerance function that only extracts the cells.
+ */
+class CellExtractor : public LocalToleranceFunction {
+
+protected:
+
+	void endBlocks(const ImageStack& /*recLabels*/, const ImageStack& /*gtLabels*/) {}
+};
+
+/**
+ * The connected components of the whole volume.
+ */
+struct Components {
+
+	// the component of each location
+	std::vector<unsigned int> ids;
+
+	// per component: labels, size, and bounding box
+	std::vector<float>                                    gtLabels;
+	std::vector<float>                                    recLabels;
+	std::vector<unsigned int>                             sizes;
+	std::vector<LocalToleranceFunction::cell_t::Location> mins;
+	std::vector<LocalToleranceFunction::cell_t::Location> maxs;
+};
+
+/**
+ * Large regions in the ground truth, diagonal stripes and noise in the
+ * reconstruction, such that the cells wind through many blocks.
+ */
+void createStacks(SampleGenerator& generator, ImageStack& gt, ImageStack& rec) {
+
+	for (unsigned int z = 0; z < Depth; z++) {
+
+		boost::shared_ptr<Image> gtSection  = boost::make_shared<Image>(Width, Height, 0);
+		boost::shared_ptr<Image> recSection = boost::make_shared<Image>(Width, Height, 0);
+
+		for (unsigned int y = 0; y < Height; y++)
+			for (unsigned int x = 0; x < Width; x++) {
+
+				(*gtSection)(x, y) = 1 + (x + z*3)/40 + 4*((y + z*2)/30);
+
+				if (generator.next() < 0.01)
+					(*recSection)(x, y) = generator.next(3);
+				else
+					(*recSection)(x, y) = (x/7 + y/5 + z)%3;
+			}
+
+		gt.add(gtSection);
+		rec.add(recSection);
+	}
+}
+
+/**
+ * Find the connected components of equal label pairs with a flood fill, in
+ * the same neighborhood as the block labelling (6-neighborhood).
+ */
+void floodFill(const ImageStack& gt, const ImageStack& rec, Components& components) {
+
+	const unsigned int None = static_cast<unsigned int>(-1);
+
+	components.ids.assign(Width*Height*Depth, None);
+
+	std::vector<unsigned int> stack;
+
+	for (unsigned int start = 0; start < components.ids.size(); start++) {
+
+		if (components.ids[start] != None)
+			continue;
+
+		unsigned int id = components.sizes.size();
+
+		unsigned int sx = start%Width;
+		unsigned int sy = (start/Width)%Height;
+		unsigned int sz = start/(Width*Height);
+
+		float gtLabel  = (*gt[sz])(sx, sy);
+		float recLabel = (*rec[sz])(sx, sy);
+
+		components.gtLabels.push_back(gtLabel);
+		components.recLabels.push_back(recLabel);
+		components.sizes.push_back(0);
+		components.mins.push_back(LocalToleranceFunction::cell_t::Location(sx, sy, sz));
+		components.maxs.push_back(LocalToleranceFunction::cell_t::Location(sx + 1, sy + 1, sz + 1));
+
+		components.ids[start] = id;
+		stack.push_back(start);
+
+		while (!stack.empty()) {
+
+			unsigned int i = stack.back();
+			stack.pop_back();
+
+			int x = i%Width;
+			int y = (i/Width)%Height;
+			int z = i/(Width*Height);
+
+			components.sizes[id]++;
+			components.mins[id].x = std::min(components.mins[id].x, x);
+			components.mins[id].y = std::min(components.mins[id].y, y);
+			components.mins[id].z = std::min(components.mins[id].z, z);
+			components.maxs[id].x = std::max(components.maxs[id].x, x + 1);
+			components.maxs[id].y = std::max(components.maxs[id].y, y + 1);
+			components.maxs[id].z = std::max(components.maxs[id].z, z + 1);
+
+			const int neighbors[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+			for (unsigned int n = 0; n < 6; n++) {
+
+				int nx = x + neighbors[n][0];
+				int ny = y + neighbors[n][1];
+				int nz = z + neighbors[n][2];
+
+				if (nx < 0 || ny < 0 || nz < 0 || nx >= (int)Width || ny >= (int)Height || nz >= (int)Depth)
+					continue;
+
+				unsigned int j = nx + ny*Width + nz*Width*Height;
+
+				if (components.ids[j] != None)
+					continue;
+
+				if ((*gt[nz])(nx, ny) != gtLabel || (*rec[nz])(nx, ny) != recLabel)
+					continue;
+
+				components.ids[j] = id;
+				stack.push_back(j);
+			}
+		}
+	}
+}
+
+/**
+ * Block visitor that writes the cell id of each location.
+ */
+void setCellIds(
+		const LocalToleranceFunction::Block&      block,
+		const vigra::MultiArray<3, unsigned int>& labels,
+		const std::vector<unsigned int>&          cellIds,
+		std::vector<unsigned int>&                locationCellIds) {
+
+	for (unsigned int z = 0; z < block.depth(); z++)
+		for (unsigned int y = 0; y < block.height(); y++)
+			for (unsigned int x = 0; x < block.width(); x++)
+				locationCellIds[(block.minX + x) + (block.minY + y)*Width + (block.minZ + z)*Width*Height] =
+						cellIds[labels(x, y, z) - 1];
+}
+
+bool equal(const LocalToleranceFunction::cell_t::Location& a, const LocalToleranceFunction::cell_t::Location& b) {
+
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator generator(42);
+
+		ImageStack gt;
+		ImageStack rec;
+		createStacks(generator, gt, rec);
+
+		// the reference
+		Components components;
+		floodFill(gt, rec, components);
+
+		// the block-wise extraction
+		CellExtractor extractor;
+		extractor.extractCells(rec, gt);
+
+		LocalToleranceFunction::cells_t cells = extractor.getCells();
+
+		std::vector<unsigned int> locationCellIds(Width*Height*Depth);
+		extractor.visitBlocks(rec, gt, boost::bind(&setCellIds, _1, _2, _3, boost::ref(locationCellIds)));
+
+		std::cout
+				<< "found " << cells->size() << " cells, " << components.sizes.size()
+				<< " components (blocks/flood fill)" << std::endl;
+
+		if (cells->size() != components.sizes.size())
+			return 1;
+
+		// each component has to be exactly one cell
+		const unsigned int None = static_cast<unsigned int>(-1);
+		std::vector<unsigned int> componentCells(components.sizes.size(), None);
+		std::vector<unsigned int> cellComponents(cells->size(), None);
+
+		for (unsigned int i = 0; i < locationCellIds.size(); i++) {
+
+			unsigned int component = components.ids[i];
+			unsigned int cell      = locationCellIds[i];
+
+			if (cell >= cells->size()) {
+
+				std::cout << "location " << i << " has invalid cell id " << cell << std::endl;
+				return 1;
+			}
+
+			if (componentCells[component] == None && cellComponents[cell] == None) {
+
+				componentCells[component] = cell;
+				cellComponents[cell]      = component;
+			}
+
+			if (componentCells[component] != cell || cellComponents[cell] != component) {
+
+				std::cout << "location " << i << " is in component " << component << " and cell " << cell
+						<< ", which are not the same" << std::endl;
+				return 1;
+			}
+		}
+
+		bool passed = true;
+
+		for (unsigned int c = 0; c < components.sizes.size(); c++) {
+
+			const LocalToleranceFunction::cell_t& cell = (*cells)[componentCells[c]];
+
+			bool same =
+					cell.getGroundTruthLabel()    == components.gtLabels[c] &&
+					cell.getReconstructionLabel() == components.recLabels[c] &&
+					cell.size()                   == components.sizes[c] &&
+					equal(cell.getMin(), components.mins[c]) &&
+					equal(cell.getMax(), components.maxs[c]);
+
+			if (!same) {
+
+				std::cout
+						<< "component " << c << " (size " << components.sizes[c]
+						<< ") differs from cell " << componentCells[c] << " (size "
+						<< cell.size() << ")" << std::endl;
+
+				passed = false;
+			}
+		}
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
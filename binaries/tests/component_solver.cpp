@@ -0,0 +1,145 @@
+/**
+ * Checks that the ComponentSolver, which splits a problem into the connected
+ * components of its constraints and merges their solutions, finds the
+ * optimum of the whole problem. The components are small enough to be
+ * enumerated, the optimum of the whole problem is found by enumerating all
+ * assignments.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <boost/make_shared.hpp>
+#include <pipeline/Process.h>
+#include <pipeline/Value.h>
+#include <inference/ComponentSolver.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "BruteForceBackend.h"
+#include "SampleGenerator.h"
+
+const unsigned int NumProblems           = 10;
+const unsigned int NumComponents         = 4;
+const unsigned int NumComponentVariables = 4;
+const unsigned int NumIsolatedVariables  = 2;
+const unsigned int NumVariables          = NumComponents*NumComponentVariables + NumIsolatedVariables;
+
+/**
+ * Create a problem of several components, whose variables are scattered over
+ * the range of variable numbers. Each component is connected by a chain of
+ * continuation equalities and has some conflict constraints. The remaining
+ * variables are not part of any constraint.
+ */
+void createProblem(
+		SampleGenerator&   generator,
+		LinearObjective&   objective,
+		LinearConstraints& constraints) {
+
+	// a random permutation of the variable numbers
+	std::vector<unsigned int> variables(NumVariables);
+	for (unsigned int i = 0; i < NumVariables; i++)
+		variables[i] = i;
+	for (unsigned int i = NumVariables - 1; i > 0; i--)
+		std::swap(variables[i], variables[generator.next(i + 1)]);
+
+	objective.resize(NumVariables);
+	objective.setSense(Minimize);
+	for (unsigned int i = 0; i < NumVariables; i++)
+		objective.setCoefficient(i, generator.next()*2 - 1.5);
+
+	for (unsigned int c = 0; c < NumComponents; c++) {
+
+		const unsigned int* component = &variables[c*NumComponentVariables];
+
+		for (unsigned int i = 0; i + 1 < NumComponentVariables; i++) {
+
+			LinearConstraint constraint;
+			constraint.setCoefficient(component[i],      1.0);
+			constraint.setCoefficient(component[i + 1], -1.0);
+			if (generator.next() < 0.5)
+				constraint.setCoefficient(component[generator.next(NumComponentVariables)], -1.0);
+			constraint.setRelation(Equal);
+			constraint.setValue(0.0);
+
+			constraints.add(constraint);
+		}
+
+		unsigned int numConflicts = 1 + generator.next(2);
+		for (unsigned int j = 0; j < numConflicts; j++) {
+
+			LinearConstraint constraint;
+			constraint.setCoefficient(component[generator.next(NumComponentVariables)], 1.0);
+			constraint.setCoefficient(component[generator.next(NumComponentVariables)], 1.0);
+			constraint.setRelation(LessEqual);
+			constraint.setValue(1.0);
+
+			constraints.add(constraint);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator generator(42);
+
+		bool passed = true;
+
+		for (unsigned int p = 0; p < NumProblems; p++) {
+
+			boost::shared_ptr<LinearObjective>   objective   = boost::make_shared<LinearObjective>();
+			boost::shared_ptr<LinearConstraints> constraints = boost::make_shared<LinearConstraints>();
+
+			createProblem(generator, *objective, *constraints);
+
+			pipeline::Process<ComponentSolver> solver;
+
+			solver->setInput("objective", objective);
+			solver->setInput("linear constraints", constraints);
+			solver->setInput("parameters", boost::make_shared<LinearSolverParameters>(Binary));
+
+			pipeline::Value<Solution> solution = solver->getOutput("solution");
+
+			// the reference: the whole problem at once
+			BruteForceBackend reference;
+			Solution          optimum;
+			double            optimalValue;
+			std::string       message;
+
+			reference.initialize(NumVariables, Binary);
+			reference.setObjective(*objective);
+			reference.setConstraints(*constraints);
+			reference.solve(optimum, optimalValue, message);
+
+			double value = BruteForceBackend::getValue(*objective, *solution);
+
+			bool same =
+					solution->size() == NumVariables &&
+					BruteForceBackend::isFeasible(*constraints, *solution) &&
+					std::abs(value - optimalValue) < 1e-6;
+
+			std::cout
+					<< "problem " << p << ": optimum " << optimalValue << "/" << value
+					<< " (whole/components)" << (same ? "" : " -- differ") << std::endl;
+
+			passed &= same;
+		}
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
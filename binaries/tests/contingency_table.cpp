@@ -0,0 +1,211 @@
+/**
+ * Checks the contingency table of two label stacks and the statistics derived
+ * from it (agreeing pairs for the RAND index, entropies for the VOI) against
+ * direct computations on the locations.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <boost/make_shared.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <imageprocessing/ImageStack.h>
+#include <pipeline/Process.h>
+#include <pipeline/Value.h>
+#include <sopnet/evaluation/ContingencyTableExtractor.h>
+#include <util/foreach.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "SampleGenerator.h"
+
+const unsigned int Width  = 40;
+const unsigned int Height = 30;
+const unsigned int Depth  = 4;
+
+typedef std::map<std::pair<float, float>, size_t> counts_type;
+
+/**
+ * Two overlapping grids of regions with some background, one of them with
+ * non-integer labels, and some noise.
+ */
+void createStacks(SampleGenerator& generator, ImageStack& stack1, ImageStack& stack2) {
+
+	for (unsigned int z = 0; z < Depth; z++) {
+
+		boost::shared_ptr<Image> section1 = boost::make_shared<Image>(Width, Height, 0);
+		boost::shared_ptr<Image> section2 = boost::make_shared<Image>(Width, Height, 0);
+
+		for (unsigned int y = 0; y < Height; y++)
+			for (unsigned int x = 0; x < Width; x++) {
+
+				(*section1)(x, y) = (x/13 + 3*(y/11))%7;
+				(*section2)(x, y) = 0.5*((x + z)/9 + 5*((y + 2*z)/8));
+
+				if (generator.next() < 0.05)
+					(*section2)(x, y) = 0;
+			}
+
+		stack1.add(section1);
+		stack2.add(section2);
+	}
+}
+
+bool checkTable(const ContingencyTable& table, const counts_type& counts) {
+
+	const std::vector<float>& labels1 = table.getLabels1();
+	const std::vector<float>& labels2 = table.getLabels2();
+
+	for (unsigned int i = 1; i < labels1.size(); i++)
+		if (labels1[i - 1] >= labels1[i]) {
+
+			std::cout << "labels of stack 1 are not sorted and unique" << std::endl;
+			return false;
+		}
+
+	for (unsigned int i = 1; i < labels2.size(); i++)
+		if (labels2[i - 1] >= labels2[i]) {
+
+			std::cout << "labels of stack 2 are not sorted and unique" << std::endl;
+			return false;
+		}
+
+	counts_type tableCounts;
+
+	foreach (const ContingencyTable::Entry& entry, table.getEntries()) {
+
+		if (entry.label1 >= labels1.size() || entry.label2 >= labels2.size()) {
+
+			std::cout << "entry with invalid label id" << std::endl;
+			return false;
+		}
+
+		tableCounts[std::make_pair(labels1[entry.label1], labels2[entry.label2])] += entry.count;
+	}
+
+	std::cout
+			<< "contingency table has " << table.getEntries().size() << " entries, expected "
+			<< counts.size() << std::endl;
+
+	return tableCounts == counts;
+}
+
+bool checkAgreeingPairs(const ContingencyTable& table, const ImageStack& stack1, const ImageStack& stack2, bool ignoreBackground) {
+
+	std::vector<float> labels1;
+	std::vector<float> labels2;
+
+	for (unsigned int z = 0; z < Depth; z++)
+		for (unsigned int y = 0; y < Height; y++)
+			for (unsigned int x = 0; x < Width; x++) {
+
+				float label1 = (*stack1[z])(x, y);
+				float label2 = (*stack2[z])(x, y);
+
+				if (ignoreBackground && (label1 == 0 || label2 == 0))
+					continue;
+
+				labels1.push_back(label1);
+				labels2.push_back(label2);
+			}
+
+	size_t numAgreeing = 0;
+	for (unsigned int i = 0; i < labels1.size(); i++)
+		for (unsigned int j = i + 1; j < labels1.size(); j++)
+			if ((labels1[i] == labels1[j]) == (labels2[i] == labels2[j]))
+				numAgreeing++;
+
+	size_t tableAgreeing = table.getNumAgreeingPairs(ignoreBackground);
+
+	std::cout
+			<< "agreeing pairs" << (ignoreBackground ? " (without background)" : "") << ": "
+			<< tableAgreeing << "/" << numAgreeing << " (table/locations)" << std::endl;
+
+	return tableAgreeing == numAgreeing && table.getNumLocations(ignoreBackground) == labels1.size();
+}
+
+bool checkEntropies(const ContingencyTable& table, const counts_type& counts) {
+
+	std::map<float, size_t> counts1;
+	std::map<float, size_t> counts2;
+	double n = 0;
+
+	std::pair<float, float> labels;
+	size_t count;
+	foreach (boost::tie(labels, count), counts) {
+
+		counts1[labels.first]  += count;
+		counts2[labels.second] += count;
+		n += count;
+	}
+
+	// H(1), H(2), and the joint entropy H(1, 2)
+	double H1 = 0, H2 = 0, H12 = 0;
+
+	float label;
+	foreach (boost::tie(label, count), counts1)
+		H1 -= (count/n)*std::log(count/n);
+	foreach (boost::tie(label, count), counts2)
+		H2 -= (count/n)*std::log(count/n);
+	foreach (boost::tie(labels, count), counts)
+		H12 -= (count/n)*std::log(count/n);
+
+	double tableH1, tableH2, tableI;
+	table.getEntropies(tableH1, tableH2, tableI);
+
+	std::cout
+			<< "entropies: H1 " << tableH1 << "/" << H1 << ", H2 " << tableH2 << "/" << H2
+			<< ", I " << tableI << "/" << (H1 + H2 - H12) << " (table/locations)" << std::endl;
+
+	return
+			std::abs(tableH1 - H1) < 1e-9 &&
+			std::abs(tableH2 - H2) < 1e-9 &&
+			std::abs(tableI - (H1 + H2 - H12)) < 1e-9;
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator generator(42);
+
+		boost::shared_ptr<ImageStack> stack1 = boost::make_shared<ImageStack>();
+		boost::shared_ptr<ImageStack> stack2 = boost::make_shared<ImageStack>();
+		createStacks(generator, *stack1, *stack2);
+
+		// the reference
+		counts_type counts;
+		for (unsigned int z = 0; z < Depth; z++)
+			for (unsigned int y = 0; y < Height; y++)
+				for (unsigned int x = 0; x < Width; x++)
+					counts[std::make_pair((*(*stack1)[z])(x, y), (*(*stack2)[z])(x, y))]++;
+
+		pipeline::Process<ContingencyTableExtractor> extractor;
+		extractor->setInput("stack 1", stack1);
+		extractor->setInput("stack 2", stack2);
+
+		pipeline::Value<ContingencyTable> table = extractor->getOutput("contingency table");
+
+		bool passed = true;
+
+		passed &= checkTable(*table, counts);
+		passed &= checkAgreeingPairs(*table, *stack1, *stack2, false);
+		passed &= checkAgreeingPairs(*table, *stack1, *stack2, true);
+		passed &= checkEntropies(*table, counts);
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
@@ -0,0 +1,161 @@
+/**
+ * Checks that the GreedyRounding finds a feasible solution for problems with
+ * variables of infinite costs without selecting them, and that the reported
+ * value, bound, and gap are well defined. Variables with infinite costs are not part of the relaxed
+ * solution, as in the relaxations that the LinearSolver finds.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <boost/make_shared.hpp>
+#include <pipeline/Process.h>
+#include <pipeline/Value.h>
+#include <inference/GreedyRounding.h>
+#include <inference/SolverStatistics.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "BruteForceBackend.h"
+#include "SampleGenerator.h"
+
+const unsigned int NumProblems  = 50;
+const unsigned int NumVariables = 14;
+
+/**
+ * Create a problem with continuation equalities and at-most-one conflicts,
+ * some infinite costs, and a fractional relaxed solution that does not
+ * select the variables with infinite costs.
+ */
+void createProblem(
+		SampleGenerator&   generator,
+		LinearObjective&   objective,
+		LinearConstraints& constraints,
+		Solution&          relaxed) {
+
+	objective.resize(NumVariables);
+	objective.setSense(Minimize);
+	objective.setConstant(generator.next());
+
+	relaxed.resize(NumVariables);
+
+	for (unsigned int i = 0; i < NumVariables; i++) {
+
+		if (generator.next() < 0.2) {
+
+			objective.setCoefficient(i, std::numeric_limits<double>::infinity());
+			relaxed[i] = 0;
+
+		} else {
+
+			objective.setCoefficient(i, generator.next()*2 - 1.5);
+			relaxed[i] = generator.next();
+		}
+	}
+
+	unsigned int numConflicts = 4 + generator.next(4);
+	for (unsigned int c = 0; c < numConflicts; c++) {
+
+		LinearConstraint constraint;
+		unsigned int size = 2 + generator.next(3);
+		for (unsigned int j = 0; j < size; j++)
+			constraint.setCoefficient(generator.next(NumVariables), 1.0);
+		constraint.setRelation(LessEqual);
+		constraint.setValue(1.0);
+
+		constraints.add(constraint);
+	}
+
+	unsigned int numEqualities = 2 + generator.next(3);
+	for (unsigned int c = 0; c < numEqualities; c++) {
+
+		LinearConstraint constraint;
+		constraint.setCoefficient(generator.next(NumVariables),  1.0);
+		constraint.setCoefficient(generator.next(NumVariables), -1.0);
+		constraint.setRelation(Equal);
+		constraint.setValue(0.0);
+
+		constraints.add(constraint);
+	}
+}
+
+bool isNan(double value) {
+
+	return value != value;
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator generator(42);
+
+		bool passed = true;
+
+		for (unsigned int p = 0; p < NumProblems; p++) {
+
+			boost::shared_ptr<LinearObjective>   objective   = boost::make_shared<LinearObjective>();
+			boost::shared_ptr<LinearConstraints> constraints = boost::make_shared<LinearConstraints>();
+			boost::shared_ptr<Solution>          relaxed     = boost::make_shared<Solution>();
+
+			createProblem(generator, *objective, *constraints, *relaxed);
+
+			pipeline::Process<GreedyRounding> rounding;
+
+			rounding->setInput("objective", objective);
+			rounding->setInput("linear constraints", constraints);
+			rounding->setInput("relaxed solution", relaxed);
+
+			pipeline::Value<Solution>         solution   = rounding->getOutput("solution");
+			pipeline::Value<SolverStatistics> statistics = rounding->getOutput("statistics");
+
+			// selecting nothing is always feasible, the optimum is finite
+			BruteForceBackend reference;
+			Solution          optimum;
+			double            optimalValue;
+			std::string       message;
+
+			reference.initialize(NumVariables, Binary);
+			reference.setObjective(*objective);
+			reference.setConstraints(*constraints);
+			reference.solve(optimum, optimalValue, message);
+
+			double value = BruteForceBackend::getValue(*objective, *solution);
+
+			bool defined =
+					!isNan(statistics->getValue()) &&
+					!isNan(statistics->getBound()) &&
+					!isNan(statistics->getGap()) &&
+					std::abs(statistics->getBound()) < std::numeric_limits<double>::infinity();
+
+			bool feasible =
+					statistics->getStatus() != SolverStatistics::Heuristic ||
+					(BruteForceBackend::isFeasible(*constraints, *solution) &&
+					 std::abs(value) < std::numeric_limits<double>::infinity() &&
+					 std::abs(value - statistics->getValue()) < 1e-6 &&
+					 value >= optimalValue - 1e-6);
+
+			std::cout
+					<< "problem " << p << ": optimum " << optimalValue << ", rounded "
+					<< statistics->getValue() << ", relaxed " << statistics->getBound()
+					<< (defined ? "" : " -- undefined statistics")
+					<< (feasible ? "" : " -- invalid solution") << std::endl;
+
+			passed &= defined && feasible;
+		}
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
@@ -0,0 +1,152 @@
+/**
+ * Checks that the LinearSolver finds the optimum of a problem if only the
+ * conflict constraints are given as linear constraints, and the continuation
+ * constraints are given as lazy constraints. The solver uses a backend that
+ * enumerates all assignments, the optimum is compared with the one of the
+ * full problem.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <boost/make_shared.hpp>
+#include <pipeline/Process.h>
+#include <pipeline/Value.h>
+#include <inference/LinearSolver.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "BruteForceBackend.h"
+#include "SampleGenerator.h"
+
+const unsigned int NumProblems   = 20;
+const unsigned int NumObjectives = 3;
+const unsigned int NumVariables  = 16;
+
+/**
+ * Create at-most-one conflict constraints and continuation equalities
+ * between random variables.
+ */
+void createConstraints(
+		SampleGenerator&   generator,
+		LinearConstraints& conflicts,
+		LinearConstraints& explanations) {
+
+	unsigned int numConflicts = 4 + generator.next(4);
+	for (unsigned int c = 0; c < numConflicts; c++) {
+
+		LinearConstraint constraint;
+		unsigned int size = 2 + generator.next(2);
+		for (unsigned int j = 0; j < size; j++)
+			constraint.setCoefficient(generator.next(NumVariables), 1.0);
+		constraint.setRelation(LessEqual);
+		constraint.setValue(1.0);
+
+		conflicts.add(constraint);
+	}
+
+	unsigned int numExplanations = 4 + generator.next(4);
+	for (unsigned int c = 0; c < numExplanations; c++) {
+
+		LinearConstraint constraint;
+		constraint.setCoefficient(generator.next(NumVariables),  1.0);
+		constraint.setCoefficient(generator.next(NumVariables), -1.0);
+		if (generator.next() < 0.5)
+			constraint.setCoefficient(generator.next(NumVariables), -1.0);
+		constraint.setRelation(Equal);
+		constraint.setValue(0.0);
+
+		explanations.add(constraint);
+	}
+}
+
+/**
+ * Selecting a variable is rewarding for most of the variables, such that the
+ * explanation constraints are violated without being enforced.
+ */
+boost::shared_ptr<LinearObjective> createObjective(SampleGenerator& generator) {
+
+	boost::shared_ptr<LinearObjective> objective = boost::make_shared<LinearObjective>(NumVariables);
+
+	for (unsigned int i = 0; i < NumVariables; i++)
+		objective->setCoefficient(i, generator.next()*2 - 1.5);
+
+	return objective;
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator   generator(42);
+		BruteForceFactory factory;
+
+		bool passed = true;
+
+		for (unsigned int p = 0; p < NumProblems; p++) {
+
+			boost::shared_ptr<LinearConstraints> conflicts    = boost::make_shared<LinearConstraints>();
+			boost::shared_ptr<LinearConstraints> explanations = boost::make_shared<LinearConstraints>();
+
+			createConstraints(generator, *conflicts, *explanations);
+
+			LinearConstraints all;
+			all.addAll(*conflicts);
+			all.addAll(*explanations);
+
+			// one solver for all objectives, lazy constraints added for one
+			// objective stay valid for the next
+			pipeline::Process<LinearSolver> solver(factory);
+
+			solver->setInput("linear constraints", conflicts);
+			solver->setInput("lazy constraints", explanations);
+			solver->setInput("parameters", boost::make_shared<LinearSolverParameters>(Binary));
+
+			for (unsigned int o = 0; o < NumObjectives; o++) {
+
+				boost::shared_ptr<LinearObjective> objective = createObjective(generator);
+
+				solver->setInput("objective", objective);
+
+				pipeline::Value<Solution> solution = solver->getOutput("solution");
+
+				// the reference: all constraints at once
+				BruteForceBackend reference;
+				Solution          optimum;
+				double            optimalValue;
+				std::string       message;
+
+				reference.initialize(NumVariables, Binary);
+				reference.setObjective(*objective);
+				reference.setConstraints(all);
+				reference.solve(optimum, optimalValue, message);
+
+				double value = BruteForceBackend::getValue(*objective, *solution);
+
+				bool same =
+						BruteForceBackend::isFeasible(all, *solution) &&
+						std::abs(value - optimalValue) < 1e-6;
+
+				std::cout
+						<< "problem " << p << ", objective " << o << ": optimum "
+						<< optimalValue << "/" << value << " (full/lazy)"
+						<< (same ? "" : " -- differ") << std::endl;
+
+				passed &= same;
+			}
+		}
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
@@ -0,0 +1,225 @@
+/**
+ * Checks that solving a problem reduced by the Presolver and mapping the
+ * solution back gives an optimal solution of the original problem. Both
+ * problems are solved by enumerating all assignments.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <boost/make_shared.hpp>
+#include <pipeline/Process.h>
+#include <pipeline/Value.h>
+#include <inference/Presolver.h>
+#include <inference/PresolvedSolutionMapper.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "BruteForceBackend.h"
+#include "SampleGenerator.h"
+
+const unsigned int NumProblems  = 50;
+const unsigned int NumVariables = 14;
+
+/**
+ * Create a problem with the kinds of rows the problem assembler creates
+ * (continuation equalities and at-most-one conflicts), and some rows and
+ * costs that the presolver can reduce: singleton equalities, duplicate rows,
+ * and infinite costs.
+ */
+void createProblem(
+		SampleGenerator&   generator,
+		LinearObjective&   objective,
+		LinearConstraints& constraints) {
+
+	objective.resize(NumVariables);
+	objective.setSense(Minimize);
+	objective.setConstant(generator.next());
+
+	for (unsigned int i = 0; i < NumVariables; i++) {
+
+		if (generator.next() < 0.1)
+			objective.setCoefficient(i, std::numeric_limits<double>::infinity());
+		else
+			objective.setCoefficient(i, generator.next()*2 - 1);
+	}
+
+	unsigned int numConflicts = 4 + generator.next(4);
+	for (unsigned int c = 0; c < numConflicts; c++) {
+
+		LinearConstraint constraint;
+		unsigned int size = 2 + generator.next(3);
+		for (unsigned int j = 0; j < size; j++)
+			constraint.setCoefficient(generator.next(NumVariables), 1.0);
+		constraint.setRelation(LessEqual);
+		constraint.setValue(1.0);
+
+		constraints.add(constraint);
+
+		// a duplicate, which is redundant
+		if (generator.next() < 0.2)
+			constraints.add(constraint);
+	}
+
+	unsigned int numEqualities = 2 + generator.next(3);
+	for (unsigned int c = 0; c < numEqualities; c++) {
+
+		LinearConstraint constraint;
+		constraint.setCoefficient(generator.next(NumVariables),  1.0);
+		constraint.setCoefficient(generator.next(NumVariables),  1.0);
+		constraint.setCoefficient(generator.next(NumVariables), -1.0);
+		constraint.setRelation(Equal);
+		constraint.setValue(0.0);
+
+		constraints.add(constraint);
+	}
+
+	unsigned int numSingletons = generator.next(3);
+	for (unsigned int c = 0; c < numSingletons; c++) {
+
+		LinearConstraint constraint;
+		constraint.setCoefficient(generator.next(NumVariables), 1.0);
+		constraint.setRelation(Equal);
+		constraint.setValue(generator.next(2));
+
+		constraints.add(constraint);
+	}
+}
+
+bool solve(
+		const LinearObjective&   objective,
+		const LinearConstraints& constraints,
+		Solution& solution,
+		double& value) {
+
+	BruteForceBackend backend;
+	std::string       message;
+
+	backend.initialize(objective.getCoefficients().size(), Binary);
+	backend.setObjective(objective);
+	backend.setConstraints(constraints);
+
+	return backend.solve(solution, value, message);
+}
+
+/**
+ * Presolve the problem, solve the reduced problem, and compare the mapped
+ * solution with the optimum of the original problem. Returns false, if they
+ * differ.
+ */
+bool checkProblem(
+		unsigned int p,
+		boost::shared_ptr<LinearObjective>   objective,
+		boost::shared_ptr<LinearConstraints> constraints,
+		bool feasible,
+		double originalValue) {
+
+	pipeline::Process<Presolver>               presolver;
+	pipeline::Process<PresolvedSolutionMapper> mapper;
+
+	presolver->setInput("objective", objective);
+	presolver->setInput("linear constraints", constraints);
+	presolver->setInput("parameters", boost::make_shared<LinearSolverParameters>(Binary));
+
+	pipeline::Value<LinearObjective>   reducedObjective   = presolver->getOutput("objective");
+	pipeline::Value<LinearConstraints> reducedConstraints = presolver->getOutput("linear constraints");
+
+	boost::shared_ptr<Solution> reduced = boost::make_shared<Solution>();
+	double reducedValue;
+	bool   reducedFeasible = solve(*reducedObjective, *reducedConstraints, *reduced, reducedValue);
+
+	if (!feasible) {
+
+		if (reducedFeasible) {
+
+			std::cout << "problem " << p << ": infeasible problem has a feasible reduction" << std::endl;
+			return false;
+		}
+
+		std::cout << "problem " << p << ": infeasible" << std::endl;
+		return true;
+	}
+
+	if (!reducedFeasible) {
+
+		std::cout << "problem " << p << ": reduction of a feasible problem is infeasible" << std::endl;
+		return false;
+	}
+
+	mapper->setInput("solution", reduced);
+	mapper->setInput("mapping", presolver->getOutput("mapping"));
+
+	pipeline::Value<Solution> mapped = mapper->getOutput("solution");
+
+	double mappedValue = BruteForceBackend::getValue(*objective, *mapped);
+
+	bool same =
+			BruteForceBackend::isFeasible(*constraints, *mapped) &&
+			std::abs(mappedValue - originalValue) < 1e-6;
+
+	std::cout
+			<< "problem " << p << ": " << objective->getCoefficients().size() << " variables reduced to "
+			<< reducedObjective->getCoefficients().size() << ", " << constraints->size()
+			<< " constraints reduced to " << reducedConstraints->size() << ", optimum "
+			<< originalValue << "/" << mappedValue << " (original/mapped)"
+			<< (same ? "" : " -- differ") << std::endl;
+
+	return same;
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator generator(42);
+
+		bool passed = true;
+
+		for (unsigned int p = 0; p < NumProblems; p++) {
+
+			boost::shared_ptr<LinearObjective>   objective   = boost::make_shared<LinearObjective>();
+			boost::shared_ptr<LinearConstraints> constraints = boost::make_shared<LinearConstraints>();
+
+			createProblem(generator, *objective, *constraints);
+
+			Solution original;
+			double   originalValue;
+			bool     feasible = solve(*objective, *constraints, original, originalValue);
+
+			// selecting a variable with infinite costs is not feasible either
+			if (feasible && originalValue == std::numeric_limits<double>::infinity())
+				feasible = false;
+
+			try {
+
+				passed &= checkProblem(p, objective, constraints, feasible, originalValue);
+
+			} catch (InfeasibleProblem&) {
+
+				if (feasible) {
+
+					std::cout << "problem " << p << ": presolver reports a feasible problem as infeasible" << std::endl;
+					passed = false;
+
+				} else {
+
+					std::cout << "problem " << p << ": infeasible, detected by the presolver" << std::endl;
+				}
+			}
+		}
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
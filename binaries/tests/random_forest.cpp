@@ -0,0 +1,132 @@
+/**
+ * Checks that the flattened random forest predicts exactly the same class
+ * probabilities as vigra's implementation, for a freshly trained forest and
+ * for the same forest after writing it to and reading it from a file.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <inference/RandomForest.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "SampleGenerator.h"
+
+const unsigned int NumFeatures     = 5;
+const unsigned int NumClasses      = 3;
+const unsigned int NumTrainSamples = 2000;
+const unsigned int NumTestSamples  = 5000;
+const unsigned int NumTrees        = 20;
+
+void createSamples(
+		SampleGenerator& generator,
+		unsigned int numSamples,
+		RandomForest::SamplesType& samples,
+		std::vector<RandomForest::LabelType>& labels) {
+
+	samples = RandomForest::SamplesType(RandomForest::SamplesSize(numSamples, NumFeatures));
+	labels.resize(numSamples);
+
+	for (unsigned int i = 0; i < numSamples; i++) {
+
+		for (unsigned int f = 0; f < NumFeatures; f++)
+			samples(i, f) = generator.next();
+
+		// a label that depends on some of the features, with noise
+		double score = samples(i, 0) + 0.5*samples(i, 1) - 0.8*samples(i, 3) + 0.3*generator.next();
+
+		labels[i] = (score < 0.2 ? 0 : (score < 0.7 ? 1 : 2));
+	}
+}
+
+bool check(RandomForest& rf, const RandomForest::SamplesType& samples, std::string name) {
+
+	if (!rf.hasFlatForest()) {
+
+		std::cerr << name << ": forest was not flattened" << std::endl;
+		return false;
+	}
+
+	unsigned int numMismatches = rf.checkFlatForest(samples);
+
+	if (numMismatches > 0) {
+
+		std::cerr
+				<< name << ": " << numMismatches << " of "
+				<< samples.shape(0)*NumClasses
+				<< " probabilities differ from vigra's prediction" << std::endl;
+		return false;
+	}
+
+	std::cout << name << ": all probabilities equal" << std::endl;
+
+	return true;
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator generator(42);
+
+		RandomForest::SamplesType            trainSamples;
+		RandomForest::SamplesType            testSamples;
+		std::vector<RandomForest::LabelType> trainLabels;
+		std::vector<RandomForest::LabelType> testLabels;
+
+		createSamples(generator, NumTrainSamples, trainSamples, trainLabels);
+		createSamples(generator, NumTestSamples, testSamples, testLabels);
+
+		// train a forest
+
+		RandomForest rf;
+
+		rf.prepareTraining(NumTrainSamples, NumFeatures);
+
+		std::vector<double> sample(NumFeatures);
+		for (unsigned int i = 0; i < NumTrainSamples; i++) {
+
+			for (unsigned int f = 0; f < NumFeatures; f++)
+				sample[f] = trainSamples(i, f);
+
+			rf.addSample(sample, trainLabels[i]);
+		}
+
+		rf.train(NumTrees);
+
+		bool passed = true;
+
+		// the training samples hit the thresholds most closely
+		passed &= check(rf, trainSamples, "trained forest, training samples");
+		passed &= check(rf, testSamples, "trained forest, test samples");
+
+		// the same forest, read from a file
+
+		const std::string filename = "random_forest_test.hdf";
+
+		rf.write(filename);
+
+		RandomForest read;
+		read.read(filename);
+
+		std::remove(filename.c_str());
+
+		passed &= check(read, trainSamples, "read forest, training samples");
+		passed &= check(read, testSamples, "read forest, test samples");
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
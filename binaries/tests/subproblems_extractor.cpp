@@ -0,0 +1,207 @@
+/**
+ * Checks that the SubproblemsExtractor without tiles decomposes a problem
+ * into the same subproblems as before the tiling was introduced: one
+ * subproblem per window of inter-section intervals, containing all variables
+ * of these intervals and all constraints that are fully contained in them.
+ * Run with --subproblemsSize and --subproblemsOverlap, without
+ * --subproblemsTileSize.
+ */
+
+#include <iostream>
+#include <vector>
+#include <boost/make_shared.hpp>
+#include <pipeline/Process.h>
+#include <pipeline/Value.h>
+#include <imageprocessing/ConnectedComponent.h>
+#include <inference/LinearConstraints.h>
+#include <inference/LinearObjective.h>
+#include <sopnet/inference/ProblemConfiguration.h>
+#include <sopnet/inference/Subproblems.h>
+#include <sopnet/inference/SubproblemsExtractor.h>
+#include <sopnet/segments/EndSegment.h>
+#include <sopnet/slices/Slice.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/foreach.h>
+#include <util/exceptions.h>
+#include "SampleGenerator.h"
+
+const unsigned int NumProblems  = 20;
+const unsigned int NumVariables = 60;
+const unsigned int NumSections  = 10;
+const unsigned int Size         = 256;
+
+/**
+ * Create an end segment of a slice with a single pixel at a random position
+ * in a random section.
+ */
+boost::shared_ptr<Segment> createSegment(SampleGenerator& generator, unsigned int id) {
+
+	boost::shared_ptr<ConnectedComponent::pixel_list_type> pixels = boost::make_shared<ConnectedComponent::pixel_list_type>(1);
+	pixels->add(util::point<unsigned int>(generator.next(Size), generator.next(Size)));
+
+	boost::shared_ptr<ConnectedComponent> component =
+			boost::make_shared<ConnectedComponent>(
+					boost::shared_ptr<Image>(),
+					0,
+					pixels,
+					pixels->begin(),
+					pixels->end());
+
+	boost::shared_ptr<Slice> slice = boost::make_shared<Slice>(id, generator.next(NumSections), component);
+
+	return boost::make_shared<EndSegment>(id, (generator.next() < 0.5 ? Left : Right), slice);
+}
+
+/**
+ * Create conflict constraints between variables of the same inter-section
+ * interval and continuation constraints between variables of neighboring
+ * intervals.
+ */
+void createConstraints(
+		SampleGenerator&      generator,
+		ProblemConfiguration& configuration,
+		LinearConstraints&    constraints) {
+
+	for (unsigned int c = 0; c < 2*NumVariables; c++) {
+
+		unsigned int first  = generator.next(NumVariables);
+		unsigned int second = generator.next(NumVariables);
+
+		int distance =
+				(int)configuration.getInterSectionInterval(first) -
+				(int)configuration.getInterSectionInterval(second);
+
+		LinearConstraint constraint;
+
+		if (distance == 0) {
+
+			constraint.setCoefficient(first,  1.0);
+			constraint.setCoefficient(second, 1.0);
+			constraint.setRelation(LessEqual);
+			constraint.setValue(1.0);
+
+		} else if (distance == 1 || distance == -1) {
+
+			constraint.setCoefficient(first,   1.0);
+			constraint.setCoefficient(second, -1.0);
+			constraint.setRelation(Equal);
+			constraint.setValue(0.0);
+
+		} else {
+
+			continue;
+		}
+
+		constraints.add(constraint);
+	}
+}
+
+/**
+ * Compare the subproblems of the variables and constraints with the ones of
+ * the decomposition in windows of inter-section intervals.
+ */
+bool checkProblem(
+		unsigned int p,
+		ProblemConfiguration& configuration,
+		const LinearConstraints& constraints,
+		Subproblems& subproblems) {
+
+	unsigned int size    = optionSubproblemsSize;
+	unsigned int overlap = optionSubproblemsOverlap;
+
+	std::vector<std::vector<unsigned int> > variableSubproblems(NumVariables);
+	std::vector<std::vector<unsigned int> > constraintSubproblems(constraints.size());
+
+	unsigned int subproblemId = 0;
+	for (unsigned int start = configuration.getMinInterSectionInterval(); start < configuration.getMaxInterSectionInterval(); start += size - overlap) {
+
+		std::vector<bool> contained(NumVariables, false);
+
+		for (unsigned int i = 0; i < NumVariables; i++)
+			if (configuration.getInterSectionInterval(i) >= start && configuration.getInterSectionInterval(i) < start + size) {
+
+				contained[i] = true;
+				variableSubproblems[i].push_back(subproblemId);
+			}
+
+		for (unsigned int i = 0; i < constraints.size(); i++) {
+
+			bool allContained = true;
+
+			unsigned int varNum;
+			double coef;
+			foreach (boost::tie(varNum, coef), constraints[i].getCoefficients())
+				allContained &= contained[varNum];
+
+			if (allContained)
+				constraintSubproblems[i].push_back(subproblemId);
+		}
+
+		subproblemId++;
+	}
+
+	bool same = true;
+
+	for (unsigned int i = 0; i < NumVariables; i++)
+		same &= (subproblems.getVariableSubproblems(i) == variableSubproblems[i]);
+
+	for (unsigned int i = 0; i < constraints.size(); i++)
+		same &= (subproblems.getConstraintSubproblems(i) == constraintSubproblems[i]);
+
+	std::cout
+			<< "problem " << p << ": " << subproblemId << " subproblems for "
+			<< NumVariables << " variables and " << constraints.size() << " constraints"
+			<< (same ? "" : " -- differ") << std::endl;
+
+	return same;
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator generator(42);
+
+		bool passed = true;
+
+		for (unsigned int p = 0; p < NumProblems; p++) {
+
+			boost::shared_ptr<ProblemConfiguration> configuration = boost::make_shared<ProblemConfiguration>();
+			boost::shared_ptr<LinearObjective>      objective     = boost::make_shared<LinearObjective>(NumVariables);
+			boost::shared_ptr<LinearConstraints>    constraints   = boost::make_shared<LinearConstraints>();
+
+			for (unsigned int i = 0; i < NumVariables; i++) {
+
+				configuration->setVariable(*createSegment(generator, i), i);
+				objective->setCoefficient(i, generator.next()*2 - 1);
+			}
+
+			createConstraints(generator, *configuration, *constraints);
+
+			pipeline::Process<SubproblemsExtractor> extractor;
+
+			extractor->setInput("objective", objective);
+			extractor->setInput("linear constraints", constraints);
+			extractor->setInput("problem configuration", configuration);
+
+			pipeline::Value<Subproblems> subproblems = extractor->getOutput("subproblems");
+
+			passed &= checkProblem(p, *configuration, *constraints, *subproblems);
+		}
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
@@ -0,0 +1,222 @@
+/**
+ * Checks that the incremental tolerant edit distance of a locally changed
+ * reconstruction gives the same errors as computing the tolerant edit
+ * distance of the changed reconstruction from scratch.
+ *
+ * Run with small blocks (e.g., --tedBlockSize=64 --tedBlockDepth=4), such
+ * that the changes touch only some of the blocks.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <boost/make_shared.hpp>
+#include <imageprocessing/ImageStack.h>
+#include <pipeline/Process.h>
+#include <pipeline/Value.h>
+#include <sopnet/evaluation/TolerantEditDistance.h>
+#include <util/ProgramOptions.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "SampleGenerator.h"
+
+const unsigned int Width        = 200;
+const unsigned int Height       = 150;
+const unsigned int Depth        = 10;
+const unsigned int NumSeeds     = 12;
+const unsigned int NumChanges   = 8;
+const unsigned int ChangeWidth  = 15;
+const unsigned int ChangeHeight = 10;
+const unsigned int ChangeDepth  = 3;
+
+struct Seed {
+
+	double x, y;
+	double dx, dy;
+};
+
+/**
+ * Label each voxel with the label of the closest seed, the seeds move a
+ * little from section to section.
+ */
+boost::shared_ptr<ImageStack> createStack(const std::vector<Seed>& seeds, const std::vector<float>& labels) {
+
+	boost::shared_ptr<ImageStack> stack = boost::make_shared<ImageStack>();
+
+	for (unsigned int z = 0; z < Depth; z++) {
+
+		boost::shared_ptr<Image> section = boost::make_shared<Image>(Width, Height, 0);
+
+		for (unsigned int y = 0; y < Height; y++)
+			for (unsigned int x = 0; x < Width; x++) {
+
+				double       minDistance = -1;
+				unsigned int closest     = 0;
+
+				for (unsigned int s = 0; s < seeds.size(); s++) {
+
+					double sx = seeds[s].x + z*seeds[s].dx;
+					double sy = seeds[s].y + z*seeds[s].dy;
+
+					double distance = (x - sx)*(x - sx) + (y - sy)*(y - sy);
+
+					if (minDistance < 0 || distance < minDistance) {
+
+						minDistance = distance;
+						closest     = s;
+					}
+				}
+
+				(*section)(x, y) = labels[closest];
+			}
+
+		stack->add(section);
+	}
+
+	return stack;
+}
+
+/**
+ * Copy a stack, such that the copy can be changed without changing the
+ * original images.
+ */
+boost::shared_ptr<ImageStack> copyStack(const ImageStack& stack) {
+
+	boost::shared_ptr<ImageStack> copy = boost::make_shared<ImageStack>();
+
+	for (unsigned int z = 0; z < stack.size(); z++) {
+
+		boost::shared_ptr<Image> section = boost::make_shared<Image>(Width, Height, 0);
+
+		for (unsigned int y = 0; y < Height; y++)
+			for (unsigned int x = 0; x < Width; x++)
+				(*section)(x, y) = (*stack[z])(x, y);
+
+		copy->add(section);
+	}
+
+	return copy;
+}
+
+/**
+ * Give a box of the reconstruction a single label: the label of its center
+ * (which grows that label), or a new label (which splits it).
+ */
+void changeBox(ImageStack& stack, SampleGenerator& generator, float newLabel) {
+
+	unsigned int minX = generator.next()*(Width  - ChangeWidth);
+	unsigned int minY = generator.next()*(Height - ChangeHeight);
+	unsigned int minZ = generator.next()*(Depth  - ChangeDepth);
+
+	float label = newLabel;
+	if (generator.next() < 0.5)
+		label = (*stack[minZ + ChangeDepth/2])(minX + ChangeWidth/2, minY + ChangeHeight/2);
+
+	for (unsigned int z = minZ; z < minZ + ChangeDepth; z++)
+		for (unsigned int y = minY; y < minY + ChangeHeight; y++)
+			for (unsigned int x = minX; x < minX + ChangeWidth; x++)
+				(*stack[z])(x, y) = label;
+}
+
+bool equal(TolerantEditDistanceErrors& full, TolerantEditDistanceErrors& incremental, unsigned int change) {
+
+	bool same =
+			full.getNumSplits()         == incremental.getNumSplits() &&
+			full.getNumMerges()         == incremental.getNumMerges() &&
+			full.getNumFalsePositives() == incremental.getNumFalsePositives() &&
+			full.getNumFalseNegatives() == incremental.getNumFalseNegatives();
+
+	std::cout
+			<< "change " << change << ": "
+			<< full.getNumSplits() << "/" << incremental.getNumSplits() << " splits, "
+			<< full.getNumMerges() << "/" << incremental.getNumMerges() << " merges, "
+			<< full.getNumFalsePositives() << "/" << incremental.getNumFalsePositives() << " false positives, "
+			<< full.getNumFalseNegatives() << "/" << incremental.getNumFalseNegatives() << " false negatives "
+			<< "(full/incremental)" << (same ? "" : " -- differ") << std::endl;
+
+	return same;
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		// init command line parser
+		util::ProgramOptions::init(argc, argv);
+
+		// init logger
+		logger::LogManager::init();
+
+		SampleGenerator generator(42);
+
+		// the ground truth
+		std::vector<Seed>  seeds(NumSeeds);
+		std::vector<float> gtLabels(NumSeeds);
+		for (unsigned int s = 0; s < NumSeeds; s++) {
+
+			seeds[s].x  = generator.next()*Width;
+			seeds[s].y  = generator.next()*Height;
+			seeds[s].dx = generator.next()*4 - 2;
+			seeds[s].dy = generator.next()*4 - 2;
+			gtLabels[s] = s + 1;
+		}
+
+		boost::shared_ptr<ImageStack> groundTruth = createStack(seeds, gtLabels);
+
+		// the reconstruction, with shifted boundaries, a merge, and a split
+		std::vector<Seed>  recSeeds = seeds;
+		std::vector<float> recLabels(NumSeeds);
+		for (unsigned int s = 0; s < NumSeeds; s++) {
+
+			recSeeds[s].x += generator.next()*6 - 3;
+			recSeeds[s].y += generator.next()*6 - 3;
+			recLabels[s] = 100 + s;
+		}
+		recLabels[1] = recLabels[0];
+
+		Seed split = seeds[2];
+		split.x += 8;
+		recSeeds.push_back(split);
+		recLabels.push_back(100 + NumSeeds);
+
+		boost::shared_ptr<ImageStack> reconstruction = createStack(recSeeds, recLabels);
+
+		// the baseline
+		pipeline::Process<TolerantEditDistance> ted;
+		ted->setInput("ground truth", groundTruth);
+		ted->setInput("reconstruction", reconstruction);
+
+		pipeline::Value<TolerantEditDistanceErrors> baselineErrors = ted->getOutput("errors");
+
+		std::cout
+				<< "baseline: "
+				<< baselineErrors->getNumSplits() << " splits, "
+				<< baselineErrors->getNumMerges() << " merges" << std::endl;
+
+		bool passed = true;
+
+		for (unsigned int change = 0; change < NumChanges; change++) {
+
+			boost::shared_ptr<ImageStack> changed = copyStack(*reconstruction);
+			changeBox(*changed, generator, 200 + change);
+
+			boost::shared_ptr<TolerantEditDistanceErrors> incrementalErrors = ted->getIncrementalErrors(changed);
+
+			pipeline::Process<TolerantEditDistance> fullTed;
+			fullTed->setInput("ground truth", groundTruth);
+			fullTed->setInput("reconstruction", changed);
+
+			pipeline::Value<TolerantEditDistanceErrors> fullErrors = fullTed->getOutput("errors");
+
+			passed &= equal(*fullErrors, *incrementalErrors, change);
+		}
+
+		return (passed ? 0 : 1);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+
+		return 1;
+	}
+}
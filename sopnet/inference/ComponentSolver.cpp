@@ -0,0 +1,395 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/timer/timer.hpp>
+
+#include <pipeline/Value.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include <util/foreach.h>
+#include <util/ParallelFor.h>
+#include "LinearSolver.h"
+#include "SolverStatistics.h"
+#include "ComponentSolver.h"
+
+static logger::LogChannel componentsolverlog("componentsolverlog", "[ComponentSolver] ");
+
+util::ProgramOption optionComponentSolverNumThreads(
+		util::_module           = "inference.components",
+		util::_long_name        = "componentSolverNumThreads",
+		util::_description_text = "The number of components to solve in parallel. The default (0) uses all available CPUs.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionMaxEnumerationVariables(
+		util::_module           = "inference.components",
+		util::_long_name        = "maxEnumerationVariables",
+		util::_description_text = "Components with at most this many binary variables are solved by enumerating all assignments.",
+		util::_default_value    = 10);
+
+// tolerance for the comparison of activities and right hand sides
+static const double Epsilon = 1e-9;
+
+ComponentSolver::ComponentSolver() :
+	_solution(new Solution()) {
+
+	registerInput(_objective, "objective");
+	registerInput(_linearConstraints, "linear constraints");
+	registerInput(_parameters, "parameters", pipeline::Optional);
+
+	registerOutput(_solution, "solution");
+}
+
+void
+ComponentSolver::updateOutputs() {
+
+	boost::timer::auto_cpu_timer timer("\tComponentSolver::updateOutputs()\t%ws\n");
+
+	// get the number of variables (as in the LinearSolver)
+	_numVariables = _objective->getCoefficients().size();
+
+	unsigned int varNum;
+	double coef;
+	foreach (const LinearConstraint& constraint, *_linearConstraints)
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			_numVariables = std::max(_numVariables, varNum + 1);
+
+	_solution->resize(_numVariables);
+
+	findComponents();
+
+	// solve the small components right away and collect the others
+	_solverComponents.clear();
+
+	unsigned int numEnumerated = 0;
+	for (unsigned int i = 0; i < _components.size(); i++) {
+
+		if (isEnumerable(_components[i]) && enumerate(_components[i])) {
+
+			numEnumerated++;
+			continue;
+		}
+
+		_solverComponents.push_back(i);
+	}
+
+	// start with the largest components to balance the load
+	std::vector<std::pair<unsigned int, unsigned int> > order;
+	foreach (unsigned int i, _solverComponents)
+		order.push_back(std::make_pair(_components[i].variables.size(), i));
+	std::sort(order.rbegin(), order.rend());
+	for (unsigned int i = 0; i < order.size(); i++)
+		_solverComponents[i] = order[i].second;
+
+	unsigned int numThreads = getNumThreads(optionComponentSolverNumThreads.as<unsigned int>(), _solverComponents.size());
+
+	LOG_USER(componentsolverlog)
+			<< "split problem with " << _numVariables << " variables into "
+			<< _components.size() << " components, enumerated "
+			<< numEnumerated << ", solving " << _solverComponents.size()
+			<< " with " << numThreads << " threads" << std::endl;
+
+	// each thread owns its own solver
+	_solvers.clear();
+	for (unsigned int i = 0; i < numThreads; i++)
+		_solvers.push_back(boost::make_shared<LinearSolver>());
+
+	// one flag per job, such that the threads don't share any memory
+	_solved.assign(_solverComponents.size(), false);
+
+	parallelFor(
+			_solverComponents.size(),
+			numThreads,
+			boost::bind(&ComponentSolver::solveComponentJob, this, _1, _2));
+
+	_solvers.clear();
+
+	unsigned int numFailed = 0;
+	for (unsigned int i = 0; i < _solverComponents.size(); i++) {
+
+		if (_solved[i])
+			continue;
+
+		// don't select anything from a component without solution
+		foreach (unsigned int varNum, _components[_solverComponents[i]].variables)
+			(*_solution)[varNum] = 0.0;
+
+		numFailed++;
+	}
+
+	if (numFailed > 0)
+		LOG_ERROR(componentsolverlog)
+				<< "failed to solve " << numFailed << " of " << _solverComponents.size()
+				<< " components, their variables are set to zero" << std::endl;
+}
+
+void
+ComponentSolver::findComponents() {
+
+	_parents.resize(_numVariables);
+	for (unsigned int i = 0; i < _numVariables; i++)
+		_parents[i] = i;
+
+	unsigned int varNum;
+	double coef;
+	foreach (const LinearConstraint& constraint, *_linearConstraints) {
+
+		if (constraint.getCoefficients().empty())
+			continue;
+
+		unsigned int first = constraint.getCoefficients().begin()->first;
+
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			unite(first, varNum);
+	}
+
+	// enumerate the components
+	std::vector<unsigned int> componentNums(_numVariables, std::numeric_limits<unsigned int>::max());
+
+	_components.clear();
+
+	for (unsigned int i = 0; i < _numVariables; i++) {
+
+		unsigned int root = findRoot(i);
+
+		if (componentNums[root] == std::numeric_limits<unsigned int>::max()) {
+
+			componentNums[root] = _components.size();
+			_components.push_back(Component());
+		}
+
+		_components[componentNums[root]].variables.push_back(i);
+	}
+
+	for (unsigned int i = 0; i < _linearConstraints->size(); i++) {
+
+		const LinearConstraint& constraint = (*_linearConstraints)[i];
+
+		if (constraint.getCoefficients().empty())
+			continue;
+
+		unsigned int root = findRoot(constraint.getCoefficients().begin()->first);
+
+		_components[componentNums[root]].constraints.push_back(i);
+	}
+}
+
+unsigned int
+ComponentSolver::findRoot(unsigned int varNum) {
+
+	// path halving
+	while (_parents[varNum] != varNum) {
+
+		_parents[varNum] = _parents[_parents[varNum]];
+		varNum = _parents[varNum];
+	}
+
+	return varNum;
+}
+
+void
+ComponentSolver::unite(unsigned int varNum1, unsigned int varNum2) {
+
+	unsigned int root1 = findRoot(varNum1);
+	unsigned int root2 = findRoot(varNum2);
+
+	if (root1 == root2)
+		return;
+
+	// keep the smaller variable as root
+	if (root1 < root2)
+		_parents[root2] = root1;
+	else
+		_parents[root1] = root2;
+}
+
+bool
+ComponentSolver::isEnumerable(const Component& component) {
+
+	// more than 2^20 assignments are not worth trying
+	unsigned int maxEnumerationVariables = std::min(optionMaxEnumerationVariables.as<unsigned int>(), 20u);
+
+	if (component.variables.size() > maxEnumerationVariables)
+		return false;
+
+	if (!_parameters.isSet())
+		return false;
+
+	foreach (unsigned int varNum, component.variables)
+		if (_parameters->getVariableType(varNum) != Binary)
+			return false;
+
+	return true;
+}
+
+bool
+ComponentSolver::enumerate(const Component& component) {
+
+	const std::vector<double>& coefs = _objective->getCoefficients();
+
+	unsigned int numVariables = component.variables.size();
+	double       sense        = (_objective->getSense() == Minimize ? 1.0 : -1.0);
+
+	// the constraints in terms of bit positions of the assignment
+	std::map<unsigned int, unsigned int> positions;
+	for (unsigned int i = 0; i < numVariables; i++)
+		positions[component.variables[i]] = i;
+
+	std::vector<std::vector<std::pair<unsigned int, double> > > terms(component.constraints.size());
+
+	unsigned int varNum;
+	double coef;
+	for (unsigned int j = 0; j < component.constraints.size(); j++)
+		foreach (boost::tie(varNum, coef), (*_linearConstraints)[component.constraints[j]].getCoefficients())
+			terms[j].push_back(std::make_pair(positions[varNum], coef));
+
+	double       bestValue = std::numeric_limits<double>::infinity();
+	unsigned int bestAssignment = 0;
+	bool         feasible = false;
+
+	for (unsigned int assignment = 0; assignment < (1u << numVariables); assignment++) {
+
+		bool satisfied = true;
+
+		for (unsigned int j = 0; j < component.constraints.size(); j++) {
+
+			const LinearConstraint& constraint = (*_linearConstraints)[component.constraints[j]];
+
+			double activity = 0;
+			unsigned int position;
+			foreach (boost::tie(position, coef), terms[j])
+				if (assignment & (1u << position))
+					activity += coef;
+
+			switch (constraint.getRelation()) {
+
+				case LessEqual:
+					satisfied = (activity <= constraint.getValue() + Epsilon);
+					break;
+				case Equal:
+					satisfied = (std::abs(activity - constraint.getValue()) <= Epsilon);
+					break;
+				case GreaterEqual:
+					satisfied = (activity >= constraint.getValue() - Epsilon);
+					break;
+			}
+
+			if (!satisfied)
+				break;
+		}
+
+		if (!satisfied)
+			continue;
+
+		double value = 0;
+		for (unsigned int i = 0; i < numVariables; i++)
+			if (assignment & (1u << i) && component.variables[i] < coefs.size())
+				value += sense*coefs[component.variables[i]];
+
+		if (!feasible || value < bestValue) {
+
+			bestValue      = value;
+			bestAssignment = assignment;
+			feasible       = true;
+		}
+	}
+
+	if (!feasible)
+		return false;
+
+	for (unsigned int i = 0; i < numVariables; i++)
+		(*_solution)[component.variables[i]] = ((bestAssignment & (1u << i)) ? 1.0 : 0.0);
+
+	return true;
+}
+
+void
+ComponentSolver::solveComponentJob(unsigned int i, unsigned int thread) {
+
+	_solved[i] = solveComponent(_components[_solverComponents[i]], *_solvers[thread]);
+}
+
+bool
+ComponentSolver::solveComponent(const Component& component, LinearSolver& solver) {
+
+	const std::vector<double>& coefs = _objective->getCoefficients();
+
+	unsigned int numVariables = component.variables.size();
+
+	// the position of each variable in the component
+	std::map<unsigned int, unsigned int> positions;
+	for (unsigned int i = 0; i < numVariables; i++)
+		positions[component.variables[i]] = i;
+
+	boost::shared_ptr<LinearObjective>        objective   = boost::make_shared<LinearObjective>(numVariables);
+	boost::shared_ptr<LinearConstraints>      constraints = boost::make_shared<LinearConstraints>();
+	boost::shared_ptr<LinearSolverParameters> parameters  = boost::make_shared<LinearSolverParameters>();
+
+	objective->setSense(_objective->getSense());
+
+	// keep the termination criteria of the whole problem, the variable types 
+	// are set per variable below
+	if (_parameters.isSet()) {
+
+		parameters->setVariableType(_parameters->getDefaultVariableType());
+		parameters->setTimeLimit(_parameters->getTimeLimit());
+		parameters->setOptimalityGap(_parameters->getOptimalityGap());
+		parameters->setRelaxed(_parameters->isRelaxed());
+	}
+
+	for (unsigned int i = 0; i < numVariables; i++) {
+
+		unsigned int varNum = component.variables[i];
+
+		if (varNum < coefs.size())
+			objective->setCoefficient(i, coefs[varNum]);
+
+		if (_parameters.isSet())
+			parameters->setVariableType(i, _parameters->getVariableType(varNum));
+	}
+
+	unsigned int varNum;
+	double coef;
+	foreach (unsigned int i, component.constraints) {
+
+		const LinearConstraint& constraint = (*_linearConstraints)[i];
+
+		LinearConstraint componentConstraint;
+		componentConstraint.setRelation(constraint.getRelation());
+		componentConstraint.setValue(constraint.getValue());
+
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			componentConstraint.setCoefficient(positions[varNum], coef);
+
+		constraints->add(componentConstraint);
+	}
+
+	solver.setInput("objective", objective);
+	solver.setInput("linear constraints", constraints);
+	solver.setInput("parameters", parameters);
+
+	pipeline::Value<Solution>         componentSolution = solver.getOutput("solution");
+	pipeline::Value<SolverStatistics> statistics        = solver.getOutput("statistics");
+
+	// the solver is reused for the next component, its solution is only
+	// valid if it found one
+	if (statistics->getStatus() != SolverStatistics::Optimal &&
+	    statistics->getStatus() != SolverStatistics::TimeLimit)
+		return false;
+
+	if (componentSolution->size() < numVariables) {
+
+		LOG_ERROR(componentsolverlog)
+				<< "solution of a component has " << componentSolution->size()
+				<< " instead of " << numVariables << " variables" << std::endl;
+
+		return false;
+	}
+
+	for (unsigned int i = 0; i < numVariables; i++)
+		(*_solution)[component.variables[i]] = (*componentSolution)[i];
+
+	return true;
+}
@@ -0,0 +1,97 @@
+#ifndef INFERENCE_COMPONENT_SOLVER_H__
+#define INFERENCE_COMPONENT_SOLVER_H__
+
+#include <boost/shared_ptr.hpp>
+
+#include <pipeline/all.h>
+#include "LinearConstraints.h"
+#include "LinearObjective.h"
+#include "LinearSolverParameters.h"
+#include "Solution.h"
+
+// forward declaration
+class LinearSolver;
+
+/**
+ * Drop-in replacement for the LinearSolver that splits the linear program
+ * into the connected components of its variable/constraint incidence graph
+ * and solves them independently. Components with only a few binary
+ * variables are solved by enumerating all assignments, all others are
+ * solved concurrently with one LinearSolver per thread. The component
+ * solutions are merged into a single solution.
+ *
+ * Inputs:
+ *
+ *   objective          : LinearObjective
+ *   linear constraints : LinearConstraints
+ *   parameters         : LinearSolverParameters (optional)
+ *
+ * Outputs:
+ *
+ *   solution           : Solution
+ */
+class ComponentSolver : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	ComponentSolver();
+
+private:
+
+	struct Component {
+
+		std::vector<unsigned int> variables;
+		std::vector<unsigned int> constraints;
+	};
+
+	void updateOutputs();
+
+	// find the connected components of the incidence graph
+	void findComponents();
+
+	// union-find on the variables
+	unsigned int findRoot(unsigned int varNum);
+	void unite(unsigned int varNum1, unsigned int varNum2);
+
+	// try all assignments of a binary component, returns false if none of
+	// them is feasible
+	bool enumerate(const Component& component);
+
+	// solve the i-th of the components to be solved with the LinearSolver,
+	// using the solver of the given thread
+	void solveComponentJob(unsigned int i, unsigned int thread);
+
+	// solve a single component with a LinearSolver, returns false if the
+	// solver did not find a solution
+	bool solveComponent(const Component& component, LinearSolver& solver);
+
+	// is the component small enough and binary, such that we can enumerate
+	// its assignments?
+	bool isEnumerable(const Component& component);
+
+	pipeline::Input<LinearObjective>        _objective;
+	pipeline::Input<LinearConstraints>      _linearConstraints;
+	pipeline::Input<LinearSolverParameters> _parameters;
+
+	pipeline::Output<Solution> _solution;
+
+	unsigned int _numVariables;
+
+	// the parents of the variables in the union-find forest
+	std::vector<unsigned int> _parents;
+
+	std::vector<Component> _components;
+
+	// the components to be solved with the LinearSolver
+	std::vector<unsigned int> _solverComponents;
+
+	// one LinearSolver per thread
+	std::vector<boost::shared_ptr<LinearSolver> > _solvers;
+
+	// whether the solver found a solution for each of the solver components
+	// (not a vector<bool>, the threads write concurrently)
+	std::vector<char> _solved;
+};
+
+#endif // INFERENCE_COMPONENT_SOLVER_H__
+
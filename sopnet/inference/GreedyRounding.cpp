@@ -0,0 +1,408 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <boost/timer/timer.hpp>
+
+#include <util/Logger.h>
+#include <util/foreach.h>
+#include "GreedyRounding.h"
+
+static logger::LogChannel greedyroundinglog("greedyroundinglog", "[GreedyRounding] ");
+
+// tolerance for the comparison of activities and right hand sides
+static const double Epsilon = 1e-6;
+
+GreedyRounding::GreedyRounding() :
+	_solution(new Solution()),
+	_statistics(new SolverStatistics()) {
+
+	registerInput(_objective, "objective");
+	registerInput(_linearConstraints, "linear constraints");
+	registerInput(_relaxedSolution, "relaxed solution");
+
+	registerOutput(_solution, "solution");
+	registerOutput(_statistics, "statistics");
+}
+
+void
+GreedyRounding::updateOutputs() {
+
+	boost::timer::auto_cpu_timer timer("\tGreedyRounding::updateOutputs()\t%ws\n");
+
+	createColumns();
+
+	_solution->resize(_numVariables);
+	std::fill(_solution->getVector().begin(), _solution->getVector().end(), 0.0);
+
+	_activities.assign(_linearConstraints->size(), 0.0);
+	_banned.assign(_numVariables, false);
+
+	selectGreedily();
+
+	unsigned int numUnrepaired = repairConstraints();
+
+	std::vector<double> relaxed(_numVariables, 0.0);
+	for (unsigned int i = 0; i < std::min(_numVariables, _relaxedSolution->size()); i++)
+		relaxed[i] = (*_relaxedSolution)[i];
+
+	double value = getValue(_solution->getVector());
+
+	// without a relaxation, there is no bound
+	double bound = (_relaxedSolution->size() > 0 ? getValue(relaxed) : value);
+
+	_statistics->clear();
+	_statistics->setValue(value);
+	_statistics->setBound(bound);
+	_statistics->setStatus(numUnrepaired == 0 ? SolverStatistics::Heuristic : SolverStatistics::Failed);
+
+	if (numUnrepaired > 0)
+		LOG_ERROR(greedyroundinglog)
+				<< numUnrepaired << " constraints are still violated after rounding"
+				<< std::endl;
+
+	LOG_USER(greedyroundinglog)
+			<< "rounded solution has value " << value << ", relaxation has value "
+			<< bound << ", integrality gap is " << _statistics->getGap() << std::endl;
+}
+
+void
+GreedyRounding::createColumns() {
+
+	_numVariables = _objective->getCoefficients().size();
+
+	unsigned int varNum;
+	double coef;
+	foreach (const LinearConstraint& constraint, *_linearConstraints)
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			_numVariables = std::max(_numVariables, varNum + 1);
+
+	_columns.clear();
+	_columns.resize(_numVariables);
+
+	for (unsigned int i = 0; i < _linearConstraints->size(); i++)
+		foreach (boost::tie(varNum, coef), (*_linearConstraints)[i].getCoefficients())
+			_columns[varNum].push_back(std::make_pair(i, coef));
+}
+
+void
+GreedyRounding::selectGreedily() {
+
+	bool haveRelaxation = (_relaxedSolution->size() > 0);
+
+	if (!haveRelaxation)
+		LOG_USER(greedyroundinglog)
+				<< "there is no relaxed solution, selecting variables by their costs"
+				<< std::endl;
+
+	// sort by relaxed value (descending), then by cost (ascending)
+	std::vector<std::pair<std::pair<double, double>, unsigned int> > order;
+	for (unsigned int i = 0; i < _numVariables; i++)
+		if (getRelaxedValue(i) > Epsilon || (!haveRelaxation && getCost(i) < 0))
+			order.push_back(std::make_pair(std::make_pair(-getRelaxedValue(i), getCost(i)), i));
+
+	std::sort(order.begin(), order.end());
+
+	unsigned int numSelected = 0;
+	for (unsigned int i = 0; i < order.size(); i++) {
+
+		unsigned int varNum = order[i].second;
+
+		if (!canSelect(varNum, std::numeric_limits<unsigned int>::max()))
+			continue;
+
+		setVariable(varNum, 1.0);
+		numSelected++;
+	}
+
+	LOG_DEBUG(greedyroundinglog)
+			<< "selected " << numSelected << " of " << order.size()
+			<< " variables with positive relaxed value" << std::endl;
+}
+
+unsigned int
+GreedyRounding::repairConstraints() {
+
+	_violated.clear();
+	for (unsigned int i = 0; i < _linearConstraints->size(); i++)
+		_violated.push_back(i);
+
+	unsigned int numSelected   = 0;
+	unsigned int numDeselected = 0;
+	unsigned int numUnrepaired = 0;
+
+	// every variable is selected and deselected at most once during the
+	// repair, and every change queues a finite number of constraints
+	while (!_violated.empty()) {
+
+		unsigned int constraintNum = _violated.front();
+		_violated.pop_front();
+
+		double missing = getMissing(constraintNum);
+
+		if (std::abs(missing) <= Epsilon)
+			continue;
+
+		if (repairBySelection(constraintNum, missing)) {
+
+			numSelected++;
+
+		} else if (repairByDeselection(constraintNum, missing)) {
+
+			numDeselected++;
+
+		} else {
+
+			numUnrepaired++;
+			continue;
+		}
+
+		// the constraint might need more changes
+		_violated.push_back(constraintNum);
+	}
+
+	LOG_DEBUG(greedyroundinglog)
+			<< "repaired constraints by selecting " << numSelected
+			<< " and deselecting " << numDeselected << " variables" << std::endl;
+
+	return numUnrepaired;
+}
+
+bool
+GreedyRounding::repairBySelection(unsigned int constraintNum, double missing) {
+
+	unsigned int best = std::numeric_limits<unsigned int>::max();
+
+	// the best variable fixes the most and violates the fewest other 
+	// constraints, then has the highest relaxed value, then the lowest cost
+	std::pair<int, std::pair<double, double> > bestScore;
+
+	unsigned int varNum;
+	double coef;
+	foreach (boost::tie(varNum, coef), (*_linearConstraints)[constraintNum].getCoefficients()) {
+
+		if ((*_solution)[varNum] > 0.5 || _banned[varNum])
+			continue;
+
+		// never select a variable with infinite costs
+		if (getCost(varNum) == std::numeric_limits<double>::infinity())
+			continue;
+
+		// does the variable change the activity in the right direction without
+		// overshooting?
+		if (coef*missing <= 0 || std::abs(coef) > std::abs(missing) + Epsilon)
+			continue;
+
+		if (!canSelect(varNum, constraintNum))
+			continue;
+
+		std::pair<int, std::pair<double, double> > score =
+				std::make_pair(
+						getBalance(varNum, constraintNum),
+						std::make_pair(-getRelaxedValue(varNum), getCost(varNum)));
+
+		if (best != std::numeric_limits<unsigned int>::max() && !(score < bestScore))
+			continue;
+
+		best      = varNum;
+		bestScore = score;
+	}
+
+	if (best == std::numeric_limits<unsigned int>::max())
+		return false;
+
+	setVariable(best, 1.0);
+
+	// the other constraints of the variable might be violated now
+	queueViolated(best, constraintNum);
+
+	return true;
+}
+
+bool
+GreedyRounding::repairByDeselection(unsigned int constraintNum, double missing) {
+
+	unsigned int best          = std::numeric_limits<unsigned int>::max();
+	double       bestCertainty = std::numeric_limits<double>::infinity();
+
+	unsigned int varNum;
+	double coef;
+	foreach (boost::tie(varNum, coef), (*_linearConstraints)[constraintNum].getCoefficients()) {
+
+		if ((*_solution)[varNum] < 0.5)
+			continue;
+
+		if (coef*missing >= 0)
+			continue;
+
+		double certainty = getRelaxedValue(varNum);
+
+		if (certainty >= bestCertainty)
+			continue;
+
+		best          = varNum;
+		bestCertainty = certainty;
+	}
+
+	if (best == std::numeric_limits<unsigned int>::max())
+		return false;
+
+	setVariable(best, 0.0);
+	_banned[best] = true;
+
+	// the other constraints of the variable might be violated now
+	queueViolated(best, constraintNum);
+
+	return true;
+}
+
+void
+GreedyRounding::setVariable(unsigned int varNum, double value) {
+
+	double change = value - (*_solution)[varNum];
+
+	(*_solution)[varNum] = value;
+
+	unsigned int constraintNum;
+	double coef;
+	foreach (boost::tie(constraintNum, coef), _columns[varNum])
+		_activities[constraintNum] += coef*change;
+}
+
+bool
+GreedyRounding::canSelect(unsigned int varNum, unsigned int ignoreConstraintNum) {
+
+	unsigned int constraintNum;
+	double coef;
+	foreach (boost::tie(constraintNum, coef), _columns[varNum]) {
+
+		if (constraintNum == ignoreConstraintNum)
+			continue;
+
+		const LinearConstraint& constraint = (*_linearConstraints)[constraintNum];
+
+		double activity = _activities[constraintNum] + coef;
+
+		switch (constraint.getRelation()) {
+
+			case LessEqual:
+				if (activity > constraint.getValue() + Epsilon)
+					return false;
+				break;
+
+			case GreaterEqual:
+				if (coef < 0 && activity < constraint.getValue() - Epsilon)
+					return false;
+				break;
+
+			case Equal:
+				// a satisfied equality can be violated (and repaired later), 
+				// but a violated one must not get worse, e.g., a slice must 
+				// not be used twice from the same side
+				if (std::abs(_activities[constraintNum] - constraint.getValue()) > Epsilon &&
+				    std::abs(activity - constraint.getValue()) > std::abs(_activities[constraintNum] - constraint.getValue()) + Epsilon)
+					return false;
+				break;
+		}
+	}
+
+	return true;
+}
+
+int
+GreedyRounding::getBalance(unsigned int varNum, unsigned int ignoreConstraintNum) {
+
+	int balance = 0;
+
+	unsigned int constraintNum;
+	double coef;
+	foreach (boost::tie(constraintNum, coef), _columns[varNum]) {
+
+		if (constraintNum == ignoreConstraintNum)
+			continue;
+
+		bool before = isSatisfied(constraintNum);
+
+		_activities[constraintNum] += coef;
+		bool after = isSatisfied(constraintNum);
+		_activities[constraintNum] -= coef;
+
+		if (before && !after)
+			balance++;
+		if (!before && after)
+			balance--;
+	}
+
+	return balance;
+}
+
+void
+GreedyRounding::queueViolated(unsigned int varNum, unsigned int ignoreConstraintNum) {
+
+	unsigned int constraintNum;
+	double coef;
+	foreach (boost::tie(constraintNum, coef), _columns[varNum])
+		if (constraintNum != ignoreConstraintNum && !isSatisfied(constraintNum))
+			_violated.push_back(constraintNum);
+}
+
+bool
+GreedyRounding::isSatisfied(unsigned int constraintNum) {
+
+	return std::abs(getMissing(constraintNum)) <= Epsilon;
+}
+
+double
+GreedyRounding::getMissing(unsigned int constraintNum) {
+
+	const LinearConstraint& constraint = (*_linearConstraints)[constraintNum];
+
+	double missing = constraint.getValue() - _activities[constraintNum];
+
+	switch (constraint.getRelation()) {
+
+		case LessEqual:
+			return std::min(0.0, missing);
+
+		case GreaterEqual:
+			return std::max(0.0, missing);
+
+		default:
+			return missing;
+	}
+}
+
+double
+GreedyRounding::getRelaxedValue(unsigned int varNum) {
+
+	if (varNum >= _relaxedSolution->size())
+		return 0;
+
+	return (*_relaxedSolution)[varNum];
+}
+
+double
+GreedyRounding::getValue(const std::vector<double>& x) {
+
+	const std::vector<double>& coefs = _objective->getCoefficients();
+
+	double value = _objective->getConstant();
+
+	for (unsigned int i = 0; i < std::min(coefs.size(), x.size()); i++)
+		// don't multiply infinite costs with zero
+		if (x[i] != 0)
+			value += coefs[i]*x[i];
+
+	return value;
+}
+
+double
+GreedyRounding::getCost(unsigned int varNum) {
+
+	const std::vector<double>& coefs = _objective->getCoefficients();
+
+	if (varNum >= coefs.size())
+		return 0;
+
+	return (_objective->getSense() == Minimize ? coefs[varNum] : -coefs[varNum]);
+}
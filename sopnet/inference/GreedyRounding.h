@@ -0,0 +1,129 @@
+#ifndef INFERENCE_GREEDY_ROUNDING_H__
+#define INFERENCE_GREEDY_ROUNDING_H__
+
+#include <deque>
+
+#include <pipeline/all.h>
+#include "LinearConstraints.h"
+#include "LinearObjective.h"
+#include "Solution.h"
+#include "SolverStatistics.h"
+
+/**
+ * Rounds the solution of the linear relaxation of a binary program to a
+ * feasible binary solution. Variables are selected greedily in the order of
+ * their relaxed values, as long as no less-or-equal constraint (like a
+ * conflict set) is violated and no violated equality constraint gets worse.
+ * For the slice continuity constraints, this means that each side of a slice
+ * is used by at most one segment.
+ *
+ * Afterwards, the violated constraints (like slices that are used from one
+ * side only) are repaired row by row. A violated row is fixed by selecting
+ * the variable that fixes the most and violates the fewest other equality
+ * rows, such that a continuation or branch can close two open slices at once
+ * or extend an open slice to the next section, where it is repaired in turn.
+ * If no variable can be selected, the least certain variable that causes
+ * the violation is deselected.
+ *
+ * If there is no relaxed solution (e.g., because the relaxation hit a time
+ * limit), variables with negative costs are selected in the order of their
+ * costs instead.
+ *
+ * Inputs:
+ *
+ *   objective          : LinearObjective
+ *   linear constraints : LinearConstraints
+ *   relaxed solution   : Solution
+ *
+ * Outputs:
+ *
+ *   solution           : Solution
+ *   statistics         : SolverStatistics
+ *
+ * The statistics contain the value of the rounded solution and the value of
+ * the relaxation as bound, such that their gap is the integrality gap.
+ */
+class GreedyRounding : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	GreedyRounding();
+
+private:
+
+	typedef std::vector<std::pair<unsigned int, double> > column_type;
+
+	void updateOutputs();
+
+	// collect the constraints each variable is involved in
+	void createColumns();
+
+	// select variables in the order of their relaxed values
+	void selectGreedily();
+
+	// repair violated constraints, returns the number of constraints that
+	// could not be repaired
+	unsigned int repairConstraints();
+
+	// try to fix the given constraint by selecting a variable
+	bool repairBySelection(unsigned int constraintNum, double missing);
+
+	// try to fix the given constraint by deselecting a variable
+	bool repairByDeselection(unsigned int constraintNum, double missing);
+
+	// select or deselect a variable and update the activities
+	void setVariable(unsigned int varNum, double value);
+
+	// would selecting the variable violate a less-or-equal constraint or make
+	// a violated equality constraint worse, apart from the given constraint?
+	bool canSelect(unsigned int varNum, unsigned int ignoreConstraintNum);
+
+	// the number of equality constraints apart from the given one that get
+	// violated minus the number that get satisfied by selecting the variable
+	int getBalance(unsigned int varNum, unsigned int ignoreConstraintNum);
+
+	// queue the constraints of the variable that are violated, apart from the
+	// given one
+	void queueViolated(unsigned int varNum, unsigned int ignoreConstraintNum);
+
+	// is the constraint satisfied by the current activities?
+	bool isSatisfied(unsigned int constraintNum);
+
+	// the amount by which the activity of a constraint has to change to
+	// satisfy it
+	double getMissing(unsigned int constraintNum);
+
+	// the relaxed value of a variable, 0 if there is none
+	double getRelaxedValue(unsigned int varNum);
+
+	// the value of the objective for the given solution
+	double getValue(const std::vector<double>& x);
+
+	// the cost of selecting a variable, independent of the objective sense
+	double getCost(unsigned int varNum);
+
+	pipeline::Input<LinearObjective>   _objective;
+	pipeline::Input<LinearConstraints> _linearConstraints;
+	pipeline::Input<Solution>          _relaxedSolution;
+
+	pipeline::Output<Solution>         _solution;
+	pipeline::Output<SolverStatistics> _statistics;
+
+	unsigned int _numVariables;
+
+	// the constraints and coefficients of each variable
+	std::vector<column_type> _columns;
+
+	// the current activity of each constraint
+	std::vector<double> _activities;
+
+	// variables that have been deselected during the repair and must not be
+	// selected again
+	std::vector<bool> _banned;
+
+	// constraints that have to be checked during the repair
+	std::deque<unsigned int> _violated;
+};
+
+#endif // INFERENCE_GREEDY_ROUNDING_H__
+
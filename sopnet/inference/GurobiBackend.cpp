@@ -2,10 +2,13 @@
 
 #ifdef HAVE_GUROBI
 
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 
 #include <util/Logger.h>
 #include <util/ProgramOptions.h>
+#include <util/ParallelFor.h>
 #include "GurobiBackend.h"
 
 using namespace logger;
@@ -24,16 +27,26 @@ util::ProgramOption optionGurobiMIPFocus(
 		util::_description_text = "The Gurobi MIP focus: 0 = balanced, 1 = feasible solutions, 2 = optimal solution, 3 = bound.",
 		util::_default_value    = 0);
 
+util::ProgramOption optionGurobiTimeLimit(
+		util::_module           = "inference.gurobi",
+		util::_long_name        = "timeLimit",
+		util::_description_text = "Stop Gurobi after this many seconds and use the best solution found so far. The default (0) does not limit the time.",
+		util::_default_value    = 0);
+
 util::ProgramOption optionGurobiNumThreads(
 		util::_module           = "inference.gurobi",
 		util::_long_name        = "numThreads",
-		util::_description_text = "The number of threads to be used by Gurobi. The default (0) uses all available CPUs.",
+		util::_description_text = "The number of threads to be used by Gurobi. The default (0) uses all available CPUs. Solvers running in "
+		                          "parallel (e.g., in the grid search or for independent components) use at most their share of the CPUs.",
 		util::_default_value    = 0);
 
 
 GurobiBackend::GurobiBackend() :
 	_variables(0),
-	_model(_env) {
+	_model(_env),
+	_gurobiCallback(*this) {
+
+	_model.setCallback(&_gurobiCallback);
 }
 
 GurobiBackend::~GurobiBackend() {
@@ -70,7 +83,15 @@ GurobiBackend::initialize(
 	else
 		LOG_ERROR(gurobilog) << "Invalid value for MPI focus!" << std::endl;
 
-	setNumThreads(optionGurobiNumThreads);
+	// limit to the share of the CPUs of this thread, if we are one of many 
+	// solvers running in parallel
+	unsigned int numThreads = getNumThreads(optionGurobiNumThreads.as<unsigned int>(), 0);
+
+	LOG_DEBUG(gurobilog) << "using " << numThreads << " threads" << std::endl;
+
+	setNumThreads(numThreads);
+
+	setTimeLimit(optionGurobiTimeLimit);
 
 	_numVariables = numVariables;
 
@@ -112,6 +133,10 @@ GurobiBackend::initialize(
 			_variables[i].set(GRB_DoubleAttr_LB, -GRB_INFINITY);
 	}
 
+	_variableTypes.assign(
+			_numVariables,
+			(defaultVariableType == Binary ? 'B' : (defaultVariableType == Integer ? 'I' : 'C')));
+
 	// handle special variable types
 	unsigned int v;
 	VariableType type;
@@ -120,6 +145,7 @@ GurobiBackend::initialize(
 		char t = (type == Binary ? 'B' : (type == Integer ? 'I' : 'C'));
 		LOG_ALL(gurobilog) << "changing type of variable " << v << " to " << t << std::endl;
 		_variables[v].set(GRB_CharAttr_VType, t);
+		_variableTypes[v] = t;
 	}
 
 	LOG_DEBUG(gurobilog) << "creating " << _numVariables << " ceofficients" << std::endl;
@@ -173,7 +199,7 @@ GurobiBackend::setObjective(const QuadraticObjective& objective) {
 
 		_model.update();
 
-	} catch (GRBException e) {
+	} catch (GRBException& e) {
 
 		LOG_ERROR(gurobilog) << "error: " << e.getMessage() << endl;
 	}
@@ -189,12 +215,20 @@ GurobiBackend::setConstraints(const LinearConstraints& constraints) {
 
 	_model.update();
 
+	LOG_DEBUG(gurobilog) << "setting " << constraints.size() << " constraints" << std::endl;
+
+	addConstraints(constraints);
+}
+
+void
+GurobiBackend::addConstraints(const LinearConstraints& constraints) {
+
 	// allocate memory for new constraints
-	_constraints.reserve(constraints.size());
+	_constraints.reserve(_constraints.size() + constraints.size());
 
 	try {
 
-		LOG_DEBUG(gurobilog) << "setting " << constraints.size() << " constraints" << std::endl;
+		LOG_DEBUG(gurobilog) << "adding " << constraints.size() << " constraints" << std::endl;
 
 		unsigned int j = 0;
 		foreach (const LinearConstraint& constraint, constraints) {
@@ -225,7 +259,7 @@ GurobiBackend::setConstraints(const LinearConstraints& constraints) {
 
 		_model.update();
 
-	} catch (GRBException e) {
+	} catch (GRBException& e) {
 
 		LOG_ERROR(gurobilog) << "error: " << e.getMessage() << endl;
 	}
@@ -249,9 +283,73 @@ GurobiBackend::unpinVariable(unsigned int varNum) {
 	return pinned;
 }
 
+void
+GurobiBackend::setInitialSolution(const Solution& solution) {
+
+	try {
+
+		unsigned int numValues = std::min(_numVariables, solution.size());
+
+		LOG_DEBUG(gurobilog) << "setting start values for " << numValues << " variables" << std::endl;
+
+		for (unsigned int i = 0; i < numValues; i++)
+			_variables[i].set(GRB_DoubleAttr_Start, (std::isnan(solution[i]) ? GRB_UNDEFINED : solution[i]));
+
+		// variables without a start value are left to gurobi
+		for (unsigned int i = numValues; i < _numVariables; i++)
+			_variables[i].set(GRB_DoubleAttr_Start, GRB_UNDEFINED);
+
+	} catch (GRBException& e) {
+
+		LOG_ERROR(gurobilog) << "error: " << e.getMessage() << endl;
+	}
+}
+
+void
+GurobiBackend::setTimeLimit(double seconds) {
+
+	// gurobi's default is no limit
+	_model.getEnv().set(GRB_DoubleParam_TimeLimit, (seconds > 0 ? seconds : GRB_INFINITY));
+}
+
+void
+GurobiBackend::setOptimalityGap(double gap) {
+
+	setMIPGap(gap);
+}
+
+void
+GurobiBackend::setRelaxed(bool relaxed) {
+
+	LOG_DEBUG(gurobilog) << (relaxed ? "relaxing" : "restoring") << " variable types" << std::endl;
+
+	// binary variables keep their bounds of 0 and 1
+	for (unsigned int i = 0; i < _numVariables; i++)
+		_variables[i].set(GRB_CharAttr_VType, (relaxed ? 'C' : _variableTypes[i]));
+
+	_model.update();
+}
+
+void
+GurobiBackend::setIncumbentCallback(incumbent_callback_type callback) {
+
+	_incumbentCallback = callback;
+}
+
+void
+GurobiBackend::getStatistics(SolverStatistics& statistics) {
+
+	statistics.setStatus(_statistics.getStatus());
+	statistics.setRuntime(_statistics.getRuntime());
+	statistics.setValue(_statistics.getValue());
+	statistics.setBound(_statistics.getBound());
+}
+
 bool
 GurobiBackend::solve(Solution& x, double& value, std::string& msg) {
 
+	_statistics.clear();
+
 	try {
 
 		LOG_ALL(gurobilog) << "solving model " << _model.getObjective() << std::endl;
@@ -260,11 +358,15 @@ GurobiBackend::solve(Solution& x, double& value, std::string& msg) {
 
 		int status = _model.get(GRB_IntAttr_Status);
 
-		if (status != GRB_OPTIMAL) {
+		_statistics.setRuntime(_model.get(GRB_DoubleAttr_Runtime));
+
+		// is there a solution at all?
+		if (_model.get(GRB_IntAttr_SolCount) == 0) {
+
+			_statistics.setStatus(SolverStatistics::Failed);
 			msg = "Optimal solution *NOT* found";
 			return false;
-		} else
-			msg = "Optimal solution found";
+		}
 
 		// extract solution
 
@@ -275,10 +377,32 @@ GurobiBackend::solve(Solution& x, double& value, std::string& msg) {
 		// get current value of the objective
 		value = _model.get(GRB_DoubleAttr_ObjVal);
 
-	} catch (GRBException e) {
+		_statistics.setValue(value);
+		_statistics.setBound(_model.get(GRB_IntAttr_IsMIP) ? _model.get(GRB_DoubleAttr_ObjBound) : value);
+
+		if (status == GRB_TIME_LIMIT) {
+
+			_statistics.setStatus(SolverStatistics::TimeLimit);
+			msg = "Time limit reached";
+			return false;
+		}
+
+		if (status != GRB_OPTIMAL) {
+
+			_statistics.setStatus(SolverStatistics::Failed);
+			msg = "Optimal solution *NOT* found";
+			return false;
+		}
+
+		_statistics.setStatus(SolverStatistics::Optimal);
+		msg = "Optimal solution found";
+
+	} catch (GRBException& e) {
 
 		LOG_ERROR(gurobilog) << "error: " << e.getMessage() << endl;
 
+		_statistics.setStatus(SolverStatistics::Failed);
+
 		msg = e.getMessage();
 
 		return false;
@@ -287,6 +411,33 @@ GurobiBackend::solve(Solution& x, double& value, std::string& msg) {
 	return true;
 }
 
+void
+GurobiBackend::IncumbentCallback::callback() {
+
+	if (where != GRB_CB_MIPSOL || !_backend._incumbentCallback)
+		return;
+
+	try {
+
+		double* values = getSolution(_backend._variables, _backend._numVariables);
+
+		Solution incumbent(_backend._numVariables);
+		std::copy(values, values + _backend._numVariables, incumbent.getVector().begin());
+
+		delete[] values;
+
+		_backend._incumbentCallback(
+				incumbent,
+				getDoubleInfo(GRB_CB_MIPSOL_OBJ),
+				getDoubleInfo(GRB_CB_MIPSOL_OBJBND),
+				getDoubleInfo(GRB_CB_RUNTIME));
+
+	} catch (GRBException& e) {
+
+		LOG_ERROR(gurobilog) << "error in incumbent callback: " << e.getMessage() << endl;
+	}
+}
+
 void
 GurobiBackend::setMIPGap(double gap) {
 
@@ -327,7 +478,7 @@ GurobiBackend::dumpProblem(std::string filename) {
 
 		LOG_ALL(gurobilog) << _model.getObjective() << std::endl;
 
-	} catch (GRBException e) {
+	} catch (GRBException& e) {
 
 		LOG_ERROR(gurobilog) << "error: " << e.getMessage() << endl;
 	}
@@ -56,6 +56,8 @@ public:
 
 	void setConstraints(const LinearConstraints& constraints);
 
+	void addConstraints(const LinearConstraints& constraints);
+
 	/**
 	 * Force the value of a variable to be a given value, i.e., pin the variable 
 	 * to a fixed value.
@@ -78,10 +80,45 @@ public:
 	 */
 	bool unpinVariable(unsigned int varNum);
 
+	/**
+	 * Set the start values of the variables for the next MIP solve.
+	 *
+	 * @param solution
+	 *              The initial value for each variable.
+	 */
+	void setInitialSolution(const Solution& solution);
+
+	void setTimeLimit(double seconds);
+
+	void setOptimalityGap(double gap);
+
+	void setRelaxed(bool relaxed);
+
+	void setIncumbentCallback(incumbent_callback_type callback);
+
+	void getStatistics(SolverStatistics& statistics);
+
 	bool solve(Solution& solution, double& value, std::string& message);
 
 private:
 
+	// forwards new incumbents to the incumbent callback
+	class IncumbentCallback : public GRBCallback {
+
+	public:
+
+		IncumbentCallback(GurobiBackend& backend) :
+			_backend(backend) {}
+
+	protected:
+
+		void callback();
+
+	private:
+
+		GurobiBackend& _backend;
+	};
+
 	//////////////
 	// internal //
 	//////////////
@@ -118,10 +155,13 @@ private:
 	// the (binary) variables x
 	GRBVar* _variables;
 
+	// the types of the variables, to undo a relaxation
+	std::vector<char> _variableTypes;
+
 	// the objective
 	GRBQuadExpr _objective;
 
-	// all constraints set via setConstraints()
+	// all constraints set via setConstraints() or addConstraints()
 	std::vector<GRBConstr> _constraints;
 
 	// the GRB model containing the objective and constraints
@@ -132,6 +172,13 @@ private:
 
 	// a value by which to scale the objective
 	double _scale;
+
+	// the callback to install in the model and the function it calls
+	IncumbentCallback       _gurobiCallback;
+	incumbent_callback_type _incumbentCallback;
+
+	// the statistics of the last call to solve()
+	SolverStatistics _statistics;
 };
 
 #endif // HAVE_GUROBI
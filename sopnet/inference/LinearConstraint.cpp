@@ -2,7 +2,8 @@
 #include "LinearConstraint.h"
 
 LinearConstraint::LinearConstraint() :
-	_relation(LessEqual) {}
+	_relation(LessEqual),
+	_value(0) {}
 
 void
 LinearConstraint::setCoefficient(unsigned int varNum, double coef) {
@@ -1,46 +1,136 @@
+#include <algorithm>
+
 #include "LinearConstraints.h"
 
-LinearConstraints::LinearConstraints(size_t size) {
+LinearConstraints::LinearConstraints(size_t size) :
+	_variableIndexDirty(true) {
 
 	_linearConstraints.resize(size);
 }
 
+LinearConstraints::LinearConstraints(const LinearConstraints& other) :
+	pipeline::Data(other),
+	_linearConstraints(other._linearConstraints),
+	_variableIndexDirty(true) {}
+
+LinearConstraints&
+LinearConstraints::operator=(const LinearConstraints& other) {
+
+	pipeline::Data::operator=(other);
+
+	_linearConstraints = other._linearConstraints;
+
+	invalidateVariableIndex();
+
+	return *this;
+}
+
 void
 LinearConstraints::add(const LinearConstraint& linearConstraint) {
 
 	_linearConstraints.push_back(linearConstraint);
+
+	invalidateVariableIndex();
 }
 
 void
 LinearConstraints::addAll(const LinearConstraints& linearConstraints) {
 
 	_linearConstraints.insert(_linearConstraints.end(), linearConstraints.begin(), linearConstraints.end());
+
+	invalidateVariableIndex();
 }
 
 void
 LinearConstraints::removeLastConstraint() {
 
 	_linearConstraints.pop_back();
+
+	invalidateVariableIndex();
 }
 
 std::vector<unsigned int>
-LinearConstraints::getConstraints(const std::vector<unsigned int>& variableIds) {
+LinearConstraints::getConstraints(const std::vector<unsigned int>& variableIds) const {
 
-	std::vector<unsigned int> indices;
+	return getConstraints(variableIds.begin(), variableIds.end());
+}
 
-	for (unsigned int i = 0; i < size(); i++) {
+std::vector<unsigned int>
+LinearConstraints::getConstraints(index_iterator beginVariableIds, index_iterator endVariableIds) const {
 
-		LinearConstraint& constraint = _linearConstraints[i];
+	updateVariableIndex();
 
-		foreach (unsigned int v, variableIds) {
+	// collect the constraints of all variables, constraints of several 
+	// variables are removed afterwards (no shared state, such that 
+	// concurrent calls are safe)
+	std::vector<unsigned int> indices;
+
+	for (index_iterator i = beginVariableIds; i != endVariableIds; i++) {
 
-			if (constraint.getCoefficients().count(v) != 0) {
+		unsigned int v = *i;
 
-				indices.push_back(i);
-				break;
-			}
-		}
+		if (v + 1 >= _variableOffsets.size())
+			continue;
+
+		indices.insert(
+				indices.end(),
+				_variableConstraints.begin() + _variableOffsets[v],
+				_variableConstraints.begin() + _variableOffsets[v + 1]);
 	}
 
+	std::sort(indices.begin(), indices.end());
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
 	return indices;
 }
+
+std::pair<LinearConstraints::index_iterator, LinearConstraints::index_iterator>
+LinearConstraints::getVariableConstraints(unsigned int variableId) const {
+
+	updateVariableIndex();
+
+	if (variableId + 1 >= _variableOffsets.size())
+		return std::make_pair(_variableConstraints.end(), _variableConstraints.end());
+
+	return std::make_pair(
+			_variableConstraints.begin() + _variableOffsets[variableId],
+			_variableConstraints.begin() + _variableOffsets[variableId + 1]);
+}
+
+void
+LinearConstraints::updateVariableIndex() const {
+
+	boost::mutex::scoped_lock lock(_variableIndexMutex);
+
+	if (!_variableIndexDirty)
+		return;
+
+	unsigned int varNum;
+	double       coef;
+
+	// find the number of variables
+	unsigned int numVariables = 0;
+	foreach (const LinearConstraint& constraint, _linearConstraints)
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			numVariables = std::max(numVariables, varNum + 1);
+
+	// count the number of constraints per variable
+	_variableOffsets.assign(numVariables + 1, 0);
+	foreach (const LinearConstraint& constraint, _linearConstraints)
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			_variableOffsets[varNum + 1]++;
+
+	for (unsigned int v = 0; v < numVariables; v++)
+		_variableOffsets[v + 1] += _variableOffsets[v];
+
+	// fill the index -- since we visit the constraints in order, the 
+	// constraints of each variable will be sorted
+	_variableConstraints.resize(_variableOffsets[numVariables]);
+	std::vector<unsigned int> next(_variableOffsets.begin(), _variableOffsets.end() - 1);
+
+	for (unsigned int i = 0; i < _linearConstraints.size(); i++)
+		foreach (boost::tie(varNum, coef), _linearConstraints[i].getCoefficients())
+			_variableConstraints[next[varNum]++] = i;
+
+	_variableIndexDirty = false;
+}
@@ -1,19 +1,31 @@
 #ifndef INFERENCE_LINEAR_CONSTRAINTS_H__
 #define INFERENCE_LINEAR_CONSTRAINTS_H__
 
+#include <boost/thread/mutex.hpp>
+
 #include <pipeline/all.h>
 #include "LinearConstraint.h"
 
+/**
+ * A set of linear constraints with an inverted index from variables to 
+ * constraints. The index is built on demand, the queries getConstraints() and 
+ * getVariableConstraints() can be used concurrently by several threads. 
+ * Constraints can only be changed in-place through getMutableConstraint(), 
+ * which keeps the index up-to-date.
+ */
 class LinearConstraints : public pipeline::Data {
 
 	typedef std::vector<LinearConstraint> linear_constraints_type;
 
 public:
 
-	typedef linear_constraints_type::iterator       iterator;
+	// the constraints can not be changed through iterators
+	typedef linear_constraints_type::const_iterator iterator;
 
 	typedef linear_constraints_type::const_iterator const_iterator;
 
+	typedef std::vector<unsigned int>::const_iterator index_iterator;
+
 	/**
 	 * Create a new set of linear constraints and allocate enough memory to hold
 	 * 'size' linear constraints. More or less constraints can be added, but
@@ -24,10 +36,27 @@ public:
 	 */
 	LinearConstraints(size_t size = 0);
 
+	/**
+	 * Copy the constraints of another set. The variable index is rebuilt on 
+	 * demand.
+	 */
+	LinearConstraints(const LinearConstraints& other);
+
+	LinearConstraints& operator=(const LinearConstraints& other);
+
 	/**
 	 * Remove all constraints from this set of linear constraints.
 	 */
-	void clear() { _linearConstraints.clear(); }
+	void clear() { _linearConstraints.clear(); invalidateVariableIndex(); }
+
+	/**
+	 * Change the number of constraints. New constraints are empty and can be 
+	 * filled in-place via getMutableConstraint(), e.g., by several threads for 
+	 * disjoint constraints.
+	 *
+	 * @param size The new number of linear constraints.
+	 */
+	void resize(size_t size) { _linearConstraints.resize(size); invalidateVariableIndex(); }
 
 	/**
 	 * Add a linear constraint.
@@ -53,27 +82,70 @@ public:
 	 */
 	unsigned int size() const { return _linearConstraints.size(); }
 
-	const const_iterator begin() const { return _linearConstraints.begin(); }
+	const_iterator begin() const { return _linearConstraints.begin(); }
 
-	iterator begin() { return _linearConstraints.begin(); }
+	const_iterator end() const { return _linearConstraints.end(); }
 
-	const const_iterator end() const { return _linearConstraints.end(); }
+	const LinearConstraint& operator[](size_t i) const { return _linearConstraints[i]; }
 
-	iterator end() { return _linearConstraints.end(); }
+	/**
+	 * Get a constraint to change it in-place. Invalidates the variable index. 
+	 * Several threads can change disjoint constraints concurrently, as long 
+	 * as the index was invalidated before (e.g., by resize()) and nobody 
+	 * queries it in the meantime.
+	 */
+	LinearConstraint& getMutableConstraint(size_t i) {
 
-	const LinearConstraint& operator[](size_t i) const { return _linearConstraints[i]; }
+		// don't write the flag if it is set already, such that concurrent 
+		// calls don't race
+		if (!_variableIndexDirty)
+			invalidateVariableIndex();
 
-	LinearConstraint& operator[](size_t i) { return _linearConstraints[i]; }
+		return _linearConstraints[i];
+	}
 
 	/**
-	 * Get a linst of indices of linear constraints that use the given 
-	 * variables.
+	 * Get a sorted list of indices of linear constraints that use the given 
+	 * variables. Uses the variable index, i.e., the costs are linear in the 
+	 * number of non-zeros of the involved constraints.
 	 */
-	std::vector<unsigned int> getConstraints(const std::vector<unsigned int>& variableIds);
+	std::vector<unsigned int> getConstraints(const std::vector<unsigned int>& variableIds) const;
+
+	/**
+	 * Same as getConstraints(variableIds) for a range of variable ids.
+	 */
+	std::vector<unsigned int> getConstraints(index_iterator beginVariableIds, index_iterator endVariableIds) const;
+
+	/**
+	 * Get the range of (sorted) indices of linear constraints that use the 
+	 * given variable. The range is valid until the constraints are changed.
+	 */
+	std::pair<index_iterator, index_iterator> getVariableConstraints(unsigned int variableId) const;
+
+	/**
+	 * Mark the variable index as outdated. The index is built on demand and 
+	 * invalidated automatically whenever constraints are added, removed, or 
+	 * accessed through getMutableConstraint().
+	 */
+	void invalidateVariableIndex() { _variableIndexDirty = true; }
 
 private:
 
+	// (re)build the inverted index from variables to constraints, if needed
+	void updateVariableIndex() const;
+
 	linear_constraints_type _linearConstraints;
+
+	// inverted index from variables to constraints in compressed row format: 
+	// the constraints of variable i are stored in 
+	// _variableConstraints[_variableOffsets[i]..._variableOffsets[i+1]-1]
+	mutable std::vector<unsigned int> _variableOffsets;
+	mutable std::vector<unsigned int> _variableConstraints;
+
+	mutable bool _variableIndexDirty;
+
+	// serializes the lazy (re)building of the index by concurrent readers
+	mutable boost::mutex _variableIndexMutex;
 };
 
 #endif // INFERENCE_LINEAR_CONSTRAINTS_H__
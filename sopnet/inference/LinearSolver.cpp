@@ -1,3 +1,6 @@
+#include <cmath>
+
+#include <boost/bind.hpp>
 #include <boost/timer/timer.hpp>
 #include <util/Logger.h>
 #include <util/foreach.h>
@@ -6,25 +9,41 @@
 
 static logger::LogChannel linearsolverlog("linearsolverlog", "[LinearSolver] ");
 
+// tolerance for the violation of lazy constraints
+static const double LazyConstraintTolerance = 1e-6;
+
 LinearSolver::LinearSolver(const LinearSolverBackendFactory& backendFactory) :
 	_solution(new Solution()),
+	_incumbent(new Solution()),
+	_statistics(new SolverStatistics()),
 	_objectiveDirty(true),
 	_linearConstraintsDirty(true),
 	_parametersDirty(true),
-	_pinnedChanged(false) {
+	_initialSolutionDirty(true),
+	_pinnedChanged(false),
+	_numAddedLazyConstraints(0),
+	_solved(false),
+	_solving(false) {
 
 	registerInput(_objective, "objective");
 	registerInput(_linearConstraints, "linear constraints");
 	registerInput(_parameters, "parameters");
+	registerInput(_initialSolution, "initial solution", pipeline::Optional);
+	registerInput(_lazyConstraints, "lazy constraints", pipeline::Optional);
 	registerOutput(_solution, "solution");
+	registerOutput(_incumbent, "incumbent");
+	registerOutput(_statistics, "statistics");
 
 	// create solver backend
 	_solver = backendFactory.createLinearSolverBackend();
+	_solver->setIncumbentCallback(boost::bind(&LinearSolver::onIncumbent, this, _1, _2, _3, _4));
 
 	// register callbacks for input changes
 	_objective.registerCallback(&LinearSolver::onObjectiveModified, this);
 	_linearConstraints.registerCallback(&LinearSolver::onLinearConstraintsModified, this);
 	_parameters.registerCallback(&LinearSolver::onParametersModified, this);
+	_initialSolution.registerCallback(&LinearSolver::onInitialSolutionModified, this);
+	_lazyConstraints.registerCallback(&LinearSolver::onLazyConstraintsModified, this);
 }
 
 LinearSolver::~LinearSolver() {
@@ -41,6 +60,7 @@ LinearSolver::pinVariable(unsigned int varNum, double value) {
 
 	_pinned[varNum] = value;
 	_pinnedChanged = true;
+	_solved = false;
 	setDirty(_solution);
 }
 
@@ -52,6 +72,7 @@ LinearSolver::unpinVariable(unsigned int varNum) {
 
 		_unpinned.insert(varNum);
 		_pinnedChanged = true;
+		_solved = false;
 		setDirty(_solution);
 
 		return true;
@@ -60,32 +81,119 @@ LinearSolver::unpinVariable(unsigned int varNum) {
 	return false;
 }
 
+void
+LinearSolver::setIncumbentCallback(LinearSolverBackend::incumbent_callback_type callback) {
+
+	_incumbentCallback = callback;
+}
+
+void
+LinearSolver::onIncumbent(const Solution& incumbent, double value, double bound, double time) {
+
+	LOG_DEBUG(linearsolverlog)
+			<< "new incumbent after " << time << "s with value " << value
+			<< " (bound " << bound << ")" << std::endl;
+
+	_statistics->addIncumbent(time, value, bound);
+
+	// only buffer the incumbent here, the output is written when it is 
+	// pulled (see updateOutputs())
+	{
+		boost::mutex::scoped_lock lock(_incumbentMutex);
+
+		_bufferedIncumbent = incumbent;
+	}
+
+	// let downstream nodes pull the new incumbent
+	setDirty(_incumbent);
+
+	if (_incumbentCallback)
+		_incumbentCallback(incumbent, value, bound, time);
+}
+
 void
 LinearSolver::onObjectiveModified(const pipeline::Modified&) {
 
 	_objectiveDirty = true;
+	_solved = false;
 }
 
 void
 LinearSolver::onLinearConstraintsModified(const pipeline::Modified&) {
 
 	_linearConstraintsDirty = true;
+	_solved = false;
 }
 
 void
 LinearSolver::onParametersModified(const pipeline::Modified&) {
 
 	_parametersDirty = true;
+	_solved = false;
+}
+
+void
+LinearSolver::onInitialSolutionModified(const pipeline::Modified&) {
+
+	_initialSolutionDirty = true;
+	_solved = false;
+}
+
+void
+LinearSolver::onLazyConstraintsModified(const pipeline::Modified&) {
+
+	// lazy constraints that have been added are part of the linear
+	// constraints of the backend, we have to start over
+	_linearConstraintsDirty = true;
+
+	// the number of variables might have changed as well
+	_parametersDirty = true;
+
+	_solved = false;
 }
 
 void
 LinearSolver::updateOutputs() {
 
+	{
+		boost::mutex::scoped_lock lock(_incumbentMutex);
+
+		// the incumbent output was pulled while the solver is running (from 
+		// the incumbent callback or another thread), publish the latest 
+		// incumbent without starting another solve
+		if (_solving) {
+
+			*_incumbent = _bufferedIncumbent;
+			return;
+		}
+	}
+
+	// the incumbent output was marked dirty, but the linear program did not 
+	// change
+	if (_solved)
+		return;
+
 	boost::timer::auto_cpu_timer timer("\tLinearSolver::updateOutputs()\t\t%ws\n");
 
+	{
+		boost::mutex::scoped_lock lock(_incumbentMutex);
+
+		_solving = true;
+	}
+
 	updateLinearProgram();
 
 	solve();
+
+	// the last incumbent is the solution
+	{
+		boost::mutex::scoped_lock lock(_incumbentMutex);
+
+		*_incumbent = *_solution;
+		_solving = false;
+	}
+
+	_solved = true;
 }
 
 void
@@ -95,6 +203,9 @@ LinearSolver::updateLinearProgram() {
 
 		LOG_DEBUG(linearsolverlog) << "initializing solver" << std::endl;
 
+		// the start values are lost with the variables
+		_initialSolutionDirty = true;
+
 		if (_parameters.isSet())
 			_solver->initialize(
 					getNumVariables(),
@@ -105,6 +216,16 @@ LinearSolver::updateLinearProgram() {
 					getNumVariables(),
 					Continuous);
 
+		if (_parameters.isSet()) {
+
+			if (_parameters->getTimeLimit() >= 0)
+				_solver->setTimeLimit(_parameters->getTimeLimit());
+			if (_parameters->getOptimalityGap() >= 0)
+				_solver->setOptimalityGap(_parameters->getOptimalityGap());
+			if (_parameters->isRelaxed())
+				_solver->setRelaxed(true);
+		}
+
 		_parametersDirty = false;
 	}
 
@@ -123,9 +244,24 @@ LinearSolver::updateLinearProgram() {
 
 		_solver->setConstraints(*_linearConstraints);
 
+		// none of the lazy constraints is part of the backend's constraints
+		// anymore
+		if (_lazyConstraints.isSet())
+			_lazyConstraintAdded.assign(_lazyConstraints->size(), false);
+		_numAddedLazyConstraints = 0;
+
 		_linearConstraintsDirty = false;
 	}
 
+	if (_initialSolutionDirty && _initialSolution.isSet()) {
+
+		LOG_DEBUG(linearsolverlog) << "setting initial solution" << std::endl;
+
+		_solver->setInitialSolution(*_initialSolution);
+
+		_initialSolutionDirty = false;
+	}
+
 	if (_pinnedChanged) {
 
 		LOG_DEBUG(linearsolverlog) << "(un)pinning variables" << std::endl;
@@ -146,20 +282,123 @@ LinearSolver::updateLinearProgram() {
 void
 LinearSolver::solve() {
 
+	_statistics->clear();
+
+	if (!solveOnce() || !_lazyConstraints.isSet())
+		return;
+
+	// add violated lazy constraints until the solution satisfies all of them
+	unsigned int numRounds = 0;
+	while (true) {
+
+		unsigned int numAdded = addViolatedLazyConstraints();
+
+		if (numAdded == 0)
+			break;
+
+		numRounds++;
+
+		LOG_USER(linearsolverlog)
+				<< "added " << numAdded << " violated lazy constraints, solving again"
+				<< std::endl;
+
+		// start from the previous solution, it is only infeasible for the new
+		// constraints
+		_solver->setInitialSolution(*_solution);
+		_initialSolutionDirty = true;
+
+		if (!solveOnce())
+			return;
+	}
+
+	LOG_USER(linearsolverlog)
+			<< "solution satisfies all lazy constraints after " << numRounds
+			<< " additional rounds, " << _numAddedLazyConstraints << " of "
+			<< _lazyConstraints->size() << " lazy constraints were added"
+			<< std::endl;
+}
+
+bool
+LinearSolver::solveOnce() {
+
 	double value;
 
 	std::string message;
 
-	if (_solver->solve(*_solution, value, message)) {
+	bool optimal = _solver->solve(*_solution, value, message);
+
+	_solver->getStatistics(*_statistics);
+
+	if (optimal) {
 
 		LOG_USER(linearsolverlog) << "optimal solution found" << std::endl;
 
+	} else if (_statistics->getStatus() == SolverStatistics::TimeLimit) {
+
+		LOG_USER(linearsolverlog)
+				<< "time limit reached, using best solution with gap "
+				<< _statistics->getGap() << " after "
+				<< _statistics->getIncumbents().size() << " incumbents" << std::endl;
+
 	} else {
 
 		LOG_ERROR(linearsolverlog) << "error: " << message << std::endl;
+
+		return false;
 	}
 
 	LOG_ALL(linearsolverlog) << "solution: " << _solution->getVector() << std::endl;
+
+	return true;
+}
+
+unsigned int
+LinearSolver::addViolatedLazyConstraints() {
+
+	LinearConstraints violated;
+
+	for (unsigned int i = 0; i < _lazyConstraints->size(); i++) {
+
+		if (_lazyConstraintAdded[i])
+			continue;
+
+		const LinearConstraint& constraint = (*_lazyConstraints)[i];
+
+		double activity = 0;
+
+		unsigned int varNum;
+		double coef;
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			if (varNum < _solution->size())
+				activity += coef*(*_solution)[varNum];
+
+		bool satisfied = true;
+		switch (constraint.getRelation()) {
+
+			case LessEqual:
+				satisfied = (activity <= constraint.getValue() + LazyConstraintTolerance);
+				break;
+			case Equal:
+				satisfied = (std::abs(activity - constraint.getValue()) <= LazyConstraintTolerance);
+				break;
+			case GreaterEqual:
+				satisfied = (activity >= constraint.getValue() - LazyConstraintTolerance);
+				break;
+		}
+
+		if (satisfied)
+			continue;
+
+		violated.add(constraint);
+		_lazyConstraintAdded[i] = true;
+	}
+
+	if (violated.size() > 0)
+		_solver->addConstraints(violated);
+
+	_numAddedLazyConstraints += violated.size();
+
+	return violated.size();
 }
 
 unsigned int
@@ -179,6 +418,13 @@ LinearSolver::getNumVariables() {
 		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
 			numVars = std::max(numVars, varNum + 1);
 
+	if (_lazyConstraints.isSet()) {
+
+		foreach (const LinearConstraint& constraint, *_lazyConstraints)
+			foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+				numVars = std::max(numVars, varNum + 1);
+	}
+
 	LOG_ALL(linearsolverlog)
 			<< "together with the constraints, "
 			<< numVars
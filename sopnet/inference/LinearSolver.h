@@ -4,6 +4,7 @@
 #include <string>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <pipeline/all.h>
 #include "DefaultFactory.h"
@@ -13,6 +14,7 @@
 #include "LinearSolverBackendFactory.h"
 #include "LinearSolverParameters.h"
 #include "Solution.h"
+#include "SolverStatistics.h"
 
 /**
  * Abstract class for linear program solvers. Implementations are supposed to
@@ -33,9 +35,30 @@
  *   constraints : LinearConstraints
  *   parameters  : SolverParameters
  *
- * and provide the output
+ * and optionally
  *
- *   solution    : Solution.
+ *   initial solution : Solution
+ *
+ * which is passed to the backend as a start for the search, and
+ *
+ *   lazy constraints : LinearConstraints
+ *
+ * which are only added to the problem if they are violated by the solution
+ * (in which case the problem is solved again),
+ * and provide the outputs
+ *
+ *   solution    : Solution
+ *   incumbent   : Solution
+ *   statistics  : SolverStatistics.
+ *
+ * If a time limit is set in the parameters, the solution is the best
+ * incumbent found within this time. While the solver is running, the
+ * incumbent output is marked dirty for each new incumbent, such that
+ * downstream nodes can show intermediate results. Pulling the incumbent
+ * output during the solve gives the latest incumbent and never starts
+ * another solve. After the solver finished, the incumbent output equals the
+ * solution. Intermediate
+ * incumbents can also be received with setIncumbentCallback().
  */
 class LinearSolver : public pipeline::SimpleProcessNode<> {
 
@@ -67,14 +90,26 @@ public:
 	 */
 	bool unpinVariable(unsigned int varNum);
 
+	/**
+	 * Set a function to be called with every new incumbent solution while 
+	 * the solver is running, e.g., to show intermediate results.
+	 */
+	void setIncumbentCallback(LinearSolverBackend::incumbent_callback_type callback);
+
 private:
 
+	void onIncumbent(const Solution& incumbent, double value, double bound, double time);
+
 	void onObjectiveModified(const pipeline::Modified& signal);
 
 	void onLinearConstraintsModified(const pipeline::Modified& signal);
 
 	void onParametersModified(const pipeline::Modified& signal);
 
+	void onInitialSolutionModified(const pipeline::Modified& signal);
+
+	void onLazyConstraintsModified(const pipeline::Modified& signal);
+
 	////////////////////////
 	// pipeline interface //
 	////////////////////////
@@ -82,8 +117,12 @@ private:
 	pipeline::Input<LinearObjective>        _objective;
 	pipeline::Input<LinearConstraints>      _linearConstraints;
 	pipeline::Input<LinearSolverParameters> _parameters;
+	pipeline::Input<Solution>               _initialSolution;
+	pipeline::Input<LinearConstraints>      _lazyConstraints;
 
-	pipeline::Output<Solution> _solution;
+	pipeline::Output<Solution>         _solution;
+	pipeline::Output<Solution>         _incumbent;
+	pipeline::Output<SolverStatistics> _statistics;
 
 	void updateOutputs();
 
@@ -95,6 +134,14 @@ private:
 
 	void solve();
 
+	// solve the current linear program once, returns false if there is no
+	// solution
+	bool solveOnce();
+
+	// add the lazy constraints that are violated by the current solution to
+	// the backend, returns the number of added constraints
+	unsigned int addViolatedLazyConstraints();
+
 	unsigned int getNumVariables();
 
 	LinearSolverBackend* _solver;
@@ -105,6 +152,8 @@ private:
 
 	bool _parametersDirty;
 
+	bool _initialSolutionDirty;
+
 	// pinned variables and their values
 	std::map<unsigned int, double> _pinned;
 
@@ -112,6 +161,26 @@ private:
 	std::set<unsigned int> _unpinned;
 
 	bool _pinnedChanged;
+
+	// which lazy constraints have been added to the backend
+	std::vector<bool> _lazyConstraintAdded;
+	unsigned int      _numAddedLazyConstraints;
+
+	// the user callback for new incumbents
+	LinearSolverBackend::incumbent_callback_type _incumbentCallback;
+
+	// was the linear program solved since the last change of the inputs or 
+	// pinned variables?
+	bool _solved;
+
+	// is the solver currently running?
+	bool _solving;
+
+	// the latest incumbent reported by the backend during the solve
+	Solution _bufferedIncumbent;
+
+	// protects _solving, _bufferedIncumbent, and the content of _incumbent
+	boost::mutex _incumbentMutex;
 };
 
 #endif // INFERENCE_LINEAR_SOLVER_H__
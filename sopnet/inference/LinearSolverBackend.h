@@ -1,15 +1,25 @@
 #ifndef INFERENCE_LINEAR_SOLVER_BACKEND_H__
 #define INFERENCE_LINEAR_SOLVER_BACKEND_H__
 
+#include <boost/function.hpp>
+
 #include "LinearObjective.h"
 #include "LinearConstraints.h"
 #include "Solution.h"
+#include "SolverStatistics.h"
 #include "VariableType.h"
 
 class LinearSolverBackend {
 
 public:
 
+	/**
+	 * Callback for new incumbent solutions, with the value of the objective, 
+	 * the current bound, and the time in seconds since the solver started.
+	 */
+	typedef boost::function<void (const Solution& incumbent, double value, double bound, double time)>
+			incumbent_callback_type;
+
 	virtual ~LinearSolverBackend() {}
 
 	/**
@@ -56,6 +66,14 @@ public:
 	 */
 	virtual void setConstraints(const LinearConstraints& constraints) = 0;
 
+	/**
+	 * Add linear (in)equality constraints to the ones set via 
+	 * setConstraints().
+	 *
+	 * @param constraints A set of linear constraints.
+	 */
+	virtual void addConstraints(const LinearConstraints& constraints) = 0;
+
 	/**
 	 * Force the value of a variable to be a given value, i.e., pin the variable 
 	 * to a fixed value.
@@ -78,13 +96,69 @@ public:
 	 */
 	virtual bool unpinVariable(unsigned int varNum) = 0;
 
+	/**
+	 * Provide a (possibly infeasible or suboptimal) solution to start the
+	 * search from, e.g., the optimum of a similar problem. Backends that do
+	 * not support initial solutions ignore it.
+	 *
+	 * @param solution
+	 *              The initial value for each variable. Variables with a NaN 
+	 *              value or beyond the size of the solution have no initial 
+	 *              value.
+	 */
+	virtual void setInitialSolution(const Solution& /*solution*/) {}
+
+	/**
+	 * Stop the next solve after the given wall-clock time and report the best
+	 * solution found so far. Backends that do not support time limits ignore 
+	 * it.
+	 *
+	 * @param seconds
+	 *              The time limit in seconds, 0 for no limit.
+	 */
+	virtual void setTimeLimit(double /*seconds*/) {}
+
+	/**
+	 * Stop the next solve as soon as the relative gap between the best 
+	 * solution and the bound is below the given value. Backends that do not 
+	 * support optimality gaps ignore it.
+	 *
+	 * @param gap
+	 *              The relative optimality gap.
+	 */
+	virtual void setOptimalityGap(double /*gap*/) {}
+
+	/**
+	 * Solve the linear relaxation of the problem set via initialize(), i.e., 
+	 * treat binary and integer variables as continuous within their bounds. 
+	 * Backends that do not support relaxations solve the original problem.
+	 *
+	 * @param relaxed
+	 *              Whether to solve the relaxation.
+	 */
+	virtual void setRelaxed(bool /*relaxed*/) {}
+
+	/**
+	 * Set a function to be called whenever the solver finds a new incumbent 
+	 * solution. Backends that do not support callbacks ignore it.
+	 */
+	virtual void setIncumbentCallback(incumbent_callback_type /*callback*/) {}
+
+	/**
+	 * Get the status, runtime, and bound of the last solve. Backends that do 
+	 * not support statistics leave them untouched.
+	 */
+	virtual void getStatistics(SolverStatistics& /*statistics*/) {}
+
 	/**
 	 * Solve the problem.
 	 *
 	 * @param solution A solution object to write the solution to.
 	 * @param value The optimal value of the objective.
 	 * @param message A status message from the solver.
-	 * @return true, if the optimal value was found.
+	 * @return true, if the optimal value was found. If the solver stopped 
+	 *         early (see setTimeLimit()), the solution is set to the best 
+	 *         incumbent, if there is one.
 	 */
 	virtual bool solve(Solution& solution, double& value, std::string& message) = 0;
 };
@@ -10,10 +10,16 @@ struct LinearSolverParameters : pipeline::Data {
 public:
 
 	LinearSolverParameters() :
-		_variableType(Continuous) {};
+		_variableType(Continuous),
+		_timeLimit(-1),
+		_optimalityGap(-1),
+		_relaxed(false) {};
 
 	LinearSolverParameters(const VariableType& variableType) :
-		_variableType(variableType) {}
+		_variableType(variableType),
+		_timeLimit(-1),
+		_optimalityGap(-1),
+		_relaxed(false) {}
 
 	/**
 	 * Set the default variable type for all variables.
@@ -46,6 +52,55 @@ public:
 		return _variableTypes;
 	}
 
+	/**
+	 * Set the wall-clock time in seconds after which the solver stops and 
+	 * reports its best solution, 0 for no limit. If not set, the backend's 
+	 * default is used.
+	 */
+	void setTimeLimit(double seconds) {
+
+		_timeLimit = seconds;
+	}
+
+	/**
+	 * Get the time limit, a negative value if not set.
+	 */
+	double getTimeLimit() const {
+
+		return _timeLimit;
+	}
+
+	/**
+	 * Set the relative optimality gap at which the solver stops. If not set, 
+	 * the backend's default is used.
+	 */
+	void setOptimalityGap(double gap) {
+
+		_optimalityGap = gap;
+	}
+
+	/**
+	 * Get the optimality gap, a negative value if not set.
+	 */
+	double getOptimalityGap() const {
+
+		return _optimalityGap;
+	}
+
+	/**
+	 * Solve only the linear relaxation of the problem, i.e., treat binary and 
+	 * integer variables as continuous variables within their bounds.
+	 */
+	void setRelaxed(bool relaxed) {
+
+		_relaxed = relaxed;
+	}
+
+	bool isRelaxed() const {
+
+		return _relaxed;
+	}
+
 private:
 
 	// the default variable type
@@ -53,6 +108,13 @@ private:
 
 	// individual variable types
 	std::map<unsigned int, VariableType> _variableTypes;
+
+	// termination criteria, negative if not set
+	double _timeLimit;
+	double _optimalityGap;
+
+	// solve the linear relaxation only
+	bool _relaxed;
 };
 
 #endif // INFERENCE_LINEAR_SOLVER_PARAMETERS_H__
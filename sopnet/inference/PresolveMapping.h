@@ -0,0 +1,117 @@
+#ifndef INFERENCE_PRESOLVE_MAPPING_H__
+#define INFERENCE_PRESOLVE_MAPPING_H__
+
+#include <boost/lexical_cast.hpp>
+
+#include <pipeline/all.h>
+#include <util/exceptions.h>
+#include "Solution.h"
+
+/**
+ * Describes how the variables of a presolved (reduced) linear program relate 
+ * to the variables of the original linear program. Every original variable 
+ * is either fixed to a value or corresponds to a variable of the reduced 
+ * problem.
+ */
+class PresolveMapping : public pipeline::Data {
+
+public:
+
+	/**
+	 * Reset the mapping for the given number of original variables. All 
+	 * variables are fixed to zero initially.
+	 */
+	void clear(unsigned int numOriginalVariables) {
+
+		_reducedVariables.assign(numOriginalVariables, -1);
+		_fixedValues.assign(numOriginalVariables, 0);
+		_numReducedVariables = 0;
+	}
+
+	/**
+	 * Fix an original variable to the given value.
+	 */
+	void setFixed(unsigned int variable, double value) {
+
+		_reducedVariables[variable] = -1;
+		_fixedValues[variable]      = value;
+	}
+
+	/**
+	 * Map an original variable to the next free variable in the reduced 
+	 * problem.
+	 *
+	 * @return The number of the variable in the reduced problem.
+	 */
+	unsigned int addReduced(unsigned int variable) {
+
+		_reducedVariables[variable] = _numReducedVariables;
+
+		return _numReducedVariables++;
+	}
+
+	/**
+	 * Get the number of the reduced variable for an original variable, or -1, 
+	 * if the variable was fixed.
+	 */
+	int getReducedVariable(unsigned int variable) const { return _reducedVariables[variable]; }
+
+	unsigned int getNumOriginalVariables() const { return _reducedVariables.size(); }
+
+	unsigned int getNumReducedVariables() const { return _numReducedVariables; }
+
+	/**
+	 * Create a solution to the original problem from a solution to the 
+	 * reduced problem. Throws a SizeMismatchError, if the reduced solution 
+	 * does not have a value for each reduced variable.
+	 */
+	void map(const Solution& reducedSolution, Solution& solution) const {
+
+		if (reducedSolution.size() != _numReducedVariables)
+			BOOST_THROW_EXCEPTION(
+					SizeMismatchError()
+					<< error_message(
+							std::string("the reduced solution has ") +
+							boost::lexical_cast<std::string>(reducedSolution.size()) +
+							" values, but the reduced problem has " +
+							boost::lexical_cast<std::string>(_numReducedVariables) +
+							" variables")
+					<< STACK_TRACE);
+
+		solution.resize(_reducedVariables.size());
+
+		for (unsigned int i = 0; i < _reducedVariables.size(); i++)
+			if (_reducedVariables[i] >= 0)
+				solution[i] = reducedSolution[_reducedVariables[i]];
+			else
+				solution[i] = _fixedValues[i];
+	}
+
+	/**
+	 * Create a (partial) solution to the reduced problem from a solution to 
+	 * the original problem, e.g., to use it as an initial solution. Values of 
+	 * variables that are not part of the given solution are passed on as 
+	 * they are.
+	 */
+	void reduce(const Solution& solution, Solution& reducedSolution) const {
+
+		reducedSolution.resize(_numReducedVariables);
+
+		for (unsigned int i = 0; i < _reducedVariables.size() && i < solution.size(); i++)
+			if (_reducedVariables[i] >= 0)
+				reducedSolution[_reducedVariables[i]] = solution[i];
+	}
+
+private:
+
+	// the reduced variable for each original variable or -1, if fixed
+	std::vector<int> _reducedVariables;
+
+	// the values of the fixed variables
+	std::vector<double> _fixedValues;
+
+	unsigned int _numReducedVariables;
+};
+
+#endif // INFERENCE_PRESOLVE_MAPPING_H__
+
@@ -0,0 +1,24 @@
+#include "PresolvedSolutionMapper.h"
+
+PresolvedSolutionMapper::PresolvedSolutionMapper() :
+	_solution(new Solution()) {
+
+	registerInput(_reducedSolution, "solution");
+	registerInput(_mapping, "mapping");
+
+	registerOutput(_solution, "solution");
+}
+
+void
+PresolvedSolutionMapper::updateOutputs() {
+
+	// there is no solution yet, e.g., the solver did not report an incumbent 
+	// so far
+	if (_reducedSolution->size() == 0 && _mapping->getNumReducedVariables() > 0) {
+
+		_solution->resize(0);
+		return;
+	}
+
+	_mapping->map(*_reducedSolution, *_solution);
+}
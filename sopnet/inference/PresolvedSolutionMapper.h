@@ -0,0 +1,39 @@
+#ifndef INFERENCE_PRESOLVED_SOLUTION_MAPPER_H__
+#define INFERENCE_PRESOLVED_SOLUTION_MAPPER_H__
+
+#include <pipeline/all.h>
+#include "PresolveMapping.h"
+#include "Solution.h"
+
+/**
+ * Maps the solution of a problem reduced by the Presolver back to the 
+ * variables of the original problem. An empty reduced solution (e.g., before 
+ * the solver found an incumbent) is mapped to an empty solution.
+ *
+ * Inputs:
+ *
+ *   solution : Solution (of the reduced problem)
+ *   mapping  : PresolveMapping
+ *
+ * Outputs:
+ *
+ *   solution : Solution (of the original problem)
+ */
+class PresolvedSolutionMapper : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	PresolvedSolutionMapper();
+
+private:
+
+	void updateOutputs();
+
+	pipeline::Input<Solution>        _reducedSolution;
+	pipeline::Input<PresolveMapping> _mapping;
+
+	pipeline::Output<Solution> _solution;
+};
+
+#endif // INFERENCE_PRESOLVED_SOLUTION_MAPPER_H__
+
@@ -0,0 +1,534 @@
+#include <cmath>
+#include <limits>
+
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/timer/timer.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <util/Logger.h>
+#include <util/foreach.h>
+#include "Presolver.h"
+
+static logger::LogChannel presolverlog("presolverlog", "[Presolver] ");
+
+// tolerance for the comparison of activities and right hand sides
+static const double Epsilon = 1e-9;
+
+Presolver::Presolver() :
+	_reducedObjective(new LinearObjective()),
+	_reducedLinearConstraints(new LinearConstraints()),
+	_reducedParameters(new LinearSolverParameters()),
+	_mapping(new PresolveMapping()) {
+
+	registerInput(_objective, "objective");
+	registerInput(_linearConstraints, "linear constraints");
+	registerInput(_parameters, "parameters", pipeline::Optional);
+
+	registerOutput(_reducedObjective, "objective");
+	registerOutput(_reducedLinearConstraints, "linear constraints");
+	registerOutput(_reducedParameters, "parameters");
+	registerOutput(_mapping, "mapping");
+}
+
+void
+Presolver::updateOutputs() {
+
+	boost::timer::auto_cpu_timer timer("\tPresolver::updateOutputs()\t\t%ws\n");
+
+	// get the number of variables (as in the LinearSolver)
+	_numVariables = _objective->getCoefficients().size();
+
+	unsigned int varNum;
+	double coef;
+	foreach (const LinearConstraint& constraint, *_linearConstraints)
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			_numVariables = std::max(_numVariables, varNum + 1);
+
+	// only binary variables have bounds that we can reason about
+	_binary.assign(_numVariables, false);
+	if (_parameters.isSet())
+		for (unsigned int i = 0; i < _numVariables; i++)
+			_binary[i] = (_parameters->getVariableType(i) == Binary);
+
+	_fixed.assign(_numVariables, false);
+	_values.assign(_numVariables, 0);
+
+	_removed.assign(_linearConstraints->size(), false);
+	_queued.assign(_linearConstraints->size(), false);
+	_queue.clear();
+
+	_numInfiniteCosts      = 0;
+	_numFixedByConstraints = 0;
+	_numUnconstrained      = 0;
+	_numRedundant          = 0;
+	_numDuplicates         = 0;
+
+	fixInfiniteCostVariables();
+
+	propagateConstraints();
+
+	removeDuplicateConstraints();
+
+	fixUnconstrainedVariables();
+
+	createReducedProblem();
+
+	LOG_USER(presolverlog)
+			<< "removed " << (_numVariables - _mapping->getNumReducedVariables())
+			<< " of " << _numVariables << " variables and "
+			<< (_linearConstraints->size() - _reducedLinearConstraints->size())
+			<< " of " << _linearConstraints->size() << " constraints" << std::endl;
+
+	LOG_DEBUG(presolverlog)
+			<< "variables: " << _numInfiniteCosts << " with infinite costs, "
+			<< _numFixedByConstraints << " fixed by constraints, "
+			<< _numUnconstrained << " unconstrained; constraints: "
+			<< _numRedundant << " redundant or forcing, "
+			<< _numDuplicates << " duplicate or dominated" << std::endl;
+}
+
+void
+Presolver::fixInfiniteCostVariables() {
+
+	const std::vector<double>& costs = _objective->getCoefficients();
+
+	// the direction in which costs are bad
+	double infinity = (_objective->getSense() == Minimize ? 1 : -1)*std::numeric_limits<double>::infinity();
+
+	for (unsigned int i = 0; i < costs.size(); i++)
+		if (_binary[i] && costs[i] == infinity) {
+
+			fix(i, 0);
+			_numInfiniteCosts++;
+		}
+}
+
+void
+Presolver::propagateConstraints() {
+
+	// process every constraint at least once
+	for (unsigned int i = 0; i < _linearConstraints->size(); i++) {
+
+		_queue.push_back(i);
+		_queued[i] = true;
+	}
+
+	while (!_queue.empty()) {
+
+		unsigned int i = _queue.front();
+		_queue.pop_front();
+		_queued[i] = false;
+
+		if (!_removed[i])
+			processConstraint(i);
+	}
+}
+
+void
+Presolver::processConstraint(unsigned int i) {
+
+	const LinearConstraint& constraint = (*_linearConstraints)[i];
+	Relation relation = constraint.getRelation();
+
+	double residual = constraint.getValue();
+
+	unsigned int numFree = 0;
+	unsigned int freeVarNum = 0;
+	double       freeCoef = 0;
+
+	bool   allBinary   = true;
+	double minActivity = 0;
+	double maxActivity = 0;
+
+	unsigned int varNum;
+	double coef;
+	foreach (boost::tie(varNum, coef), constraint.getCoefficients()) {
+
+		if (_fixed[varNum]) {
+
+			residual -= coef*_values[varNum];
+			continue;
+		}
+
+		numFree++;
+		freeVarNum = varNum;
+		freeCoef   = coef;
+
+		if (!_binary[varNum])
+			allBinary = false;
+
+		if (coef < 0)
+			minActivity += coef;
+		else
+			maxActivity += coef;
+	}
+
+	// all variables are fixed
+	if (numFree == 0) {
+
+		bool satisfied =
+				(relation == LessEqual    ? 0 <= residual + Epsilon :
+				(relation == GreaterEqual ? 0 >= residual - Epsilon :
+				                            std::abs(residual) <= Epsilon));
+
+		if (satisfied) {
+
+			_removed[i] = true;
+			_numRedundant++;
+
+		} else {
+
+			BOOST_THROW_EXCEPTION(
+					InfeasibleProblem()
+					<< error_message("constraint " + boost::lexical_cast<std::string>(i) + " can not be satisfied")
+					<< STACK_TRACE);
+		}
+
+		return;
+	}
+
+	// singleton equality rows fix their variable
+	if (relation == Equal && numFree == 1) {
+
+		double value = residual/freeCoef;
+
+		if (_binary[freeVarNum]) {
+
+			if (std::abs(value) > Epsilon && std::abs(value - 1) > Epsilon) {
+
+				BOOST_THROW_EXCEPTION(
+						InfeasibleProblem()
+						<< error_message(
+								"constraint " + boost::lexical_cast<std::string>(i) +
+								" forces binary variable " + boost::lexical_cast<std::string>(freeVarNum) +
+								" to " + boost::lexical_cast<std::string>(value))
+						<< STACK_TRACE);
+			}
+
+			value = (value > 0.5 ? 1 : 0);
+
+		} else if (_parameters.isSet() && _parameters->getVariableType(freeVarNum) == Integer) {
+
+			if (std::abs(value - std::floor(value + 0.5)) > Epsilon)
+				return;
+
+			value = std::floor(value + 0.5);
+		}
+
+		_removed[i] = true;
+		_numRedundant++;
+
+		fix(freeVarNum, value);
+		_numFixedByConstraints++;
+
+		return;
+	}
+
+	// for rows with unbounded variables, we can not say more
+	if (!allBinary)
+		return;
+
+	if ((relation == LessEqual && minActivity > residual + Epsilon) ||
+	    (relation == GreaterEqual && maxActivity < residual - Epsilon) ||
+	    (relation == Equal && (minActivity > residual + Epsilon || maxActivity < residual - Epsilon))) {
+
+		BOOST_THROW_EXCEPTION(
+				InfeasibleProblem()
+				<< error_message("constraint " + boost::lexical_cast<std::string>(i) + " can not be satisfied")
+				<< STACK_TRACE);
+	}
+
+	// the row is satisfied for any assignment of the binary variables
+	if ((relation == LessEqual    && maxActivity <= residual + Epsilon) ||
+	    (relation == GreaterEqual && minActivity >= residual - Epsilon)) {
+
+		_removed[i] = true;
+		_numRedundant++;
+
+		return;
+	}
+
+	// the row can only be satisfied with all variables at their lower or upper
+	// activity
+	bool forcedToMin = (relation != GreaterEqual && minActivity >= residual - Epsilon);
+	bool forcedToMax = (relation != LessEqual    && maxActivity <= residual + Epsilon);
+
+	if (!forcedToMin && !forcedToMax)
+		return;
+
+	_removed[i] = true;
+	_numRedundant++;
+
+	foreach (boost::tie(varNum, coef), constraint.getCoefficients()) {
+
+		if (_fixed[varNum])
+			continue;
+
+		if (forcedToMin)
+			fix(varNum, coef < 0 ? 1 : 0);
+		else
+			fix(varNum, coef < 0 ? 0 : 1);
+
+		_numFixedByConstraints++;
+	}
+}
+
+void
+Presolver::fix(unsigned int varNum, double value) {
+
+	if (_fixed[varNum])
+		return;
+
+	_fixed[varNum]  = true;
+	_values[varNum] = value;
+
+	// revisit all rows of this variable
+	LinearConstraints::index_iterator begin, end;
+	for (boost::tie(begin, end) = _linearConstraints->getVariableConstraints(varNum); begin != end; begin++) {
+
+		if (_removed[*begin] || _queued[*begin])
+			continue;
+
+		_queue.push_back(*begin);
+		_queued[*begin] = true;
+	}
+}
+
+void
+Presolver::removeDuplicateConstraints() {
+
+	typedef std::vector<std::pair<unsigned int, double> > row_type;
+
+	/* Bring all remaining rows into the form
+	 *
+	 *   [free part of row] <= or == [residual],
+	 *
+	 * and hash them by their coefficients. Rows with equal coefficients are
+	 * either duplicates or dominate each other.
+	 */
+
+	unsigned int numConstraints = _linearConstraints->size();
+
+	std::vector<row_type> rows(numConstraints);
+	std::vector<double>   residuals(numConstraints);
+
+	boost::unordered_map<std::size_t, std::vector<unsigned int> > buckets;
+
+	for (unsigned int i = 0; i < numConstraints; i++) {
+
+		if (_removed[i])
+			continue;
+
+		const LinearConstraint& constraint = (*_linearConstraints)[i];
+
+		double sign = (constraint.getRelation() == GreaterEqual ? -1 : 1);
+
+		unsigned int varNum;
+		double coef;
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			if (!_fixed[varNum])
+				rows[i].push_back(std::make_pair(varNum, sign*coef));
+
+		residuals[i] = sign*getResidual(constraint);
+
+		buckets[boost::hash_range(rows[i].begin(), rows[i].end())].push_back(i);
+	}
+
+	typedef boost::unordered_map<std::size_t, std::vector<unsigned int> >::const_iterator bucket_iterator;
+	for (bucket_iterator i = buckets.begin(); i != buckets.end(); i++) {
+
+		const std::vector<unsigned int>& bucket = i->second;
+
+		if (bucket.size() < 2)
+			continue;
+
+		for (unsigned int j = 0; j < bucket.size(); j++) {
+
+			unsigned int a = bucket[j];
+
+			for (unsigned int k = j + 1; k < bucket.size() && !_removed[a]; k++) {
+
+				unsigned int b = bucket[k];
+
+				if (_removed[b] || rows[a] != rows[b])
+					continue;
+
+				bool equalA = ((*_linearConstraints)[a].getRelation() == Equal);
+				bool equalB = ((*_linearConstraints)[b].getRelation() == Equal);
+
+				unsigned int dominated;
+
+				if (equalA && equalB) {
+
+					if (std::abs(residuals[a] - residuals[b]) > Epsilon) {
+
+						BOOST_THROW_EXCEPTION(
+								InfeasibleProblem()
+								<< error_message(
+										"constraints " + boost::lexical_cast<std::string>(a) +
+										" and " + boost::lexical_cast<std::string>(b) +
+										" contradict each other")
+								<< STACK_TRACE);
+					}
+
+					dominated = b;
+
+				} else if (equalA) {
+
+					// a: ax == r_a, b: ax <= r_b
+					if (residuals[a] > residuals[b] + Epsilon)
+						continue;
+
+					dominated = b;
+
+				} else if (equalB) {
+
+					if (residuals[b] > residuals[a] + Epsilon)
+						continue;
+
+					dominated = a;
+
+				} else {
+
+					// keep the tighter one
+					dominated = (residuals[b] < residuals[a] ? a : b);
+				}
+
+				_removed[dominated] = true;
+				_numDuplicates++;
+			}
+		}
+	}
+}
+
+void
+Presolver::fixUnconstrainedVariables() {
+
+	std::vector<bool> used(_numVariables, false);
+
+	for (unsigned int i = 0; i < _linearConstraints->size(); i++) {
+
+		if (_removed[i])
+			continue;
+
+		unsigned int varNum;
+		double coef;
+		foreach (boost::tie(varNum, coef), (*_linearConstraints)[i].getCoefficients())
+			used[varNum] = true;
+	}
+
+	const std::vector<double>& costs = _objective->getCoefficients();
+	double sense = (_objective->getSense() == Minimize ? 1 : -1);
+
+	for (unsigned int i = 0; i < _numVariables; i++) {
+
+		if (_fixed[i] || used[i] || !_binary[i])
+			continue;
+
+		double cost = (i < costs.size() ? sense*costs[i] : 0);
+
+		fix(i, cost < 0 ? 1 : 0);
+		_numUnconstrained++;
+	}
+}
+
+void
+Presolver::createReducedProblem() {
+
+	// create the mapping
+
+	_mapping->clear(_numVariables);
+
+	for (unsigned int i = 0; i < _numVariables; i++)
+		if (_fixed[i])
+			_mapping->setFixed(i, _values[i]);
+		else
+			_mapping->addReduced(i);
+
+	// create the objective
+
+	const std::vector<double>& costs = _objective->getCoefficients();
+
+	*_reducedObjective = LinearObjective(_mapping->getNumReducedVariables());
+	_reducedObjective->setSense(_objective->getSense());
+
+	double constant = _objective->getConstant();
+
+	for (unsigned int i = 0; i < costs.size(); i++) {
+
+		if (_fixed[i]) {
+
+			// don't multiply infinite costs with zero
+			if (_values[i] != 0)
+				constant += costs[i]*_values[i];
+
+		} else {
+
+			_reducedObjective->setCoefficient(_mapping->getReducedVariable(i), costs[i]);
+		}
+	}
+
+	_reducedObjective->setConstant(constant);
+
+	// create the constraints
+
+	_reducedLinearConstraints->clear();
+
+	for (unsigned int i = 0; i < _linearConstraints->size(); i++) {
+
+		if (_removed[i])
+			continue;
+
+		const LinearConstraint& constraint = (*_linearConstraints)[i];
+
+		LinearConstraint reduced;
+
+		unsigned int varNum;
+		double coef;
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+			if (!_fixed[varNum])
+				reduced.setCoefficient(_mapping->getReducedVariable(varNum), coef);
+
+		reduced.setRelation(constraint.getRelation());
+		reduced.setValue(getResidual(constraint));
+
+		_reducedLinearConstraints->add(reduced);
+	}
+
+	// create the parameters
+
+	if (_parameters.isSet()) {
+
+		*_reducedParameters = LinearSolverParameters(_parameters->getDefaultVariableType());
+
+		// keep the termination criteria
+		_reducedParameters->setTimeLimit(_parameters->getTimeLimit());
+		_reducedParameters->setOptimalityGap(_parameters->getOptimalityGap());
+		_reducedParameters->setRelaxed(_parameters->isRelaxed());
+
+		unsigned int varNum;
+		VariableType type;
+		foreach (boost::tie(varNum, type), _parameters->getSpecialVariableTypes())
+			if (varNum < _numVariables && !_fixed[varNum])
+				_reducedParameters->setVariableType(_mapping->getReducedVariable(varNum), type);
+
+	} else {
+
+		*_reducedParameters = LinearSolverParameters(Continuous);
+	}
+}
+
+double
+Presolver::getResidual(const LinearConstraint& constraint) {
+
+	double residual = constraint.getValue();
+
+	unsigned int varNum;
+	double coef;
+	foreach (boost::tie(varNum, coef), constraint.getCoefficients())
+		if (_fixed[varNum])
+			residual -= coef*_values[varNum];
+
+	return residual;
+}
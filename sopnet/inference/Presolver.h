@@ -0,0 +1,113 @@
+#ifndef INFERENCE_PRESOLVER_H__
+#define INFERENCE_PRESOLVER_H__
+
+#include <deque>
+
+#include <pipeline/all.h>
+#include <util/exceptions.h>
+#include "LinearConstraints.h"
+#include "LinearObjective.h"
+#include "LinearSolverParameters.h"
+#include "PresolveMapping.h"
+
+struct InfeasibleProblem : virtual Exception {};
+
+/**
+ * Reduces a linear program before it is passed to the LinearSolver. The
+ * presolver
+ *
+ *   • fixes binary variables with infinite costs to zero,
+ *   • fixes variables that are forced by singleton equality rows (and,
+ *     transitively, by rows that become singletons or forcing rows after
+ *     substituting fixed variables),
+ *   • removes redundant, dominated, and duplicate constraints.
+ *
+ * The reduced problem has a contiguous range of variables. Use the
+ * PresolvedSolutionMapper with the mapping output to transform a solution
+ * of the reduced problem into a solution of the original problem. If the
+ * presolver finds that the problem can not be satisfied, it throws an
+ * InfeasibleProblem exception.
+ *
+ * Inputs:
+ *
+ *   objective          : LinearObjective
+ *   linear constraints : LinearConstraints
+ *   parameters         : LinearSolverParameters
+ *
+ * Outputs:
+ *
+ *   objective          : LinearObjective (reduced)
+ *   linear constraints : LinearConstraints (reduced)
+ *   parameters         : LinearSolverParameters (reduced)
+ *   mapping            : PresolveMapping
+ */
+class Presolver : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	Presolver();
+
+private:
+
+	void updateOutputs();
+
+	// fix binary variables with infinite costs
+	void fixInfiniteCostVariables();
+
+	// propagate singleton and forcing rows and remove redundant rows
+	void propagateConstraints();
+
+	// remove constraints that are implied by other constraints with the same
+	// coefficients
+	void removeDuplicateConstraints();
+
+	// fix binary variables that are not used in any constraint
+	void fixUnconstrainedVariables();
+
+	// analyse a single row, fixing variables or removing the row if possible
+	void processConstraint(unsigned int i);
+
+	// fix a variable and schedule all of its rows for processing
+	void fix(unsigned int varNum, double value);
+
+	// assemble the reduced problem and the mapping
+	void createReducedProblem();
+
+	// the value of the rhs of a constraint after substituting the fixed
+	// variables
+	double getResidual(const LinearConstraint& constraint);
+
+	pipeline::Input<LinearObjective>        _objective;
+	pipeline::Input<LinearConstraints>      _linearConstraints;
+	pipeline::Input<LinearSolverParameters> _parameters;
+
+	pipeline::Output<LinearObjective>        _reducedObjective;
+	pipeline::Output<LinearConstraints>      _reducedLinearConstraints;
+	pipeline::Output<LinearSolverParameters> _reducedParameters;
+	pipeline::Output<PresolveMapping>        _mapping;
+
+	unsigned int _numVariables;
+
+	// per variable: is it binary, is it fixed, and to which value
+	std::vector<bool>   _binary;
+	std::vector<bool>   _fixed;
+	std::vector<double> _values;
+
+	// per constraint: was it removed, is it scheduled for processing (every 
+	// push to _queue sets _queued, such that a constraint is in the queue at 
+	// most once)
+	std::vector<bool> _removed;
+	std::vector<bool> _queued;
+
+	std::deque<unsigned int> _queue;
+
+	// statistics
+	unsigned int _numInfiniteCosts;
+	unsigned int _numFixedByConstraints;
+	unsigned int _numUnconstrained;
+	unsigned int _numRedundant;
+	unsigned int _numDuplicates;
+};
+
+#endif // INFERENCE_PRESOLVER_H__
+
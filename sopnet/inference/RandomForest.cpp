@@ -1,7 +1,22 @@
+#include <algorithm>
+#include <cmath>
+
+#include <boost/bind.hpp>
 #include <vigra/random_forest_hdf5_impex.hxx>
+#include <util/Logger.h>
+#include <util/ParallelFor.h>
 #include "RandomForest.h"
 
+static logger::LogChannel randomforestlog("randomforestlog", "[RandomForest] ");
+
+// the number of samples per job in batch predictions
+static const unsigned int SamplesPerJob = 1024;
+
+// the number of samples that traverse the flat forest together
+static const unsigned int FlatBlockSize = 64;
+
 RandomForest::RandomForest() :
+	_flatForestValid(false),
 	_outOfBagError(0),
 	_variableImportance(0) {
 
@@ -70,6 +85,8 @@ RandomForest::train(int numTrees, int numFeatures) {
 		_variableImportance[i] = variableVisitor.variable_importance_(i);
 
 	_numClasses = _rf.class_count();
+
+	compileForest();
 }
 
 double
@@ -98,6 +115,24 @@ RandomForest::getLabel(const std::vector<FeatureType>& sample) {
 std::vector<double>
 RandomForest::getProbabilities(const std::vector<FeatureType>& sample) {
 
+	if (_flatForestValid) {
+
+		bool hasNan = false;
+		for (unsigned int i = 0; i < _numFeatures; i++)
+			if (std::isnan(sample[i]))
+				hasNan = true;
+
+		if (!hasNan) {
+
+			std::vector<double> p(_numClasses, 0);
+			double total = 0;
+
+			evaluateFlat(&sample[0], 1, &p[0], &total);
+
+			return p;
+		}
+	}
+
 	SamplesType s(SamplesSize(1, _numFeatures));
 	ProbsType   probs(ProbsSize(1, _numClasses));
 
@@ -114,6 +149,255 @@ RandomForest::getProbabilities(const std::vector<FeatureType>& sample) {
 	return p;
 }
 
+void
+RandomForest::getProbabilities(
+		const SamplesType&   samples,
+		std::vector<double>& probabilities,
+		unsigned int         classIndex,
+		unsigned int         numThreads) {
+
+	unsigned int numSamples = samples.shape(0);
+
+	probabilities.resize(numSamples);
+
+	if (numSamples == 0)
+		return;
+
+	parallelFor(
+			(numSamples + SamplesPerJob - 1)/SamplesPerJob,
+			numThreads,
+			boost::bind(
+					&RandomForest::predictJob,
+					this,
+					_1,
+					boost::cref(samples),
+					boost::ref(probabilities),
+					classIndex));
+}
+
+unsigned int
+RandomForest::checkFlatForest(const SamplesType& samples) {
+
+	unsigned int numSamples = samples.shape(0);
+
+	std::vector<double> flat(numSamples);
+	std::vector<double> reference(numSamples);
+
+	unsigned int numMismatches = 0;
+
+	for (unsigned int c = 0; c < _numClasses; c++) {
+
+		predictBlock(samples, flat, c, 0, numSamples);
+		predictBlockVigra(samples, reference, c, 0, numSamples);
+
+		for (unsigned int i = 0; i < numSamples; i++)
+			if (flat[i] != reference[i])
+				numMismatches++;
+	}
+
+	return numMismatches;
+}
+
+void
+RandomForest::predictJob(
+		unsigned int         i,
+		const SamplesType&   samples,
+		std::vector<double>& probabilities,
+		unsigned int         classIndex) {
+
+	unsigned int begin = i*SamplesPerJob;
+	unsigned int end   = std::min(begin + SamplesPerJob, static_cast<unsigned int>(samples.shape(0)));
+
+	predictBlock(samples, probabilities, classIndex, begin, end);
+}
+
+void
+RandomForest::predictBlock(
+		const SamplesType&   samples,
+		std::vector<double>& probabilities,
+		unsigned int         classIndex,
+		unsigned int         begin,
+		unsigned int         end) {
+
+	if (!_flatForestValid) {
+
+		predictBlockVigra(samples, probabilities, classIndex, begin, end);
+		return;
+	}
+
+	// the samples of one block in row-major order
+	std::vector<FeatureType> block(FlatBlockSize*_numFeatures);
+	std::vector<double>      probs(FlatBlockSize*_numClasses);
+	std::vector<double>      totals(FlatBlockSize);
+
+	for (unsigned int blockBegin = begin; blockBegin < end; blockBegin += FlatBlockSize) {
+
+		unsigned int blockEnd = std::min(blockBegin + FlatBlockSize, end);
+		unsigned int size     = blockEnd - blockBegin;
+
+		bool hasNan = false;
+
+		for (unsigned int i = 0; i < size; i++)
+			for (unsigned int f = 0; f < _numFeatures; f++) {
+
+				FeatureType value = samples(blockBegin + i, f);
+
+				if (std::isnan(value))
+					hasNan = true;
+
+				block[i*_numFeatures + f] = value;
+			}
+
+		// leave samples with missing features to vigra
+		if (hasNan) {
+
+			predictBlockVigra(samples, probabilities, classIndex, blockBegin, blockEnd);
+			continue;
+		}
+
+		std::fill(probs.begin(), probs.end(), 0.0);
+		std::fill(totals.begin(), totals.end(), 0.0);
+
+		evaluateFlat(&block[0], size, &probs[0], &totals[0]);
+
+		for (unsigned int i = 0; i < size; i++)
+			probabilities[blockBegin + i] = probs[i*_numClasses + classIndex];
+	}
+}
+
+void
+RandomForest::predictBlockVigra(
+		const SamplesType&   samples,
+		std::vector<double>& probabilities,
+		unsigned int         classIndex,
+		unsigned int         begin,
+		unsigned int         end) {
+
+	ProbsType probs(ProbsSize(end - begin, _numClasses));
+
+	_rf.predictProbabilities(
+			samples.subarray(SamplesSize(begin, 0), SamplesSize(end, samples.shape(1))),
+			probs);
+
+	for (unsigned int i = begin; i < end; i++)
+		probabilities[i] = probs(i - begin, classIndex);
+}
+
+void
+RandomForest::compileForest() {
+
+	_flatNodes.clear();
+	_flatRoots.clear();
+	_leafProbabilities.clear();
+
+	_flatForestValid = false;
+
+	if (_rf.options_.tree_count_ <= 0)
+		return;
+
+	int weighted = _rf.options_.predict_weighted_;
+
+	for (int k = 0; k < _rf.options_.tree_count_; k++) {
+
+		const vigra::ArrayVector<vigra::Int32>& topology   = _rf.trees_[k].topology_;
+		const vigra::ArrayVector<double>&       parameters = _rf.trees_[k].parameters_;
+
+		unsigned int root = _flatNodes.size();
+
+		_flatRoots.push_back(root);
+
+		// the vigra topology index of each node of this tree in breadth-first
+		// order, starting with the root at index 2
+		std::vector<vigra::Int32> nodes(1, 2);
+
+		for (unsigned int n = 0; n < nodes.size(); n++) {
+
+			vigra::Int32 index         = nodes[n];
+			vigra::Int32 type          = topology[index];
+			vigra::Int32 parameterAddr = topology[index + 1];
+
+			FlatNode node;
+
+			if (type == vigra::i_ThresholdNode) {
+
+				// topology: type, parameters, left, right, column
+				// parameters: weight, threshold
+				node.threshold = parameters[parameterAddr + 1];
+				node.feature   = topology[index + 4];
+				node.child     = root + nodes.size();
+
+				nodes.push_back(topology[index + 2]);
+				nodes.push_back(topology[index + 3]);
+
+			} else if (type == vigra::e_ConstProbNode) {
+
+				// parameters: weight, class probabilities
+				double weight = weighted*parameters[parameterAddr] + (1 - weighted);
+
+				node.threshold = 0;
+				node.feature   = -1;
+				node.child     = _leafProbabilities.size();
+
+				// same arithmetic as in vigra's predictProbabilities
+				for (unsigned int c = 0; c < _numClasses; c++)
+					_leafProbabilities.push_back(parameters[parameterAddr + 1 + c]*weight);
+
+			} else {
+
+				LOG_ERROR(randomforestlog)
+						<< "node type " << type
+						<< " can not be flattened, using vigra for prediction" << std::endl;
+
+				_flatNodes.clear();
+				_flatRoots.clear();
+				_leafProbabilities.clear();
+
+				return;
+			}
+
+			_flatNodes.push_back(node);
+		}
+	}
+
+	_flatForestValid = true;
+}
+
+void
+RandomForest::evaluateFlat(
+		const FeatureType* features,
+		unsigned int       numSamples,
+		double*            probs,
+		double*            totals) const {
+
+	// Let all samples traverse one tree before going to the next, such that
+	// the tree stays in cache. Per sample, probabilities are summed in the
+	// same order as in vigra, which makes the results identical.
+	for (unsigned int k = 0; k < _flatRoots.size(); k++) {
+
+		for (unsigned int s = 0; s < numSamples; s++) {
+
+			const FeatureType* sample = features + s*_numFeatures;
+
+			const FlatNode* node = &_flatNodes[_flatRoots[k]];
+
+			while (node->feature >= 0)
+				node = &_flatNodes[node->child + (sample[node->feature] < node->threshold ? 0 : 1)];
+
+			const double* leaf = &_leafProbabilities[node->child];
+
+			for (unsigned int c = 0; c < _numClasses; c++) {
+
+				probs[s*_numClasses + c] += leaf[c];
+				totals[s] += leaf[c];
+			}
+		}
+	}
+
+	for (unsigned int s = 0; s < numSamples; s++)
+		for (unsigned int c = 0; c < _numClasses; c++)
+			probs[s*_numClasses + c] /= totals[s];
+}
+
 void
 RandomForest::write(std::string filename) {
 
@@ -121,7 +405,7 @@ RandomForest::write(std::string filename) {
 
 		vigra::rf_export_HDF5(_rf, filename);
 
-	} catch (std::runtime_error e) {
+	} catch (std::runtime_error& e) {
 
 		std::cerr << "[RandomForest] could not write to file: "
 		          << e.what() << std::endl;
@@ -135,7 +419,7 @@ RandomForest::read(std::string filename) {
 
 		vigra::rf_import_HDF5(_rf, filename);
 
-	} catch (std::runtime_error e) {
+	} catch (std::runtime_error& e) {
 
 		std::cerr << "[RandomForest] could not read from file: "
 		          << e.what() << std::endl;
@@ -143,5 +427,7 @@ RandomForest::read(std::string filename) {
 
 	_numFeatures = _rf.feature_count();
 	_numClasses  = _rf.class_count();
+
+	compileForest();
 }
 
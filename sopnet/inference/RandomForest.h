@@ -64,6 +64,35 @@ public:
 	 */
 	std::vector<double> getProbabilities(const std::vector<FeatureType>& sample);
 
+	/**
+	 * Get the probability of class classIndex for each row of a sample matrix.
+	 * The rows are split into batches that are predicted in parallel by up to
+	 * numThreads threads (0 uses all available CPUs).
+	 */
+	void getProbabilities(
+			const SamplesType&   samples,
+			std::vector<double>& probabilities,
+			unsigned int         classIndex = 1,
+			unsigned int         numThreads = 0);
+
+	/**
+	 * Compare the predictions of the flattened forest with the ones of vigra's 
+	 * implementation on each row of the given samples. Returns the number of 
+	 * sample and class pairs for which the probabilities are not exactly 
+	 * equal.
+	 */
+	unsigned int checkFlatForest(const SamplesType& samples);
+
+	/**
+	 * Is the forest evaluated on the flattened trees?
+	 */
+	bool hasFlatForest() const { return _flatForestValid; }
+
+	/**
+	 * Get the number of features the classifier expects per sample.
+	 */
+	unsigned int getNumFeatures() const { return _numFeatures; }
+
 	/**
 	 * Write the classifier to a file.
 	 */
@@ -76,10 +105,68 @@ public:
 
 private:
 
+	// a node of the flattened forest
+	struct FlatNode {
+
+		// the threshold of an inner node
+		double threshold;
+
+		// the feature to compare against the threshold, -1 for leaves
+		int feature;
+
+		// for inner nodes the index of the left child (the right child
+		// follows immediately), for leaves the offset of the class
+		// probabilities in _leafProbabilities
+		unsigned int child;
+	};
+
+	// predict the class probability of the i-th batch of rows of samples
+	void predictJob(
+			unsigned int         i,
+			const SamplesType&   samples,
+			std::vector<double>& probabilities,
+			unsigned int         classIndex);
+
+	// predict the class probability of the rows [begin, end) of samples
+	void predictBlock(
+			const SamplesType&   samples,
+			std::vector<double>& probabilities,
+			unsigned int         classIndex,
+			unsigned int         begin,
+			unsigned int         end);
+
+	// same as predictBlock, but using vigra's implementation
+	void predictBlockVigra(
+			const SamplesType&   samples,
+			std::vector<double>& probabilities,
+			unsigned int         classIndex,
+			unsigned int         begin,
+			unsigned int         end);
+
+	// compile the vigra forest into the flat representation
+	void compileForest();
+
+	// evaluate the flat forest on numSamples samples, given row-major in
+	// features, and store the class probabilities row-major in probs
+	void evaluateFlat(
+			const FeatureType* features,
+			unsigned int       numSamples,
+			double*            probs,
+			double*            totals) const;
+
 	// random forest implementation
 
 	RandomForestType _rf;
 
+	// the same forest with the trees stored in flat arrays in breadth-first
+	// order, each leaf holding its (weighted) class probabilities
+
+	std::vector<FlatNode>     _flatNodes;
+	std::vector<unsigned int> _flatRoots;
+	std::vector<double>       _leafProbabilities;
+
+	bool _flatForestValid;
+
 	// training data
 
 	SamplesType _samples;
@@ -0,0 +1,121 @@
+#ifndef INFERENCE_SOLVER_STATISTICS_H__
+#define INFERENCE_SOLVER_STATISTICS_H__
+
+#include <cmath>
+#include <vector>
+
+#include <pipeline/all.h>
+
+/**
+ * Statistics about a run of a solver backend: the trajectory of incumbent
+ * solutions, the final bound, and why the solver stopped.
+ */
+class SolverStatistics : public pipeline::Data {
+
+public:
+
+	/**
+	 * The reason for the solver to stop.
+	 */
+	enum Status {
+
+		// the solver has not been run yet
+		NotSolved,
+
+		// the solution is optimal (within the requested optimality gap)
+		Optimal,
+
+		// the time limit was reached, the solution is the best incumbent
+		TimeLimit,
+
+		// the solution was found by a heuristic, the bound is the value of a
+		// relaxation
+		Heuristic,
+
+		// no solution was found
+		Failed
+	};
+
+	/**
+	 * An improving solution found during the search.
+	 */
+	struct Incumbent {
+
+		// seconds since the start of the solver
+		double time;
+
+		// the value of the objective
+		double value;
+
+		// the best bound on the objective at that time
+		double bound;
+	};
+
+	SolverStatistics() {
+
+		clear();
+	}
+
+	void clear() {
+
+		_incumbents.clear();
+		_status  = NotSolved;
+		_runtime = 0;
+		_value   = 0;
+		_bound   = 0;
+	}
+
+	void addIncumbent(double time, double value, double bound) {
+
+		Incumbent incumbent;
+		incumbent.time  = time;
+		incumbent.value = value;
+		incumbent.bound = bound;
+
+		_incumbents.push_back(incumbent);
+	}
+
+	const std::vector<Incumbent>& getIncumbents() const { return _incumbents; }
+
+	void setStatus(Status status) { _status = status; }
+
+	Status getStatus() const { return _status; }
+
+	void setRuntime(double runtime) { _runtime = runtime; }
+
+	double getRuntime() const { return _runtime; }
+
+	void setValue(double value) { _value = value; }
+
+	double getValue() const { return _value; }
+
+	void setBound(double bound) { _bound = bound; }
+
+	double getBound() const { return _bound; }
+
+	/**
+	 * Get the relative gap between the final value and bound.
+	 */
+	double getGap() const {
+
+		if (_value == 0)
+			return (_bound == 0 ? 0 : 1);
+
+		return std::abs(_value - _bound)/std::abs(_value);
+	}
+
+private:
+
+	std::vector<Incumbent> _incumbents;
+
+	Status _status;
+
+	double _runtime;
+
+	double _value;
+
+	double _bound;
+};
+
+#endif // INFERENCE_SOLVER_STATISTICS_H__
+
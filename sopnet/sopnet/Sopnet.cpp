@@ -3,7 +3,11 @@
 
 #include <imageprocessing/ImageStack.h>
 #include <inference/io/RandomForestHdf5Reader.h>
+#include <inference/ComponentSolver.h>
+#include <inference/GreedyRounding.h>
 #include <inference/LinearSolver.h>
+#include <inference/Presolver.h>
+#include <inference/PresolvedSolutionMapper.h>
 #include <pipeline/Process.h>
 #include <util/foreach.h>
 #include <util/ProgramOptions.h>
@@ -11,11 +15,15 @@
 #include <sopnet/features/SegmentFeaturesExtractor.h>
 #include <sopnet/inference/ProblemGraphWriter.h>
 #include <sopnet/inference/ObjectiveGenerator.h>
+#include <sopnet/inference/ParallelGridSearch.h>
 #include <sopnet/inference/ProblemAssembler.h>
+#include <sopnet/inference/SlidingWindowSolver.h>
 #include <sopnet/inference/SubproblemsExtractor.h>
 #include <sopnet/inference/SubproblemsSolver.h>
 #include <sopnet/inference/LinearCostFunction.h>
 #include <sopnet/inference/io/LinearCostFunctionParametersReader.h>
+#include <sopnet/inference/io/WarmStartReader.h>
+#include <sopnet/inference/io/WarmStartWriter.h>
 #include <sopnet/inference/RandomForestCostFunction.h>
 #include <sopnet/inference/SegmentationCostFunction.h>
 #include <sopnet/inference/PriorCostFunction.h>
@@ -72,6 +80,74 @@ util::ProgramOption optionDecomposeProblem(
 		util::_description_text = "Decompose the problem into overlapping subproblems and solve them using SCALAR.",
 		util::_default_value    = false);
 
+util::ProgramOption optionPreview(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "preview",
+		util::_description_text = "Solve only the linear relaxation of the problem and round its solution greedily. Much faster than "
+		                          "solving the integer program, but the solution is not optimal.",
+		util::_default_value    = false);
+
+util::ProgramOption optionPreviewTimeLimit(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "previewTimeLimit",
+		util::_description_text = "The time limit in seconds for solving the linear relaxation in the preview. If the relaxation is not "
+		                          "solved in time, the preview is rounded from the segment costs alone. 0 uses the solverTimeLimit.",
+		util::_default_value    = 10);
+
+util::ProgramOption optionSlidingWindow(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "slidingWindow",
+		util::_description_text = "Solve the problem in overlapping windows of inter-section intervals along z and write the committed "
+		                          "segments to the partial solution file. The problem is still assembled for the whole stack, only the "
+		                          "linear solver sees one window at a time.",
+		util::_default_value    = false);
+
+util::ProgramOption optionPresolve(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "presolve",
+		util::_description_text = "Reduce the problem before passing it to the linear solver by fixing variables with infinite costs or "
+		                          "forced values and by removing redundant and duplicate constraints.",
+		util::_default_value    = false);
+
+util::ProgramOption optionSplitComponents(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "splitComponents",
+		util::_description_text = "Split the problem into independent components and solve them concurrently.",
+		util::_default_value    = false);
+
+util::ProgramOption optionWarmStart(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "warmStart",
+		util::_description_text = "Store the solution by segment hashes and use it as the initial solution of the next run.",
+		util::_default_value    = false);
+
+util::ProgramOption optionWarmStartFile(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "warmStartFile",
+		util::_description_text = "The file to store the solution for warm starts in.",
+		util::_default_value    = "./warm_start.txt");
+
+util::ProgramOption optionLazyExplanationConstraints(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "lazyExplanationConstraints",
+		util::_description_text = "Start the solver with the conflict constraints only and add violated explanation constraints until "
+		                          "there are none left. Disables the presolve.",
+		util::_default_value    = false);
+
+util::ProgramOption optionSolverTimeLimit(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "solverTimeLimit",
+		util::_description_text = "Stop the solver after this many seconds and use the best solution found so far. The default (0) uses "
+		                          "the time limit of the solver backend.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionSolverOptimalityGap(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "solverOptimalityGap",
+		util::_description_text = "Stop the solver as soon as the relative gap between the best solution and the bound is below this "
+		                          "value. The default (0) uses the optimality gap of the solver backend.",
+		util::_default_value    = 0);
+
 util::ProgramOption optionReadGoldStandardFromFile(
 		util::_module           = "sopnet.training",
 		util::_long_name        = "readGoldStandardFromFile",
@@ -84,8 +160,13 @@ Sopnet::Sopnet(
 	_segmentFeaturesExtractor(boost::make_shared<SegmentFeaturesExtractor>()),
 	_randomForestReader(boost::make_shared<RandomForestHdf5Reader>(optionRandomForestFile.as<std::string>())),
 	_objectiveGenerator(boost::make_shared<ObjectiveGenerator>()),
-	_linearSolver(boost::make_shared<LinearSolver>()),
+	_linearSolver(
+			optionSplitComponents ?
+			boost::shared_ptr<pipeline::ProcessNode>(boost::make_shared<ComponentSolver>()) :
+			boost::shared_ptr<pipeline::ProcessNode>(boost::make_shared<LinearSolver>())),
+	_greedyRounding(boost::make_shared<GreedyRounding>()),
 	_reconstructor(boost::make_shared<Reconstructor>()),
+	_incumbentReconstructor(boost::make_shared<Reconstructor>()),
 	_groundTruthExtractor(boost::make_shared<GroundTruthExtractor>()),
 	_segmentRfTrainer(boost::make_shared<SegmentRandomForestTrainer>()),
 	_spWriter(boost::make_shared<StructuredProblemWriter>()),
@@ -121,8 +202,17 @@ Sopnet::Sopnet(
 		_goldStandardProvider = boost::make_shared<GoldStandardExtractor>();
 	}
 
+	// the statistics of the rounded preview, or of the linear solver if it 
+	// solves the whole problem
+	if (optionPreview)
+		_solverStatisticsProvider = _greedyRounding;
+	else if (!optionDecomposeProblem && !optionSlidingWindow && !optionSplitComponents)
+		_solverStatisticsProvider = _linearSolver;
+
 	// tell the outside world what we've got
 	registerOutput(_reconstructor->getOutput(), "solution");
+	registerOutput(_incumbentReconstructor->getOutput(), "incumbent solution");
+	if (_solverStatisticsProvider) registerOutput(_solverStatisticsProvider->getOutput("statistics"), "solver statistics");
 	registerOutput(_problemAssembler->getOutput("segments"), "segments");
 	registerOutput(_problemAssembler->getOutput("problem configuration"), "problem configuration");
 	registerOutput(_objectiveGenerator->getOutput("objective"), "objective");
@@ -135,16 +225,19 @@ Sopnet::Sopnet(
 
 	// set input-output dependencies
 	setDependency(_rawSections, _reconstructor->getOutput());
+	setDependency(_rawSections, _incumbentReconstructor->getOutput());
 	setDependency(_rawSections, _objectiveGenerator->getOutput("objective"));
 	setDependency(_rawSections, _segmentRfTrainer->getOutput("random forest"));
 	setDependency(_rawSections, _segmentFeaturesExtractor->getOutput("all features"));
 
 	setDependency(_membranes, _reconstructor->getOutput());
+	setDependency(_membranes, _incumbentReconstructor->getOutput());
 	setDependency(_membranes, _objectiveGenerator->getOutput("objective"));
 	setDependency(_membranes, _segmentRfTrainer->getOutput("random forest"));
 	setDependency(_membranes, _segmentFeaturesExtractor->getOutput("all features"));
 
 	setDependency(_neuronSlices, _reconstructor->getOutput());
+	setDependency(_neuronSlices, _incumbentReconstructor->getOutput());
 	setDependency(_neuronSlices, _problemAssembler->getOutput("segments"));
 	setDependency(_neuronSlices, _problemAssembler->getOutput("problem configuration"));
 	setDependency(_neuronSlices, _objectiveGenerator->getOutput("objective"));
@@ -153,6 +246,7 @@ Sopnet::Sopnet(
 	setDependency(_neuronSlices, _segmentRfTrainer->getOutput("random forest"));
 	setDependency(_neuronSlices, _segmentFeaturesExtractor->getOutput("all features"));
 	setDependency(_neuronSliceStackDirectories, _reconstructor->getOutput());
+	setDependency(_neuronSliceStackDirectories, _incumbentReconstructor->getOutput());
 	setDependency(_neuronSliceStackDirectories, _problemAssembler->getOutput("segments"));
 	setDependency(_neuronSliceStackDirectories, _problemAssembler->getOutput("problem configuration"));
 	setDependency(_neuronSliceStackDirectories, _objectiveGenerator->getOutput("objective"));
@@ -161,6 +255,7 @@ Sopnet::Sopnet(
 	setDependency(_neuronSliceStackDirectories, _segmentRfTrainer->getOutput("random forest"));
 	setDependency(_neuronSliceStackDirectories, _segmentFeaturesExtractor->getOutput("all features"));
 	setDependency(_mitochondriaSlices, _reconstructor->getOutput());
+	setDependency(_mitochondriaSlices, _incumbentReconstructor->getOutput());
 	setDependency(_mitochondriaSlices, _problemAssembler->getOutput("segments"));
 	setDependency(_mitochondriaSlices, _problemAssembler->getOutput("problem configuration"));
 	setDependency(_mitochondriaSlices, _objectiveGenerator->getOutput("objective"));
@@ -169,6 +264,7 @@ Sopnet::Sopnet(
 	setDependency(_mitochondriaSlices, _segmentRfTrainer->getOutput("random forest"));
 	setDependency(_mitochondriaSlices, _segmentFeaturesExtractor->getOutput("all features"));
 	setDependency(_mitochondriaSliceStackDirectories, _reconstructor->getOutput());
+	setDependency(_mitochondriaSliceStackDirectories, _incumbentReconstructor->getOutput());
 	setDependency(_mitochondriaSliceStackDirectories, _problemAssembler->getOutput("segments"));
 	setDependency(_mitochondriaSliceStackDirectories, _problemAssembler->getOutput("problem configuration"));
 	setDependency(_mitochondriaSliceStackDirectories, _objectiveGenerator->getOutput("objective"));
@@ -177,6 +273,7 @@ Sopnet::Sopnet(
 	setDependency(_mitochondriaSliceStackDirectories, _segmentRfTrainer->getOutput("random forest"));
 	setDependency(_mitochondriaSliceStackDirectories, _segmentFeaturesExtractor->getOutput("all features"));
 	setDependency(_synapseSlices, _reconstructor->getOutput());
+	setDependency(_synapseSlices, _incumbentReconstructor->getOutput());
 	setDependency(_synapseSlices, _problemAssembler->getOutput("segments"));
 	setDependency(_synapseSlices, _problemAssembler->getOutput("problem configuration"));
 	setDependency(_synapseSlices, _objectiveGenerator->getOutput("objective"));
@@ -185,6 +282,7 @@ Sopnet::Sopnet(
 	setDependency(_synapseSlices, _segmentRfTrainer->getOutput("random forest"));
 	setDependency(_synapseSlices, _segmentFeaturesExtractor->getOutput("all features"));
 	setDependency(_synapseSliceStackDirectories, _reconstructor->getOutput());
+	setDependency(_synapseSliceStackDirectories, _incumbentReconstructor->getOutput());
 	setDependency(_synapseSliceStackDirectories, _problemAssembler->getOutput("segments"));
 	setDependency(_synapseSliceStackDirectories, _problemAssembler->getOutput("problem configuration"));
 	setDependency(_synapseSliceStackDirectories, _objectiveGenerator->getOutput("objective"));
@@ -199,15 +297,33 @@ Sopnet::Sopnet(
 	setDependency(_groundTruth, _segmentRfTrainer->getOutput("random forest"));
 
 	setDependency(_segmentationCostFunctionParameters, _reconstructor->getOutput());
+	setDependency(_segmentationCostFunctionParameters, _incumbentReconstructor->getOutput());
 	setDependency(_segmentationCostFunctionParameters, _objectiveGenerator->getOutput("objective"));
 
 	setDependency(_priorCostFunctionParameters, _reconstructor->getOutput());
+	setDependency(_priorCostFunctionParameters, _incumbentReconstructor->getOutput());
 	setDependency(_priorCostFunctionParameters, _objectiveGenerator->getOutput("objective"));
 
 	setDependency(_forceExplanation, _reconstructor->getOutput());
+	setDependency(_forceExplanation, _incumbentReconstructor->getOutput());
 	setDependency(_forceExplanation, _goldStandardProvider->getOutput("gold standard"));
 	setDependency(_forceExplanation, _goldStandardProvider->getOutput("negative samples"));
 	setDependency(_forceExplanation, _segmentRfTrainer->getOutput("random forest"));
+
+	if (_solverStatisticsProvider) {
+
+		setDependency(_rawSections, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_membranes, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_neuronSlices, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_neuronSliceStackDirectories, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_mitochondriaSlices, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_mitochondriaSliceStackDirectories, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_synapseSlices, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_synapseSliceStackDirectories, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_segmentationCostFunctionParameters, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_priorCostFunctionParameters, _solverStatisticsProvider->getOutput("statistics"));
+		setDependency(_forceExplanation, _solverStatisticsProvider->getOutput("statistics"));
+	}
 }
 
 void
@@ -318,24 +434,24 @@ Sopnet::createInferencePipeline() {
 	_segmentFeaturesExtractor->setInput("segments", _problemAssembler->getOutput("segments"));
 	_segmentFeaturesExtractor->setInput("raw sections", _rawSections.getAssignedOutput());
 
-	boost::shared_ptr<LinearCostFunction>       linearCostFunction;
-	boost::shared_ptr<RandomForestCostFunction> rfCostFunction;
-	boost::shared_ptr<SegmentationCostFunction> segmentationCostFunction;
-	boost::shared_ptr<PriorCostFunction>        priorCostFunction;
+	_linearCostFunction.reset();
+	_rfCostFunction.reset();
+	_segmentationCostFunction.reset();
+	_priorCostFunction.reset();
 
 	// setup the segment evaluation functions
 	if (optionLinearCostFunction) {
 
 		LOG_DEBUG(sopnetlog) << "creating linear segment cost function" << std::endl;
 
-		linearCostFunction = boost::make_shared<LinearCostFunction>();
+		_linearCostFunction = boost::make_shared<LinearCostFunction>();
 		boost::shared_ptr<LinearCostFunctionParametersReader> reader
 				= boost::make_shared<LinearCostFunctionParametersReader>();
 		boost::shared_ptr<FileContentProvider> contentProvider
 				= boost::make_shared<FileContentProvider>(optionLinearCostFunctionParametersFile.as<std::string>());
 		reader->setInput(contentProvider->getOutput());
-		linearCostFunction->setInput("features", _segmentFeaturesExtractor->getOutput("all features"));
-		linearCostFunction->setInput("parameters", reader->getOutput());
+		_linearCostFunction->setInput("features", _segmentFeaturesExtractor->getOutput("all features"));
+		_linearCostFunction->setInput("parameters", reader->getOutput());
 
 	}
 
@@ -343,22 +459,22 @@ Sopnet::createInferencePipeline() {
 
 		LOG_DEBUG(sopnetlog) << "creating random forest segment cost function" << std::endl;
 
-		rfCostFunction = boost::make_shared<RandomForestCostFunction>();
-		rfCostFunction->setInput("features", _segmentFeaturesExtractor->getOutput("all features"));
-		rfCostFunction->setInput("random forest", _randomForestReader->getOutput("random forest"));
+		_rfCostFunction = boost::make_shared<RandomForestCostFunction>();
+		_rfCostFunction->setInput("features", _segmentFeaturesExtractor->getOutput("all features"));
+		_rfCostFunction->setInput("random forest", _randomForestReader->getOutput("random forest"));
 	}
 
 	if (optionSegmentationCostFunction) {
 
-		segmentationCostFunction = boost::make_shared<SegmentationCostFunction>();
-		segmentationCostFunction->setInput("membranes", _membranes);
-		segmentationCostFunction->setInput("parameters", _segmentationCostFunctionParameters);
+		_segmentationCostFunction = boost::make_shared<SegmentationCostFunction>();
+		_segmentationCostFunction->setInput("membranes", _membranes);
+		_segmentationCostFunction->setInput("parameters", _segmentationCostFunctionParameters);
 	}
 
 	if (optionPriorCostFunction) {
 
-		priorCostFunction = boost::make_shared<PriorCostFunction>();
-		priorCostFunction->setInput("parameters", _priorCostFunctionParameters);
+		_priorCostFunction = boost::make_shared<PriorCostFunction>();
+		_priorCostFunction->setInput("parameters", _priorCostFunctionParameters);
 	}
 
 	if (_problemWriter) {
@@ -368,28 +484,63 @@ Sopnet::createInferencePipeline() {
 		_problemWriter->setInput("features", _segmentFeaturesExtractor->getOutput("all features"));
 		
 		// assuming one of the two was selected
-		if (rfCostFunction)
-			_problemWriter->setInput("segment cost function", rfCostFunction->getOutput("cost function"));
+		if (_rfCostFunction)
+			_problemWriter->setInput("segment cost function", _rfCostFunction->getOutput("cost function"));
 		else
-			_problemWriter->setInput("segment cost function", linearCostFunction->getOutput("cost function"));
+			_problemWriter->setInput("segment cost function", _linearCostFunction->getOutput("cost function"));
 
-		_problemWriter->setInput("segmentation cost function", segmentationCostFunction->getOutput("cost function"));
+		_problemWriter->setInput("segmentation cost function", _segmentationCostFunction->getOutput("cost function"));
 		_problemWriter->addInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
 
 	} else {
 
 		// feed all segments to objective generator
 		_objectiveGenerator->setInput("segments", _problemAssembler->getOutput("segments"));
-		if (rfCostFunction)
-			_objectiveGenerator->addInput("cost functions", rfCostFunction->getOutput("cost function"));
-		if (linearCostFunction)
-			_objectiveGenerator->addInput("cost functions", linearCostFunction->getOutput("cost function"));
-		if (segmentationCostFunction)
-			_objectiveGenerator->addInput("cost functions", segmentationCostFunction->getOutput("cost function"));
-		if (priorCostFunction)
-			_objectiveGenerator->addInput("cost functions", priorCostFunction->getOutput("cost function"));
+		if (_rfCostFunction)
+			_objectiveGenerator->addInput("cost functions", _rfCostFunction->getOutput("cost function"));
+		if (_linearCostFunction)
+			_objectiveGenerator->addInput("cost functions", _linearCostFunction->getOutput("cost function"));
+		if (_segmentationCostFunction)
+			_objectiveGenerator->addInput("cost functions", _segmentationCostFunction->getOutput("cost function"));
+		if (_priorCostFunction)
+			_objectiveGenerator->addInput("cost functions", _priorCostFunction->getOutput("cost function"));
+
+		// the component solver has no initial solution
+		bool useWarmStart = optionWarmStart && !optionSplitComponents;
+
+		// lazy constraints are added by the linear solver on the original
+		// variables, so they can neither be presolved nor split into components
+		bool useLazyConstraints = optionLazyExplanationConstraints && !optionSplitComponents;
+
+		if (optionPreview) {
 
-		if (optionDecomposeProblem) {
+			pipeline::Process<LinearSolver> relaxationSolver;
+
+			boost::shared_ptr<LinearSolverParameters> relaxed = createLinearSolverParameters();
+			relaxed->setRelaxed(true);
+
+			// without a relaxed solution, the rounding selects by costs
+			if (optionPreviewTimeLimit.as<double>() > 0)
+				relaxed->setTimeLimit(optionPreviewTimeLimit.as<double>());
+
+			// solve the linear relaxation
+			relaxationSolver->setInput("objective", _objectiveGenerator->getOutput());
+			relaxationSolver->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
+			relaxationSolver->setInput("parameters", relaxed);
+
+			// round it to a feasible solution
+			_greedyRounding->setInput("objective", _objectiveGenerator->getOutput());
+			_greedyRounding->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
+			_greedyRounding->setInput("relaxed solution", relaxationSolver->getOutput("solution"));
+
+			// feed solution and segments to reconstructor
+			_reconstructor->setInput("solution", _greedyRounding->getOutput("solution"));
+			_reconstructor->setInput("segments", _problemAssembler->getOutput("segments"));
+
+			// there are no intermediate solutions
+			_incumbentReconstructor->setInput("solution", _greedyRounding->getOutput("solution"));
+
+		} else if (optionDecomposeProblem) {
 
 			pipeline::Process<SubproblemsExtractor> subproblemsExtractor;
 			pipeline::Process<SubproblemsSolver>    subproblemsSolver;
@@ -404,21 +555,147 @@ Sopnet::createInferencePipeline() {
 			_reconstructor->setInput("solution", subproblemsSolver->getOutput("solution"));
 			_reconstructor->setInput("segments", _problemAssembler->getOutput("segments"));
 
+			// there are no intermediate solutions
+			_incumbentReconstructor->setInput("solution", subproblemsSolver->getOutput("solution"));
+
+		} else if (optionSlidingWindow) {
+
+			pipeline::Process<SlidingWindowSolver> slidingWindowSolver;
+
+			slidingWindowSolver->setInput("objective", _objectiveGenerator->getOutput());
+			slidingWindowSolver->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
+			slidingWindowSolver->setInput("problem configuration", _problemAssembler->getOutput("problem configuration"));
+			slidingWindowSolver->setInput("parameters", createLinearSolverParameters());
+
+			// feed solution and segments to reconstructor
+			_reconstructor->setInput("solution", slidingWindowSolver->getOutput("solution"));
+			_reconstructor->setInput("segments", _problemAssembler->getOutput("segments"));
+
+			// there are no intermediate solutions
+			_incumbentReconstructor->setInput("solution", slidingWindowSolver->getOutput("solution"));
+
+		} else if (optionPresolve && !useLazyConstraints) {
+
+			pipeline::Process<Presolver>               presolver;
+			pipeline::Process<PresolvedSolutionMapper> solutionMapper;
+			pipeline::Process<PresolvedSolutionMapper> incumbentMapper;
+
+			// reduce the problem before it is passed to the ilp solver
+			presolver->setInput("objective", _objectiveGenerator->getOutput());
+			presolver->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
+			presolver->setInput("parameters", createLinearSolverParameters());
+
+			_linearSolver->setInput("objective", presolver->getOutput("objective"));
+			_linearSolver->setInput("linear constraints", presolver->getOutput("linear constraints"));
+			_linearSolver->setInput("parameters", presolver->getOutput("parameters"));
+
+			// map the solution back to the original variables
+			solutionMapper->setInput("solution", _linearSolver->getOutput("solution"));
+			solutionMapper->setInput("mapping", presolver->getOutput("mapping"));
+
+			// map the incumbents as well, the component solver has none
+			if (optionSplitComponents)
+				incumbentMapper->setInput("solution", _linearSolver->getOutput("solution"));
+			else
+				incumbentMapper->setInput("solution", _linearSolver->getOutput("incumbent"));
+			incumbentMapper->setInput("mapping", presolver->getOutput("mapping"));
+			_incumbentReconstructor->setInput("solution", incumbentMapper->getOutput("solution"));
+
+			if (useWarmStart) {
+
+				pipeline::Process<WarmStartReader> warmStartReader(optionWarmStartFile.as<std::string>());
+				pipeline::Process<WarmStartWriter> warmStartWriter(optionWarmStartFile.as<std::string>());
+
+				// start from the previous solution, mapped to the reduced problem
+				warmStartReader->setInput("segments", _problemAssembler->getOutput("segments"));
+				warmStartReader->setInput("problem configuration", _problemAssembler->getOutput("problem configuration"));
+				warmStartReader->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
+				warmStartReader->setInput("mapping", presolver->getOutput("mapping"));
+				_linearSolver->setInput("initial solution", warmStartReader->getOutput("initial solution"));
+
+				// store the solution for the next run
+				warmStartWriter->setInput("solution", solutionMapper->getOutput("solution"));
+				warmStartWriter->setInput("segments", _problemAssembler->getOutput("segments"));
+				warmStartWriter->setInput("problem configuration", _problemAssembler->getOutput("problem configuration"));
+
+				_reconstructor->setInput("solution", warmStartWriter->getOutput("solution"));
+
+			} else {
+
+				_reconstructor->setInput("solution", solutionMapper->getOutput("solution"));
+			}
+
+			// feed segments to reconstructor
+			_reconstructor->setInput("segments", _problemAssembler->getOutput("segments"));
+
 		} else {
 
 			// feed objective and linear constraints to ilp creator
 			_linearSolver->setInput("objective", _objectiveGenerator->getOutput());
-			_linearSolver->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
-			_linearSolver->setInput("parameters", boost::make_shared<LinearSolverParameters>(Binary));
+			_linearSolver->setInput("parameters", createLinearSolverParameters());
 
-			// feed solution and segments to reconstructor
-			_reconstructor->setInput("solution", _linearSolver->getOutput("solution"));
+			if (useLazyConstraints) {
+
+				_linearSolver->setInput("linear constraints", _problemAssembler->getOutput("conflict constraints"));
+				_linearSolver->setInput("lazy constraints", _problemAssembler->getOutput("explanation constraints"));
+
+			} else {
+
+				_linearSolver->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
+			}
+
+			if (useWarmStart) {
+
+				pipeline::Process<WarmStartReader> warmStartReader(optionWarmStartFile.as<std::string>());
+				pipeline::Process<WarmStartWriter> warmStartWriter(optionWarmStartFile.as<std::string>());
+
+				// start from the previous solution
+				warmStartReader->setInput("segments", _problemAssembler->getOutput("segments"));
+				warmStartReader->setInput("problem configuration", _problemAssembler->getOutput("problem configuration"));
+				warmStartReader->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
+				_linearSolver->setInput("initial solution", warmStartReader->getOutput("initial solution"));
+
+				// store the solution for the next run
+				warmStartWriter->setInput("solution", _linearSolver->getOutput("solution"));
+				warmStartWriter->setInput("segments", _problemAssembler->getOutput("segments"));
+				warmStartWriter->setInput("problem configuration", _problemAssembler->getOutput("problem configuration"));
+
+				_reconstructor->setInput("solution", warmStartWriter->getOutput("solution"));
+
+			} else {
+
+				_reconstructor->setInput("solution", _linearSolver->getOutput("solution"));
+			}
+
+			// the component solver has no incumbents
+			if (optionSplitComponents)
+				_incumbentReconstructor->setInput("solution", _linearSolver->getOutput("solution"));
+			else
+				_incumbentReconstructor->setInput("solution", _linearSolver->getOutput("incumbent"));
+
+			// feed segments to reconstructor
 			_reconstructor->setInput("segments", _problemAssembler->getOutput("segments"));
 		}
+
+		_incumbentReconstructor->setInput("segments", _problemAssembler->getOutput("segments"));
 	}
 
 }
 
+boost::shared_ptr<LinearSolverParameters>
+Sopnet::createLinearSolverParameters() {
+
+	boost::shared_ptr<LinearSolverParameters> parameters = boost::make_shared<LinearSolverParameters>(Binary);
+
+	if (optionSolverTimeLimit.as<double>() > 0)
+		parameters->setTimeLimit(optionSolverTimeLimit.as<double>());
+
+	if (optionSolverOptimalityGap.as<double>() > 0)
+		parameters->setOptimalityGap(optionSolverOptimalityGap.as<double>());
+
+	return parameters;
+}
+
 void
 Sopnet::createTrainingPipeline() {
 
@@ -501,3 +778,51 @@ Sopnet::writeMinimalImpactTEDCoefficients(std::string filename) {
 	_mitWriter->write(filename);
 }
 
+
+void
+Sopnet::gridSearch(std::string filename) {
+
+	LOG_DEBUG(sopnetlog) << "requested to perform a grid search, updating inputs" << std::endl;
+
+	updateInputs();
+
+	LOG_DEBUG(sopnetlog) << "creating internal pipeline, if not created yet" << std::endl;
+
+	createPipeline();
+
+	if (!_groundTruth.isSet())
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"a grid search needs the 'ground truth' to be set");
+
+	// the other solvers write their solutions to files or call external 
+	// programs, which the parallel workers can not share
+	if (optionPreview || optionDecomposeProblem || optionSlidingWindow)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"a grid search can not be combined with 'preview', 'decomposeProblem', or 'slidingWindow'");
+
+	ParallelGridSearch::Options options;
+	options.priorCostFunction = optionPriorCostFunction.as<bool>();
+	options.presolve          = optionPresolve.as<bool>();
+	options.splitComponents   = optionSplitComponents.as<bool>();
+
+	pipeline::Process<ParallelGridSearch> gridSearch(options);
+
+	gridSearch->setInput("segments", _problemAssembler->getOutput("segments"));
+	gridSearch->setInput("linear constraints", _problemAssembler->getOutput("linear constraints"));
+	gridSearch->setInput("parameters", createLinearSolverParameters());
+	if (_rfCostFunction)
+		gridSearch->addInput("cost functions", _rfCostFunction->getOutput("cost function"));
+	if (_linearCostFunction)
+		gridSearch->addInput("cost functions", _linearCostFunction->getOutput("cost function"));
+	if (_segmentationCostFunction)
+		gridSearch->setInput("membranes", _membranes);
+	gridSearch->setInput("ground truth", _groundTruth);
+	gridSearch->setInput("ground truth segments", _groundTruthExtractor->getOutput("ground truth segments"));
+	gridSearch->setInput("gold standard segments", _goldStandardProvider->getOutput("gold standard"));
+
+	LOG_DEBUG(sopnetlog) << "performing grid search" << std::endl;
+
+	gridSearch->run(filename);
+}
@@ -13,13 +13,15 @@ class GoldStandardExtractor;
 class GroundTruthExtractor;
 class ImageExtractor;
 class ImageStack;
-class LinearSolver;
+class LinearCostFunction;
 class ObjectiveGenerator;
 class PriorCostFunction;
 class ProblemAssembler;
 class RandomForestCostFunction;
 class RandomForestHdf5Reader;
+class GreedyRounding;
 class Reconstructor;
+struct LinearSolverParameters;
 class SectionSelector;
 class SegmentEvaluator;
 class SegmentExtractor;
@@ -46,6 +48,20 @@ public:
 
 	void writeMinimalImpactTEDCoefficients(std::string filename);
 
+	/**
+	 * Evaluate the grid of prior and segmentation cost parameters (as given by
+	 * the GridSearch options) in parallel against the ground truth and write
+	 * one line per grid point to the given file.
+	 */
+	void gridSearch(std::string filename);
+
+	/**
+	 * Does this Sopnet provide the output "solver statistics"? This is the 
+	 * case if the whole problem is solved by a single linear solver, or 
+	 * rounded from its relaxation in the preview.
+	 */
+	bool hasSolverStatistics() const { return _solverStatisticsProvider; }
+
 private:
 
 	void updateOutputs();
@@ -62,6 +78,10 @@ private:
 
 	void createMinimalImpactTEDPipeline();
 
+	// create the parameters for the solvers of the inference pipeline, with 
+	// the time limit and optimality gap given by the program options
+	boost::shared_ptr<LinearSolverParameters> createLinearSolverParameters();
+
 	/**********
 	 * INPUTS *
 	 **********/
@@ -129,16 +149,32 @@ private:
 	// a random forest file reader
 	boost::shared_ptr<RandomForestHdf5Reader>         	_randomForestReader;
 
+	// the cost functions, the ones that are not used are not set
+	boost::shared_ptr<LinearCostFunction>             	_linearCostFunction;
+	boost::shared_ptr<RandomForestCostFunction>       	_rfCostFunction;
+	boost::shared_ptr<SegmentationCostFunction>       	_segmentationCostFunction;
+	boost::shared_ptr<PriorCostFunction>              	_priorCostFunction;
+
 	// the objective generator that computes the costs for each segment
 	boost::shared_ptr<ObjectiveGenerator>             	_objectiveGenerator;
 
-	// the linear solver
-	boost::shared_ptr<LinearSolver>                   	_linearSolver;
+	// the linear solver (a LinearSolver or a ComponentSolver)
+	boost::shared_ptr<pipeline::ProcessNode>          	_linearSolver;
+
+	// rounds the relaxed solution in the preview
+	boost::shared_ptr<GreedyRounding>                 	_greedyRounding;
+
+	// the node providing the statistics output of the solver, if any
+	boost::shared_ptr<pipeline::ProcessNode>          	_solverStatisticsProvider;
 
 	// the last proess node in the internal pipeline, providing the final
 	// solution
 	boost::shared_ptr<Reconstructor>                  	_reconstructor;
 
+	// reconstructs the incumbent solutions while the solver is running, and 
+	// the final solution afterwards
+	boost::shared_ptr<Reconstructor>                  	_incumbentReconstructor;
+
 	/*
 	 * training part
 	 */
@@ -1,7 +1,13 @@
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
 #include <util/Logger.h>
 #include <util/ProgramOptions.h>
 #include <util/helpers.hpp>
+#include <util/ParallelFor.h>
 #include "AnisotropicEditDistance.h"
+#include "ContingencyTableExtractor.h"
 
 logger::LogChannel resultevaluatorlog("resultevaluatorlog", "[AnisotropicEditDistance] ");
 
@@ -40,7 +46,7 @@ AnisotropicEditDistance::updateOutputs() {
 
 	// pointers from any mapping of any section to the mapping in the previous 
 	// section with minimal accumulated slice error
-	std::vector<std::map<int, int> > bestPreviousMapping;
+	std::vector<std::vector<unsigned int> > bestPreviousMapping;
 
 	// all minimal sliceErrors until a section and a mapping of this section
 	std::vector<std::vector<AnisotropicEditDistanceErrors> > accumulatedSliceErrors;
@@ -55,8 +61,8 @@ AnisotropicEditDistance::updateOutputs() {
 
 		Mappings& currentMappings = allMappings[section];
 
-		// new map of mappings to mappings for current section
-		bestPreviousMapping.push_back(std::map<int, int>());
+		// new vector of pointers to previous mappings for current section
+		bestPreviousMapping.push_back(std::vector<unsigned int>(currentMappings.size(), 0));
 
 		if (section == 0) {
 
@@ -81,46 +87,30 @@ AnisotropicEditDistance::updateOutputs() {
 
 		Mappings& previousMappings = allMappings[section - 1];
 
-		// Compute slice errors of all mappings of current section when combined 
-		// with any mapping of previous section.
-
-		std::map<int, std::map<int, AnisotropicEditDistanceErrors> > sliceErrors;
-
-		LOG_DEBUG(resultevaluatorlog)
-				<< "computing slice errors for all " << currentMappings.size() << "x"
-				<< previousMappings.size() << " combinations" << std::endl;
-
-		for (unsigned int i = 0; i < currentMappings.size(); i++)
-			for (unsigned int j = 0; j < previousMappings.size(); j++)
-				sliceErrors[i][j] = getSliceErrors(currentMappings[i], previousMappings[j], section);
-
 		// For each mapping of the current section, get the minimal number of 
 		// slice errors up to the current section, remember which mapping in the 
-		// previous section was involved.
-
-		LOG_ALL(resultevaluatorlog) << "searching for minimal accumulated slice errors" << std::endl;
-
-		for (unsigned int i = 0; i < currentMappings.size(); i++) {
-
-			int numSliceErrors = -1;
-
-			for (unsigned int j = 0; j < previousMappings.size(); j++) {
+		// previous section was involved. Combinations with the previous 
+		// mappings that can not improve on the best one found so far are 
+		// skipped.
 
-				// the sliceError until j in the previous section
-				const AnisotropicEditDistanceErrors& previousSliceErrors = accumulatedSliceErrors[section-1][j];
-
-				// the sliceError until i when going over j
-				AnisotropicEditDistanceErrors currentSliceErrors = sliceErrors[i][j] + previousSliceErrors;
+		LOG_DEBUG(resultevaluatorlog)
+				<< "searching for minimal accumulated slice errors in " << currentMappings.size() << "x"
+				<< previousMappings.size() << " combinations" << std::endl;
 
-				// remember the best j
-				if (currentSliceErrors.total() < numSliceErrors || numSliceErrors == -1) {
-
-					numSliceErrors = currentSliceErrors.total();
-					bestPreviousMapping[section][i] = j;
-					accumulatedSliceErrors[section][i] = currentSliceErrors;
-				}
-			}
-		}
+		prepareMappings(currentMappings, previousMappings, accumulatedSliceErrors[section-1], section);
+
+		parallelFor(
+				currentMappings.size(),
+				optionEvaluationNumThreads.as<unsigned int>(),
+				boost::bind(
+						&AnisotropicEditDistance::findBestPreviousMapping,
+						this,
+						_1,
+						boost::cref(currentMappings),
+						boost::cref(accumulatedSliceErrors[section-1]),
+						boost::ref(accumulatedSliceErrors[section]),
+						boost::ref(bestPreviousMapping[section]),
+						section));
 
 		LOG_ALL(resultevaluatorlog) << "section " << section << ": " << accumulatedSliceErrors[section] << std::endl;
 
@@ -424,24 +414,158 @@ AnisotropicEditDistance::createMappings(
 	LOG_ALL(resultevaluatorlog) << "done with slice #" << numSlice << std::endl;
 }
 
-AnisotropicEditDistanceErrors
-AnisotropicEditDistance::getSliceErrors(
-		const Mapping& mapping,
-		const Mapping& previousMapping,
+void
+AnisotropicEditDistance::prepareMappings(
+		const Mappings& currentMappings,
+		const Mappings& previousMappings,
+		std::vector<AnisotropicEditDistanceErrors>& previousSliceErrors,
 		unsigned int section) {
 
-	// Compute the slice errors for the given mappings of 'section' and the 
-	// previous section.
+	_currentPartners.clear();
+	_previousPartners.clear();
+	_currentUnmatchedLinks.clear();
+	_previousUnmatchedLinks.clear();
+	_previousTotals.clear();
+
+	foreach (const Mapping& mapping, currentMappings) {
+
+		_currentPartners.push_back(getPartners(mapping));
+		_currentUnmatchedLinks.push_back(getNumUnmatchedLinks(_currentPartners.back(), section, false));
+	}
+
+	foreach (const Mapping& mapping, previousMappings) {
+
+		_previousPartners.push_back(getPartners(mapping));
+		_previousUnmatchedLinks.push_back(getNumUnmatchedLinks(_previousPartners.back(), section, true));
+	}
+
+	// order the previous mappings by their accumulated slice errors, such that 
+	// the most promising ones are considered first
+	std::vector<std::pair<int, unsigned int> > order;
+
+	for (unsigned int j = 0; j < previousMappings.size(); j++) {
+
+		_previousTotals.push_back(previousSliceErrors[j].total());
+		order.push_back(std::make_pair(_previousTotals[j], j));
+	}
+
+	std::sort(order.begin(), order.end());
+
+	_previousOrder.clear();
+	for (unsigned int k = 0; k < order.size(); k++)
+		_previousOrder.push_back(order[k].second);
+}
+
+void
+AnisotropicEditDistance::findBestPreviousMapping(
+		unsigned int i,
+		const Mappings& currentMappings,
+		const std::vector<AnisotropicEditDistanceErrors>& previousSliceErrors,
+		std::vector<AnisotropicEditDistanceErrors>& currentSliceErrors,
+		std::vector<unsigned int>& bestPreviousMapping,
+		unsigned int section) {
+
+	// The errors of the sections and of the intra- and inter-section errors 
+	// are disjoint, such that the total of a combination is the sum of the 
+	// totals of its parts. Together with the number of links that are errors 
+	// under any partner mapping, this gives a lower bound on the total of 
+	// each combination.
+
+	AnisotropicEditDistanceErrors intraSliceErrors = getIntraSliceErrors(currentMappings[i], section);
+
+	int numIntraSliceErrors = intraSliceErrors.total();
+
+	int          minTotal = -1;
+	unsigned int best     = 0;
+
+	unsigned int numEvaluated = 0;
+
+	foreach (unsigned int j, _previousOrder) {
+
+		if (minTotal != -1) {
+
+			int bound = numIntraSliceErrors + _previousTotals[j];
 
-	// Get intra-section slice errors.
+			// the previous mappings are ordered by their totals, none of the 
+			// remaining ones can be better
+			if (bound + _currentUnmatchedLinks[i] > minTotal)
+				break;
 
-	AnisotropicEditDistanceErrors intraSliceErrors = getIntraSliceErrors(mapping, section);
+			bound += std::max(_currentUnmatchedLinks[i], _previousUnmatchedLinks[j]);
 
-	// Get inter-section slice errors.
+			// of several optimal previous mappings, the first one wins
+			if (bound > minTotal || (bound == minTotal && j > best))
+				continue;
+		}
+
+		AnisotropicEditDistanceErrors sliceErrors =
+				intraSliceErrors +
+				getInterSliceErrors(_currentPartners[i], _previousPartners[j], section) +
+				previousSliceErrors[j];
+
+		numEvaluated++;
+
+		int total = sliceErrors.total();
+
+		// remember the best j
+		if (minTotal == -1 || total < minTotal || (total == minTotal && j < best)) {
+
+			minTotal = total;
+			best     = j;
+			currentSliceErrors[i] = sliceErrors;
+		}
+	}
 
-	AnisotropicEditDistanceErrors interSliceErrors = getInterSliceErrors(mapping, previousMapping, section);
+	bestPreviousMapping[i] = best;
 
-	return intraSliceErrors + interSliceErrors;
+	LOG_ALL(resultevaluatorlog)
+			<< "evaluated " << numEvaluated << " of " << _previousOrder.size()
+			<< " previous mappings for mapping " << i << std::endl;
+}
+
+AnisotropicEditDistance::Partners
+AnisotropicEditDistance::getPartners(const Mapping& mapping) {
+
+	// Create a look-up table for result ids to ground-truth ids under the 
+	// given mapping.
+	Partners partners;
+
+	int r, g;
+	foreach (boost::tie(r, g), mapping)
+		partners[r].push_back(g);
+
+	return partners;
+}
+
+int
+AnisotropicEditDistance::getNumUnmatchedLinks(
+		const Partners& partners,
+		unsigned int section,
+		bool previous) {
+
+	std::set<int> mappedIds;
+
+	int r;
+	std::vector<int> gs;
+	foreach (boost::tie(r, gs), partners)
+		mappedIds.insert(gs.begin(), gs.end());
+
+	int numUnmatchedLinks = 0;
+
+	// Result links whose slice in this section is not mapped are false merges, 
+	// ground-truth links whose slice in this section is not mapped are false 
+	// splits.
+
+	int a, b;
+	foreach (boost::tie(a, b), _resultLinks[section])
+		if (!partners.count(previous ? a : b))
+			numUnmatchedLinks++;
+
+	foreach (boost::tie(a, b), _groundTruthLinks[section])
+		if (!mappedIds.count(previous ? a : b))
+			numUnmatchedLinks++;
+
+	return numUnmatchedLinks;
 }
 
 AnisotropicEditDistanceErrors
@@ -497,51 +621,38 @@ AnisotropicEditDistance::getIntraSliceErrors(const Mapping& mapping, unsigned in
 
 AnisotropicEditDistanceErrors
 AnisotropicEditDistance::getInterSliceErrors(
-		const Mapping& mapping,
-		const Mapping& previousMapping,
+		const Partners& partnersOf,
+		const Partners& previousPartnersOf,
 		unsigned int section) {
 
 	AnisotropicEditDistanceErrors interSliceErrors;
 
-	// Create a look-up table for result ids to ground-truth ids under the 
-	// current mapping.
-	std::map<int, std::vector<int> > partnersOf;
-	std::map<int, std::vector<int> > previousPartnersOf;
-
-	int r, g;
-	foreach (boost::tie(r, g), mapping)
-		partnersOf[r].push_back(g);
-	foreach (boost::tie(r, g), previousMapping)
-		previousPartnersOf[r].push_back(g);
-
 	// Get all links in result.
-	std::set<std::pair<int, int> > resultLinks = _resultLinks[section];
+	const std::set<std::pair<int, int> >& resultLinks = _resultLinks[section];
 	std::set<std::pair<int, int> > trueResultLinks;
 
 	// Get all links in ground-truth.
-	std::set<std::pair<int, int> > groundTruthLinks = _groundTruthLinks[section];
+	const std::set<std::pair<int, int> >& groundTruthLinks = _groundTruthLinks[section];
 	std::set<std::pair<int, int> > foundGroundTruthLinks;
 
 	int a, b;
 
-	LOG_ALL(resultevaluatorlog) << "result links: ";
-	foreach (boost::tie(a, b), resultLinks)
-		LOG_ALL(resultevaluatorlog) << "    (" << a << ", " << b << ")" << std::endl;
-
-	LOG_ALL(resultevaluatorlog) << "ground truth links: ";
-	foreach (boost::tie(a, b), groundTruthLinks)
-		LOG_ALL(resultevaluatorlog) << "    (" << a << ", " << b << ")" << std::endl;
-
 	// For each link in result...
 	foreach (boost::tie(a, b), resultLinks) {
 
 		// ...find all corresponding links in ground-truth.
 
+		Partners::const_iterator previousPartners = previousPartnersOf.find(a);
+		Partners::const_iterator partners         = partnersOf.find(b);
+
+		if (previousPartners == previousPartnersOf.end() || partners == partnersOf.end())
+			continue;
+
 		// For each partner pa of a
-		foreach (int pa, previousPartnersOf[a]) {
+		foreach (int pa, previousPartners->second) {
 
 			// For each partner pb of b
-			foreach (int pb, partnersOf[b]) {
+			foreach (int pb, partners->second) {
 
 				// If (pa, pb) is in groundTruthLinks
 				if (groundTruthLinks.count(std::make_pair(pa, pb))) {
@@ -550,33 +661,22 @@ AnisotropicEditDistance::getInterSliceErrors(
 					// positives
 					trueResultLinks.insert(std::make_pair(a, b));
 					foundGroundTruthLinks.insert(std::make_pair(pa, pb));
-
-					LOG_ALL(resultevaluatorlog) << "found a mathing link: (" << a << ", " << b << ") -> (" << pa << ", " << pb << ")" << std::endl;
 				}
 			}
 		}
 	}
 
-	LOG_ALL(resultevaluatorlog) << "true result links: ";
-	foreach (boost::tie(a, b), trueResultLinks)
-		LOG_ALL(resultevaluatorlog) << "    (" << a << ", " << b << ")" << std::endl;
-
-	LOG_ALL(resultevaluatorlog) << "found ground truth links: ";
-	foreach (boost::tie(a, b), foundGroundTruthLinks)
-		LOG_ALL(resultevaluatorlog) << "    (" << a << ", " << b << ")" << std::endl;
-
 	// Remaining result links are false merges.
 
-	foreach (boost::tie(a, b), trueResultLinks)
-		resultLinks.erase(std::make_pair(a, b));
-	interSliceErrors.falseMerges() = resultLinks;
+	foreach (boost::tie(a, b), resultLinks)
+		if (!trueResultLinks.count(std::make_pair(a, b)))
+			interSliceErrors.falseMerges().insert(std::make_pair(a, b));
 
 	// Remaining ground-truth links are false splits.
 
-	foreach (boost::tie(a, b), foundGroundTruthLinks)
-		groundTruthLinks.erase(std::make_pair(a, b));
-	interSliceErrors.falseSplits() = groundTruthLinks;
+	foreach (boost::tie(a, b), groundTruthLinks)
+		if (!foundGroundTruthLinks.count(std::make_pair(a, b)))
+			interSliceErrors.falseSplits().insert(std::make_pair(a, b));
 
 	return interSliceErrors;
 }
-
@@ -2,7 +2,6 @@
 #define SOPNET_EVALUATION_ANISOTROPIC_EDIT_DISTANCE_H__
 
 #include <pipeline/all.h>
-
 #include <sopnet/features/Overlap.h>
 #include <sopnet/segments/Segments.h>
 #include "AnisotropicEditDistanceErrors.h"
@@ -12,6 +11,9 @@ class AnisotropicEditDistance : public pipeline::SimpleProcessNode<> {
 	typedef std::vector<std::pair<int, int> > Mapping;
 	typedef std::vector<Mapping>              Mappings;
 
+	// the ground-truth partners of each mapped result slice
+	typedef std::map<int, std::vector<int> >  Partners;
+
 public:
 
 	/**
@@ -53,18 +55,41 @@ private:
 			std::vector<boost::shared_ptr<Slice> >& resultSlices,
 			unsigned int                            numSlice);
 
-	AnisotropicEditDistanceErrors getSliceErrors(
-			const Mapping& mapping,
-			const Mapping& previousMapping,
+	// prepare the partners, error bounds, and order of the mappings for the 
+	// search of the best previous mappings
+	void prepareMappings(
+			const Mappings& currentMappings,
+			const Mappings& previousMappings,
+			std::vector<AnisotropicEditDistanceErrors>& previousSliceErrors,
 			unsigned int section);
 
+	// find the previous mapping with the minimal accumulated slice errors for 
+	// the i-th current mapping
+	void findBestPreviousMapping(
+			unsigned int i,
+			const Mappings& currentMappings,
+			const std::vector<AnisotropicEditDistanceErrors>& previousSliceErrors,
+			std::vector<AnisotropicEditDistanceErrors>& currentSliceErrors,
+			std::vector<unsigned int>& bestPreviousMapping,
+			unsigned int section);
+
+	Partners getPartners(const Mapping& mapping);
+
+	// the number of links of the given section that are errors for any 
+	// mapping of the other section, given the partners in this (current or 
+	// previous) section
+	int getNumUnmatchedLinks(
+			const Partners& partners,
+			unsigned int section,
+			bool previous);
+
 	AnisotropicEditDistanceErrors getIntraSliceErrors(
 			const Mapping& mapping,
 			unsigned int section);
 
 	AnisotropicEditDistanceErrors getInterSliceErrors(
-			const Mapping& mapping,
-			const Mapping& previousMapping,
+			const Partners& partnersOf,
+			const Partners& previousPartnersOf,
 			unsigned int section);
 
 	pipeline::Input<Segments> _result;
@@ -83,6 +108,23 @@ private:
 	std::vector<std::vector<boost::shared_ptr<Slice> > > _groundTruthSlices;
 	std::vector<std::set<std::pair<int, int> > > _resultLinks;
 	std::vector<std::set<std::pair<int, int> > > _groundTruthLinks;
+
+	// the partners of each mapping in the current and previous section
+	std::vector<Partners> _currentPartners;
+	std::vector<Partners> _previousPartners;
+
+	// lower bounds on the inter-section slice errors of each mapping in the 
+	// current and previous section
+	std::vector<int> _currentUnmatchedLinks;
+	std::vector<int> _previousUnmatchedLinks;
+
+	// the total accumulated slice errors of each mapping in the previous 
+	// section
+	std::vector<int> _previousTotals;
+
+	// the mappings of the previous section, ordered by their total 
+	// accumulated slice errors
+	std::vector<unsigned int> _previousOrder;
 };
 
 #endif // SOPNET_EVALUATION_ANISOTROPIC_EDIT_DISTANCE_H__
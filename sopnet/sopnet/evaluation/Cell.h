@@ -1,6 +1,8 @@
 #ifndef SOPNET_EVALUATION_CELL_H__
 #define SOPNET_EVALUATION_CELL_H__
 
+#include <algorithm>
+#include <limits>
 #include <set>
 
 /**
@@ -10,7 +12,7 @@
  *
  * Cells are annotated with their original reconstruction label, as well as 
  * possible alternative reconstruction labels according to an external tolerance 
- * criterion.
+ * criterion. Of the locations, only their number and bounding box are kept.
  */
 template <typename LabelType>
 class Cell {
@@ -47,6 +49,11 @@ public:
 		}
 	};
 
+	Cell() :
+		_min(std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max()),
+		_max(0, 0, 0),
+		_size(0) {}
+
 	/**
 	 * Set the original reconstruction label of this cell.
 	 */
@@ -96,47 +103,27 @@ public:
 	}
 
 	/**
-	 * Add a location to this cell.
-	 */
-	void add(const Location& l) {
-
-		_content.push_back(l);
-	}
-
-	/**
-	 * Add a boundary location to this cell.
-	 */
-	void addBoundary(const Location& l) {
-
-		_boundary.push_back(l);
-	}
-
-	/**
-	 * Remove a location from this cell. Returns false, if the location was not 
-	 * part of this cell.
+	 * Add a part of this cell, given by the bounding box and the number of its 
+	 * locations. Cells do not store their locations, they are visited 
+	 * block-wise with LocalToleranceFunction::visitBlocks().
+	 *
+	 * @param min
+	 *             The smallest coordinates of the part (inclusive).
+	 * @param max
+	 *             The largest coordinates of the part (exclusive).
+	 * @param size
+	 *             The number of locations of the part.
 	 */
-	bool remove(const Location& l) {
-
-		iterator i = _content.find(l);
-
-		if (i != _content.end())
-			_content.erase(i);
-		else
-			return false;
-
-		return true;
-	}
+	void addPart(const Location& min, const Location& max, unsigned int size) {
 
-	bool removeBoundary(const Location& l) {
+		_min.x = std::min(_min.x, min.x);
+		_min.y = std::min(_min.y, min.y);
+		_min.z = std::min(_min.z, min.z);
+		_max.x = std::max(_max.x, max.x);
+		_max.y = std::max(_max.y, max.y);
+		_max.z = std::max(_max.z, max.z);
 
-		iterator i = _boundary.find(l);
-
-		if (i != _boundary.end())
-			_boundary.erase(i);
-		else
-			return false;
-
-		return true;
+		_size += size;
 	}
 
 	/**
@@ -144,24 +131,24 @@ public:
 	 */
 	unsigned int size() const {
 
-		return _content.size();
+		return _size;
 	}
 
-	const std::vector<Location>& getBoundary() const {
+	/**
+	 * Get the smallest coordinates of the locations of this cell (inclusive).
+	 */
+	const Location& getMin() const {
 
-		return _boundary;
+		return _min;
 	}
 
 	/**
-	 * Iterator access to the locations of the cell.
+	 * Get the largest coordinates of the locations of this cell (exclusive).
 	 */
-	typedef typename std::vector<Location>::iterator       iterator;
-	typedef typename std::vector<Location>::const_iterator const_iterator;
+	const Location& getMax() const {
 
-	iterator begin() { return _content.begin(); }
-	iterator end() { return _content.end(); }
-	const_iterator begin() const { return _content.begin(); }
-	const_iterator end() const { return _content.end(); }
+		return _max;
+	}
 
 private:
 
@@ -175,11 +162,12 @@ private:
 	// criterion
 	std::set<LabelType> _alternativeLabels;
 
-	// the volume locations that constitute this cell
-	std::vector<Location> _content;
+	// the bounding box of the locations of this cell
+	Location _min;
+	Location _max;
 
-	// the locations that are forming the boundary
-	std::vector<Location> _boundary;
+	// the number of locations of this cell
+	unsigned int _size;
 };
 
 #endif // SOPNET_EVALUATION_CELL_H__
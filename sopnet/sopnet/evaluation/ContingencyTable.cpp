@@ -0,0 +1,135 @@
+#include <cmath>
+
+#include <util/foreach.h>
+#include "ContingencyTable.h"
+
+void
+ContingencyTable::clear() {
+
+	_labels1.clear();
+	_labels2.clear();
+	_entries.clear();
+}
+
+void
+ContingencyTable::setLabels(const std::vector<float>& labels1, const std::vector<float>& labels2) {
+
+	_labels1 = labels1;
+	_labels2 = labels2;
+}
+
+void
+ContingencyTable::addEntry(unsigned int label1, unsigned int label2, size_t count) {
+
+	Entry entry;
+	entry.label1 = label1;
+	entry.label2 = label2;
+	entry.count  = count;
+
+	_entries.push_back(entry);
+}
+
+size_t
+ContingencyTable::getCounts(
+		std::vector<size_t>& counts1,
+		std::vector<size_t>& counts2,
+		bool ignoreBackground) const {
+
+	counts1.assign(_labels1.size(), 0);
+	counts2.assign(_labels2.size(), 0);
+
+	size_t numLocations = 0;
+
+	foreach (const Entry& entry, _entries) {
+
+		if (ignoreBackground && isBackground(entry))
+			continue;
+
+		counts1[entry.label1] += entry.count;
+		counts2[entry.label2] += entry.count;
+		numLocations += entry.count;
+	}
+
+	return numLocations;
+}
+
+size_t
+ContingencyTable::getNumLocations(bool ignoreBackground) const {
+
+	size_t numLocations = 0;
+
+	foreach (const Entry& entry, _entries)
+		if (!ignoreBackground || !isBackground(entry))
+			numLocations += entry.count;
+
+	return numLocations;
+}
+
+size_t
+ContingencyTable::getNumAgreeingPairs(bool ignoreBackground) const {
+
+	// Implementation following algorith by Bjoern Andres:
+	//
+	// https://github.com/bjoern-andres/partition-comparison/blob/master/include/andres/partition-comparison.hxx
+
+	std::vector<size_t> a;
+	std::vector<size_t> b;
+	size_t numLocations = getCounts(a, b, ignoreBackground);
+
+	size_t A = 0;
+	size_t B = numLocations*numLocations;
+
+	foreach (const Entry& entry, _entries) {
+
+		if (ignoreBackground && isBackground(entry))
+			continue;
+
+		size_t n = entry.count;
+
+		A += n*(n-1);
+		B += n*n;
+	}
+
+	foreach (size_t n, a)
+		B -= n*n;
+	foreach (size_t n, b)
+		B -= n*n;
+
+	return (A+B)/2;
+}
+
+void
+ContingencyTable::getEntropies(
+		double& H1,
+		double& H2,
+		double& I,
+		bool ignoreBackground) const {
+
+	std::vector<size_t> counts1;
+	std::vector<size_t> counts2;
+	double n = getCounts(counts1, counts2, ignoreBackground);
+
+	H1 = 0.0;
+	H2 = 0.0;
+	I  = 0.0;
+
+	foreach (size_t count, counts1)
+		if (count > 0)
+			H1 -= (count/n)*std::log(count/n);
+
+	foreach (size_t count, counts2)
+		if (count > 0)
+			H2 -= (count/n)*std::log(count/n);
+
+	foreach (const Entry& entry, _entries) {
+
+		if (ignoreBackground && isBackground(entry))
+			continue;
+
+		const double pjk = entry.count/n;
+		const double pj  = counts1[entry.label1]/n;
+		const double pk  = counts2[entry.label2]/n;
+
+		I += pjk * std::log( pjk / (pj*pk) );
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef SOPNET_EVALUATION_CONTINGENCY_TABLE_H__
+#define SOPNET_EVALUATION_CONTINGENCY_TABLE_H__
+
+#include <vector>
+
+#include <pipeline/all.h>
+
+/**
+ * The contingency table of two label volumes, i.e., the number of locations 
+ * for each pair of labels that occur together. Labels are mapped to dense ids 
+ * in ascending order of their values. All statistics can optionally ignore 
+ * locations where either of the labels is zero (the background).
+ */
+class ContingencyTable : public pipeline::Data {
+
+public:
+
+	/**
+	 * The number of locations that have label1 in the first and label2 in the 
+	 * second volume, where both labels are given as dense ids.
+	 */
+	struct Entry {
+
+		unsigned int label1;
+		unsigned int label2;
+		size_t       count;
+	};
+
+	void clear();
+
+	/**
+	 * Set the labels of both volumes. The position of each label is its dense 
+	 * id.
+	 */
+	void setLabels(const std::vector<float>& labels1, const std::vector<float>& labels2);
+
+	/**
+	 * Add an entry for two dense label ids.
+	 */
+	void addEntry(unsigned int label1, unsigned int label2, size_t count);
+
+	const std::vector<float>& getLabels1() const { return _labels1; }
+
+	const std::vector<float>& getLabels2() const { return _labels2; }
+
+	const std::vector<Entry>& getEntries() const { return _entries; }
+
+	/**
+	 * Get the number of locations for each dense label id of both volumes, and 
+	 * the total number of locations.
+	 */
+	size_t getCounts(
+			std::vector<size_t>& counts1,
+			std::vector<size_t>& counts2,
+			bool ignoreBackground = false) const;
+
+	/**
+	 * Get the number of locations.
+	 */
+	size_t getNumLocations(bool ignoreBackground = false) const;
+
+	/**
+	 * Get the number of location pairs that are either in the same or in 
+	 * different segments in both volumes.
+	 */
+	size_t getNumAgreeingPairs(bool ignoreBackground = false) const;
+
+	/**
+	 * Get the entropies H1 and H2 of the label distributions of both volumes 
+	 * and their mutual information I.
+	 */
+	void getEntropies(
+			double& H1,
+			double& H2,
+			double& I,
+			bool ignoreBackground = false) const;
+
+private:
+
+	bool isBackground(const Entry& entry) const {
+
+		return _labels1[entry.label1] == 0 || _labels2[entry.label2] == 0;
+	}
+
+	std::vector<float> _labels1;
+	std::vector<float> _labels2;
+
+	std::vector<Entry> _entries;
+};
+
+#endif // SOPNET_EVALUATION_CONTINGENCY_TABLE_H__
+
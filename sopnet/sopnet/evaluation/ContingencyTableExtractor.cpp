@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cstring>
+
+#include <boost/bind.hpp>
+#include <boost/timer/timer.hpp>
+#include <vigra/distancetransform.hxx>
+#include <vigra/seededregiongrowing.hxx>
+
+#include <util/exceptions.h>
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include <util/ParallelFor.h>
+#include "ContingencyTableExtractor.h"
+
+logger::LogChannel contingencytableextractorlog("contingencytableextractorlog", "[ContingencyTableExtractor] ");
+
+util::ProgramOption optionEvaluationNumThreads(
+		util::_module           = "sopnet.evaluation",
+		util::_long_name        = "evaluationNumThreads",
+		util::_description_text = "The number of threads to use in the evaluation. Set to 0 to use all available cores.",
+		util::_default_value    = 0);
+
+ContingencyTableExtractor::ContingencyTableExtractor(bool growSlices) :
+	_table(new ContingencyTable()),
+	_growSlices(growSlices) {
+
+	registerInput(_stack1, "stack 1");
+	registerInput(_stack2, "stack 2");
+	registerOutput(_table, "contingency table");
+}
+
+void
+ContingencyTableExtractor::updateOutputs() {
+
+	boost::timer::auto_cpu_timer timer("\tContingencyTableExtractor::updateOutputs()\t%ws\n");
+
+	if (_stack1->size() != _stack2->size())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("image stacks have different size") << STACK_TRACE);
+
+	unsigned int numThreads = getNumThreads(optionEvaluationNumThreads.as<unsigned int>(), _stack1->size());
+
+	// one hash table per thread
+	_counts.clear();
+	_counts.resize(numThreads);
+
+	parallelFor(
+			_stack1->size(),
+			numThreads,
+			boost::bind(&ContingencyTableExtractor::countSection, this, _1, _2));
+
+	// reduce the counts of all threads into the first one
+	boost::uint64_t key;
+	size_t count;
+	for (unsigned int i = 1; i < _counts.size(); i++) {
+
+		foreach (boost::tie(key, count), _counts[i])
+			_counts[0][key] += count;
+
+		_counts[i].clear();
+	}
+
+	createTable();
+
+	LOG_DEBUG(contingencytableextractorlog)
+			<< "found " << _table->getEntries().size() << " label pairs of "
+			<< _table->getLabels1().size() << " and " << _table->getLabels2().size()
+			<< " labels" << std::endl;
+}
+
+void
+ContingencyTableExtractor::countSection(unsigned int z, unsigned int thread) {
+
+	if (!_growSlices) {
+
+		countSection(*(*_stack1)[z], *(*_stack2)[z], _counts[thread]);
+		return;
+	}
+
+	const Image& image = *(*_stack2)[z];
+
+	Image grown(image.width(), image.height());
+	growSection(image, grown);
+
+	countSection(*(*_stack1)[z], grown, _counts[thread]);
+}
+
+void
+ContingencyTableExtractor::growSection(const Image& image, Image& grown) {
+
+	grown = image;
+
+	// the distance of each background location to the closest label
+	vigra::MultiArray<2, float> dist(image.width(), image.height());
+	vigra::distanceTransform(image, dist, 0, 2);
+
+	float min, max;
+	image.minmax(&min, &max);
+
+	vigra::ArrayOfRegionStatistics<vigra::SeedRgDirectValueFunctor<float> > stats(max);
+
+	// grow the labels in the order of their distance
+	vigra::seededRegionGrowing(dist, grown, grown, stats);
+}
+
+void
+ContingencyTableExtractor::countSection(const Image& image1, const Image& image2, counts_type& counts) {
+
+	if (image1.size() != image2.size())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("images have different size") << STACK_TRACE);
+
+	size_t size = image1.size();
+
+	if (size == 0)
+		return;
+
+	const float* labels1 = image1.data();
+	const float* labels2 = image2.data();
+
+	// neighboring locations mostly have the same labels, so we count runs of 
+	// equal pairs and touch the hash table only when the pair changes
+	boost::uint64_t current = toKey(labels1[0], labels2[0]);
+	size_t          run     = 0;
+
+	for (size_t i = 0; i < size; i++) {
+
+		boost::uint64_t key = toKey(labels1[i], labels2[i]);
+
+		if (key != current) {
+
+			counts[current] += run;
+			current = key;
+			run     = 0;
+		}
+
+		run++;
+	}
+
+	counts[current] += run;
+}
+
+void
+ContingencyTableExtractor::createTable() {
+
+	std::vector<float> labels1;
+	std::vector<float> labels2;
+
+	boost::uint64_t key;
+	size_t count;
+	float label1, label2;
+
+	const counts_type& counts = _counts[0];
+
+	foreach (boost::tie(key, count), counts) {
+
+		fromKey(key, label1, label2);
+
+		labels1.push_back(label1);
+		labels2.push_back(label2);
+	}
+
+	// dense ids in ascending order of the labels
+	std::sort(labels1.begin(), labels1.end());
+	std::sort(labels2.begin(), labels2.end());
+	labels1.erase(std::unique(labels1.begin(), labels1.end()), labels1.end());
+	labels2.erase(std::unique(labels2.begin(), labels2.end()), labels2.end());
+
+	// sort the entries, such that the table does not depend on the hashing
+	std::vector<std::pair<std::pair<unsigned int, unsigned int>, size_t> > entries;
+
+	foreach (boost::tie(key, count), counts) {
+
+		fromKey(key, label1, label2);
+
+		unsigned int id1 = std::lower_bound(labels1.begin(), labels1.end(), label1) - labels1.begin();
+		unsigned int id2 = std::lower_bound(labels2.begin(), labels2.end(), label2) - labels2.begin();
+
+		entries.push_back(std::make_pair(std::make_pair(id1, id2), count));
+	}
+
+	std::sort(entries.begin(), entries.end());
+
+	_table->clear();
+	_table->setLabels(labels1, labels2);
+
+	for (unsigned int i = 0; i < entries.size(); i++)
+		_table->addEntry(entries[i].first.first, entries[i].first.second, entries[i].second);
+
+	_counts.clear();
+}
+
+boost::uint64_t
+ContingencyTableExtractor::toKey(float label1, float label2) {
+
+	// -0 and 0 are the same label
+	if (label1 == 0)
+		label1 = 0;
+	if (label2 == 0)
+		label2 = 0;
+
+	boost::uint32_t bits1, bits2;
+	std::memcpy(&bits1, &label1, sizeof(float));
+	std::memcpy(&bits2, &label2, sizeof(float));
+
+	return (static_cast<boost::uint64_t>(bits1) << 32) | bits2;
+}
+
+void
+ContingencyTableExtractor::fromKey(boost::uint64_t key, float& label1, float& label2) {
+
+	boost::uint32_t bits1 = static_cast<boost::uint32_t>(key >> 32);
+	boost::uint32_t bits2 = static_cast<boost::uint32_t>(key);
+
+	std::memcpy(&label1, &bits1, sizeof(float));
+	std::memcpy(&label2, &bits2, sizeof(float));
+}
@@ -0,0 +1,84 @@
+#ifndef SOPNET_EVALUATION_CONTINGENCY_TABLE_EXTRACTOR_H__
+#define SOPNET_EVALUATION_CONTINGENCY_TABLE_EXTRACTOR_H__
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <pipeline/all.h>
+#include <imageprocessing/ImageStack.h>
+#include <util/ProgramOptions.h>
+#include "ContingencyTable.h"
+
+extern util::ProgramOption optionEvaluationNumThreads;
+
+/**
+ * Counts the co-occurrences of labels in two image stacks in a single pass 
+ * over the volumes. Sections are processed in parallel, each thread counts 
+ * runs of equal label pairs into its own hash table. The tables are reduced 
+ * and the labels mapped to dense ids afterwards.
+ *
+ * Optionally, the labels of each section of the second stack are grown until 
+ * no background (zero) locations are left before counting. The grown 
+ * sections are not kept.
+ *
+ * Inputs:
+ *
+ *   stack 1           : ImageStack
+ *   stack 2           : ImageStack
+ *
+ * Outputs:
+ *
+ *   contingency table : ContingencyTable
+ */
+class ContingencyTableExtractor : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	/**
+	 * Create a new contingency table extractor.
+	 *
+	 * @param growSlices
+	 *             If true, grow the labels of each section of the second stack 
+	 *             until no background location is left before counting.
+	 */
+	ContingencyTableExtractor(bool growSlices = false);
+
+private:
+
+	// counts by the bits of both labels
+	typedef boost::unordered_map<boost::uint64_t, size_t> counts_type;
+
+	void updateOutputs();
+
+	// count the label pairs of section z into the counts of the given thread
+	void countSection(unsigned int z, unsigned int thread);
+
+	// count the label pairs of a single section
+	void countSection(const Image& image1, const Image& image2, counts_type& counts);
+
+	// grow the labels of a section into its background locations
+	void growSection(const Image& image, Image& grown);
+
+	// map the labels to dense ids and fill the contingency table
+	void createTable();
+
+	// combine the bits of two labels into one key
+	static boost::uint64_t toKey(float label1, float label2);
+
+	// get the labels of a key
+	static void fromKey(boost::uint64_t key, float& label1, float& label2);
+
+	pipeline::Input<ImageStack> _stack1;
+	pipeline::Input<ImageStack> _stack2;
+
+	pipeline::Output<ContingencyTable> _table;
+
+	// grow the sections of the second stack before counting
+	bool _growSlices;
+
+	// the counts of each thread, reduced into the first one
+	std::vector<counts_type> _counts;
+};
+
+#endif // SOPNET_EVALUATION_CONTINGENCY_TABLE_EXTRACTOR_H__
+
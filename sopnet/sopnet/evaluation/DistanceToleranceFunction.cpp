@@ -1,7 +1,17 @@
-#include "DistanceToleranceFunction.h"
-#include <util/Logger.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include <boost/bind.hpp>
+#include <boost/tuple/tuple.hpp>
 #include <vigra/multi_distance.hxx>
-//#include <vigra/multi_impex.hxx>
+
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include <util/ParallelFor.h>
+#include <util/ProgramOptions.h>
+#include "DistanceToleranceFunction.h"
 
 logger::LogChannel distancetolerancelog("distancetolerancelog", "[DistanceToleranceFunction] ");
 
@@ -16,64 +26,138 @@ DistanceToleranceFunction::DistanceToleranceFunction(
 	_resolutionX = 4.0;
 	_resolutionY = 4.0;
 	_resolutionZ = 40.0;
+
+	// a voxel further away than the threshold in any direction is further away 
+	// than the threshold
+	_haloX = std::ceil(_maxDistanceThreshold/_resolutionX);
+	_haloY = std::ceil(_maxDistanceThreshold/_resolutionY);
+	_haloZ = std::ceil(_maxDistanceThreshold/_resolutionZ);
+
+	// the boundaries in the halo depend on one more voxel
+	setBlockHalo(_haloX + 1, _haloY + 1, _haloZ + 1);
+}
+
+void
+DistanceToleranceFunction::beginBlocks(const ImageStack& /*recLabels*/, const ImageStack& /*gtLabels*/) {
+
+	_maxBoundaryDistances.assign(_cells->size(), 0);
+
+	_blockMaxBoundaryDistances.clear();
+	_blockMaxBoundaryDistances.resize(getNumBlocks());
+
+	LOG_DEBUG(distancetolerancelog)
+			<< "computing boundary distances in blocks with a halo of "
+			<< _haloX << "x" << _haloY << "x" << _haloZ << std::endl;
 }
 
 void
-DistanceToleranceFunction::extractCells(
-		unsigned int numCells,
-		const vigra::MultiArray<3, unsigned int>& cellLabels,
+DistanceToleranceFunction::processBlock(
+		unsigned int i,
+		const Block& block,
+		const vigra::MultiArray<3, unsigned int>& labels,
+		const std::vector<unsigned int>& cellIds,
 		const ImageStack& recLabels,
-		const ImageStack& gtLabels) {
+		const ImageStack& /*gtLabels*/) {
 
-	_depth  = gtLabels.size();
-	_width  = gtLabels.width();
-	_height = gtLabels.height();
+	// the block grown by the halo
+	Block halo = getHalo(block);
 
-	createBoundaryMap(recLabels);
-	createBoundaryDistanceMap();
+	vigra::MultiArray<3, bool> boundaryMap;
+	findBoundaries(halo, recLabels, boundaryMap);
 
-	//vigra::exportVolume(cellLabels, vigra::VolumeExportInfo("cell_labels/cell_labels", ".tif").setPixelType("FLOAT"));
-	//vigra::exportVolume(_boundaryMap, vigra::VolumeExportInfo("boundaries/boundaries", ".tif").setPixelType("FLOAT"));
-	//vigra::exportVolume(_boundaryDistance2, vigra::VolumeExportInfo("distances/boundary_distance2", ".tif").setPixelType("FLOAT"));
+	float pitch[3];
+	pitch[0] = _resolutionX;
+	pitch[1] = _resolutionY;
+	pitch[2] = _resolutionZ;
 
-	// create a cell for each found connected component in cellLabels
-	_cells->resize(numCells);
+	// compute l2 distance for each pixel to boundary -- this is exact for all 
+	// distances up to the threshold, larger distances might be overestimated
+	vigra::MultiArray<3, float> boundaryDistance2(boundaryMap.shape());
+	vigra::separableMultiDistSquared(
+			boundaryMap,
+			boundaryDistance2,
+			true /* background */,
+			pitch);
 
-	// the maximum boundary distance of any location for each cell
-	std::vector<float> maxBoundaryDistances(numCells, 0);
+	// the maximum boundary distance of any location for each component in 
+	// this block
+	std::vector<float> maxBoundaryDistances(cellIds.size(), 0);
 
-	std::set<unsigned int> foundCells;
-	for (unsigned int z = 0; z < _depth; z++) {
+	unsigned int offsetX = block.minX - halo.minX;
+	unsigned int offsetY = block.minY - halo.minY;
+	unsigned int offsetZ = block.minZ - halo.minZ;
 
-		boost::shared_ptr<const Image> gt  = gtLabels[z];
-		boost::shared_ptr<const Image> rec = recLabels[z];
+	for (unsigned int z = 0; z < block.depth(); z++)
+		for (unsigned int y = 0; y < block.height(); y++) {
 
-		for (unsigned int x = 0; x < _width; x++)
-			for (unsigned int y = 0; y < _height; y++) {
+			const unsigned int* labelRow    = &labels(0, y, z);
+			const float*        distanceRow = &boundaryDistance2(offsetX, offsetY + y, offsetZ + z);
 
-				float gtLabel  = (*gt)(x, y);
-				float recLabel = (*rec)(x, y);
+			for (unsigned int x = 0; x < block.width(); x++) {
 
 				// argh, vigra starts counting at 1!
-				unsigned int cellIndex = cellLabels(x, y, z) - 1;
+				float& maxDistance = maxBoundaryDistances[labelRow[x] - 1];
+				maxDistance = std::max(maxDistance, distanceRow[x]);
+			}
+		}
 
-				(*_cells)[cellIndex].add(cell_t::Location(x, y, z));
-				(*_cells)[cellIndex].setReconstructionLabel(recLabel);
-				(*_cells)[cellIndex].setGroundTruthLabel(gtLabel);
+	_blockMaxBoundaryDistances[i] = maxBoundaryDistances;
 
-				maxBoundaryDistances[cellIndex] = std::max(maxBoundaryDistances[cellIndex], _boundaryDistance2(x, y, z));
+	boost::mutex::scoped_lock lock(_maxBoundaryDistancesMutex);
 
-				if (foundCells.count(cellIndex) == 0) {
+	for (unsigned int l = 0; l < cellIds.size(); l++)
+		_maxBoundaryDistances[cellIds[l]] = std::max(_maxBoundaryDistances[cellIds[l]], maxBoundaryDistances[l]);
+}
 
-					registerPossibleMatch(gtLabel, recLabel);
-					foundCells.insert(cellIndex);
-				}
-			}
+void
+DistanceToleranceFunction::keepBlock(
+		unsigned int i,
+		const Block& /*block*/,
+		const std::vector<unsigned int>& cellIds) {
+
+	// the baseline is a tolerance function of the same type
+	const DistanceToleranceFunction* baseline = static_cast<const DistanceToleranceFunction*>(getBaseline());
+
+	_blockMaxBoundaryDistances[i] = baseline->_blockMaxBoundaryDistances[i];
+
+	for (unsigned int l = 0; l < cellIds.size(); l++)
+		_maxBoundaryDistances[cellIds[l]] = std::max(_maxBoundaryDistances[cellIds[l]], _blockMaxBoundaryDistances[i][l]);
+}
+
+void
+DistanceToleranceFunction::endBlocks(const ImageStack& recLabels, const ImageStack& gtLabels) {
+
+	if (isUpdate()) {
+
+		// cells that did not change keep their alternatives
+		for (unsigned int cellIndex = 0; cellIndex < _cells->size(); cellIndex++) {
+
+			const cell_t& cell = (*_cells)[cellIndex];
+
+			// alternatives depend on the boundaries within the halo, which 
+			// depend on the labels of their neighbors
+			Block region = getBoundingBox(cell, _haloX + 1, _haloY + 1, _haloZ + 1);
+
+			if (keepBaselineAlternatives(cellIndex, region))
+				_maxBoundaryDistances[cellIndex] = std::numeric_limits<float>::max();
+		}
 	}
 
-	findRelabelCandidates(maxBoundaryDistances);
+	findRelabelCandidates(_maxBoundaryDistances);
+
+	if (isUpdate()) {
 
-	enumerateCellLabels(recLabels);
+		// subclasses might have selected cells that kept their alternatives
+		std::vector<unsigned int> relabelCandidates;
+		foreach (unsigned int cellIndex, _relabelCandidates)
+			if (getBaselineCells()[cellIndex] < 0)
+				relabelCandidates.push_back(cellIndex);
+		_relabelCandidates.swap(relabelCandidates);
+	}
+
+	enumerateCellLabels(recLabels, gtLabels);
+
+	std::vector<float>().swap(_maxBoundaryDistances);
 }
 
 void
@@ -85,74 +169,71 @@ DistanceToleranceFunction::findRelabelCandidates(const std::vector<float>& maxBo
 			_relabelCandidates.push_back(cellIndex);
 }
 
-void
-DistanceToleranceFunction::createBoundaryMap(const ImageStack& recLabels) {
-
-	vigra::Shape3 shape(_width, _height, _depth);
-	_boundaryMap.reshape(shape);
-
-	// create boundary map
-	LOG_DEBUG(distancetolerancelog) << "creating boundary map of size " << shape << std::endl;
-	_boundaryMap = 0.0f;
-	for (unsigned int x = 0; x < _width; x++)
-		for (unsigned int y = 0; y < _height; y++)
-			for (unsigned int z = 0; z < _depth; z++)
-				if (isBoundaryVoxel(x, y, z, recLabels))
-					_boundaryMap(x, y, z) = 1.0f;
-}
-
-void
-DistanceToleranceFunction::createBoundaryDistanceMap() {
+DistanceToleranceFunction::Block
+DistanceToleranceFunction::getHalo(const Block& block) const {
 
-	vigra::Shape3 shape(_width, _height, _depth);
-	_boundaryDistance2.reshape(shape);
+	Block halo;
+	halo.minX = std::max(0, (int)block.minX - _haloX);
+	halo.minY = std::max(0, (int)block.minY - _haloY);
+	halo.minZ = std::max(0, (int)block.minZ - _haloZ);
+	halo.maxX = std::min(_width,  block.maxX + _haloX);
+	halo.maxY = std::min(_height, block.maxY + _haloY);
+	halo.maxZ = std::min(_depth,  block.maxZ + _haloZ);
 
-	float pitch[3];
-	pitch[0] = _resolutionX;
-	pitch[1] = _resolutionY;
-	pitch[2] = _resolutionZ;
-
-	// compute l2 distance for each pixel to boundary
-	LOG_DEBUG(distancetolerancelog) << "computing boundary distances" << std::endl;
-	vigra::separableMultiDistSquared(
-			_boundaryMap,
-			_boundaryDistance2,
-			true /* background */,
-			pitch);
+	return halo;
 }
 
 void
-DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels) {
+DistanceToleranceFunction::findBoundaries(
+		const Block& region,
+		const ImageStack& recLabels,
+		vigra::MultiArray<3, bool>& boundaryMap) {
+
+	// create boundary map, row by row
+	boundaryMap.reshape(vigra::Shape3(region.width(), region.height(), region.depth()));
+	for (unsigned int z = 0; z < region.depth(); z++)
+		for (unsigned int y = 0; y < region.height(); y++)
+			findRowBoundaries(
+					region.minY + y,
+					region.minZ + z,
+					region.minX,
+					region.maxX,
+					recLabels,
+					&boundaryMap(0, y, z));
+}
 
-	_maxDistanceThresholdX = std::min((float)_width,  _maxDistanceThreshold/_resolutionX);
-	_maxDistanceThresholdY = std::min((float)_height, _maxDistanceThreshold/_resolutionY);
-	_maxDistanceThresholdZ = std::min((float)_depth,  _maxDistanceThreshold/_resolutionZ);
+void
+DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels, const ImageStack& gtLabels) {
 
 	LOG_DEBUG(distancetolerancelog) << "there are " << _relabelCandidates.size() << " cells that can be relabeled" << std::endl;
 
 	if (_relabelCandidates.size() == 0)
 		return;
 
-	LOG_DEBUG(distancetolerancelog) << "creating distance threshold neighborhood" << std::endl;
+	_candidateIndices.assign(_cells->size(), -1);
+	for (unsigned int i = 0; i < _relabelCandidates.size(); i++)
+		_candidateIndices[_relabelCandidates[i]] = i;
 
-	// list of all location offsets within threshold distance
-	std::vector<cell_t::Location> neighborhood = createNeighborhood();
+	// the cells do not know their locations, find the alternatives of their 
+	// components in the blocks that contain them in parallel
+	_alternativeLabels.clear();
+	_alternativeLabels.resize(_relabelCandidates.size());
+	_searched.assign(_relabelCandidates.size(), false);
 
-	LOG_DEBUG(distancetolerancelog) << "there are " << neighborhood.size() << " pixels in the neighborhood for a threshold of " << _maxDistanceThreshold << std::endl;
+	visitBlocks(
+			recLabels,
+			gtLabels,
+			_relabelCandidates,
+			boost::bind(&DistanceToleranceFunction::findBlockAlternativeLabels, this, _1, _2, _3, boost::cref(recLabels)));
 
-	// for each cell
-	foreach (unsigned int index, _relabelCandidates) {
+	for (unsigned int i = 0; i < _relabelCandidates.size(); i++) {
 
-		cell_t& cell = (*_cells)[index];
+		cell_t& cell = (*_cells)[_relabelCandidates[i]];
 
-		LOG_ALL(distancetolerancelog) << "processing cell " << index << " (label " << cell.getReconstructionLabel() << ")" << std::flush;
-
-		std::set<float> alternativeLabels = getAlternativeLabels(cell, neighborhood, recLabels);
-
-		LOG_ALL(distancetolerancelog) << "; can map to ";
+		LOG_ALL(distancetolerancelog) << "cell " << _relabelCandidates[i] << " (label " << cell.getReconstructionLabel() << ") can map to ";
 
 		// for each alternative label
-		foreach (float recLabel, alternativeLabels) {
+		foreach (float recLabel, _alternativeLabels[i]) {
 
 			LOG_ALL(distancetolerancelog) << recLabel << " ";
 
@@ -161,179 +242,316 @@ DistanceToleranceFunction::enumerateCellLabels(const ImageStack& recLabels) {
 			registerPossibleMatch(cell.getGroundTruthLabel(), recLabel);
 		}
 		LOG_ALL(distancetolerancelog) << std::endl;
-
-		// DEBUG
-		index++;
 	}
-}
 
-bool
-DistanceToleranceFunction::isBoundaryVoxel(int x, int y, int z, const ImageStack& stack) {
-
-	// voxels at the volume borders are always boundary voxels
-	if (x == 0 || x == (int)_width - 1)
-		return true;
-	if (y == 0 || y == (int)_height - 1)
-		return true;
-	// in z only if there are multiple sections
-	if (_depth > 1 && (z == 0 || z == (int)_depth - 1))
-		return true;
-
-	float center = (*stack[z])(x, y);
-
-	if (x > 0)
-		if ((*stack[z])(x - 1, y) != center)
-			return true;
-	if (x < (int)_width - 1)
-		if ((*stack[z])(x + 1, y) != center)
-			return true;
-	if (y > 0)
-		if ((*stack[z])(x, y - 1) != center)
-			return true;
-	if (y < (int)_height - 1)
-		if ((*stack[z])(x, y + 1) != center)
-			return true;
-	if (z > 0)
-		if ((*stack[z - 1])(x, y) != center)
-			return true;
-	if (z < (int)_depth - 1)
-		if ((*stack[z + 1])(x, y) != center)
-			return true;
-
-	return false;
+	_alternativeLabels.clear();
+	_searched.clear();
+	_candidateIndices.clear();
 }
 
-std::vector<DistanceToleranceFunction::cell_t::Location>
-DistanceToleranceFunction::createNeighborhood() {
+void
+DistanceToleranceFunction::findBlockAlternativeLabels(
+		const Block& block,
+		const vigra::MultiArray<3, unsigned int>& labels,
+		const std::vector<unsigned int>& cellIds,
+		const ImageStack& recLabels) {
 
-	std::vector<cell_t::Location> thresholdOffsets;
+	// the bounding box of each component of a relabel candidate in this block
+	std::vector<Block> components(cellIds.size());
+	std::vector<bool>  isCandidate(cellIds.size(), false);
 
-	// quick check first: test on all three axes -- if they contain all covering
-	// labels already, we can abort iterating earlier in getAlternativeLabels()
+	bool haveCandidates = false;
+	{
+		boost::mutex::scoped_lock lock(_alternativeLabelsMutex);
 
-	for (int z = 1; z <= _maxDistanceThresholdZ; z++) {
+		for (unsigned int l = 0; l < cellIds.size(); l++) {
 
-		thresholdOffsets.push_back(cell_t::Location(0, 0,  z));
-		thresholdOffsets.push_back(cell_t::Location(0, 0, -z));
-	}
-	for (int y = 1; y <= _maxDistanceThresholdY; y++) {
+			int i = _candidateIndices[cellIds[l]];
 
-		thresholdOffsets.push_back(cell_t::Location(0,  y, 0));
-		thresholdOffsets.push_back(cell_t::Location(0, -y, 0));
-	}
-	for (int x = 1; x <= _maxDistanceThresholdX; x++) {
+			// components whose cell has no alternatives left need not be 
+			// searched
+			if (i < 0 || (_searched[i] && _alternativeLabels[i].empty()))
+				continue;
 
-		thresholdOffsets.push_back(cell_t::Location( x, 0, 0));
-		thresholdOffsets.push_back(cell_t::Location(-x, 0, 0));
+			isCandidate[l] = true;
+			haveCandidates = true;
+
+			components[l].minX = block.maxX;
+			components[l].minY = block.maxY;
+			components[l].minZ = block.maxZ;
+			components[l].maxX = 0;
+			components[l].maxY = 0;
+			components[l].maxZ = 0;
+		}
 	}
 
-	for (int z = -_maxDistanceThresholdZ; z <= _maxDistanceThresholdZ; z++)
-		for (int y = -_maxDistanceThresholdY; y <= _maxDistanceThresholdY; y++)
-			for (int x = -_maxDistanceThresholdX; x <= _maxDistanceThresholdX; x++) {
+	if (!haveCandidates)
+		return;
 
-				// axis locations have been added already, center is not needed
-				if ((x == 0 && y == 0) || (x == 0 && z == 0) || (y == 0 && z == 0))
-					continue;
+	for (unsigned int z = 0; z < block.depth(); z++)
+		for (unsigned int y = 0; y < block.height(); y++) {
+
+			const unsigned int* labelRow = &labels(0, y, z);
 
-				// is it within threshold distance?
-				if (
-						x*_resolutionX*x*_resolutionX +
-						y*_resolutionY*y*_resolutionY +
-						z*_resolutionZ*z*_resolutionZ <= _maxDistanceThreshold*_maxDistanceThreshold)
+			for (unsigned int x = 0; x < block.width(); x++) {
 
-					thresholdOffsets.push_back(cell_t::Location(x, y, z));
+				unsigned int l = labelRow[x] - 1;
+
+				if (!isCandidate[l])
+					continue;
+
+				Block& component = components[l];
+				component.minX = std::min(component.minX, block.minX + x);
+				component.minY = std::min(component.minY, block.minY + y);
+				component.minZ = std::min(component.minZ, block.minZ + z);
+				component.maxX = std::max(component.maxX, block.minX + x + 1);
+				component.maxY = std::max(component.maxY, block.minY + y + 1);
+				component.maxZ = std::max(component.maxZ, block.minZ + z + 1);
 			}
+		}
 
-	return thresholdOffsets;
-}
+	Block halo = getHalo(block);
 
-std::set<float>
-DistanceToleranceFunction::getAlternativeLabels(
-		const cell_t& cell,
-		const std::vector<cell_t::Location>& neighborhood,
-		const ImageStack& recLabels) {
+	vigra::MultiArray<3, bool> boundaryMap;
+	findBoundaries(halo, recLabels, boundaryMap);
 
-	float cellLabel = cell.getReconstructionLabel();
+	// the components that have a boundary voxel of another label within their 
+	// grown bounding box, and the region around all of them, for each label
+	std::map<float, std::vector<unsigned int> > componentsByLabel;
+	std::map<float, Block>                      regionsByLabel;
 
-	// counts for each neighbor label, how often it was found while iterating 
-	// over the cells locations
-	std::map<float, unsigned int> counts;
+	for (unsigned int l = 0; l < cellIds.size(); l++) {
 
-	// the number of cell locations visited so far
-	unsigned int numVisited = 0;
+		if (!isCandidate[l])
+			continue;
 
-	// the maximal number of alternative labels, starts with number of labels 
-	// found at first location and decreases whenever one label was not found
-	unsigned int maxAlternativeLabels = 0;
+		// every boundary voxel within the distance threshold of the component 
+		// is in there
+		Block region = getHalo(components[l]);
 
-	// for each location i in that cell
-	foreach (const cell_t::Location& i, cell) {
+		std::set<float> boundaryLabels;
+		findBoundaryLabels(
+				region,
+				(*_cells)[cellIds[l]].getReconstructionLabel(),
+				halo,
+				boundaryMap,
+				recLabels,
+				boundaryLabels);
 
-		// all the labels in the neighborhood of i
-		std::set<float> neighborhoodLabels;
+		foreach (float boundaryLabel, boundaryLabels) {
 
-		numVisited++;
+			std::map<float, Block>::iterator i = regionsByLabel.find(boundaryLabel);
 
-		// the number of complete neighbor labels that have been seen at the 
-		// current location
-		unsigned int numComplete = 0;
+			if (i == regionsByLabel.end())
+				regionsByLabel.insert(std::make_pair(boundaryLabel, region));
+			else
+				i->second = getUnion(i->second, region);
 
-		// for all locations within the neighborhood, get alternative labels
-		foreach (const cell_t::Location& n, neighborhood) {
+			componentsByLabel[boundaryLabel].push_back(l);
+		}
+	}
 
-			cell_t::Location j(i.x + n.x, i.y + n.y, i.z + n.z);
+	// the alternatives of each component
+	std::vector<std::set<float> > alternativeLabels(cellIds.size());
 
-			// are we leaving the image?
-			if (j.x < 0 || j.x >= (int)_width || j.y < 0 || j.y >= (int)_height || j.z < 0 || j.z >= (int)_depth)
-				continue;
+	float pitch[3];
+	pitch[0] = _resolutionX;
+	pitch[1] = _resolutionY;
+	pitch[2] = _resolutionZ;
 
-			// is this a boundary?
-			if (!_boundaryMap(j.x, j.y, j.z))
-				continue;
+	vigra::MultiArray<3, bool>  labelBoundaries;
+	vigra::MultiArray<3, float> boundaryDistance2;
+
+	float boundaryLabel;
+	Block region;
+	foreach (boost::tie(boundaryLabel, region), regionsByLabel) {
 
-			// now we have found a boundary pixel within our neighborhood
-			float label = (*(recLabels)[j.z])(j.x, j.y);
+		vigra::Shape3 shape(region.width(), region.height(), region.depth());
 
-			// count how often we see a neighbor label the first time
-			if (label != cellLabel) {
+		// the boundary voxels of the current label in the region
+		labelBoundaries.reshape(shape);
+		labelBoundaries = false;
 
-				bool firstTime = neighborhoodLabels.insert(label).second;
+		for (unsigned int z = region.minZ; z < region.maxZ; z++) {
 
-				// seen the first time for the current location i
-				if (firstTime)
-					// is a potential alternative label (covers all visited 
-					// locations so far)
-					if (++counts[label] == numVisited) {
+			boost::shared_ptr<const Image> section = recLabels[z];
 
-						numComplete++;
+			for (unsigned int y = region.minY; y < region.maxY; y++) {
 
-						// if we have seen all the possible complete labels 
-						// already, there is no need to search further for the 
-						// current location i
-						if (numComplete == maxAlternativeLabels)
-							break;
-					}
+				const float* row         = &(*section)(region.minX, y);
+				const bool*  boundaryRow = &boundaryMap(region.minX - halo.minX, y - halo.minY, z - halo.minZ);
+				bool*        labelRow    = &labelBoundaries(0, y - region.minY, z - region.minZ);
+
+				for (unsigned int x = 0; x < region.width(); x++)
+					labelRow[x] = boundaryRow[x] && row[x] == boundaryLabel;
 			}
 		}
 
-		// the number of labels that we have seen for each location visited so 
-		// far is the maximal possible number of alternative labels
-		maxAlternativeLabels = numComplete;
+		// the distance of each voxel in the region to the closest boundary 
+		// voxel of the current label, shared by all components close to it
+		boundaryDistance2.reshape(shape);
+		vigra::separableMultiDistSquared(
+				labelBoundaries,
+				boundaryDistance2,
+				true /* background */,
+				pitch);
+
+		// the label is an alternative, if every location of the component is 
+		// within the threshold
+		foreach (unsigned int l, componentsByLabel[boundaryLabel])
+			if (isCovered(block, labels, l + 1, components[l], region, boundaryDistance2))
+				alternativeLabels[l].insert(boundaryLabel);
+	}
+
+	// the alternatives of a cell are the ones all its components agree on
+	boost::mutex::scoped_lock lock(_alternativeLabelsMutex);
+
+	for (unsigned int l = 0; l < cellIds.size(); l++) {
+
+		if (!isCandidate[l])
+			continue;
+
+		unsigned int i = _candidateIndices[cellIds[l]];
+
+		if (!_searched[i]) {
+
+			_alternativeLabels[i].swap(alternativeLabels[l]);
+			_searched[i] = true;
+
+		} else {
+
+			std::set<float> intersection;
+			std::set_intersection(
+					_alternativeLabels[i].begin(), _alternativeLabels[i].end(),
+					alternativeLabels[l].begin(), alternativeLabels[l].end(),
+					std::inserter(intersection, intersection.begin()));
+			_alternativeLabels[i].swap(intersection);
+		}
+	}
+}
+
+void
+DistanceToleranceFunction::findBoundaryLabels(
+		const Block& region,
+		float cellLabel,
+		const Block& halo,
+		const vigra::MultiArray<3, bool>& boundaryMap,
+		const ImageStack& recLabels,
+		std::set<float>& boundaryLabels) {
+
+	for (unsigned int z = region.minZ; z < region.maxZ; z++) {
+
+		boost::shared_ptr<const Image> section = recLabels[z];
+
+		for (unsigned int y = region.minY; y < region.maxY; y++) {
+
+			const float* row         = &(*section)(region.minX, y);
+			const bool*  boundaryRow = &boundaryMap(region.minX - halo.minX, y - halo.minY, z - halo.minZ);
+
+			// labels come in runs, insert only at the start of each run
+			float previous = cellLabel;
+			for (unsigned int x = 0; x < region.width(); x++)
+				if (boundaryRow[x] && row[x] != cellLabel && row[x] != previous) {
+
+					boundaryLabels.insert(row[x]);
+					previous = row[x];
+				}
+		}
+	}
+}
+
+bool
+DistanceToleranceFunction::isCovered(
+		const Block& block,
+		const vigra::MultiArray<3, unsigned int>& labels,
+		unsigned int label,
+		const Block& component,
+		const Block& region,
+		const vigra::MultiArray<3, float>& boundaryDistance2) {
+
+	float maxDistance2 = _maxDistanceThreshold*_maxDistanceThreshold;
+
+	for (unsigned int z = component.minZ; z < component.maxZ; z++)
+		for (unsigned int y = component.minY; y < component.maxY; y++) {
+
+			const unsigned int* labelRow    = &labels(component.minX - block.minX, y - block.minY, z - block.minZ);
+			const float*        distanceRow = &boundaryDistance2(component.minX - region.minX, y - region.minY, z - region.minZ);
+
+			for (unsigned int x = 0; x < component.width(); x++)
+				if (labelRow[x] == label && distanceRow[x] > maxDistance2)
+					return false;
+		}
+
+	return true;
+}
 
-		// none of the neighbor labels covers the cell
-		if (maxAlternativeLabels == 0)
-			break;
+DistanceToleranceFunction::Block
+DistanceToleranceFunction::getUnion(const Block& a, const Block& b) {
+
+	Block u;
+	u.minX = std::min(a.minX, b.minX);
+	u.minY = std::min(a.minY, b.minY);
+	u.minZ = std::min(a.minZ, b.minZ);
+	u.maxX = std::max(a.maxX, b.maxX);
+	u.maxY = std::max(a.maxY, b.maxY);
+	u.maxZ = std::max(a.maxZ, b.maxZ);
+
+	return u;
+}
+
+void
+DistanceToleranceFunction::findRowBoundaries(
+		unsigned int y,
+		unsigned int z,
+		unsigned int minX,
+		unsigned int maxX,
+		const ImageStack& recLabels,
+		bool* boundaries) {
+
+	// voxels at the volume borders are always boundary voxels, in z only if 
+	// there are multiple sections
+	if (y == 0 || y == _height - 1 || (_depth > 1 && (z == 0 || z == _depth - 1))) {
+
+		std::fill(boundaries, boundaries + (maxX - minX), true);
+		return;
 	}
 
-	std::set<float> alternativeLabels;
+	boost::shared_ptr<const Image> section = recLabels[z];
 
-	// collect all neighbor labels that we have seen for every location of the 
-	// cell
-	float label;
-	unsigned int count;
-	foreach (boost::tie(label, count), counts)
-		if (count == cell.size())
-			alternativeLabels.insert(label);
+	const float* row   = &(*section)(0, y);
+	const float* above = &(*section)(0, y - 1);
+	const float* below = &(*section)(0, y + 1);
+
+	// for a single section, there are no neighbors in z
+	boost::shared_ptr<const Image> previousSection = section;
+	boost::shared_ptr<const Image> nextSection     = section;
+	if (_depth > 1) {
+
+		previousSection = recLabels[z - 1];
+		nextSection     = recLabels[z + 1];
+	}
+
+	const float* previous = &(*previousSection)(0, y);
+	const float* next     = &(*nextSection)(0, y);
+
+	// the inner voxels of the row, without branches
+	unsigned int begin = std::max(minX, 1u);
+	unsigned int end   = std::min(maxX, _width - 1);
+	for (unsigned int x = begin; x < end; x++) {
+
+		float center = row[x];
+
+		boundaries[x - minX] =
+				(row[x - 1]  != center) |
+				(row[x + 1]  != center) |
+				(above[x]    != center) |
+				(below[x]    != center) |
+				(previous[x] != center) |
+				(next[x]     != center);
+	}
 
-	return alternativeLabels;
+	if (minX == 0)
+		boundaries[0] = true;
+	if (maxX == _width)
+		boundaries[maxX - 1 - minX] = true;
 }
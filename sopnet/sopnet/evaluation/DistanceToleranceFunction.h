@@ -12,13 +12,24 @@ public:
 			bool haveBackgroundLabel,
 			float backgroundLabel = 0.0);
 
-	void extractCells(
-			unsigned int numCells,
-			const vigra::MultiArray<3, unsigned int>& cellLabels,
+protected:
+
+	void beginBlocks(const ImageStack& recLabels, const ImageStack& gtLabels);
+
+	void processBlock(
+			unsigned int i,
+			const Block& block,
+			const vigra::MultiArray<3, unsigned int>& labels,
+			const std::vector<unsigned int>& cellIds,
 			const ImageStack& recLabels,
 			const ImageStack& gtLabels);
 
-protected:
+	void keepBlock(
+			unsigned int i,
+			const Block& block,
+			const std::vector<unsigned int>& cellIds);
+
+	void endBlocks(const ImageStack& recLabels, const ImageStack& gtLabels);
 
 	virtual void findRelabelCandidates(const std::vector<float>& maxBoundaryDistances);
 
@@ -29,28 +40,61 @@ protected:
 
 private:
 
-	// find alternative cell labels
-	void enumerateCellLabels(const ImageStack& recLabels);
-
-	// create a b/w image of reconstruction label changes
-	void createBoundaryMap(const ImageStack& recLabels);
+	// the block grown by the halo and limited to the volume
+	Block getHalo(const Block& block) const;
 
-	// create a distance2 image of boundary distances
-	void createBoundaryDistanceMap();
-
-	// find all offset locations for the given distance threshold
-	std::vector<cell_t::Location> createNeighborhood();
+	// find the reconstruction boundaries in the given region
+	void findBoundaries(
+			const Block& region,
+			const ImageStack& recLabels,
+			vigra::MultiArray<3, bool>& boundaryMap);
 
-	// search for all relabeling alternatives for the given cell and 
-	// neighborhood
-	std::set<float> getAlternativeLabels(
-			const cell_t& cell,
-			const std::vector<cell_t::Location>& neighborhood,
+	// find alternative cell labels
+	void enumerateCellLabels(const ImageStack& recLabels, const ImageStack& gtLabels);
+
+	// search for the relabeling alternatives of all relabel candidates with a 
+	// component in the given block, i.e., all labels that have a boundary 
+	// voxel within the distance threshold of each location of the component 
+	// -- one distance transform per label is shared by all components of the 
+	// block
+	void findBlockAlternativeLabels(
+			const Block& block,
+			const vigra::MultiArray<3, unsigned int>& labels,
+			const std::vector<unsigned int>& cellIds,
 			const ImageStack& recLabels);
 
-	// test, whether a voxel is surrounded by at least one other voxel with a 
-	// different label
-	bool isBoundaryVoxel(int x, int y, int z, const ImageStack& stack);
+	// find all labels except the given one with a boundary voxel in the 
+	// region
+	void findBoundaryLabels(
+			const Block& region,
+			float cellLabel,
+			const Block& halo,
+			const vigra::MultiArray<3, bool>& boundaryMap,
+			const ImageStack& recLabels,
+			std::set<float>& boundaryLabels);
+
+	// is every location of the given component within the distance threshold, 
+	// according to the squared distances of the region?
+	bool isCovered(
+			const Block& block,
+			const vigra::MultiArray<3, unsigned int>& labels,
+			unsigned int label,
+			const Block& component,
+			const Block& region,
+			const vigra::MultiArray<3, float>& boundaryDistance2);
+
+	// the smallest block containing both given blocks
+	static Block getUnion(const Block& a, const Block& b);
+
+	// find all voxels in a row between minX and maxX that are surrounded by 
+	// at least one other voxel with a different label
+	void findRowBoundaries(
+			unsigned int y,
+			unsigned int z,
+			unsigned int minX,
+			unsigned int maxX,
+			const ImageStack& recLabels,
+			bool* boundaries);
 
 	// the distance threshold in nm
 	float _maxDistanceThreshold;
@@ -60,16 +104,34 @@ private:
 	float _resolutionY;
 	float _resolutionZ;
 
-	// the distance threshold in pixels for each direction
-	int _maxDistanceThresholdX;
-	int _maxDistanceThresholdY;
-	int _maxDistanceThresholdZ;
+	// the number of voxels around a block or cell that can influence 
+	// boundary distances up to the distance threshold
+	int _haloX;
+	int _haloY;
+	int _haloZ;
+
+	// the maximum boundary distance of any location for each cell
+	std::vector<float> _maxBoundaryDistances;
+
+	// the maximum boundary distance of any location for each component of 
+	// each block, kept for updates
+	std::vector<std::vector<float> > _blockMaxBoundaryDistances;
+
+	// protects _maxBoundaryDistances
+	boost::mutex _maxBoundaryDistancesMutex;
+
+	// the index of each cell in _relabelCandidates, or -1
+	std::vector<int> _candidateIndices;
+
+	// the alternative labels of each relabel candidate, the intersection of 
+	// the alternatives of the components searched so far
+	std::vector<std::set<float> > _alternativeLabels;
 
-	// the extends of the ground truth and reconstruction
-	unsigned int _width, _height, _depth;
+	// was a component of the relabel candidate searched already?
+	std::vector<bool> _searched;
 
-	vigra::MultiArray<3, bool>  _boundaryMap;
-	vigra::MultiArray<3, float> _boundaryDistance2;
+	// protects _alternativeLabels and _searched
+	boost::mutex _alternativeLabelsMutex;
 };
 
 #endif // SOPNET_EVALUATION_DISTANCE_TOLERANCE_FUNCTION_H__
@@ -1,11 +1,17 @@
+#include <algorithm>
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/timer/timer.hpp>
+
 #include "ErrorReport.h"
-#include <vigra/seededregiongrowing.hxx>
-#include <vigra/distancetransform.hxx>
-#include <imageprocessing/io/ImageStackDirectoryWriter.h>
 #include <sopnet/neurons/NeuronExtractor.h>
 #include <sopnet/io/IdMapCreator.h>
 #include <util/ProgramOptions.h>
+#include <util/ParallelFor.h>
 #include <util/Logger.h>
+#include <util/foreach.h>
 
 util::ProgramOption optionReportVoi(
 		util::_module           = "sopnet.evaluation",
@@ -40,125 +46,301 @@ util::ProgramOption optionGrowSlices(
 logger::LogChannel errorreportlog("errorreportlog", "[ErrorReport] ");
 
 ErrorReport::ErrorReport() :
-		_pipelineSetup(false) {
+	_reportHeader(new std::string()),
+	_report(new std::string()),
+	_humanReadableReport(new std::string()) {
 
 	registerInput(_groundTruthIdMap, "ground truth");
 	registerInput(_groundTruth, "ground truth segments");
 	registerInput(_goldStandard, "gold standard segments");
 	registerInput(_reconstruction, "reconstruction segments");
 
-	if (optionReportVoi) {
+	if (optionReportVoi)
+		registerOutput(_voiErrors, "voi errors");
 
-		_reportAssembler->addInput("errors", _voi->getOutput("errors"));
-		registerOutput(_voi->getOutput("errors"), "voi errors");
-	}
+	if (optionReportRand)
+		registerOutput(_randErrors, "rand errors");
 
-	if (optionReportRand) {
+	if (optionReportTed)
+		registerOutput(_tedErrors, "ted errors");
 
-		_reportAssembler->addInput("errors", _rand->getOutput("errors"));
-		registerOutput(_rand->getOutput("errors"), "rand errors");
-	}
+	if (optionReportAed)
+		registerOutput(_aedErrors, "aed errors");
 
-	if (optionReportTed) {
+	if (optionReportHamming)
+		registerOutput(_hammingErrors, "hamming errors");
 
-		_reportAssembler->addInput("errors", _ted->getOutput("errors"));
-		registerOutput(_ted->getOutput("errors"), "ted errors");
-	}
+	registerOutput(_reportHeader, "error report header");
+	registerOutput(_report, "error report");
+	registerOutput(_humanReadableReport, "human readable error report");
+}
+
+void
+ErrorReport::updateOutputs() {
 
-	if (optionReportAed) {
+	boost::timer::auto_cpu_timer timer("\tErrorReport::updateOutputs()\t\t%ws\n");
 
-		_reportAssembler->addInput("errors", _aed->getOutput("errors"));
-		registerOutput(_aed->getOutput("errors"), "aed errors");
-	}
+	_metrics.clear();
 
-	if (optionReportHamming) {
+	bool voiRand = (optionReportVoi || optionReportRand);
 
-		_reportAssembler->addInput("errors", _hamming->getOutput("errors"));
-		registerOutput(_hamming->getOutput("errors"), "hamming errors");
+	// without grown slices, the cells of TED give the contingency table
+	if (voiRand && optionReportTed && !optionGrowSlices) {
+
+		_metrics.push_back(Metric("TED, VOI, and RAND", boost::bind(&ErrorReport::computeTedVoiRand, this)));
+
+	} else {
+
+		if (voiRand)
+			_metrics.push_back(Metric("VOI and RAND", boost::bind(&ErrorReport::computeVoiRand, this)));
+
+		if (optionReportTed)
+			_metrics.push_back(Metric("TED", boost::bind(&ErrorReport::computeTed, this)));
 	}
 
-	registerOutput(_reportAssembler->getOutput("error report header"), "error report header");
-	registerOutput(_reportAssembler->getOutput("error report"), "error report");
-	registerOutput(_reportAssembler->getOutput("human readable error report"), "human readable error report");
+	if (optionReportAed)
+		_metrics.push_back(Metric("AED", boost::bind(&ErrorReport::computeAed, this)));
+
+	if (optionReportHamming)
+		_metrics.push_back(Metric("Hamming", boost::bind(&ErrorReport::computeHamming, this)));
+
+	// the shared preprocessing
+	if (voiRand || optionReportTed)
+		createIdMap();
+
+	computeMetrics();
+
+	// the id map is not needed anymore
+	_idMap.reset();
+
+	foreach (const Metric& metric, _metrics)
+		LOG_USER(errorreportlog) << metric.name << " took " << metric.wallTime << "s" << std::endl;
+
+	setOutputs();
+
+	assembleReport();
 }
 
 void
-ErrorReport::updateOutputs() {
-
-	if (_pipelineSetup)
-		return;
+ErrorReport::createIdMap() {
 
-	LOG_DEBUG(errorreportlog) << "setting up internal pipeline" << std::endl;
+	boost::timer::cpu_timer timer;
 
 	pipeline::Process<NeuronExtractor> neuronExtractor;
 	pipeline::Process<IdMapCreator>    idMapCreator;
 
-	pipeline::Process<> voiRandIdMapProvider;
+	neuronExtractor->setInput(_reconstruction);
+	idMapCreator->setInput("neurons", neuronExtractor->getOutput());
+	idMapCreator->setInput("reference", _groundTruthIdMap);
 
-	if (optionGrowSlices) {
+	pipeline::Value<ImageStack> idMap = idMapCreator->getOutput("id map");
+	_idMap = idMap;
 
-		voiRandIdMapProvider = pipeline::Process<GrowSlices>();
-		voiRandIdMapProvider->setInput(idMapCreator->getOutput());
+	LOG_USER(errorreportlog)
+			<< "creating the id map took "
+			<< static_cast<double>(timer.elapsed().wall)/1e9 << "s" << std::endl;
+}
 
-	} else {
+void
+ErrorReport::computeMetrics() {
+
+	unsigned int numThreads = getNumThreads(optionEvaluationNumThreads.as<unsigned int>(), _metrics.size());
+
+	LOG_DEBUG(errorreportlog)
+			<< "computing " << _metrics.size() << " metrics with "
+			<< numThreads << " threads" << std::endl;
+
+	parallelFor(
+			_metrics.size(),
+			numThreads,
+			boost::bind(&ErrorReport::computeMetric, this, _1));
+}
+
+void
+ErrorReport::computeMetric(unsigned int i) {
+
+	boost::timer::cpu_timer timer;
+
+	_metrics[i].compute();
+
+	_metrics[i].wallTime = static_cast<double>(timer.elapsed().wall)/1e9;
+}
+
+void
+ErrorReport::computeVoiRand() {
+
+	// VOI and RAND share the label co-occurrences
+	pipeline::Process<ContingencyTableExtractor> contingencyTableExtractor(optionGrowSlices.as<bool>());
+	contingencyTableExtractor->setInput("stack 1", _groundTruthIdMap);
+	contingencyTableExtractor->setInput("stack 2", _idMap);
 
-		voiRandIdMapProvider = idMapCreator;
+	pipeline::Value<ContingencyTable> table = contingencyTableExtractor->getOutput("contingency table");
+
+	computeVoiRand(table);
+}
+
+void
+ErrorReport::computeTedVoiRand() {
+
+	computeTed();
+
+	computeVoiRand(createContingencyTable(*_ted));
+}
+
+void
+ErrorReport::computeVoiRand(boost::shared_ptr<ContingencyTable> table) {
+
+	if (optionReportVoi) {
+
+		pipeline::Process<VariationOfInformation> voi;
+		voi->setInput("contingency table", table);
+
+		pipeline::Value<VariationOfInformationErrors> errors = voi->getOutput("errors");
+		_voi = errors;
 	}
 
-	neuronExtractor->setInput(_reconstruction);
-	idMapCreator->setInput("neurons", neuronExtractor->getOutput());
-	idMapCreator->setInput("reference", _groundTruthIdMap);
+	if (optionReportRand) {
 
-	_voi->setInput("stack 1", _groundTruthIdMap);
-	_voi->setInput("stack 2", voiRandIdMapProvider->getOutput());
+		pipeline::Process<RandIndex> rand;
+		rand->setInput("contingency table", table);
 
-	_rand->setInput("stack 1", _groundTruthIdMap);
-	_rand->setInput("stack 2", voiRandIdMapProvider->getOutput());
+		pipeline::Value<RandIndexErrors> errors = rand->getOutput("errors");
+		_rand = errors;
+	}
+}
 
-	_ted->setInput("ground truth", _groundTruthIdMap);
-	_ted->setInput("reconstruction", idMapCreator->getOutput());
+void
+ErrorReport::computeTed() {
 
-	_aed->setInput("ground truth", _groundTruth);
-	_aed->setInput("result", _reconstruction);
+	pipeline::Process<TolerantEditDistance> ted;
+	ted->setInput("ground truth", _groundTruthIdMap);
+	ted->setInput("reconstruction", _idMap);
+
+	pipeline::Value<TolerantEditDistanceErrors> errors = ted->getOutput("errors");
+	_ted = errors;
+}
 
-	_hamming->setInput("gold standard", _goldStandard);
-	_hamming->setInput("reconstruction", _reconstruction);
+void
+ErrorReport::computeAed() {
 
-	_pipelineSetup = true;
+	pipeline::Process<AnisotropicEditDistance> aed;
+	aed->setInput("ground truth", _groundTruth);
+	aed->setInput("result", _reconstruction);
 
-	LOG_DEBUG(errorreportlog) << "internal pipeline set up" << std::endl;
+	pipeline::Value<AnisotropicEditDistanceErrors> errors = aed->getOutput("errors");
+	_aed = errors;
 }
 
 void
-ErrorReport::GrowSlices::updateOutputs() {
+ErrorReport::computeHamming() {
+
+	pipeline::Process<HammingDistance> hamming;
+	hamming->setInput("gold standard", _goldStandard);
+	hamming->setInput("reconstruction", _reconstruction);
 
-	if (!_grown)
-		_grown = new ImageStack();
-	else
-		_grown->clear();
+	pipeline::Value<HammingDistanceErrors> errors = hamming->getOutput("errors");
+	_hamming = errors;
+}
 
-	foreach (boost::shared_ptr<Image> image, *_stack) {
+boost::shared_ptr<ContingencyTable>
+ErrorReport::createContingencyTable(const TolerantEditDistanceErrors& tedErrors) {
 
-		boost::shared_ptr<Image> grown = boost::make_shared<Image>(image->width(), image->height());
-		*grown = *image;
+	// the cells partition the volume, each cell has a single ground truth and 
+	// reconstruction label
+	std::map<std::pair<float, float>, size_t> counts;
 
-		// perform Euclidean distance transform
-		vigra::MultiArray<2, float> dist(image->width(), image->height());
-		vigra::distanceTransform(*image, dist, 0, 2);
+	foreach (const TolerantEditDistanceErrors::cell_t& cell, *tedErrors.getCells())
+		counts[std::make_pair(cell.getGroundTruthLabel(), cell.getReconstructionLabel())] += cell.size();
 
-		float min, max;
-		image->minmax(&min, &max);
+	std::vector<float> labels1;
+	std::vector<float> labels2;
 
-		// init statistics functor
-		vigra::ArrayOfRegionStatistics<vigra::SeedRgDirectValueFunctor<float> > stats(max);
+	std::pair<float, float> labels;
+	size_t count;
 
-		// grow regions
-		vigra::seededRegionGrowing(dist, *grown, *grown, stats);
+	foreach (boost::tie(labels, count), counts) {
 
-		_grown->add(grown);
+		labels1.push_back(labels.first);
+		labels2.push_back(labels.second);
 	}
 
-	pipeline::Process<ImageStackDirectoryWriter> writer("result_grown");
-	writer->setInput(_grown.getSharedPointer());
-	writer->write();
+	// dense ids in ascending order of the labels, as in the 
+	// ContingencyTableExtractor
+	std::sort(labels1.begin(), labels1.end());
+	std::sort(labels2.begin(), labels2.end());
+	labels1.erase(std::unique(labels1.begin(), labels1.end()), labels1.end());
+	labels2.erase(std::unique(labels2.begin(), labels2.end()), labels2.end());
+
+	boost::shared_ptr<ContingencyTable> table = boost::make_shared<ContingencyTable>();
+	table->setLabels(labels1, labels2);
+
+	// the map is sorted by the labels, and thus by the dense ids
+	foreach (boost::tie(labels, count), counts) {
+
+		unsigned int id1 = std::lower_bound(labels1.begin(), labels1.end(), labels.first)  - labels1.begin();
+		unsigned int id2 = std::lower_bound(labels2.begin(), labels2.end(), labels.second) - labels2.begin();
+
+		table->addEntry(id1, id2, count);
+	}
+
+	return table;
+}
+
+void
+ErrorReport::setOutputs() {
+
+	// only here, in the thread that updates this node
+	if (optionReportVoi)
+		_voiErrors = new VariationOfInformationErrors(*_voi);
+	if (optionReportRand)
+		_randErrors = new RandIndexErrors(*_rand);
+	if (optionReportTed)
+		_tedErrors = new TolerantEditDistanceErrors(*_ted);
+	if (optionReportAed)
+		_aedErrors = new AnisotropicEditDistanceErrors(*_aed);
+	if (optionReportHamming)
+		_hammingErrors = new HammingDistanceErrors(*_hamming);
+
+	_voi.reset();
+	_rand.reset();
+	_ted.reset();
+	_aed.reset();
+	_hamming.reset();
+}
+
+void
+ErrorReport::assembleReport() {
+
+	_reportHeader->clear();
+	_report->clear();
+	_humanReadableReport->clear();
+
+	// same order as before the metrics were computed concurrently
+	if (optionReportVoi)
+		addToReport(*_voiErrors);
+	if (optionReportRand)
+		addToReport(*_randErrors);
+	if (optionReportTed)
+		addToReport(*_tedErrors);
+	if (optionReportAed)
+		addToReport(*_aedErrors);
+	if (optionReportHamming)
+		addToReport(*_hammingErrors);
+}
+
+void
+ErrorReport::addToReport(Errors& errors) {
+
+	if (!_reportHeader->empty())
+		(*_reportHeader) += "\t";
+
+	if (!_report->empty())
+		(*_report) += "\t";
+
+	if (!_humanReadableReport->empty())
+		(*_humanReadableReport) += "; ";
+
+	(*_reportHeader)        += errors.errorHeader();
+	(*_report)              += errors.errorString();
+	(*_humanReadableReport) += errors.humanReadableErrorString();
 }
@@ -2,15 +2,54 @@
 #define SOPNET_EVALUATION_ERROR_REPORT_H__
 
 #include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+
 #include <pipeline/SimpleProcessNode.h>
 #include <imageprocessing/ImageStack.h>
 #include <sopnet/segments/Segments.h>
+#include "ContingencyTableExtractor.h"
 #include "VariationOfInformation.h"
 #include "RandIndex.h"
 #include "AnisotropicEditDistance.h"
 #include "TolerantEditDistance.h"
 #include "HammingDistance.h"
 
+/**
+ * Computes the errors of a reconstruction for all metrics that are enabled 
+ * via program options and assembles them into a report.
+ *
+ * The preprocessing that several metrics need is done only once: the 
+ * reconstruction id map is created once for VOI, RAND, and TED. If TED is 
+ * computed and the slices are not grown, the contingency table of VOI and RAND 
+ * is summed from the sizes of the TED cells instead of another pass over the 
+ * volumes. Otherwise, VOI and RAND share one contingency table, which grows 
+ * the slices section by section if requested.
+ *
+ * Afterwards, the metrics are computed concurrently, each in a pipeline of its 
+ * own. Nested parallel loops of the metrics share the threads of the 
+ * evaluation. The outputs are set after all metrics are done. The wall time of 
+ * each metric is logged.
+ *
+ * Inputs:
+ *
+ *   ground truth                : ImageStack
+ *   ground truth segments       : Segments
+ *   gold standard segments      : Segments
+ *   reconstruction segments     : Segments
+ *
+ * Outputs:
+ *
+ *   voi errors                  : VariationOfInformationErrors (if reportVoi)
+ *   rand errors                 : RandIndexErrors (if reportRand)
+ *   ted errors                  : TolerantEditDistanceErrors (if reportTed)
+ *   aed errors                  : AnisotropicEditDistanceErrors (if reportAed)
+ *   hamming errors              : HammingDistanceErrors (if reportHamming)
+ *   error report header         : std::string
+ *   error report                : std::string
+ *   human readable error report : std::string
+ */
 class ErrorReport : public pipeline::SimpleProcessNode<> {
 
 public:
@@ -19,95 +58,85 @@ public:
 
 private:
 
-	class ReportAssembler : public pipeline::SimpleProcessNode<> {
-
-	public:
-
-		ReportAssembler() {
-
-			registerInputs(_errors, "errors");
-			registerOutput(_reportHeader, "error report header");
-			registerOutput(_report, "error report");
-			registerOutput(_humanReadableReport, "human readable error report");
-		}
-
-	private:
-
-		void updateOutputs() {
-
-			_reportHeader        = new std::string();
-			_report              = new std::string();
-			_humanReadableReport = new std::string();
+	/**
+	 * A metric (or a group of metrics that share their computation) to run 
+	 * concurrently with the others.
+	 */
+	struct Metric {
 
-			foreach (const pipeline::Input<Errors>& errors, _errors) {
+		Metric(std::string name_, boost::function<void()> compute_) :
+			name(name_),
+			compute(compute_),
+			wallTime(0) {}
 
-				if (!_reportHeader->empty())
-					(*_reportHeader) += "\t";
+		std::string name;
 
-				if (!_report->empty())
-					(*_report) += "\t";
+		boost::function<void()> compute;
 
-				if (!_humanReadableReport->empty())
-					(*_humanReadableReport) += "; ";
+		// the wall time of the computation in seconds
+		double wallTime;
+	};
 
-				(*_reportHeader)        += errors->errorHeader();
-				(*_report)              += errors->errorString();
-				(*_humanReadableReport) += errors->humanReadableErrorString();
-			}
-		}
+	void updateOutputs();
 
-		pipeline::Inputs<Errors> _errors;
-		pipeline::Output<std::string> _reportHeader;
-		pipeline::Output<std::string> _report;
-		pipeline::Output<std::string> _humanReadableReport;
-	};
+	// create the id map of the reconstruction, shared by VOI, RAND, and TED
+	void createIdMap();
 
-	/**
-	 * Grows all slices in each image of a given stack until no more background 
-	 * pixels are present.
-	 */
-	class GrowSlices : public pipeline::SimpleProcessNode<> {
+	// compute all metrics in _metrics, using several threads
+	void computeMetrics();
 
-	public:
+	// compute the i-th metric in _metrics and measure its wall time
+	void computeMetric(unsigned int i);
 
-		GrowSlices() {
+	// the metrics
+	void computeVoiRand();
+	void computeTedVoiRand();
+	void computeTed();
+	void computeAed();
+	void computeHamming();
 
-			registerInput(_stack, "stack");
-			registerOutput(_grown, "grown");
-		}
+	// compute VOI and RAND from the given contingency table
+	void computeVoiRand(boost::shared_ptr<ContingencyTable> table);
 
-	private:
+	// sum the contingency table of the ground truth and the reconstruction from 
+	// the sizes of the TED cells
+	boost::shared_ptr<ContingencyTable> createContingencyTable(const TolerantEditDistanceErrors& tedErrors);
 
-		void updateOutputs();
+	// set the outputs to the errors of the metrics
+	void setOutputs();
 
-		pipeline::Input<ImageStack>  _stack;
-		pipeline::Output<ImageStack> _grown;
-	};
+	// concatenate the error strings of all metrics
+	void assembleReport();
 
-	void updateOutputs();
+	// add the errors of one metric to the report
+	void addToReport(Errors& errors);
 
 	pipeline::Input<ImageStack> _groundTruthIdMap;
 	pipeline::Input<Segments>   _groundTruth;
 	pipeline::Input<Segments>   _goldStandard;
 	pipeline::Input<Segments>   _reconstruction;
 
-	pipeline::Process<VariationOfInformation>  _voi;
-	pipeline::Process<RandIndex>               _rand;
-	pipeline::Process<AnisotropicEditDistance> _aed;
-	pipeline::Process<TolerantEditDistance>    _ted;
-	pipeline::Process<HammingDistance>         _hamming;
-	pipeline::Process<ReportAssembler>         _reportAssembler;
-
 	pipeline::Output<VariationOfInformationErrors>  _voiErrors;
 	pipeline::Output<RandIndexErrors>               _randErrors;
 	pipeline::Output<AnisotropicEditDistanceErrors> _aedErrors;
 	pipeline::Output<TolerantEditDistanceErrors>    _tedErrors;
 	pipeline::Output<HammingDistanceErrors>         _hammingErrors;
-	pipeline::Output<std::string>                   _reportLine;
+	pipeline::Output<std::string>                   _reportHeader;
+	pipeline::Output<std::string>                   _report;
 	pipeline::Output<std::string>                   _humanReadableReport;
 
-	bool _pipelineSetup;
+	// the id map of the reconstruction segments
+	boost::shared_ptr<ImageStack> _idMap;
+
+	// the metrics to compute in the current update
+	std::vector<Metric> _metrics;
+
+	// the errors of the metrics, set by the metric jobs
+	boost::shared_ptr<VariationOfInformationErrors>  _voi;
+	boost::shared_ptr<RandIndexErrors>               _rand;
+	boost::shared_ptr<TolerantEditDistanceErrors>    _ted;
+	boost::shared_ptr<AnisotropicEditDistanceErrors> _aed;
+	boost::shared_ptr<HammingDistanceErrors>         _hamming;
 };
 
 #endif // SOPNET_EVALUATION_ERROR_REPORT_H__
-
@@ -1,7 +1,14 @@
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/timer/timer.hpp>
+
 #include <pipeline/Value.h>
 #include <pipeline/Process.h>
-#include <imageprocessing/ImageExtractor.h>
+#include <util/ParallelFor.h>
 #include <sopnet/slices/SliceExtractor.h>
+#include "ContingencyTableExtractor.h"
 #include "GroundTruthExtractor.h"
 
 util::ProgramOption optionGroundTruthFromSkeletons(
@@ -44,58 +51,89 @@ GroundTruthExtractor::updateOutputs() {
 std::vector<Slices>
 GroundTruthExtractor::extractSlices(int firstSection, int lastSection) {
 
-	// find the maximal value in the ground truth images
-	float maxIntensity = 0;
-	foreach (boost::shared_ptr<Image> image, *_groundTruthSections) {
+	boost::timer::auto_cpu_timer timer("\tGroundTruthExtractor::extractSlices()\t%ws\n");
+
+	unsigned int numSections = lastSection - firstSection + 1;
 
-		float min, max;
-		image->minmax(&min, &max);
+	// find the maximal value in the ground truth images
+	std::vector<float> maxIntensities(_groundTruthSections->size(), 0);
+	parallelFor(
+			_groundTruthSections->size(),
+			optionEvaluationNumThreads.as<unsigned int>(),
+			boost::bind(&GroundTruthExtractor::findMaxIntensity, this, _1, boost::ref(maxIntensities)));
 
+	float maxIntensity = 0;
+	foreach (float max, maxIntensities)
 		maxIntensity = std::max(maxIntensity, max);
-	}
 
 	// create parameters suitable to extract ground-truth connected components
-	pipeline::Value<ComponentTreeExtractorParameters> cteParameters;
+	ComponentTreeExtractorParameters cteParameters;
 	if (optionGroundTruthFromSkeletons)
-		cteParameters->minSize  = 0; // skeletons are small
+		cteParameters.minSize  = 0; // skeletons are small
 	else
-		cteParameters->minSize  = 50; // this is to avoid this tiny annotation that mess up the result
-	cteParameters->maxSize      = 10000000;
-	cteParameters->darkToBright = false;
-	cteParameters->sameIntensityComponents = _addIntensityBoundaries; // only extract connected components of same intensity
-	cteParameters->minIntensity = 0;
-	cteParameters->maxIntensity = maxIntensity;
-
-	// create a section extractor to access the sections in the stack
-	pipeline::Process<ImageExtractor> sectionExtractor;
-	sectionExtractor->setInput(_groundTruthSections);
+		cteParameters.minSize  = 50; // this is to avoid this tiny annotation that mess up the result
+	cteParameters.maxSize      = 10000000;
+	cteParameters.darkToBright = false;
+	cteParameters.sameIntensityComponents = _addIntensityBoundaries; // only extract connected components of same intensity
+	cteParameters.minIntensity = 0;
+	cteParameters.maxIntensity = maxIntensity;
 
 	// list of all slices for each section
-	std::vector<Slices> slices;
+	std::vector<Slices> slices(numSections);
 
-	float resX = _groundTruthSections->getResolutionX();
-	float resY = _groundTruthSections->getResolutionY();
-	float resZ = _groundTruthSections->getResolutionZ();
+	parallelFor(
+			numSections,
+			optionEvaluationNumThreads.as<unsigned int>(),
+			boost::bind(&GroundTruthExtractor::extractSectionSlices, this, _1, firstSection, boost::cref(cteParameters), boost::ref(slices)));
 
-	for (int section = firstSection; section <= lastSection; section++) {
+	return slices;
+}
 
-		LOG_DEBUG(groundtruthextractorlog) << "extracting slices in section " << section << std::endl;
+void
+GroundTruthExtractor::findMaxIntensity(unsigned int section, std::vector<float>& maxIntensities) {
 
-		// create a SliceExtractor
-		pipeline::Process<SliceExtractor<unsigned short> > sliceExtractor(section, resX, resY, resZ, false /* don't downsample */);
+	const Image& image = *(*_groundTruthSections)[section];
 
-		// give it the section it has to process and our parameters
-		sliceExtractor->setInput("membrane", sectionExtractor->getOutput(section));
-		sliceExtractor->setInput("parameters", cteParameters);
+	const float* data = image.data();
+	size_t       size = image.size();
 
-		// get the slices in the current section
-		pipeline::Value<Slices> sectionSlices = sliceExtractor->getOutput("slices");
-		slices.push_back(*sectionSlices);
+	// only the maximum is needed for the parameters of the slice extraction
+	float max = 0;
+	for (size_t i = 0; i < size; i++)
+		max = std::max(max, data[i]);
 
-		LOG_ALL(groundtruthextractorlog) << "found " << sectionSlices->size() << " slices" << std::endl;
-	}
+	maxIntensities[section] = max;
+}
 
-	return slices;
+void
+GroundTruthExtractor::extractSectionSlices(
+		unsigned int i,
+		int firstSection,
+		const ComponentTreeExtractorParameters& parameters,
+		std::vector<Slices>& slices) {
+
+	unsigned int section = firstSection + i;
+
+	LOG_DEBUG(groundtruthextractorlog) << "extracting slices in section " << section << std::endl;
+
+	// create a SliceExtractor
+	pipeline::Process<SliceExtractor<unsigned short> > sliceExtractor(
+			section,
+			_groundTruthSections->getResolutionX(),
+			_groundTruthSections->getResolutionY(),
+			_groundTruthSections->getResolutionZ(),
+			false /* don't downsample */);
+
+	// give it the section it has to process and our parameters, each thread 
+	// gets its own copy of the parameters
+	sliceExtractor->setInput("membrane", (*_groundTruthSections)[section]);
+	sliceExtractor->setInput("parameters", boost::make_shared<ComponentTreeExtractorParameters>(parameters));
+
+	// get the slices in the current section
+	pipeline::Value<Slices> sectionSlices = sliceExtractor->getOutput("slices");
+	slices[i] = *sectionSlices;
+
+	LOG_ALL(groundtruthextractorlog) << "found " << sectionSlices->size() << " slices in section " << section << std::endl;
 }
 
 Segments
@@ -122,15 +160,48 @@ GroundTruthExtractor::findMinimalTrees(const std::vector<Slices>& slices) {
 	// for each neuron label
 	if (!_endSegmentsOnly) {
 
+		std::vector<float>                             labels;
+		std::vector<std::vector<ContinuationSegment>*> continuations;
+
 		typedef std::map<float, std::vector<ContinuationSegment> >::value_type pair_t;
 		foreach (pair_t& pair, links) {
 
-			float label = pair.first;
-			std::vector<ContinuationSegment>& continuations = pair.second;
-
-			findLabelTree(label, continuations, linksLeft, linksRight, segments);
+			labels.push_back(pair.first);
+			continuations.push_back(&pair.second);
 		}
 
+		// the labels do not share slices, so their trees can be found 
+		// independently
+		std::vector<std::vector<ContinuationSegment> > trees(labels.size());
+
+		parallelFor(
+				labels.size(),
+				optionEvaluationNumThreads.as<unsigned int>(),
+				boost::bind(&GroundTruthExtractor::findLabelTreeJob, this, _1, boost::cref(labels), boost::ref(continuations), boost::ref(trees)));
+
+		// add the trees in the order of the labels
+		foreach (const std::vector<ContinuationSegment>& tree, trees)
+			foreach (const ContinuationSegment& continuation, tree) {
+
+				// put continuation in segments
+				segments.add(boost::make_shared<ContinuationSegment>(continuation));
+
+				unsigned int source = continuation.getSourceSlice()->getId();
+				unsigned int target = continuation.getTargetSlice()->getId();
+
+				// count number of usages of involved slices
+				if (continuation.getDirection() == Right) {
+
+					linksLeft[target]++;
+					linksRight[source]++;
+
+				} else {
+
+					linksRight[target]++;
+					linksLeft[source]++;
+				}
+			}
+
 	} else {
 
 		LOG_USER(groundtruthextractorlog) << "skipping extraction of continuation segments" << std::endl;
@@ -150,13 +221,21 @@ GroundTruthExtractor::findMinimalTrees(const std::vector<Slices>& slices) {
 	return segments;
 }
 
+void
+GroundTruthExtractor::findLabelTreeJob(
+		unsigned int i,
+		const std::vector<float>& labels,
+		std::vector<std::vector<ContinuationSegment>*>& continuations,
+		std::vector<std::vector<ContinuationSegment> >& trees) {
+
+	findLabelTree(labels[i], *continuations[i], trees[i]);
+}
+
 void
 GroundTruthExtractor::findLabelTree(
 		float label,
 		std::vector<ContinuationSegment>& continuations,
-		std::map<unsigned int, unsigned int>& linksLeft,
-		std::map<unsigned int, unsigned int>& linksRight,
-		Segments& segments) {
+		std::vector<ContinuationSegment>& tree) {
 
 	LOG_ALL(groundtruthextractorlog) << "processing neuron label " << label << std::endl;
 
@@ -203,20 +282,8 @@ GroundTruthExtractor::findLabelTree(
 
 			foundOpenEdge = true;
 
-			// put continuation in segments
-			segments.add(boost::make_shared<ContinuationSegment>(*i));
-
-			// count number of usages of involved slices
-			if (i->getDirection() == Right) {
-
-				linksLeft[target]++;
-				linksRight[source]++;
-
-			} else {
-
-				linksRight[target]++;
-				linksLeft[source]++;
-			}
+			// put continuation in tree
+			tree.push_back(*i);
 
 			// put new slice into connected slices
 			connectedSlices.insert(target);
@@ -8,6 +8,7 @@
 #include <sopnet/slices/Slices.h>
 #include <sopnet/segments/Segments.h>
 #include <sopnet/features/Overlap.h>
+#include <imageprocessing/ComponentTreeExtractor.h>
 
 extern util::ProgramOption optionGroundTruthFromSkeletons;
 
@@ -58,22 +59,38 @@ private:
 
 	void updateOutputs();
 
-	// extract all slices of each ground-truth section
+	// extract all slices of each ground-truth section, sections are processed 
+	// in parallel
 	std::vector<Slices> extractSlices(int firstSection, int lastSection);
 
+	// find the maximal intensity of a ground-truth section
+	void findMaxIntensity(unsigned int section, std::vector<float>& maxIntensities);
+
+	// extract the slices of the i-th ground-truth section
+	void extractSectionSlices(
+			unsigned int i,
+			int firstSection,
+			const ComponentTreeExtractorParameters& parameters,
+			std::vector<Slices>& slices);
+
 	std::map<float, std::vector<ContinuationSegment> > extractContinuations(const std::vector<Slices>& slices);
 
 	// find a minimal spanning segment tree for each set of slices with the same 
-	// id
+	// id, labels are processed in parallel
 	Segments findMinimalTrees(const std::vector<Slices>& slices);
 
+	// find the tree of the i-th label
+	void findLabelTreeJob(
+			unsigned int i,
+			const std::vector<float>& labels,
+			std::vector<std::vector<ContinuationSegment>*>& continuations,
+			std::vector<std::vector<ContinuationSegment> >& trees);
+
 	// find on tree of segments per connected component of label
 	void findLabelTree(
 			float label,
 			std::vector<ContinuationSegment>& continuations,
-			std::map<unsigned int, unsigned int>& linksLeft,
-			std::map<unsigned int, unsigned int>& linksRight,
-			Segments& segments);
+			std::vector<ContinuationSegment>& tree);
 
 	// the ground truth images
 	pipeline::Input<ImageStack> _groundTruthSections;
@@ -1,5 +1,48 @@
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <vigra/multi_labeling.hxx>
+
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include <util/ParallelFor.h>
 #include "LocalToleranceFunction.h"
 
+logger::LogChannel localtolerancelog("localtolerancelog", "[LocalToleranceFunction] ");
+
+util::ProgramOption optionTedBlockSize(
+		util::_module           = "sopnet.evaluation",
+		util::_long_name        = "tedBlockSize",
+		util::_description_text = "The width and height of the blocks in which the tolerant edit distance extracts cells. The width is rounded up to a multiple of 64.",
+		util::_default_value    = 512);
+
+util::ProgramOption optionTedBlockDepth(
+		util::_module           = "sopnet.evaluation",
+		util::_long_name        = "tedBlockDepth",
+		util::_description_text = "The number of sections of the blocks in which the tolerant edit distance extracts cells.",
+		util::_default_value    = 32);
+
+util::ProgramOption optionTedNumThreads(
+		util::_module           = "sopnet.evaluation",
+		util::_long_name        = "tedNumThreads",
+		util::_description_text = "The number of threads to process blocks of the tolerant edit distance. Set to 0 to use all available cores.",
+		util::_default_value    = 0);
+
+LocalToleranceFunction::LocalToleranceFunction() :
+	_cells(boost::make_shared<std::vector<cell_t> >()),
+	_width(0),
+	_height(0),
+	_depth(0),
+	_blockHaloX(0),
+	_blockHaloY(0),
+	_blockHaloZ(0),
+	_baseline(0),
+	_baselineRecLabels(0),
+	_updatedLabels(0) {}
+
 void
 LocalToleranceFunction::clear() {
 
@@ -9,6 +52,787 @@ LocalToleranceFunction::clear() {
 	_possibleGroundTruthMatches.clear();
 	_possibleReconstructionMatches.clear();
 	_cellsByRecToGtLabel.clear();
+	_blocks.clear();
+	_blockLabels.clear();
+	_cellIds.clear();
+	_equalBaselineCells.clear();
+	_baselineCells.clear();
+}
+
+void
+LocalToleranceFunction::setBlockHalo(int x, int y, int z) {
+
+	_blockHaloX = x;
+	_blockHaloY = y;
+	_blockHaloZ = z;
+}
+
+void
+LocalToleranceFunction::extractCells(
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels) {
+
+	_depth  = gtLabels.size();
+	_width  = gtLabels.width();
+	_height = gtLabels.height();
+
+	createBlocks();
+
+	_blockLabels.clear();
+	_blockLabels.resize(_blocks.size());
+
+	// the blocks to label, and the blocks to process
+	std::vector<unsigned int> labelled;
+	std::vector<unsigned int> processed;
+
+	if (isUpdate()) {
+
+		findChangedBlocks(recLabels);
+
+		for (unsigned int z = 0; z < _numBlocksZ; z++)
+			for (unsigned int y = 0; y < _numBlocksY; y++)
+				for (unsigned int x = 0; x < _numBlocksX; x++) {
+
+					unsigned int i = x + y*_numBlocksX + z*_numBlocksX*_numBlocksY;
+
+					// changed blocks and their neighbors need their faces to 
+					// be merged
+					bool label =
+							_changed[i] ||
+							(x > 0               && _changed[i - 1]) ||
+							(x + 1 < _numBlocksX && _changed[i + 1]) ||
+							(y > 0               && _changed[i - _numBlocksX]) ||
+							(y + 1 < _numBlocksY && _changed[i + _numBlocksX]) ||
+							(z > 0               && _changed[i - _numBlocksX*_numBlocksY]) ||
+							(z + 1 < _numBlocksZ && _changed[i + _numBlocksX*_numBlocksY]);
+
+					if (!_changed[i])
+						copyBaselineBlock(i);
+					if (label)
+						labelled.push_back(i);
+
+					// blocks with a change in their halo need to be processed
+					Block halo = _blocks[i];
+					halo.minX = std::max(0, (int)halo.minX - _blockHaloX);
+					halo.minY = std::max(0, (int)halo.minY - _blockHaloY);
+					halo.minZ = std::max(0, (int)halo.minZ - _blockHaloZ);
+					halo.maxX = std::min(_width,  halo.maxX + _blockHaloX);
+					halo.maxY = std::min(_height, halo.maxY + _blockHaloY);
+					halo.maxZ = std::min(_depth,  halo.maxZ + _blockHaloZ);
+
+					if (hasChanges(halo))
+						processed.push_back(i);
+				}
+
+		LOG_DEBUG(localtolerancelog)
+				<< _changedRegions.size() << " of " << _blocks.size() << " blocks changed, labelling "
+				<< labelled.size() << " and processing " << processed.size() << " blocks" << std::endl;
+
+	} else {
+
+		for (unsigned int i = 0; i < _blocks.size(); i++) {
+
+			labelled.push_back(i);
+			processed.push_back(i);
+		}
+
+		LOG_DEBUG(localtolerancelog)
+				<< "labelling " << _blocks.size() << " blocks of size "
+				<< _blockWidth << "x" << _blockHeight << "x" << _blockDepth << std::endl;
+	}
+
+	parallelFor(
+			labelled.size(),
+			optionTedNumThreads.as<unsigned int>(),
+			boost::bind(&LocalToleranceFunction::labelBlockFaces, this, _1, boost::cref(labelled), boost::cref(recLabels), boost::cref(gtLabels)));
+
+	mergeBlocks();
+
+	LOG_DEBUG(localtolerancelog) << "found " << _cells->size() << " cells" << std::endl;
+
+	beginBlocks(recLabels, gtLabels);
+
+	parallelFor(
+			processed.size(),
+			optionTedNumThreads.as<unsigned int>(),
+			boost::bind(&LocalToleranceFunction::extractBlockCells, this, _1, boost::cref(processed), boost::cref(recLabels), boost::cref(gtLabels)));
+
+	// the results of the other blocks are the ones of the baseline
+	if (isUpdate()) {
+
+		std::vector<bool> isProcessed(_blocks.size(), false);
+		foreach (unsigned int i, processed)
+			isProcessed[i] = true;
+
+		for (unsigned int i = 0; i < _blocks.size(); i++)
+			if (!isProcessed[i])
+				keepBlock(
+						i,
+						_blocks[i],
+						std::vector<unsigned int>(
+								_cellIds.begin() + _blockLabels[i].offset,
+								_cellIds.begin() + _blockLabels[i].offset + _blockLabels[i].numLabels));
+	}
+
+	addCellParts();
+
+	std::vector<unsigned int>().swap(_parents);
+
+	if (isUpdate())
+		findEqualBaselineCells();
+
+	endBlocks(recLabels, gtLabels);
+
+	_changed.clear();
+	_changedRegions.clear();
+}
+
+void
+LocalToleranceFunction::updateCells(
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels,
+		const LocalToleranceFunction& baseline,
+		const ImageStack& baselineRecLabels,
+		const std::map<float, float>& updatedLabels) {
+
+	_baseline          = &baseline;
+	_baselineRecLabels = &baselineRecLabels;
+	_updatedLabels     = &updatedLabels;
+
+	extractCells(recLabels, gtLabels);
+
+	_baseline          = 0;
+	_baselineRecLabels = 0;
+	_updatedLabels     = 0;
+
+	unsigned int numKept = 0;
+	foreach (int baselineCell, _baselineCells)
+		if (baselineCell >= 0)
+			numKept++;
+
+	LOG_DEBUG(localtolerancelog)
+			<< numKept << " of " << _cells->size()
+			<< " cells are unchanged since the baseline" << std::endl;
+}
+
+void
+LocalToleranceFunction::createBlocks() {
+
+	// round up to a multiple of 64
+	_blockWidth  = std::max(64u, (optionTedBlockSize.as<unsigned int>() + 63)/64*64);
+	_blockHeight = std::max(1u, optionTedBlockSize.as<unsigned int>());
+	_blockDepth  = std::max(1u, optionTedBlockDepth.as<unsigned int>());
+
+	_numBlocksX = (_width  + _blockWidth  - 1)/_blockWidth;
+	_numBlocksY = (_height + _blockHeight - 1)/_blockHeight;
+	_numBlocksZ = (_depth  + _blockDepth  - 1)/_blockDepth;
+
+	_blocks.clear();
+
+	for (unsigned int z = 0; z < _numBlocksZ; z++)
+		for (unsigned int y = 0; y < _numBlocksY; y++)
+			for (unsigned int x = 0; x < _numBlocksX; x++) {
+
+				Block block;
+
+				block.minX = x*_blockWidth;
+				block.minY = y*_blockHeight;
+				block.minZ = z*_blockDepth;
+				block.maxX = std::min(_width,  block.minX + _blockWidth);
+				block.maxY = std::min(_height, block.minY + _blockHeight);
+				block.maxZ = std::min(_depth,  block.minZ + _blockDepth);
+
+				_blocks.push_back(block);
+			}
+}
+
+unsigned int
+LocalToleranceFunction::labelBlock(
+		const Block& block,
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels,
+		vigra::MultiArray<3, unsigned int>& labels,
+		std::vector<std::pair<float, float> >& values) {
+
+	vigra::Shape3 shape(block.width(), block.height(), block.depth());
+
+	vigra::MultiArray<3, std::pair<float, float> > gtAndRec(shape);
+
+	for (unsigned int z = 0; z < block.depth(); z++) {
+
+		boost::shared_ptr<const Image> gt  = gtLabels[block.minZ + z];
+		boost::shared_ptr<const Image> rec = recLabels[block.minZ + z];
+
+		for (unsigned int y = 0; y < block.height(); y++) {
+
+			const float* gtRow  = &(*gt)(block.minX, block.minY + y);
+			const float* recRow = &(*rec)(block.minX, block.minY + y);
+
+			std::pair<float, float>* gtAndRecRow = &gtAndRec(0, y, z);
+
+			for (unsigned int x = 0; x < block.width(); x++)
+				gtAndRecRow[x] = std::make_pair(gtRow[x], recRow[x]);
+		}
+	}
+
+	// find connected components in gt and rec image
+	labels.reshape(shape);
+	labels = 0;
+	unsigned int numLabels = vigra::labelMultiArray(gtAndRec, labels);
+
+	values.resize(numLabels);
+	for (unsigned int z = 0; z < block.depth(); z++)
+		for (unsigned int y = 0; y < block.height(); y++) {
+
+			const unsigned int*            labelRow    = &labels(0, y, z);
+			const std::pair<float, float>* gtAndRecRow = &gtAndRec(0, y, z);
+
+			for (unsigned int x = 0; x < block.width(); x++)
+				// argh, vigra starts counting at 1!
+				values[labelRow[x] - 1] = gtAndRecRow[x];
+		}
+
+	return numLabels;
+}
+
+void
+LocalToleranceFunction::findChangedBlocks(const ImageStack& recLabels) {
+
+	_changed.assign(_blocks.size(), false);
+	_changedRegions.clear();
+
+	// the baseline was extracted with different blocks, nothing can be kept
+	if (_baseline->_blocks.size() != _blocks.size()) {
+
+		_changed.assign(_blocks.size(), true);
+		_changedRegions = _blocks;
+		return;
+	}
+
+	parallelFor(
+			_blocks.size(),
+			optionTedNumThreads.as<unsigned int>(),
+			boost::bind(&LocalToleranceFunction::findBlockChanges, this, _1, boost::cref(recLabels)));
+}
+
+void
+LocalToleranceFunction::findBlockChanges(unsigned int i, const ImageStack& recLabels) {
+
+	const Block& block = _blocks[i];
+
+	// the bounding box of the changed locations
+	Block changes;
+	changes.minX = block.maxX;
+	changes.minY = block.maxY;
+	changes.minZ = block.maxZ;
+	changes.maxX = 0;
+	changes.maxY = 0;
+	changes.maxZ = 0;
+
+	for (unsigned int z = block.minZ; z < block.maxZ; z++) {
+
+		boost::shared_ptr<const Image> rec         = recLabels[z];
+		boost::shared_ptr<const Image> baselineRec = (*_baselineRecLabels)[z];
+
+		for (unsigned int y = block.minY; y < block.maxY; y++) {
+
+			const float* row         = &(*rec)(0, y);
+			const float* baselineRow = &(*baselineRec)(0, y);
+
+			// labels come in runs, look up the updated label only at the 
+			// start of each run
+			float baselineLabel = baselineRow[block.minX];
+			std::map<float, float>::const_iterator updatedLabel = _updatedLabels->find(baselineLabel);
+
+			for (unsigned int x = block.minX; x < block.maxX; x++) {
+
+				if (baselineRow[x] != baselineLabel) {
+
+					baselineLabel = baselineRow[x];
+					updatedLabel  = _updatedLabels->find(baselineLabel);
+				}
+
+				if (updatedLabel == _updatedLabels->end() || updatedLabel->second != row[x]) {
+
+					changes.minX = std::min(changes.minX, x);
+					changes.minY = std::min(changes.minY, y);
+					changes.minZ = std::min(changes.minZ, z);
+					changes.maxX = std::max(changes.maxX, x + 1);
+					changes.maxY = std::max(changes.maxY, y + 1);
+					changes.maxZ = std::max(changes.maxZ, z + 1);
+				}
+			}
+		}
+	}
+
+	if (changes.maxX == 0)
+		return;
+
+	// blocks write to different elements of _changed, but the elements of a 
+	// vector<bool> share words
+	boost::mutex::scoped_lock lock(_changedRegionsMutex);
+
+	_changed[i] = true;
+	_changedRegions.push_back(changes);
+}
+
+void
+LocalToleranceFunction::copyBaselineBlock(unsigned int i) {
+
+	const BlockLabels& baseline = _baseline->_blockLabels[i];
+	BlockLabels&       result   = _blockLabels[i];
+
+	result.numLabels = baseline.numLabels;
+	result.sizes     = baseline.sizes;
+	result.mins      = baseline.mins;
+	result.maxs      = baseline.maxs;
+
+	// none of the locations changed, so all the reconstruction labels have an 
+	// updated label
+	result.values.resize(baseline.numLabels);
+	for (unsigned int l = 0; l < baseline.numLabels; l++)
+		result.values[l] = std::make_pair(
+				baseline.values[l].first,
+				_updatedLabels->find(baseline.values[l].second)->second);
+}
+
+void
+LocalToleranceFunction::labelBlockFaces(
+		unsigned int job,
+		const std::vector<unsigned int>& blocks,
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels) {
+
+	const Block& block  = _blocks[blocks[job]];
+	BlockLabels& result = _blockLabels[blocks[job]];
+
+	vigra::MultiArray<3, unsigned int> labels;
+	result.numLabels = labelBlock(block, recLabels, gtLabels, labels, result.values);
+
+	unsigned int w = block.width();
+	unsigned int h = block.height();
+	unsigned int d = block.depth();
+
+	result.lowerFaces[0].resize(h*d);
+	result.upperFaces[0].resize(h*d);
+	for (unsigned int z = 0; z < d; z++)
+		for (unsigned int y = 0; y < h; y++) {
+
+			result.lowerFaces[0][y + z*h] = labels(0,     y, z);
+			result.upperFaces[0][y + z*h] = labels(w - 1, y, z);
+		}
+
+	result.lowerFaces[1].resize(w*d);
+	result.upperFaces[1].resize(w*d);
+	for (unsigned int z = 0; z < d; z++)
+		for (unsigned int x = 0; x < w; x++) {
+
+			result.lowerFaces[1][x + z*w] = labels(x, 0,     z);
+			result.upperFaces[1][x + z*w] = labels(x, h - 1, z);
+		}
+
+	result.lowerFaces[2].resize(w*h);
+	result.upperFaces[2].resize(w*h);
+	for (unsigned int y = 0; y < h; y++)
+		for (unsigned int x = 0; x < w; x++) {
+
+			result.lowerFaces[2][x + y*w] = labels(x, y, 0);
+			result.upperFaces[2][x + y*w] = labels(x, y, d - 1);
+		}
+}
+
+void
+LocalToleranceFunction::mergeBlocks() {
+
+	// one union-find entry for each component of each block
+	unsigned int numEntries = 0;
+	for (unsigned int i = 0; i < _blockLabels.size(); i++) {
+
+		_blockLabels[i].offset = numEntries;
+		numEntries += _blockLabels[i].numLabels;
+	}
+
+	_parents.resize(numEntries);
+	for (unsigned int e = 0; e < numEntries; e++)
+		_parents[e] = e;
+
+	// merge components that touch across block borders
+	for (unsigned int z = 0; z < _numBlocksZ; z++)
+		for (unsigned int y = 0; y < _numBlocksY; y++)
+			for (unsigned int x = 0; x < _numBlocksX; x++) {
+
+				unsigned int i = x + y*_numBlocksX + z*_numBlocksX*_numBlocksY;
+
+				if (x + 1 < _numBlocksX)
+					mergeFaces(i, i + 1, 0);
+				if (y + 1 < _numBlocksY)
+					mergeFaces(i, i + _numBlocksX, 1);
+				if (z + 1 < _numBlocksZ)
+					mergeFaces(i, i + _numBlocksX*_numBlocksY, 2);
+			}
+
+	// roots are always the smallest entry of their set, so we can number them 
+	// in one pass
+	_cellIds.resize(numEntries);
+
+	unsigned int numCells = 0;
+	for (unsigned int e = 0; e < numEntries; e++) {
+
+		unsigned int root = findRoot(e);
+
+		if (root == e)
+			_cellIds[e] = numCells++;
+		else
+			_cellIds[e] = _cellIds[root];
+	}
+
+	// create a cell for each component
+	_cells->resize(numCells);
+
+	for (unsigned int i = 0; i < _blockLabels.size(); i++)
+		for (unsigned int l = 0; l < _blockLabels[i].numLabels; l++) {
+
+			unsigned int e = _blockLabels[i].offset + l;
+
+			if (_parents[e] != e)
+				continue;
+
+			float gtLabel  = _blockLabels[i].values[l].first;
+			float recLabel = _blockLabels[i].values[l].second;
+
+			cell_t& cell = (*_cells)[_cellIds[e]];
+			cell.setGroundTruthLabel(gtLabel);
+			cell.setReconstructionLabel(recLabel);
+
+			registerPossibleMatch(gtLabel, recLabel);
+		}
+
+	// the faces are not needed anymore, the touching components are kept in 
+	// the merges
+	foreach (BlockLabels& blockLabels, _blockLabels)
+		for (int axis = 0; axis < 3; axis++) {
+
+			std::vector<unsigned int>().swap(blockLabels.lowerFaces[axis]);
+			std::vector<unsigned int>().swap(blockLabels.upperFaces[axis]);
+		}
+}
+
+void
+LocalToleranceFunction::mergeFaces(unsigned int i, unsigned int j, int axis) {
+
+	BlockLabels&       a = _blockLabels[i];
+	const BlockLabels& b = _blockLabels[j];
+
+	std::vector<std::pair<unsigned int, unsigned int> >& merges = a.merges[axis];
+
+	if (isUpdate() && !_changed[i] && !_changed[j]) {
+
+		// neither block changed, the same components touch as in the baseline
+		merges = _baseline->_blockLabels[i].merges[axis];
+
+	} else {
+
+		const std::vector<unsigned int>& upper = a.upperFaces[axis];
+		const std::vector<unsigned int>& lower = b.lowerFaces[axis];
+
+		merges.clear();
+
+		for (unsigned int k = 0; k < upper.size(); k++) {
+
+			unsigned int labelA = upper[k] - 1;
+			unsigned int labelB = lower[k] - 1;
+
+			if (a.values[labelA] == b.values[labelB])
+				merges.push_back(std::make_pair(labelA, labelB));
+		}
+
+		std::sort(merges.begin(), merges.end());
+		merges.erase(std::unique(merges.begin(), merges.end()), merges.end());
+	}
+
+	unsigned int labelA, labelB;
+	foreach (boost::tie(labelA, labelB), merges)
+		merge(a.offset + labelA, b.offset + labelB);
+}
+
+void
+LocalToleranceFunction::extractBlockCells(
+		unsigned int job,
+		const std::vector<unsigned int>& blocks,
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels) {
+
+	unsigned int i      = blocks[job];
+	const Block& block  = _blocks[i];
+	BlockLabels& result = _blockLabels[i];
+
+	// labelling is deterministic, so we get the same components as before
+	vigra::MultiArray<3, unsigned int>     labels;
+	std::vector<std::pair<float, float> > values;
+	unsigned int numLabels = labelBlock(block, recLabels, gtLabels, labels, values);
+
+	// the global cell id of each component
+	std::vector<unsigned int> cellIds(
+			_cellIds.begin() + result.offset,
+			_cellIds.begin() + result.offset + numLabels);
+
+	// the size and bounding box of each component
+	result.sizes.assign(numLabels, 0);
+	result.mins.assign(numLabels, cell_t::Location(block.maxX, block.maxY, block.maxZ));
+	result.maxs.assign(numLabels, cell_t::Location(0, 0, 0));
+
+	for (unsigned int z = 0; z < block.depth(); z++)
+		for (unsigned int y = 0; y < block.height(); y++) {
+
+			const unsigned int* labelRow = &labels(0, y, z);
+
+			for (unsigned int x = 0; x < block.width(); x++) {
+
+				unsigned int l = labelRow[x] - 1;
+
+				result.sizes[l]++;
+
+				cell_t::Location& min = result.mins[l];
+				cell_t::Location& max = result.maxs[l];
+				min.x = std::min(min.x, (int)(block.minX + x));
+				min.y = std::min(min.y, (int)(block.minY + y));
+				min.z = std::min(min.z, (int)(block.minZ + z));
+				max.x = std::max(max.x, (int)(block.minX + x + 1));
+				max.y = std::max(max.y, (int)(block.minY + y + 1));
+				max.z = std::max(max.z, (int)(block.minZ + z + 1));
+			}
+		}
+
+	processBlock(i, block, labels, cellIds, recLabels, gtLabels);
+}
+
+void
+LocalToleranceFunction::addCellParts() {
+
+	for (unsigned int i = 0; i < _blockLabels.size(); i++) {
+
+		const BlockLabels& blockLabels = _blockLabels[i];
+
+		for (unsigned int l = 0; l < blockLabels.numLabels; l++)
+			(*_cells)[_cellIds[blockLabels.offset + l]].addPart(
+					blockLabels.mins[l],
+					blockLabels.maxs[l],
+					blockLabels.sizes[l]);
+	}
+}
+
+void
+LocalToleranceFunction::visitBlocks(
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels,
+		block_visitor_type visitor) {
+
+	std::vector<unsigned int> blocks(_blocks.size());
+	for (unsigned int i = 0; i < _blocks.size(); i++)
+		blocks[i] = i;
+
+	parallelFor(
+			blocks.size(),
+			optionTedNumThreads.as<unsigned int>(),
+			boost::bind(&LocalToleranceFunction::visitBlock, this, _1, boost::cref(blocks), boost::cref(recLabels), boost::cref(gtLabels), boost::ref(visitor)));
+}
+
+void
+LocalToleranceFunction::visitBlocks(
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels,
+		const std::vector<unsigned int>& cells,
+		block_visitor_type visitor) {
+
+	std::vector<bool> isVisited(_cells->size(), false);
+	foreach (unsigned int cellIndex, cells)
+		isVisited[cellIndex] = true;
+
+	std::vector<unsigned int> blocks;
+	for (unsigned int i = 0; i < _blockLabels.size(); i++)
+		for (unsigned int l = 0; l < _blockLabels[i].numLabels; l++)
+			if (isVisited[_cellIds[_blockLabels[i].offset + l]]) {
+
+				blocks.push_back(i);
+				break;
+			}
+
+	parallelFor(
+			blocks.size(),
+			optionTedNumThreads.as<unsigned int>(),
+			boost::bind(&LocalToleranceFunction::visitBlock, this, _1, boost::cref(blocks), boost::cref(recLabels), boost::cref(gtLabels), boost::ref(visitor)));
+}
+
+void
+LocalToleranceFunction::visitBlock(
+		unsigned int job,
+		const std::vector<unsigned int>& blocks,
+		const ImageStack& recLabels,
+		const ImageStack& gtLabels,
+		block_visitor_type& visitor) {
+
+	const Block& block  = _blocks[blocks[job]];
+	unsigned int offset = _blockLabels[blocks[job]].offset;
+
+	vigra::MultiArray<3, unsigned int>     labels;
+	std::vector<std::pair<float, float> > values;
+	unsigned int numLabels = labelBlock(block, recLabels, gtLabels, labels, values);
+
+	std::vector<unsigned int> cellIds(
+			_cellIds.begin() + offset,
+			_cellIds.begin() + offset + numLabels);
+
+	visitor(block, labels, cellIds);
+}
+
+void
+LocalToleranceFunction::findEqualBaselineCells() {
+
+	_equalBaselineCells.assign(_cells->size(), -1);
+	_baselineCells.assign(_cells->size(), -1);
+
+	if (_baseline->_blocks.size() != _blocks.size())
+		return;
+
+	// the number of components of each baseline cell
+	std::vector<unsigned int> baselineNumComponents(_baseline->_cells->size(), 0);
+	foreach (unsigned int baselineCell, _baseline->_cellIds)
+		baselineNumComponents[baselineCell]++;
+
+	// A cell is equal to a baseline cell, if all its components are in 
+	// unchanged blocks, where they are the components of the baseline, and 
+	// they are all the components of one baseline cell.
+	std::vector<unsigned int> numComponents(_cells->size(), 0);
+	std::vector<bool>         changed(_cells->size(), false);
+
+	for (unsigned int i = 0; i < _blockLabels.size(); i++)
+		for (unsigned int l = 0; l < _blockLabels[i].numLabels; l++) {
+
+			unsigned int cellIndex = _cellIds[_blockLabels[i].offset + l];
+
+			numComponents[cellIndex]++;
+
+			if (_changed[i]) {
+
+				changed[cellIndex] = true;
+				continue;
+			}
+
+			int baselineCell = _baseline->_cellIds[_baseline->_blockLabels[i].offset + l];
+
+			if (numComponents[cellIndex] == 1)
+				_equalBaselineCells[cellIndex] = baselineCell;
+			else if (_equalBaselineCells[cellIndex] != baselineCell)
+				changed[cellIndex] = true;
+		}
+
+	for (unsigned int cellIndex = 0; cellIndex < _cells->size(); cellIndex++)
+		if (changed[cellIndex] || numComponents[cellIndex] != baselineNumComponents[_equalBaselineCells[cellIndex]])
+			_equalBaselineCells[cellIndex] = -1;
+}
+
+bool
+LocalToleranceFunction::keepBaselineAlternatives(unsigned int cellIndex, const Block& region) {
+
+	if (!isUpdate())
+		return false;
+
+	int baselineCellIndex = _equalBaselineCells[cellIndex];
+
+	if (baselineCellIndex < 0 || hasChanges(region))
+		return false;
+
+	const cell_t& baselineCell = (*_baseline->_cells)[baselineCellIndex];
+
+	// the alternative labels have boundaries in the unchanged region, so they 
+	// all have an updated label
+	std::set<float> alternativeLabels;
+	foreach (float baselineLabel, baselineCell.getAlternativeLabels()) {
+
+		std::map<float, float>::const_iterator updatedLabel = _updatedLabels->find(baselineLabel);
+
+		if (updatedLabel == _updatedLabels->end())
+			return false;
+
+		alternativeLabels.insert(updatedLabel->second);
+	}
+
+	cell_t& cell = (*_cells)[cellIndex];
+
+	foreach (float recLabel, alternativeLabels) {
+
+		cell.addAlternativeLabel(recLabel);
+		registerPossibleMatch(cell.getGroundTruthLabel(), recLabel);
+	}
+
+	_baselineCells[cellIndex] = baselineCellIndex;
+
+	return true;
+}
+
+bool
+LocalToleranceFunction::hasChanges(const Block& region) const {
+
+	foreach (const Block& changes, _changedRegions)
+		if (intersect(changes, region))
+			return true;
+
+	return false;
+}
+
+bool
+LocalToleranceFunction::intersect(const Block& a, const Block& b) {
+
+	return
+			a.minX < b.maxX && b.minX < a.maxX &&
+			a.minY < b.maxY && b.minY < a.maxY &&
+			a.minZ < b.maxZ && b.minZ < a.maxZ;
+}
+
+LocalToleranceFunction::Block
+LocalToleranceFunction::getBoundingBox(const cell_t& cell, int marginX, int marginY, int marginZ) const {
+
+	const cell_t::Location& min = cell.getMin();
+	const cell_t::Location& max = cell.getMax();
+
+	Block box;
+	box.minX = std::max(0, min.x - marginX);
+	box.minY = std::max(0, min.y - marginY);
+	box.minZ = std::max(0, min.z - marginZ);
+	box.maxX = std::min((int)_width,  max.x + marginX);
+	box.maxY = std::min((int)_height, max.y + marginY);
+	box.maxZ = std::min((int)_depth,  max.z + marginZ);
+
+	return box;
+}
+
+unsigned int
+LocalToleranceFunction::findRoot(unsigned int entry) {
+
+	// path halving
+	while (_parents[entry] != entry) {
+
+		_parents[entry] = _parents[_parents[entry]];
+		entry = _parents[entry];
+	}
+
+	return entry;
+}
+
+void
+LocalToleranceFunction::merge(unsigned int a, unsigned int b) {
+
+	a = findRoot(a);
+	b = findRoot(b);
+
+	if (a == b)
+		return;
+
+	// keep the smaller entry as root
+	if (a < b)
+		_parents[b] = a;
+	else
+		_parents[a] = b;
 }
 
 std::set<float>&
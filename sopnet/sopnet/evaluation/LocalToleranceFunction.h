@@ -5,16 +5,35 @@
 #include <set>
 #include <map>
 
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 
 #include <imageprocessing/ImageStack.h>
+#include <util/ProgramOptions.h>
 #include "Cell.h"
 
 #include <vigra/multi_array.hxx>
 
+extern util::ProgramOption optionTedNumThreads;
+
 /**
  * Superclass of local tolerance functions, i.e., functions, that assign relabel
  * alternatives to each cell independently.
+ *
+ * Cells are extracted block-wise: The volume is split into blocks that are
+ * labelled independently and in parallel. Cells that touch across block
+ * borders are merged afterwards. Subclasses get to see each block together
+ * with the global cell ids of its voxels, such that no data structure of the
+ * size of the whole volume is needed.
+ *
+ * Cells do not store their locations. What is kept is the labels, size, and
+ * bounding box of each cell, the same for each connected component of each
+ * block, the pairs of components that touch across block faces, and the cell
+ * id of each component. Consumers of the locations relabel the blocks with
+ * visitBlocks(). Apart from the input stacks, the memory is thus linear in
+ * the number of cells, block components, and touching components, plus the
+ * labelling of one block per thread.
  */
 class LocalToleranceFunction {
 
@@ -23,6 +42,34 @@ public:
 	typedef Cell<float>                             cell_t;
 	typedef boost::shared_ptr<std::vector<cell_t> > cells_t;
 
+	/**
+	 * A block of the volume, given by its minimal (inclusive) and maximal 
+	 * (exclusive) coordinates.
+	 */
+	struct Block {
+
+		unsigned int minX, minY, minZ;
+		unsigned int maxX, maxY, maxZ;
+
+		unsigned int width()  const { return maxX - minX; }
+		unsigned int height() const { return maxY - minY; }
+		unsigned int depth()  const { return maxZ - minZ; }
+	};
+
+	/**
+	 * Callback for visitBlocks(), gets the block, the block-local component 
+	 * labels of its voxels (starting at 1), and the global cell id of each 
+	 * component (at label - 1).
+	 */
+	typedef boost::function<
+			void
+			(const Block& block,
+			 const vigra::MultiArray<3, unsigned int>& labels,
+			 const std::vector<unsigned int>& cellIds)>
+			block_visitor_type;
+
+	LocalToleranceFunction();
+
 	virtual ~LocalToleranceFunction() {}
 
 	/**
@@ -31,31 +78,80 @@ public:
 	void clear();
 
 	/**
-	 * Extract cells from the given cell label image and find all alternative 
-	 * labels for them.
+	 * Extract cells as the connected components of the intersection of the 
+	 * reconstruction and ground truth labels and find all alternative labels 
+	 * for them.
 	 * 
-	 * @param numCells
-	 *             The number of cells in the cell label image.
-	 * @param cellLabels
-	 *             A volume with a cell id at each location.
 	 * @param recLabels
-	 *             A corresponding image stack with the original reconstruction 
-	 *             labels at each location.
+	 *             An image stack with the original reconstruction labels at 
+	 *             each location.
 	 * @param gtLabels
 	 *             A corresponding image stack with the ground-truth labels at 
 	 *             each location.
 	 */
-	virtual void extractCells(
-			unsigned int numCells,
-			const vigra::MultiArray<3, unsigned int>& cellLabels,
+	void extractCells(
 			const ImageStack& recLabels,
-			const ImageStack& gtLabels) = 0;
+			const ImageStack& gtLabels);
+
+	/**
+	 * Extract the cells of a reconstruction that differs only locally from a 
+	 * baseline reconstruction. Cells are extracted as in extractCells(), but 
+	 * only blocks with changed locations are labelled again, and only blocks 
+	 * with a changed location within their halo are processed again. The 
+	 * components of all other blocks are taken from the baseline. Cells that 
+	 * are equal to a cell of the baseline and that are far enough away from 
+	 * any changed location keep the alternative labels of the baseline cell.
+	 *
+	 * @param recLabels
+	 *             The new reconstruction.
+	 * @param gtLabels
+	 *             The ground truth, the same as for the baseline.
+	 * @param baseline
+	 *             A tolerance function of the same type, that extracted the 
+	 *             cells of the baseline reconstruction.
+	 * @param baselineRecLabels
+	 *             The baseline reconstruction.
+	 * @param updatedLabels
+	 *             The label in the new reconstruction for each label of the 
+	 *             baseline reconstruction that did not change. A location is 
+	 *             changed, if its labels are not one of these pairs.
+	 */
+	void updateCells(
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels,
+			const LocalToleranceFunction& baseline,
+			const ImageStack& baselineRecLabels,
+			const std::map<float, float>& updatedLabels);
+
+	/**
+	 * After updateCells(), get for each cell the index of the baseline cell 
+	 * whose locations and alternative labels it kept, or -1 if the cell 
+	 * changed.
+	 */
+	const std::vector<int>& getBaselineCells() const { return _baselineCells; }
 
 	/**
 	 * Get all the cells that have been extracted.
 	 */
 	cells_t getCells() { return _cells; }
 
+	/**
+	 * Visit the locations of the extracted cells block by block. The blocks 
+	 * are labelled again and passed to the visitor concurrently, in an 
+	 * arbitrary order.
+	 *
+	 * @param recLabels
+	 *             The reconstruction the cells were extracted from.
+	 * @param gtLabels
+	 *             The ground truth the cells were extracted from.
+	 * @param visitor
+	 *             The function to call for each block.
+	 */
+	void visitBlocks(
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels,
+			block_visitor_type visitor);
+
 	/**
 	 * Get all the ground truth labels.
 	 */
@@ -80,13 +176,242 @@ public:
 
 protected:
 
+	/**
+	 * Called after all cells have been created (with their labels, but without 
+	 * their sizes and bounding boxes), before the first call to processBlock().
+	 */
+	virtual void beginBlocks(const ImageStack& /*recLabels*/, const ImageStack& /*gtLabels*/) {}
+
+	/**
+	 * Called for the i-th block with the block-local component labels of its 
+	 * voxels (starting at 1) and the global cell id of each component (at 
+	 * label - 1), such that implementations can accumulate values per cell in 
+	 * dense arrays. This method is called concurrently for different blocks. 
+	 * Blocks start at x-coordinates that are multiples of 64, such that 
+	 * bitmaps with one bit per voxel can be written concurrently.
+	 */
+	virtual void processBlock(
+			unsigned int /*i*/,
+			const Block& /*block*/,
+			const vigra::MultiArray<3, unsigned int>& /*labels*/,
+			const std::vector<unsigned int>& /*cellIds*/,
+			const ImageStack& /*recLabels*/,
+			const ImageStack& /*gtLabels*/) {}
+
+	/**
+	 * In updateCells(), called instead of processBlock() for the i-th block, 
+	 * if no location within the block halo changed. The components of the 
+	 * block are the same as in the baseline, implementations take their 
+	 * results for the block from there.
+	 */
+	virtual void keepBlock(
+			unsigned int /*i*/,
+			const Block& /*block*/,
+			const std::vector<unsigned int>& /*cellIds*/) {}
+
+	/**
+	 * Called after all blocks have been processed and all cells know their 
+	 * size and bounding box. Implementations find the alternative labels of 
+	 * the cells here, visitBlocks() can be used to get to their locations.
+	 */
+	virtual void endBlocks(const ImageStack& recLabels, const ImageStack& gtLabels) = 0;
+
 	void registerPossibleMatch(float gtLabel, float recLabel);
 
+	/**
+	 * Set the number of voxels around a block that processBlock() looks at. In 
+	 * updateCells(), only blocks with a changed location within this halo are 
+	 * processed again.
+	 */
+	void setBlockHalo(int x, int y, int z);
+
+	/**
+	 * Get the number of blocks the volume is split into.
+	 */
+	unsigned int getNumBlocks() const { return _blocks.size(); }
+
+	/**
+	 * Are the cells extracted by updateCells()?
+	 */
+	bool isUpdate() const { return _baseline != 0; }
+
+	/**
+	 * In updateCells(), get the tolerance function of the baseline.
+	 */
+	const LocalToleranceFunction* getBaseline() const { return _baseline; }
+
+	/**
+	 * Visit only the blocks that contain a location of one of the given cells.
+	 */
+	void visitBlocks(
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels,
+			const std::vector<unsigned int>& cells,
+			block_visitor_type visitor);
+
+	/**
+	 * In updateCells(), let a cell keep the alternative labels of the equal 
+	 * baseline cell, if there is one and if no location in the given region 
+	 * changed. The region has to contain the cell and everything its 
+	 * alternative labels depend on. Returns false, if the alternative labels 
+	 * have to be found again.
+	 */
+	bool keepBaselineAlternatives(unsigned int cellIndex, const Block& region);
+
+	/**
+	 * Get the bounding box of a cell, grown by the given margins and limited to 
+	 * the volume.
+	 */
+	Block getBoundingBox(const cell_t& cell, int marginX, int marginY, int marginZ) const;
+
 	// all extracted cells
 	cells_t _cells;
 
+	// the extends of the ground truth and reconstruction
+	unsigned int _width, _height, _depth;
+
 private:
 
+	// the result of labelling a single block
+	struct BlockLabels {
+
+		// the number of connected components in the block
+		unsigned int numLabels;
+
+		// the first union-find entry of this block
+		unsigned int offset;
+
+		// (gt, rec) label pair of each component
+		std::vector<std::pair<float, float> > values;
+
+		// the size and bounding box of each component
+		std::vector<unsigned int>     sizes;
+		std::vector<cell_t::Location> mins;
+		std::vector<cell_t::Location> maxs;
+
+		// the pairs of components that touch across the upper face of the 
+		// block along each axis, given by their labels in this and the next 
+		// block
+		std::vector<std::pair<unsigned int, unsigned int> > merges[3];
+
+		// the component labels on the lower and upper faces of the block, for 
+		// each axis, only until the blocks are merged
+		std::vector<unsigned int> lowerFaces[3];
+		std::vector<unsigned int> upperFaces[3];
+	};
+
+	// split the volume into blocks
+	void createBlocks();
+
+	// find connected components within the given block, returns the local 
+	// labels
+	unsigned int labelBlock(
+			const Block& block,
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels,
+			vigra::MultiArray<3, unsigned int>& labels,
+			std::vector<std::pair<float, float> >& values);
+
+	// in updateCells(), find the blocks with changed locations
+	void findChangedBlocks(const ImageStack& recLabels);
+
+	// in updateCells(), find the changed locations of block i
+	void findBlockChanges(unsigned int i, const ImageStack& recLabels);
+
+	// in updateCells(), take the components of an unchanged block from the 
+	// baseline
+	void copyBaselineBlock(unsigned int i);
+
+	// label the job-th of the given blocks and remember its faces
+	void labelBlockFaces(
+			unsigned int job,
+			const std::vector<unsigned int>& blocks,
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels);
+
+	// merge components of neighboring blocks and assign global cell ids
+	void mergeBlocks();
+
+	// merge the components that touch across the upper face of block i along 
+	// the given axis with the lower face of block j
+	void mergeFaces(unsigned int i, unsigned int j, int axis);
+
+	// label the job-th of the given blocks again, find the sizes and bounding 
+	// boxes of its components and pass it on to processBlock()
+	void extractBlockCells(
+			unsigned int job,
+			const std::vector<unsigned int>& blocks,
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels);
+
+	// add the sizes and bounding boxes of all components to their cells
+	void addCellParts();
+
+	// label the job-th of the given blocks again and pass it on to the visitor
+	void visitBlock(
+			unsigned int job,
+			const std::vector<unsigned int>& blocks,
+			const ImageStack& recLabels,
+			const ImageStack& gtLabels,
+			block_visitor_type& visitor);
+
+	// in updateCells(), find the baseline cell with the same components for 
+	// each cell
+	void findEqualBaselineCells();
+
+	// is there a changed location in the given region?
+	bool hasChanges(const Block& region) const;
+
+	// do the given blocks intersect?
+	static bool intersect(const Block& a, const Block& b);
+
+	// union-find on component entries
+	unsigned int findRoot(unsigned int entry);
+	void merge(unsigned int a, unsigned int b);
+
+	// the size of the blocks
+	unsigned int _blockWidth, _blockHeight, _blockDepth;
+
+	// the blocks of the volume
+	std::vector<Block> _blocks;
+
+	// the number of blocks along each axis
+	unsigned int _numBlocksX, _numBlocksY, _numBlocksZ;
+
+	// the number of voxels around a block that processBlock() looks at
+	int _blockHaloX, _blockHaloY, _blockHaloZ;
+
+	// the labelling result of each block
+	std::vector<BlockLabels> _blockLabels;
+
+	// union-find parents of the components of all blocks
+	std::vector<unsigned int> _parents;
+
+	// the global cell id of each component of all blocks, the components of 
+	// block i start at _blockLabels[i].offset
+	std::vector<unsigned int> _cellIds;
+
+	// the baseline tolerance function and reconstruction, and the updated 
+	// labels in updateCells()
+	const LocalToleranceFunction* _baseline;
+	const ImageStack*             _baselineRecLabels;
+	const std::map<float, float>* _updatedLabels;
+
+	// in updateCells(), is there a changed location in each block?
+	std::vector<bool> _changed;
+
+	// the bounding boxes of the changed locations of the changed blocks
+	std::vector<Block> _changedRegions;
+
+	// protects _changedRegions
+	boost::mutex _changedRegionsMutex;
+
+	// the baseline cell with equal locations and labels for each cell, or -1
+	std::vector<int> _equalBaselineCells;
+
+	// the baseline cell whose alternatives were kept for each cell, or -1
+	std::vector<int> _baselineCells;
+
 	// set of all ground truth labels
 	std::set<float> _groundTruthLabels;
 
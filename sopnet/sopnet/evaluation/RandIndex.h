@@ -2,7 +2,7 @@
 #define SOPNET_EVALUATION_RAND_INDEX_H__
 
 #include <pipeline/all.h>
-#include <imageprocessing/ImageStack.h>
+#include "ContingencyTable.h"
 #include "RandIndexErrors.h"
 
 class RandIndex : public pipeline::SimpleProcessNode<> {
@@ -15,11 +15,8 @@ private:
 
 	void updateOutputs();
 
-	size_t getNumAgreeingPairs(const ImageStack& stack1, const ImageStack& stack2, size_t& numLocations);
-
-	// input image stacks
-	pipeline::Input<ImageStack> _stack1;
-	pipeline::Input<ImageStack> _stack2;
+	// the label co-occurrences of the two image stacks to compare
+	pipeline::Input<ContingencyTable> _table;
 
 	pipeline::Output<RandIndexErrors> _errors;
 
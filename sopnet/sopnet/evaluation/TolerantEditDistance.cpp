@@ -1,19 +1,22 @@
 #include <algorithm>
 
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/range/adaptors.hpp>
 #include <boost/timer/timer.hpp>
 #include <boost/tuple/tuple.hpp>
-#include <vigra/multi_labeling.hxx>
 
 #include <sopnet/evaluation/GroundTruthExtractor.h>
+#include <inference/ComponentSolver.h>
 #include <inference/LinearConstraints.h>
 #include <inference/LinearObjective.h>
-#include <inference/LinearSolver.h>
+#include <inference/LinearSolverParameters.h>
 #include <pipeline/Value.h>
 #include <util/exceptions.h>
 #include <util/Logger.h>
 #include <util/ProgramOptions.h>
 #include "TolerantEditDistance.h"
+#include "ContingencyTableExtractor.h"
 #include "DistanceToleranceFunction.h"
 #include "SkeletonToleranceFunction.h"
 
@@ -70,10 +73,7 @@ TolerantEditDistance::TolerantEditDistance() :
 	registerOutput(_fnLocations, "false negatives");
 	registerOutput(_errors, "errors");
 
-	if (optionGroundTruthFromSkeletons)
-		_toleranceFunction = new SkeletonToleranceFunction(optionToleranceDistanceThreshold.as<float>(), _recBackgroundLabel);
-	else
-		_toleranceFunction = new DistanceToleranceFunction(optionToleranceDistanceThreshold.as<float>(), _haveBackgroundLabel, _recBackgroundLabel);
+	_toleranceFunction = createToleranceFunction();
 }
 
 TolerantEditDistance::~TolerantEditDistance() {
@@ -81,6 +81,15 @@ TolerantEditDistance::~TolerantEditDistance() {
 	delete _toleranceFunction;
 }
 
+LocalToleranceFunction*
+TolerantEditDistance::createToleranceFunction() {
+
+	if (optionGroundTruthFromSkeletons)
+		return new SkeletonToleranceFunction(optionToleranceDistanceThreshold.as<float>(), _recBackgroundLabel);
+	else
+		return new DistanceToleranceFunction(optionToleranceDistanceThreshold.as<float>(), _haveBackgroundLabel, _recBackgroundLabel);
+}
+
 void
 TolerantEditDistance::updateOutputs() {
 
@@ -88,28 +97,101 @@ TolerantEditDistance::updateOutputs() {
 
 	extractCells();
 
-	findBestCellLabels();
+	findTrivialLabels(*_toleranceFunction);
+
+	findBestCellLabels(*_toleranceFunction);
 
 	correctReconstruction();
 
 	findErrors();
+
+	writeLocations();
+
+	// keep the images of the reconstruction and the solution as baseline for 
+	// getIncrementalErrors(), the stack itself might be changed later
+	_baselineReconstruction = boost::make_shared<ImageStack>();
+	foreach (boost::shared_ptr<Image> image, *_reconstruction)
+		_baselineReconstruction->add(image);
+
+	getCellLabels(_baselineCellLabels);
+}
+
+boost::shared_ptr<TolerantEditDistanceErrors>
+TolerantEditDistance::getIncrementalErrors(boost::shared_ptr<ImageStack> reconstruction) {
+
+	boost::timer::auto_cpu_timer timer(std::cout, "\tgetIncrementalErrors():\t\t\t%ws\n");
+
+	if (!_baselineReconstruction)
+		BOOST_THROW_EXCEPTION(UsageError() << error_message("incremental errors need a baseline, update the node first") << STACK_TRACE);
+
+	if (reconstruction->size() != _baselineReconstruction->size())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("reconstruction and baseline reconstruction have different size") << STACK_TRACE);
+
+	if (reconstruction->height() != _baselineReconstruction->height() || reconstruction->width() != _baselineReconstruction->width())
+		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("reconstruction and baseline reconstruction have different size") << STACK_TRACE);
+
+	clearCellLabels();
+
+	std::map<float, float> updatedLabels;
+	matchLabels(reconstruction, updatedLabels);
+
+	// extract the cells, keep the unchanged ones of the baseline
+	boost::shared_ptr<LocalToleranceFunction> toleranceFunction(createToleranceFunction());
+	toleranceFunction->updateCells(
+			*reconstruction,
+			*_groundTruth,
+			*_toleranceFunction,
+			*_baselineReconstruction,
+			updatedLabels);
+
+	findTrivialLabels(*toleranceFunction);
+
+	findUnchangedLabels(*toleranceFunction, updatedLabels);
+
+	findBestCellLabels(*toleranceFunction);
+
+	boost::shared_ptr<TolerantEditDistanceErrors> errors(
+			_haveBackgroundLabel ?
+			new TolerantEditDistanceErrors(_gtBackgroundLabel, _recBackgroundLabel) :
+			new TolerantEditDistanceErrors());
+
+	errors->setCells(toleranceFunction->getCells());
+
+	unsigned int var;
+	std::pair<unsigned int, float> labeling;
+	foreach (boost::tie(var, labeling), _labelingByVar)
+		if ((*_solution)[var])
+			errors->addMapping(labeling.first, labeling.second);
+
+	return errors;
 }
 
 void
 TolerantEditDistance::clear() {
 
 	_toleranceFunction->clear();
-	_indicatorVarsByRecLabel.clear();
-	_indicatorVarsByGtToRecLabel.clear();
-	_matchVars.clear();
-	_labelingByVar.clear();
-	_alternativeIndicators.clear();
+	clearCellLabels();
 	_errors->clear();
 	_correctedReconstruction->clear();
 	_splitLocations->clear();
 	_mergeLocations->clear();
 	_fpLocations->clear();
 	_fnLocations->clear();
+	_baselineReconstruction.reset();
+	_baselineCellLabels.clear();
+}
+
+void
+TolerantEditDistance::clearCellLabels() {
+
+	_indicatorVarsByRecLabel.clear();
+	_indicatorVarsByGtToRecLabel.clear();
+	_matchVars.clear();
+	_labelingByVar.clear();
+	_alternativeIndicators.clear();
+	_trivialGtLabels.clear();
+	_trivialRecLabels.clear();
+	_fixedCellLabels.clear();
 }
 
 void
@@ -129,39 +211,15 @@ TolerantEditDistance::extractCells() {
 
 	LOG_ALL(tedlog) << "extracting cells in " << _width << "x" << _height << "x" << _depth << " volume" << std::endl;
 
-	vigra::MultiArray<3, std::pair<float, float> > gtAndRec(vigra::Shape3(_width, _height, _depth));
-	vigra::MultiArray<3, unsigned int>             cellIds(vigra::Shape3(_width, _height, _depth));
-
-	// prepare gt and rec image
-
-	for (unsigned int z = 0; z < _depth; z++) {
-
-		boost::shared_ptr<Image> gt  = (*_groundTruth)[z];
-		boost::shared_ptr<Image> rec = (*_reconstruction)[z];
-
-		for (unsigned int x = 0; x < _width; x++)
-			for (unsigned int y = 0; y < _height; y++) {
-
-				float gtLabel  = (*gt)(x, y);
-				float recLabel = (*rec)(x, y);
-
-				gtAndRec(x, y, z) = std::make_pair(gtLabel, recLabel);
-			}
-	}
-
-	// find connected components in gt and rec image
-	cellIds = 0;
-	_numCells = vigra::labelMultiArray(gtAndRec, cellIds);
-
-	LOG_DEBUG(tedlog) << "found " << _numCells << " cells" << std::endl;
-
-	// let tolerance function extract cells from that
+	// let tolerance function extract cells block-wise
 	_toleranceFunction->extractCells(
-			_numCells,
-			cellIds,
 			*_reconstruction,
 			*_groundTruth);
 
+	_numCells = _toleranceFunction->getCells()->size();
+
+	LOG_DEBUG(tedlog) << "found " << _numCells << " cells" << std::endl;
+
 	LOG_ALL(tedlog)
 			<< "found "
 			<< _toleranceFunction->getGroundTruthLabels().size()
@@ -172,7 +230,7 @@ TolerantEditDistance::extractCells() {
 }
 
 void
-TolerantEditDistance::findBestCellLabels() {
+TolerantEditDistance::findBestCellLabels(LocalToleranceFunction& toleranceFunction) {
 
 	boost::timer::auto_cpu_timer timer(std::cout, "\tfindBestCellLabels():\t\t\t%ws\n");
 
@@ -182,11 +240,15 @@ TolerantEditDistance::findBestCellLabels() {
 	// the default are binary variables
 	parameters->setVariableType(Binary);
 
-	// introduce indicators for each cell and each possible label of that cell
+	// introduce indicators for each cell and each possible label of that cell, 
+	// only for cells that have a choice
 	unsigned int var = 0;
-	for (unsigned int cellIndex = 0; cellIndex < _toleranceFunction->getCells()->size(); cellIndex++) {
+	for (unsigned int cellIndex = 0; cellIndex < toleranceFunction.getCells()->size(); cellIndex++) {
 
-		cell_t& cell = (*_toleranceFunction->getCells())[cellIndex];
+		cell_t& cell = (*toleranceFunction.getCells())[cellIndex];
+
+		if (_trivialGtLabels.count(cell.getGroundTruthLabel()))
+			continue;
 
 		// first indicator variable for this cell
 		unsigned int begin = var;
@@ -213,10 +275,12 @@ TolerantEditDistance::findBestCellLabels() {
 		constraint.setValue(1);
 		constraints->add(constraint);
 	}
-	_numIndicatorVars = var;
 
 	// labels can not disappear
-	foreach (float recLabel, _toleranceFunction->getReconstructionLabels()) {
+	foreach (float recLabel, toleranceFunction.getReconstructionLabels()) {
+
+		if (_trivialRecLabels.count(recLabel))
+			continue;
 
 		LinearConstraint constraint;
 		foreach (unsigned int v, getIndicatorsByRec(recLabel))
@@ -228,13 +292,26 @@ TolerantEditDistance::findBestCellLabels() {
 
 	// introduce indicators for each match of ground truth label to 
 	// reconstruction label
-	foreach (float gtLabel, _toleranceFunction->getGroundTruthLabels())
-		foreach (float recLabel, _toleranceFunction->getPossibleMatchesByGt(gtLabel))
+	unsigned int matchBegin = var;
+
+	foreach (float gtLabel, toleranceFunction.getGroundTruthLabels()) {
+
+		if (_trivialGtLabels.count(gtLabel))
+			continue;
+
+		foreach (float recLabel, toleranceFunction.getPossibleMatchesByGt(gtLabel))
 			assignMatchVariable(var++, gtLabel, recLabel);
+	}
+
+	unsigned int matchEnd = var;
 
 	// cell label selection activates match
-	foreach (float gtLabel, _toleranceFunction->getGroundTruthLabels()) {
-		foreach (float recLabel, _toleranceFunction->getPossibleMatchesByGt(gtLabel)) {
+	foreach (float gtLabel, toleranceFunction.getGroundTruthLabels()) {
+
+		if (_trivialGtLabels.count(gtLabel))
+			continue;
+
+		foreach (float recLabel, toleranceFunction.getPossibleMatchesByGt(gtLabel)) {
 
 			unsigned int matchVar = getMatchVariable(gtLabel, recLabel);
 
@@ -262,113 +339,293 @@ TolerantEditDistance::findBestCellLabels() {
 		}
 	}
 
-	// introduce split number for each ground truth label
+	unsigned int numVariables = var;
+
+	// cells without a choice keep their fixed label
+	for (unsigned int cellIndex = 0; cellIndex < toleranceFunction.getCells()->size(); cellIndex++) {
+
+		cell_t& cell = (*toleranceFunction.getCells())[cellIndex];
+
+		if (_trivialGtLabels.count(cell.getGroundTruthLabel()))
+			assignIndicatorVariable(var++, cellIndex, cell.getGroundTruthLabel(), _fixedCellLabels[cellIndex]);
+	}
 
-	unsigned int splitBegin = var;
+	LOG_DEBUG(tedlog)
+			<< "solving ILP with " << numVariables << " variables, "
+			<< (var - numVariables) << " cells have a fixed label" << std::endl;
+
+	_solution->resize(var);
+	std::fill(_solution->getVector().begin(), _solution->getVector().end(), 0.0);
+
+	for (unsigned int i = numVariables; i < var; i++)
+		(*_solution)[i] = 1.0;
+
+	if (numVariables == 0)
+		return;
+
+	// create objective
 
-	foreach (float gtLabel, _toleranceFunction->getGroundTruthLabels()) {
+	pipeline::Value<LinearObjective> objective(numVariables);
 
-		unsigned int splitVar = var++;
+	// we want to minimize the number of split and merges: each ground truth 
+	// label splits into one less than its number of matches, and each 
+	// reconstruction label merges one less than its number of matches -- every 
+	// match thus counts twice, up to a constant
+	for (unsigned int i = matchBegin; i < matchEnd; i++)
+		objective->setCoefficient(i, 2);
+	// however, if there are multiple equal solutions, we prefer the ones with 
+	// the least changes -- therefore, we add a small value for each of those 
+	// variables that can not sum up to one and therefor does not change the 
+	// number of splits and merges
+	unsigned int ind;
+	size_t cellSize;
+	double volumeSize = _width*_height*_depth;
+	foreach (boost::tie(ind, cellSize), _alternativeIndicators)
+		objective->setCoefficient(ind, static_cast<double>(cellSize)/(volumeSize + 1));
+	objective->setSense(Minimize);
 
-		parameters->setVariableType(splitVar, Integer);
+	// solve each connected component of the label matches independently
 
-		LinearConstraint positive;
-		positive.setCoefficient(splitVar, 1);
-		positive.setRelation(GreaterEqual);
-		positive.setValue(0);
-		constraints->add(positive);
+	pipeline::Process<ComponentSolver> solver;
 
-		LinearConstraint numSplits;
-		numSplits.setCoefficient(splitVar, 1);
-		foreach (float recLabel, _toleranceFunction->getPossibleMatchesByGt(gtLabel))
-			numSplits.setCoefficient(getMatchVariable(gtLabel, recLabel), -1);
-		numSplits.setRelation(Equal);
-		numSplits.setValue(-1);
-		constraints->add(numSplits);
+	solver->setInput("objective", objective);
+	solver->setInput("linear constraints", constraints);
+	solver->setInput("parameters", parameters);
+
+	pipeline::Value<Solution> solution = solver->getOutput("solution");
+
+	for (unsigned int i = 0; i < numVariables; i++)
+		(*_solution)[i] = (*solution)[i];
+}
+
+void
+TolerantEditDistance::findTrivialLabels(LocalToleranceFunction& toleranceFunction) {
+
+	std::map<float, unsigned int> gtComponents;
+	std::map<float, unsigned int> recComponents;
+
+	unsigned int numNodes = findComponents(toleranceFunction, gtComponents, recComponents);
+
+	// components with at least one cell that has alternative labels
+	std::vector<bool> hasChoice(numNodes, false);
+	foreach (const cell_t& cell, *toleranceFunction.getCells())
+		if (!cell.getAlternativeLabels().empty())
+			hasChoice[gtComponents[cell.getGroundTruthLabel()]] = true;
+
+	_trivialGtLabels.clear();
+	_trivialRecLabels.clear();
+
+	float label;
+	unsigned int component;
+	foreach (boost::tie(label, component), gtComponents)
+		if (!hasChoice[component])
+			_trivialGtLabels.insert(label);
+	foreach (boost::tie(label, component), recComponents)
+		if (!hasChoice[component])
+			_trivialRecLabels.insert(label);
+
+	// cells without a choice keep their label
+	_fixedCellLabels.clear();
+	foreach (const cell_t& cell, *toleranceFunction.getCells())
+		_fixedCellLabels.push_back(cell.getReconstructionLabel());
+
+	LOG_DEBUG(tedlog)
+			<< _trivialGtLabels.size() << " of " << gtComponents.size()
+			<< " ground truth labels do not need to be optimized" << std::endl;
+}
+
+void
+TolerantEditDistance::findUnchangedLabels(
+		LocalToleranceFunction& toleranceFunction,
+		const std::map<float, float>& updatedLabels) {
+
+	LocalToleranceFunction::cells_t baselineCells = _toleranceFunction->getCells();
+	LocalToleranceFunction::cells_t cells         = toleranceFunction.getCells();
+
+	const std::vector<int>& keptCells = toleranceFunction.getBaselineCells();
+
+	// A component of the baseline changed, if one of its cells was not kept. 
+	// A component of the update is equal to a component of the baseline, if 
+	// all its cells were kept from unchanged baseline components.
+
+	std::map<float, unsigned int> baselineGtComponents;
+	std::map<float, unsigned int> baselineRecComponents;
+
+	unsigned int numBaselineNodes = findComponents(*_toleranceFunction, baselineGtComponents, baselineRecComponents);
+
+	std::vector<bool> kept(baselineCells->size(), false);
+	foreach (int baselineCell, keptCells)
+		if (baselineCell >= 0)
+			kept[baselineCell] = true;
+
+	std::vector<bool> baselineChanged(numBaselineNodes, false);
+	for (unsigned int j = 0; j < baselineCells->size(); j++)
+		if (!kept[j])
+			baselineChanged[baselineGtComponents[(*baselineCells)[j].getGroundTruthLabel()]] = true;
+
+	std::map<float, unsigned int> gtComponents;
+	std::map<float, unsigned int> recComponents;
+
+	unsigned int numNodes = findComponents(toleranceFunction, gtComponents, recComponents);
+
+	std::vector<bool> changed(numNodes, false);
+	for (unsigned int i = 0; i < cells->size(); i++) {
+
+		unsigned int component = gtComponents[(*cells)[i].getGroundTruthLabel()];
+
+		int j = keptCells[i];
+
+		if (j < 0 ||
+		    baselineChanged[baselineGtComponents[(*baselineCells)[j].getGroundTruthLabel()]] ||
+		    !updatedLabels.count(_baselineCellLabels[j]))
+			changed[component] = true;
 	}
 
-	unsigned int splitEnd = var;
+	// cells of unchanged components keep their label of the baseline solution
+	for (unsigned int i = 0; i < cells->size(); i++)
+		if (!changed[gtComponents[(*cells)[i].getGroundTruthLabel()]])
+			_fixedCellLabels[i] = updatedLabels.find(_baselineCellLabels[keptCells[i]])->second;
+
+	float label;
+	unsigned int component;
+	foreach (boost::tie(label, component), gtComponents)
+		if (!changed[component])
+			_trivialGtLabels.insert(label);
+	foreach (boost::tie(label, component), recComponents)
+		if (!changed[component])
+			_trivialRecLabels.insert(label);
+
+	LOG_DEBUG(tedlog)
+			<< _trivialGtLabels.size() << " of " << gtComponents.size()
+			<< " ground truth labels do not need to be optimized again" << std::endl;
+}
 
-	// introduce total split number
+unsigned int
+TolerantEditDistance::findComponents(
+		LocalToleranceFunction& toleranceFunction,
+		std::map<float, unsigned int>& gtComponents,
+		std::map<float, unsigned int>& recComponents) {
 
-	_splits = var++;
-	parameters->setVariableType(_splits, Integer);
+	// union-find on the labels, ground truth labels first
+	std::map<float, unsigned int> gtNodes;
+	std::map<float, unsigned int> recNodes;
 
-	LinearConstraint sumOfSplits;
-	sumOfSplits.setCoefficient(_splits, 1);
-	for (unsigned int i = splitBegin; i < splitEnd; i++)
-		sumOfSplits.setCoefficient(i, -1);
-	sumOfSplits.setRelation(Equal);
-	sumOfSplits.setValue(0);
-	constraints->add(sumOfSplits);
+	foreach (float gtLabel, toleranceFunction.getGroundTruthLabels())
+		gtNodes.insert(std::make_pair(gtLabel, gtNodes.size()));
+	foreach (float recLabel, toleranceFunction.getReconstructionLabels())
+		recNodes.insert(std::make_pair(recLabel, gtNodes.size() + recNodes.size()));
 
-	// introduce merge number for each reconstruction label
+	std::vector<unsigned int> parents(gtNodes.size() + recNodes.size());
+	for (unsigned int i = 0; i < parents.size(); i++)
+		parents[i] = i;
 
-	unsigned int mergeBegin = var;
+	foreach (float gtLabel, toleranceFunction.getGroundTruthLabels())
+		foreach (float recLabel, toleranceFunction.getPossibleMatchesByGt(gtLabel)) {
 
-	foreach (float recLabel, _toleranceFunction->getReconstructionLabels()) {
+			unsigned int a = findRoot(parents, gtNodes[gtLabel]);
+			unsigned int b = findRoot(parents, recNodes[recLabel]);
 
-		unsigned int mergeVar = var++;
+			parents[std::max(a, b)] = std::min(a, b);
+		}
 
-		parameters->setVariableType(mergeVar, Integer);
+	gtComponents.clear();
+	recComponents.clear();
+
+	float label;
+	unsigned int node;
+	foreach (boost::tie(label, node), gtNodes)
+		gtComponents[label] = findRoot(parents, node);
+	foreach (boost::tie(label, node), recNodes)
+		recComponents[label] = findRoot(parents, node);
+
+	return parents.size();
+}
+
+unsigned int
+TolerantEditDistance::findRoot(std::vector<unsigned int>& parents, unsigned int node) {
 
-		LinearConstraint positive;
-		positive.setCoefficient(mergeVar, 1);
-		positive.setRelation(GreaterEqual);
-		positive.setValue(0);
-		constraints->add(positive);
+	// path halving
+	while (parents[node] != node) {
 
-		LinearConstraint numMerges;
-		numMerges.setCoefficient(mergeVar, 1);
-		foreach (float gtLabel, _toleranceFunction->getPossibleMathesByRec(recLabel))
-			numMerges.setCoefficient(getMatchVariable(gtLabel, recLabel), -1);
-		numMerges.setRelation(Equal);
-		numMerges.setValue(-1);
-		constraints->add(numMerges);
+		parents[node] = parents[parents[node]];
+		node = parents[node];
 	}
 
-	unsigned int mergeEnd = var;
+	return node;
+}
 
-	// introduce total merge number
+void
+TolerantEditDistance::matchLabels(
+		boost::shared_ptr<ImageStack> reconstruction,
+		std::map<float, float>& updatedLabels) {
 
-	_merges = var++;
-	parameters->setVariableType(_merges, Integer);
+	pipeline::Process<ContingencyTableExtractor> contingencyTableExtractor;
 
-	LinearConstraint sumOfMerges;
-	sumOfMerges.setCoefficient(_merges, 1);
-	for (unsigned int i = mergeBegin; i < mergeEnd; i++)
-		sumOfMerges.setCoefficient(i, -1);
-	sumOfMerges.setRelation(Equal);
-	sumOfMerges.setValue(0);
-	constraints->add(sumOfMerges);
+	contingencyTableExtractor->setInput("stack 1", _baselineReconstruction);
+	contingencyTableExtractor->setInput("stack 2", reconstruction);
 
-	// create objective
+	pipeline::Value<ContingencyTable> table = contingencyTableExtractor->getOutput("contingency table");
 
-	pipeline::Value<LinearObjective> objective(var);
+	const std::vector<float>&                    baselineLabels = table->getLabels1();
+	const std::vector<float>&                    labels         = table->getLabels2();
+	const std::vector<ContingencyTable::Entry>& entries        = table->getEntries();
 
-	// we want to minimize the number of split and merges
-	objective->setCoefficient(_splits, 1);
-	objective->setCoefficient(_merges, 1);
-	// however, if there are multiple equal solutions, we prefer the ones with 
-	// the least changes -- therefore, we add a small value for each of those 
-	// variables that can not sum up to one and therefor does not change the 
-	// number of splits and merges
-	unsigned int ind;
-	size_t cellSize;
-	double volumeSize = _width*_height*_depth;
-	foreach (boost::tie(ind, cellSize), _alternativeIndicators)
-		objective->setCoefficient(ind, static_cast<double>(cellSize)/(volumeSize + 1));
-	objective->setSense(Minimize);
+	std::vector<bool> baselineMatched(baselineLabels.size(), false);
+	std::vector<bool> matched(labels.size(), false);
 
-	// solve
+	updatedLabels.clear();
 
-	pipeline::Process<LinearSolver> solver;
+	// the background labels have to stay the background
+	if (_haveBackgroundLabel) {
 
-	solver->setInput("objective", objective);
-	solver->setInput("linear constraints", constraints);
-	solver->setInput("parameters", parameters);
+		for (unsigned int i = 0; i < baselineLabels.size(); i++)
+			if (baselineLabels[i] == _recBackgroundLabel)
+				baselineMatched[i] = true;
+		for (unsigned int i = 0; i < labels.size(); i++)
+			if (labels[i] == _recBackgroundLabel)
+				matched[i] = true;
+
+		foreach (const ContingencyTable::Entry& entry, entries)
+			if (baselineLabels[entry.label1] == _recBackgroundLabel && labels[entry.label2] == _recBackgroundLabel)
+				updatedLabels[_recBackgroundLabel] = _recBackgroundLabel;
+	}
+
+	// match greedily by the number of shared locations -- any one-to-one 
+	// matching is correct, the better it is, the fewer locations change
+	std::vector<std::pair<size_t, unsigned int> > order;
+	for (unsigned int i = 0; i < entries.size(); i++)
+		order.push_back(std::make_pair(entries[i].count, i));
+
+	std::sort(order.begin(), order.end());
 
-	_solution = solver->getOutput("solution");
+	for (unsigned int k = order.size(); k > 0; k--) {
+
+		const ContingencyTable::Entry& entry = entries[order[k - 1].second];
+
+		if (baselineMatched[entry.label1] || matched[entry.label2])
+			continue;
+
+		baselineMatched[entry.label1] = true;
+		matched[entry.label2]         = true;
+
+		updatedLabels[baselineLabels[entry.label1]] = labels[entry.label2];
+	}
+
+	LOG_DEBUG(tedlog)
+			<< "matched " << updatedLabels.size() << " of " << baselineLabels.size()
+			<< " baseline labels to " << labels.size() << " labels" << std::endl;
+}
+
+void
+TolerantEditDistance::getCellLabels(std::vector<float>& cellLabels) {
+
+	cellLabels.resize(_numCells);
+
+	unsigned int var;
+	std::pair<unsigned int, float> labeling;
+	foreach (boost::tie(var, labeling), _labelingByVar)
+		if ((*_solution)[var])
+			cellLabels[labeling.first] = labeling.second;
 }
 
 void
@@ -393,16 +650,11 @@ TolerantEditDistance::findErrors() {
 
 	// fill error data structure
 
-	for (unsigned int i = 0; i < _numIndicatorVars; i++) {
-
-		if ((*_solution)[i]) {
-
-			unsigned int cellIndex = _labelingByVar[i].first;
-			float        recLabel  = _labelingByVar[i].second;
-
-			_errors->addMapping(cellIndex, recLabel);
-		}
-	}
+	unsigned int var;
+	std::pair<unsigned int, float> labeling;
+	foreach (boost::tie(var, labeling), _labelingByVar)
+		if ((*_solution)[var])
+			_errors->addMapping(labeling.first, labeling.second);
 
 	//LOG_USER(tedlog) << "error counts from Errors data structure:" << std::endl;
 	//LOG_USER(tedlog) << "num splits: " << _errors->getNumSplits() << std::endl;
@@ -410,9 +662,12 @@ TolerantEditDistance::findErrors() {
 	//LOG_USER(tedlog) << "num false positives: " << _errors->getNumFalsePositives() << std::endl;
 	//LOG_USER(tedlog) << "num false negatives: " << _errors->getNumFalseNegatives() << std::endl;
 
-	// fill error location image stack
+	// fill the error location values of the cells, gray for no error
 
-	// all cells that changed label within tolerance
+	_splitCellLabels.assign(_numCells, 0.33);
+	_mergeCellLabels.assign(_numCells, 0.33);
+	_fpCellLabels.assign(_numCells, 0.33);
+	_fnCellLabels.assign(_numCells, 0.33);
 
 	// all cells that split the ground truth
 	float gtLabel;
@@ -420,16 +675,14 @@ TolerantEditDistance::findErrors() {
 	foreach (gtLabel, _errors->getSplitLabels())
 		foreach (const mapping_t& cells, _errors->getSplitCells(gtLabel))
 			foreach (unsigned int cellIndex, cells.second)
-				foreach (const cell_t::Location& l, (*_toleranceFunction->getCells())[cellIndex])
-					(*(*_splitLocations)[l.z])(l.x, l.y) = cells.first;
+				_splitCellLabels[cellIndex] = cells.first;
 
 	// all cells that split the reconstruction
 	float recLabel;
 	foreach (recLabel, _errors->getMergeLabels())
 		foreach (const mapping_t& cells, _errors->getMergeCells(recLabel))
 			foreach (unsigned int cellIndex, cells.second)
-				foreach (const cell_t::Location& l, (*_toleranceFunction->getCells())[cellIndex])
-					(*(*_mergeLocations)[l.z])(l.x, l.y) = cells.first;
+				_mergeCellLabels[cellIndex] = cells.first;
 
 	if (_haveBackgroundLabel) {
 
@@ -437,16 +690,14 @@ TolerantEditDistance::findErrors() {
 		foreach (const mapping_t& cells, _errors->getFalsePositiveCells())
 			if (cells.first != _recBackgroundLabel) {
 				foreach (unsigned int cellIndex, cells.second)
-					foreach (const cell_t::Location& l, (*_toleranceFunction->getCells())[cellIndex])
-						(*(*_fpLocations)[l.z])(l.x, l.y) = cells.first;
+					_fpCellLabels[cellIndex] = cells.first;
 			}
 
 		// all cells that are false negatives
 		foreach (const mapping_t& cells, _errors->getFalseNegativeCells())
 			if (cells.first != _gtBackgroundLabel) {
 				foreach (unsigned int cellIndex, cells.second)
-					foreach (const cell_t::Location& l, (*_toleranceFunction->getCells())[cellIndex])
-						(*(*_fnLocations)[l.z])(l.x, l.y) = cells.first;
+					_fnCellLabels[cellIndex] = cells.first;
 			}
 	}
 }
@@ -465,16 +716,58 @@ TolerantEditDistance::correctReconstruction() {
 
 	// read solution
 
-	for (unsigned int i = 0; i < _numIndicatorVars; i++) {
+	getCellLabels(_correctedCellLabels);
+}
+
+void
+TolerantEditDistance::writeLocations() {
+
+	boost::timer::auto_cpu_timer timer(std::cout, "\twriteLocations():\t\t\t%ws\n");
 
-		if ((*_solution)[i]) {
+	// the cells do not store their locations, the tolerance function labels 
+	// the blocks again
+	_toleranceFunction->visitBlocks(
+			*_reconstruction,
+			*_groundTruth,
+			boost::bind(&TolerantEditDistance::writeBlockLocations, this, _1, _2, _3));
+
+	_correctedCellLabels.clear();
+	_splitCellLabels.clear();
+	_mergeCellLabels.clear();
+	_fpCellLabels.clear();
+	_fnCellLabels.clear();
+}
+
+void
+TolerantEditDistance::writeBlockLocations(
+		const LocalToleranceFunction::Block& block,
+		const vigra::MultiArray<3, unsigned int>& labels,
+		const std::vector<unsigned int>& cellIds) {
+
+	// blocks do not overlap, so they can write to the images concurrently
+	for (unsigned int z = 0; z < block.depth(); z++) {
 
-			unsigned int cellIndex = _labelingByVar[i].first;
-			float        recLabel  = _labelingByVar[i].second;
-			cell_t&      cell      = (*_toleranceFunction->getCells())[cellIndex];
+		Image& corrected = *(*_correctedReconstruction)[block.minZ + z];
+		Image& splits    = *(*_splitLocations)[block.minZ + z];
+		Image& merges    = *(*_mergeLocations)[block.minZ + z];
+		Image& fps       = *(*_fpLocations)[block.minZ + z];
+		Image& fns       = *(*_fnLocations)[block.minZ + z];
 
-			foreach (const cell_t::Location& l, cell)
-				(*(*_correctedReconstruction)[l.z])(l.x, l.y) = recLabel;
+		for (unsigned int y = 0; y < block.height(); y++) {
+
+			const unsigned int* labelRow = &labels(0, y, z);
+
+			for (unsigned int x = 0; x < block.width(); x++) {
+
+				// argh, vigra starts counting at 1!
+				unsigned int cellIndex = cellIds[labelRow[x] - 1];
+
+				corrected(block.minX + x, block.minY + y) = _correctedCellLabels[cellIndex];
+				splits(block.minX + x, block.minY + y)    = _splitCellLabels[cellIndex];
+				merges(block.minX + x, block.minY + y)    = _mergeCellLabels[cellIndex];
+				fps(block.minX + x, block.minY + y)       = _fpCellLabels[cellIndex];
+				fns(block.minX + x, block.minY + y)       = _fnCellLabels[cellIndex];
+			}
 		}
 	}
 }
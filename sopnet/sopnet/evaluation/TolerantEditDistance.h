@@ -17,22 +17,81 @@ public:
 
 	~TolerantEditDistance();
 
+	/**
+	 * Get the errors of a reconstruction that differs only locally from the 
+	 * reconstruction of the last update of this node (the baseline). The 
+	 * cells, their alternative labels, and the solution of the match ILP are 
+	 * kept from the baseline wherever the changes have no influence. Only the 
+	 * changed cells and the connected components of the label match graph 
+	 * they are part of are computed again. The error counts are the same as 
+	 * for a full update with the given reconstruction.
+	 *
+	 * The outputs of this node are not changed, such that several 
+	 * reconstructions can be compared to the same baseline.
+	 */
+	boost::shared_ptr<TolerantEditDistanceErrors> getIncrementalErrors(boost::shared_ptr<ImageStack> reconstruction);
+
 private:
 
 	typedef LocalToleranceFunction::cell_t cell_t;
 
 	void updateOutputs();
 
+	LocalToleranceFunction* createToleranceFunction();
+
 	void clear();
 
+	// clear the ILP and the cell labels
+	void clearCellLabels();
+
 	void extractCells();
 
-	void findBestCellLabels();
+	// match each label of the baseline reconstruction to the label of the 
+	// given reconstruction that shares the most locations with it
+	void matchLabels(
+			boost::shared_ptr<ImageStack> reconstruction,
+			std::map<float, float>& updatedLabels);
+
+	void findBestCellLabels(LocalToleranceFunction& toleranceFunction);
+
+	// find all labels in connected components of the label match graph in 
+	// which no cell has alternative labels
+	void findTrivialLabels(LocalToleranceFunction& toleranceFunction);
+
+	// in an update, find all labels in connected components of the label match 
+	// graph that did not change since the baseline, and keep the baseline 
+	// labels of their cells
+	void findUnchangedLabels(
+			LocalToleranceFunction& toleranceFunction,
+			const std::map<float, float>& updatedLabels);
+
+	// find the connected component of each ground truth and reconstruction 
+	// label in the label match graph, given by the index of its root node
+	unsigned int findComponents(
+			LocalToleranceFunction& toleranceFunction,
+			std::map<float, unsigned int>& gtComponents,
+			std::map<float, unsigned int>& recComponents);
+
+	// union-find on the label match graph
+	unsigned int findRoot(std::vector<unsigned int>& parents, unsigned int node);
+
+	// get the label of each cell in the current solution
+	void getCellLabels(std::vector<float>& cellLabels);
 
 	void findErrors();
 
 	void correctReconstruction();
 
+	// write the values of the cells to the corrected reconstruction and the 
+	// error location stacks, block by block
+	void writeLocations();
+
+	// write the values of the cells of one block
+	void writeBlockLocations(
+			const LocalToleranceFunction::Block& block,
+			const vigra::MultiArray<3, unsigned int>& labels,
+			const std::vector<unsigned int>& cellIds);
+
 	void assignIndicatorVariable(unsigned int var, unsigned int cellIndex, float gtLabel, float recLabel);
 
 	std::vector<unsigned int>& getIndicatorsByRec(float recLabel);
@@ -82,17 +141,33 @@ private:
 	// map from ground truth label x reconstruction label to match variable
 	std::map<float, std::map<float, unsigned int> > _matchVars;
 
-	// the number of indicator variables in the ILP
-	unsigned int _numIndicatorVars;
-
 	// indicators for alternative cell labels, and the corresponding cell size
 	std::vector<std::pair<unsigned int, size_t> > _alternativeIndicators;
 
-	// the ILP variables for the number of splits and merges
-	unsigned int _splits;
-	unsigned int _merges;
+	// labels of match graph components that do not need to be optimized, 
+	// since all their cells have a fixed label
+	std::set<float> _trivialGtLabels;
+	std::set<float> _trivialRecLabels;
+
+	// the labels of the cells in components that do not need to be optimized
+	std::vector<float> _fixedCellLabels;
+
+	// the reconstruction of the last update
+	boost::shared_ptr<ImageStack> _baselineReconstruction;
+
+	// the labels of the cells in the solution of the last update
+	std::vector<float> _baselineCellLabels;
+
+	// the value of each cell in the corrected reconstruction and the error 
+	// location stacks
+	std::vector<float> _correctedCellLabels;
+	std::vector<float> _splitCellLabels;
+	std::vector<float> _mergeCellLabels;
+	std::vector<float> _fpCellLabels;
+	std::vector<float> _fnCellLabels;
 
-	// the solution of the ILP
+	// the solution of the ILP, followed by the indicators of cells that keep 
+	// their labels
 	pipeline::Value<Solution> _solution;
 };
 
@@ -48,6 +48,11 @@ public:
 	 */
 	void setCells(cells_t cells);
 
+	/**
+	 * Get the list of cells this errors data structure is working on.
+	 */
+	cells_t getCells() const { return _cells; }
+
 	/**
 	 * Clear the label mappings and error counts.
 	 */
@@ -1,5 +1,4 @@
 #include <util/Logger.h>
-#include <util/exceptions.h>
 #include <util/ProgramOptions.h>
 #include "VariationOfInformation.h"
 
@@ -13,86 +12,22 @@ logger::LogChannel variationofinformationlog("variationofinformationlog", "[Resu
 VariationOfInformation::VariationOfInformation() :
 		_ignoreBackground(optionVoiIgnoreBackground.as<bool>()) {
 
-	registerInput(_stack1, "stack 1");
-	registerInput(_stack2, "stack 2");
+	registerInput(_table, "contingency table");
 	registerOutput(_errors, "errors");
 }
 
 void
 VariationOfInformation::updateOutputs() {
 
-	if (_stack1->size() != _stack2->size())
-		BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("image stacks have different size") << STACK_TRACE);
-
-	// count label occurences
-
-	_p1.clear();
-	_p2.clear();
-	_p12.clear();
-
-	ImageStack::const_iterator i1  = _stack1->begin();
-	ImageStack::const_iterator i2  = _stack2->begin();
-
-	unsigned int n = 0;
-
-	for (; i1 != _stack1->end(); i1++, i2++) {
-
-		if ((*i1)->size() != (*i2)->size())
-			BOOST_THROW_EXCEPTION(SizeMismatchError() << error_message("images have different size") << STACK_TRACE);
-
-		n += (*i1)->size();
-
-		Image::iterator j1 = (*i1)->begin();
-		Image::iterator j2 = (*i2)->begin();
-
-		for (; j1 != (*i1)->end(); j1++, j2++) {
-
-			if (_ignoreBackground && (*j1 == 0 || *j2 == 0)) {
-
-				n--;
-				continue;
-			}
-
-			_p1[*j1]++;
-			_p2[*j2]++;
-			_p12[std::make_pair(*j1, *j2)]++;
-		}
-	}
-
-	// normalize
-
-	for (typename LabelProb::iterator i = _p1.begin(); i != _p1.end(); i++)
-		i->second /= n;
-	for (typename LabelProb::iterator i = _p2.begin(); i != _p2.end(); i++)
-		i->second /= n;
-	for (typename JointLabelProb::iterator i = _p12.begin(); i != _p12.end(); i++)
-		i->second /= n;
-
 	// compute information
 
 	// H(stack 1)
-	double H1 = 0.0;
+	double H1;
 	// H(stack 2)
-	double H2 = 0.0;
-	double I  = 0.0;
-
-	for(typename LabelProb::const_iterator i = _p1.begin(); i != _p1.end(); i++)
-		H1 -= i->second * std::log(i->second);
-
-	for(typename LabelProb::const_iterator i = _p2.begin(); i != _p2.end(); i++)
-		H2 -= i->second * std::log(i->second);
-
-	for(typename JointLabelProb::const_iterator i = _p12.begin(); i != _p12.end(); i++) {
-
-		const float j = i->first.first;
-		const float k = i->first.second;
-
-		const double pjk = i->second;
-		const double pj  = _p1[j];
-		const double pk  = _p2[k];
+	double H2;
+	double I;
 
-		I += pjk * std::log( pjk / (pj*pk) );
-	}
+	_table->getEntropies(H1, H2, I, _ignoreBackground);
 
 	// H(stack 1, stack2)
 	double H12 = H1 + H2 - I;
@@ -2,14 +2,11 @@
 #define SOPNET_EVALUATION_VARIATION_OF_INFORMATION_H__
 
 #include <pipeline/all.h>
-#include <imageprocessing/ImageStack.h>
+#include "ContingencyTable.h"
 #include "VariationOfInformationErrors.h"
 
 class VariationOfInformation : public pipeline::SimpleProcessNode<> {
 
-	typedef std::map<float, double>                   LabelProb;
-	typedef std::map<std::pair<float, float>, double> JointLabelProb;
-
 public:
 
 	VariationOfInformation();
@@ -18,17 +15,11 @@ private:
 
 	void updateOutputs();
 
-	// input image stacks
-	pipeline::Input<ImageStack> _stack1;
-	pipeline::Input<ImageStack> _stack2;
+	// the label co-occurrences of the two image stacks to compare
+	pipeline::Input<ContingencyTable> _table;
 
 	pipeline::Output<VariationOfInformationErrors> _errors;
 
-	// label probabilities
-	LabelProb      _p1;
-	LabelProb      _p2;
-	JointLabelProb _p12;
-
 	// do not count statistics for pixels that belong to the background
 	bool _ignoreBackground;
 };
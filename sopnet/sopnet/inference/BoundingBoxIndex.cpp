@@ -0,0 +1,85 @@
+#include <algorithm>
+
+#include "BoundingBoxIndex.h"
+
+BoundingBoxIndex::BoundingBoxIndex(int cellSize) :
+	_cellSize(std::max(1, cellSize)),
+	_currentMark(0) {}
+
+void
+BoundingBoxIndex::clear() {
+
+	_cells.clear();
+	_ids.clear();
+	_boundingBoxes.clear();
+	_marks.clear();
+	_currentMark = 0;
+}
+
+void
+BoundingBoxIndex::add(unsigned int id, const util::rect<int>& boundingBox) {
+
+	unsigned int entry = _ids.size();
+
+	_ids.push_back(id);
+	_boundingBoxes.push_back(boundingBox);
+	_marks.push_back(0);
+
+	for (int x = getCell(boundingBox.minX); x <= getCell(boundingBox.maxX); x++)
+		for (int y = getCell(boundingBox.minY); y <= getCell(boundingBox.maxY); y++)
+			_cells[cell_type(x, y)].push_back(entry);
+}
+
+void
+BoundingBoxIndex::find(const util::rect<int>& region, std::vector<unsigned int>& ids) {
+
+	ids.clear();
+
+	// get a fresh mark, reset all marks on overflow
+	_currentMark++;
+	if (_currentMark == 0) {
+
+		std::fill(_marks.begin(), _marks.end(), 0);
+		_currentMark = 1;
+	}
+
+	for (int x = getCell(region.minX); x <= getCell(region.maxX); x++)
+		for (int y = getCell(region.minY); y <= getCell(region.maxY); y++) {
+
+			boost::unordered_map<cell_type, std::vector<unsigned int> >::const_iterator cell = _cells.find(cell_type(x, y));
+
+			if (cell == _cells.end())
+				continue;
+
+			for (unsigned int i = 0; i < cell->second.size(); i++) {
+
+				unsigned int entry = cell->second[i];
+
+				if (_marks[entry] == _currentMark)
+					continue;
+
+				_marks[entry] = _currentMark;
+
+				if (intersects(_boundingBoxes[entry], region))
+					ids.push_back(_ids[entry]);
+			}
+		}
+}
+
+int
+BoundingBoxIndex::getCell(int coordinate) const {
+
+	// round towards negative infinity
+	if (coordinate < 0)
+		return -((-coordinate + _cellSize - 1)/_cellSize);
+
+	return coordinate/_cellSize;
+}
+
+bool
+BoundingBoxIndex::intersects(const util::rect<int>& a, const util::rect<int>& b) {
+
+	return
+			a.minX <= b.maxX && b.minX <= a.maxX &&
+			a.minY <= b.maxY && b.minY <= a.maxY;
+}
@@ -0,0 +1,66 @@
+#ifndef SOPNET_INFERENCE_BOUNDING_BOX_INDEX_H__
+#define SOPNET_INFERENCE_BOUNDING_BOX_INDEX_H__
+
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include <util/rect.hpp>
+
+/**
+ * A uniform grid over 2D bounding boxes to quickly find all boxes that
+ * intersect a query region. Each box is registered with all grid cells it
+ * covers, such that a query only has to look at the boxes in the cells
+ * covered by the query region.
+ */
+class BoundingBoxIndex {
+
+public:
+
+	/**
+	 * Create a new index.
+	 *
+	 * @param cellSize The width and height of the grid cells.
+	 */
+	BoundingBoxIndex(int cellSize = 128);
+
+	/**
+	 * Remove all boxes from the index.
+	 */
+	void clear();
+
+	/**
+	 * Add a bounding box with an id to the index.
+	 */
+	void add(unsigned int id, const util::rect<int>& boundingBox);
+
+	/**
+	 * Get the ids of all boxes that intersect the given region. Each id is
+	 * reported only once.
+	 */
+	void find(const util::rect<int>& region, std::vector<unsigned int>& ids);
+
+private:
+
+	typedef std::pair<int, int> cell_type;
+
+	// the cell that contains the given coordinates
+	int getCell(int coordinate) const;
+
+	static bool intersects(const util::rect<int>& a, const util::rect<int>& b);
+
+	int _cellSize;
+
+	// the entries (positions in _ids and _boundingBoxes) of each grid cell
+	boost::unordered_map<cell_type, std::vector<unsigned int> > _cells;
+
+	std::vector<unsigned int>    _ids;
+	std::vector<util::rect<int> > _boundingBoxes;
+
+	// marks for each entry to report entries spanning several cells only once
+	std::vector<unsigned int> _marks;
+	unsigned int              _currentMark;
+};
+
+#endif // SOPNET_INFERENCE_BOUNDING_BOX_INDEX_H__
+
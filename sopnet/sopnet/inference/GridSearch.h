@@ -25,18 +25,46 @@ public:
 	 */
 	std::string currentParameters() {
 
+		return toString(*_priorCostFunctionParameters, *_segmentationCostFunctionParameters);
+	}
+
+	/**
+	 * Get the current prior cost function parameters.
+	 */
+	const PriorCostFunctionParameters& currentPriorCostFunctionParameters() {
+
+		return *_priorCostFunctionParameters;
+	}
+
+	/**
+	 * Get the current segmentation cost function parameters.
+	 */
+	const SegmentationCostFunctionParameters& currentSegmentationCostFunctionParameters() {
+
+		return *_segmentationCostFunctionParameters;
+	}
+
+	/**
+	 * Get a configuration as a string.
+	 *
+	 * @return A string representing the given configuration.
+	 */
+	static std::string toString(
+			const PriorCostFunctionParameters&        priorCostFunctionParameters,
+			const SegmentationCostFunctionParameters& segmentationCostFunctionParameters) {
+
 		return
-				boost::lexical_cast<std::string>(_priorCostFunctionParameters->priorEnd) +
+				boost::lexical_cast<std::string>(priorCostFunctionParameters.priorEnd) +
 				std::string("\t") +
-				boost::lexical_cast<std::string>(_priorCostFunctionParameters->priorContinuation) +
+				boost::lexical_cast<std::string>(priorCostFunctionParameters.priorContinuation) +
 				std::string("\t") +
-				boost::lexical_cast<std::string>(_priorCostFunctionParameters->priorBranch) +
+				boost::lexical_cast<std::string>(priorCostFunctionParameters.priorBranch) +
 				std::string("\t") +
-				boost::lexical_cast<std::string>(_segmentationCostFunctionParameters->weight) +
+				boost::lexical_cast<std::string>(segmentationCostFunctionParameters.weight) +
 				std::string("\t") +
-				boost::lexical_cast<std::string>(_segmentationCostFunctionParameters->weightPotts) +
+				boost::lexical_cast<std::string>(segmentationCostFunctionParameters.weightPotts) +
 				std::string("\t") +
-				boost::lexical_cast<std::string>(_segmentationCostFunctionParameters->priorForeground);
+				boost::lexical_cast<std::string>(segmentationCostFunctionParameters.priorForeground);
 	}
 
 private:
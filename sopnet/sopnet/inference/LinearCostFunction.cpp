@@ -20,8 +20,8 @@ LinearCostFunction::LinearCostFunction() :
 void
 LinearCostFunction::updateOutputs() {
 
-	// invalidate cache
-	_cache.clear();
+	// features or weights changed
+	_cache.invalidate();
 
 	if (_features->numFeatures() != _parameters->getWeights().size()) {
 
@@ -45,59 +45,45 @@ LinearCostFunction::costs(
 
 	segmentCosts.resize(ends.size() + continuations.size() + branches.size(), 0);
 
-	if (segmentCosts.size() == _cache.size()) {
-
-		for (unsigned int i = 0; i < segmentCosts.size(); i++)
-			segmentCosts[i] += _cache[i];
-
-		return;
-	}
-
-	_cache.resize(ends.size() + continuations.size() + branches.size());
-
-	const std::vector<double> weights = _parameters->getWeights();
+	const std::vector<double>& weights = _parameters->getWeights();
 
 	unsigned int i = 0;
 
 	foreach (boost::shared_ptr<EndSegment> end, ends) {
 
-		double c = costs(*end, weights);
-
-		segmentCosts[i] += c;
-		_cache[i] = c;
-
+		segmentCosts[i] += costs(*end, weights);
 		i++;
 	}
 
 	foreach (boost::shared_ptr<ContinuationSegment> continuation, continuations) {
 
-		double c = costs(*continuation, weights);
-
-		segmentCosts[i] += c;
-		_cache[i] = c;
-
+		segmentCosts[i] += costs(*continuation, weights);
 		i++;
 	}
 
 	foreach (boost::shared_ptr<BranchSegment> branch, branches) {
 
-		double c = costs(*branch, weights);
-
-		segmentCosts[i] += c;
-		_cache[i] = c;
-
+		segmentCosts[i] += costs(*branch, weights);
 		i++;
 	}
+
+	// forget about segments that are not part of the problem anymore
+	_cache.removeUnused();
 }
 
 double
 LinearCostFunction::costs(const Segment& segment, const std::vector<double>& weights) {
 
+	if (_cache.contains(segment.getId()))
+		return _cache.get(segment.getId());
+
 	const std::vector<double>& features = _features->get(segment.getId());
 
 	double costs = 0;
 	for (unsigned int i = 0; i < features.size(); i++)
 		costs += features[i]*weights[i];
 
+	_cache.set(segment.getId(), costs);
+
 	return costs;
 }
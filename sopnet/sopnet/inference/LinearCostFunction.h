@@ -5,6 +5,7 @@
 #include <sopnet/features/Features.h>
 #include <sopnet/segments/Segment.h>
 #include "LinearCostFunctionParameters.h"
+#include "SegmentCostsCache.h"
 
 // forward declarations
 class EndSegment;
@@ -44,7 +45,8 @@ private:
 
 	pipeline::Output<costs_function_type> _costFunction;
 
-	std::vector<double> _cache;
+	// the costs of each segment, keyed by segment id
+	SegmentCostsCache _cache;
 };
 
 #endif // CELLTRACKER_TRACKLET_EVALUATOR_H__
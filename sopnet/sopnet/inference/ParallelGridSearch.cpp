@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <fstream>
+
+#include <boost/make_shared.hpp>
+
+#include <inference/ComponentSolver.h>
+#include <inference/LinearSolver.h>
+#include <inference/Presolver.h>
+#include <inference/PresolvedSolutionMapper.h>
+#include <util/Logger.h>
+#include <util/foreach.h>
+#include <util/ProgramOptions.h>
+#include <util/ParallelFor.h>
+#include <sopnet/evaluation/ErrorReport.h>
+#include "GridSearch.h"
+#include "ObjectiveGenerator.h"
+#include "PriorCostFunction.h"
+#include "Reconstructor.h"
+#include "SegmentationCostFunction.h"
+#include "ParallelGridSearch.h"
+
+static logger::LogChannel parallelgridsearchlog("parallelgridsearchlog", "[ParallelGridSearch] ");
+
+util::ProgramOption optionGridSearchNumThreads(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "gridSearchNumThreads",
+		util::_description_text = "The number of grid points to evaluate in parallel. The default (0) uses all available CPUs.",
+		util::_default_value    = 0);
+
+/**
+ * The per-thread part of the grid search: an optional prior cost function,
+ * objective generator, optional presolver, linear (or component) solver,
+ * reconstructor, and error report that operate on the shared segments and
+ * linear constraints.
+ */
+class ParallelGridSearch::Worker {
+
+public:
+
+	Worker(
+			boost::shared_ptr<Segments>               segments,
+			boost::shared_ptr<LinearConstraints>      linearConstraints,
+			boost::shared_ptr<LinearSolverParameters> parameters,
+			boost::shared_ptr<costs_function_type>    fixedCostFunction,
+			boost::shared_ptr<ImageStack>             groundTruth,
+			boost::shared_ptr<Segments>               groundTruthSegments,
+			boost::shared_ptr<Segments>               goldStandard,
+			const Options&                            options) :
+		_objectiveGenerator(boost::make_shared<ObjectiveGenerator>()),
+		_linearSolver(
+				options.splitComponents ?
+				boost::shared_ptr<pipeline::ProcessNode>(boost::make_shared<ComponentSolver>()) :
+				boost::shared_ptr<pipeline::ProcessNode>(boost::make_shared<LinearSolver>())),
+		_reconstructor(boost::make_shared<Reconstructor>()),
+		_errorReport(boost::make_shared<ErrorReport>()),
+		// the component solver has no initial solution
+		_warmStart(!options.splitComponents) {
+
+		_objectiveGenerator->setInput("segments", segments);
+		_objectiveGenerator->addInput("cost functions", fixedCostFunction);
+
+		if (options.priorCostFunction) {
+
+			_priorCostFunction = boost::make_shared<PriorCostFunction>();
+			_objectiveGenerator->addInput("cost functions", _priorCostFunction->getOutput("cost function"));
+		}
+
+		if (options.presolve) {
+
+			_presolver      = boost::make_shared<Presolver>();
+			_solutionMapper = boost::make_shared<PresolvedSolutionMapper>();
+
+			_presolver->setInput("objective", _objectiveGenerator->getOutput());
+			_presolver->setInput("linear constraints", linearConstraints);
+			_presolver->setInput("parameters", parameters);
+
+			_linearSolver->setInput("objective", _presolver->getOutput("objective"));
+			_linearSolver->setInput("linear constraints", _presolver->getOutput("linear constraints"));
+			_linearSolver->setInput("parameters", _presolver->getOutput("parameters"));
+
+			_solutionMapper->setInput("solution", _linearSolver->getOutput("solution"));
+			_solutionMapper->setInput("mapping", _presolver->getOutput("mapping"));
+
+			_solutionProvider = _solutionMapper;
+
+		} else {
+
+			_linearSolver->setInput("objective", _objectiveGenerator->getOutput());
+			_linearSolver->setInput("linear constraints", linearConstraints);
+			_linearSolver->setInput("parameters", parameters);
+
+			_solutionProvider = _linearSolver;
+		}
+
+		_reconstructor->setInput("solution", _solutionProvider->getOutput("solution"));
+		_reconstructor->setInput("segments", segments);
+
+		_errorReport->setInput("ground truth", groundTruth);
+		_errorReport->setInput("ground truth segments", groundTruthSegments);
+		_errorReport->setInput("gold standard segments", goldStandard);
+		_errorReport->setInput("reconstruction segments", _reconstructor->getOutput("reconstruction"));
+	}
+
+	/**
+	 * Solve the problem for the given prior parameters and get the error
+	 * report of the solution.
+	 */
+	std::string evaluate(const PriorCostFunctionParameters& parameters) {
+
+		if (_priorCostFunction)
+			_priorCostFunction->setInput("parameters", boost::make_shared<PriorCostFunctionParameters>(parameters));
+
+		// start from the optimum of the previous (neighbouring) grid point
+		if (_warmStart && _previousSolution) {
+
+			if (_presolver) {
+
+				// the reduction depends on the costs, map the previous 
+				// solution to the reduction of this grid point
+				pipeline::Value<PresolveMapping> mapping = _presolver->getOutput("mapping");
+
+				boost::shared_ptr<Solution> reduced = boost::make_shared<Solution>();
+				mapping->reduce(*_previousSolution, *reduced);
+
+				_linearSolver->setInput("initial solution", reduced);
+
+			} else {
+
+				_linearSolver->setInput("initial solution", _previousSolution);
+			}
+		}
+
+		pipeline::Value<std::string> report   = _errorReport->getOutput("error report");
+		pipeline::Value<Solution>    solution = _solutionProvider->getOutput("solution");
+
+		_previousSolution = boost::make_shared<Solution>(*solution);
+
+		return *report;
+	}
+
+	/**
+	 * Get the header of the error report. Valid after the first call to
+	 * evaluate().
+	 */
+	std::string getReportHeader() {
+
+		pipeline::Value<std::string> header = _errorReport->getOutput("error report header");
+
+		return *header;
+	}
+
+private:
+
+	boost::shared_ptr<PriorCostFunction>       _priorCostFunction;
+	boost::shared_ptr<ObjectiveGenerator>      _objectiveGenerator;
+	boost::shared_ptr<Presolver>               _presolver;
+	boost::shared_ptr<pipeline::ProcessNode>   _linearSolver;
+	boost::shared_ptr<PresolvedSolutionMapper> _solutionMapper;
+	boost::shared_ptr<Reconstructor>           _reconstructor;
+	boost::shared_ptr<ErrorReport>             _errorReport;
+
+	// the node that provides the solution of the original problem
+	boost::shared_ptr<pipeline::ProcessNode> _solutionProvider;
+
+	bool _warmStart;
+
+	boost::shared_ptr<Solution> _previousSolution;
+};
+
+ParallelGridSearch::ParallelGridSearch(const Options& options) :
+	_options(options),
+	_segmentationCostFunction(boost::make_shared<SegmentationCostFunction>()) {
+
+	registerInput(_segments, "segments");
+	registerInput(_linearConstraints, "linear constraints");
+	registerInput(_parameters, "parameters", pipeline::Optional);
+	registerInputs(_costFunctions, "cost functions");
+	registerInput(_membranes, "membranes", pipeline::Optional);
+	registerInput(_groundTruth, "ground truth");
+	registerInput(_groundTruthSegments, "ground truth segments");
+	registerInput(_goldStandard, "gold standard segments");
+}
+
+void
+ParallelGridSearch::run(const std::string& filename) {
+
+	// compute all shared data in this thread
+	updateInputs();
+
+	createGridPoints();
+
+	_results.clear();
+	_results.resize(_gridPoints.size());
+	_reportHeader = "";
+
+	unsigned int numThreads = getNumThreads(optionGridSearchNumThreads.as<unsigned int>(), _gridPoints.size());
+
+	LOG_USER(parallelgridsearchlog)
+			<< "evaluating " << _gridPoints.size() << " grid points with "
+			<< numThreads << " threads, each solver uses at most "
+			<< std::max(1u, getNumThreads(0, 0)/numThreads) << " CPUs" << std::endl;
+
+	boost::shared_ptr<costs_function_type> fixedCostFunction =
+			boost::make_shared<costs_function_type>(
+					boost::bind(&ParallelGridSearch::addFixedCosts, boost::cref(_fixedCosts), _1, _2, _3, _4));
+
+	// all workers solve with the same parameters
+	boost::shared_ptr<LinearSolverParameters> parameters =
+			(_parameters.isSet() ?
+			 _parameters.getSharedPointer() :
+			 boost::make_shared<LinearSolverParameters>(Binary));
+
+	if (!_options.priorCostFunction)
+		LOG_USER(parallelgridsearchlog)
+				<< "the prior cost function is not used, grid points that only differ "
+				<< "in the priors have the same result" << std::endl;
+
+	_workers.clear();
+	for (unsigned int i = 0; i < numThreads; i++)
+		_workers.push_back(
+				boost::make_shared<Worker>(
+						_segments.getSharedPointer(),
+						_linearConstraints.getSharedPointer(),
+						parameters,
+						fixedCostFunction,
+						_groundTruth.getSharedPointer(),
+						_groundTruthSegments.getSharedPointer(),
+						_goldStandard.getSharedPointer(),
+						_options));
+
+	// the costs of the parameter independent cost functions
+	std::vector<double> staticCosts;
+	for (unsigned int i = 0; i < _costFunctions.size(); i++)
+		(*_costFunctions[i])(_segments->getEnds(), _segments->getContinuations(), _segments->getBranches(), staticCosts);
+	staticCosts.resize(_segments->size(), 0);
+
+	if (_membranes.isSet())
+		_segmentationCostFunction->setInput("membranes", _membranes.getSharedPointer());
+
+	// process the grid points in groups of equal segmentation parameters
+	unsigned int groupBegin = 0;
+	while (groupBegin < _gridPoints.size()) {
+
+		const SegmentationCostFunctionParameters& segmentationParameters =
+				_gridPoints[groupBegin].segmentationCostFunctionParameters;
+
+		_rows.clear();
+
+		unsigned int groupEnd = groupBegin;
+		while (groupEnd < _gridPoints.size()) {
+
+			const GridPoint& point = _gridPoints[groupEnd];
+
+			if (point.segmentationCostFunctionParameters.weight          != segmentationParameters.weight ||
+			    point.segmentationCostFunctionParameters.weightPotts     != segmentationParameters.weightPotts ||
+			    point.segmentationCostFunctionParameters.priorForeground != segmentationParameters.priorForeground)
+				break;
+
+			// start a new row whenever the continuation or branch prior
+			// changes
+			if (_rows.empty() ||
+			    point.priorCostFunctionParameters.priorContinuation != _gridPoints[groupEnd - 1].priorCostFunctionParameters.priorContinuation ||
+			    point.priorCostFunctionParameters.priorBranch       != _gridPoints[groupEnd - 1].priorCostFunctionParameters.priorBranch) {
+
+				Row row;
+				row.begin = groupEnd;
+				_rows.push_back(row);
+			}
+
+			groupEnd++;
+			_rows.back().end = groupEnd;
+		}
+
+		LOG_USER(parallelgridsearchlog)
+				<< "evaluating grid points " << groupBegin << " to " << (groupEnd - 1)
+				<< " in " << _rows.size() << " rows" << std::endl;
+
+		updateFixedCosts(staticCosts, segmentationParameters);
+
+		parallelFor(
+				_rows.size(),
+				numThreads,
+				boost::bind(&ParallelGridSearch::processRow, this, _1, _2));
+
+		groupBegin = groupEnd;
+	}
+
+	LOG_USER(parallelgridsearchlog) << "writing results to " << filename << std::endl;
+
+	std::ofstream out(filename.c_str());
+	out
+			<< "# end\tcont\tbranch\tseg_w\tseg_p\tseg_f:\t"
+			<< _reportHeader << std::endl;
+
+	for (unsigned int i = 0; i < _gridPoints.size(); i++)
+		out
+				<< GridSearch::toString(
+						_gridPoints[i].priorCostFunctionParameters,
+						_gridPoints[i].segmentationCostFunctionParameters)
+				<< "\t" << _results[i] << std::endl;
+}
+
+void
+ParallelGridSearch::createGridPoints() {
+
+	_gridPoints.clear();
+
+	GridSearch gridSearch;
+
+	do {
+
+		GridPoint point;
+		point.priorCostFunctionParameters        = gridSearch.currentPriorCostFunctionParameters();
+		point.segmentationCostFunctionParameters = gridSearch.currentSegmentationCostFunctionParameters();
+
+		_gridPoints.push_back(point);
+
+	} while (gridSearch.next());
+}
+
+void
+ParallelGridSearch::updateFixedCosts(
+		const std::vector<double>&                staticCosts,
+		const SegmentationCostFunctionParameters& parameters) {
+
+	_fixedCosts = staticCosts;
+
+	if (!_membranes.isSet())
+		return;
+
+	_segmentationCostFunction->setInput("parameters", boost::make_shared<SegmentationCostFunctionParameters>(parameters));
+
+	pipeline::Value<costs_function_type> segmentationCostFunction = _segmentationCostFunction->getOutput("cost function");
+
+	(*segmentationCostFunction)(_segments->getEnds(), _segments->getContinuations(), _segments->getBranches(), _fixedCosts);
+}
+
+void
+ParallelGridSearch::processRow(unsigned int r, unsigned int thread) {
+
+	Worker& worker = *_workers[thread];
+
+	const Row& row = _rows[r];
+
+	for (unsigned int i = row.begin; i < row.end; i++) {
+
+		LOG_DEBUG(parallelgridsearchlog)
+				<< "evaluating grid point " << i << ": "
+				<< GridSearch::toString(
+						_gridPoints[i].priorCostFunctionParameters,
+						_gridPoints[i].segmentationCostFunctionParameters)
+				<< std::endl;
+
+		try {
+
+			_results[i] = worker.evaluate(_gridPoints[i].priorCostFunctionParameters);
+
+			boost::mutex::scoped_lock lock(_mutex);
+
+			if (_reportHeader.empty())
+				_reportHeader = worker.getReportHeader();
+
+		} catch (std::exception& e) {
+
+			LOG_ERROR(parallelgridsearchlog)
+					<< "evaluation of grid point " << i << " failed: "
+					<< e.what() << std::endl;
+
+			_results[i] = "failed";
+		}
+	}
+}
+
+void
+ParallelGridSearch::addFixedCosts(
+		const std::vector<double>&                                  fixedCosts,
+		const std::vector<boost::shared_ptr<EndSegment> >&          ends,
+		const std::vector<boost::shared_ptr<ContinuationSegment> >& continuations,
+		const std::vector<boost::shared_ptr<BranchSegment> >&       branches,
+		std::vector<double>& costs) {
+
+	costs.resize(ends.size() + continuations.size() + branches.size(), 0);
+
+	for (unsigned int i = 0; i < costs.size(); i++)
+		costs[i] += fixedCosts[i];
+}
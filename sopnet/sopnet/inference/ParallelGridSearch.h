@@ -0,0 +1,175 @@
+#ifndef SOPNET_INFERENCE_PARALLEL_GRID_SEARCH_H__
+#define SOPNET_INFERENCE_PARALLEL_GRID_SEARCH_H__
+
+#include <string>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+#include <pipeline/all.h>
+#include <imageprocessing/ImageStack.h>
+#include <inference/LinearConstraints.h>
+#include <inference/LinearSolverParameters.h>
+#include <sopnet/segments/Segments.h>
+#include "PriorCostFunctionParameters.h"
+#include "SegmentationCostFunctionParameters.h"
+
+// forward declarations
+class SegmentationCostFunction;
+
+/**
+ * Evaluates the grid of prior and segmentation cost parameters given by the
+ * GridSearch options in parallel.
+ *
+ * The segments, linear constraints, and the parameter independent cost
+ * functions are computed once and shared read-only between a pool of
+ * workers. Each worker owns its own objective generator, linear solver, and
+ * error report. Grid points are handed out in rows that only differ in the
+ * end prior, and each worker passes its previous optimum as initial solution
+ * to the solver.
+ *
+ * The workers run in threads of the same process. This is safe, since:
+ *
+ *   - the workers only read the shared data, which is computed before and
+ *     handed to them as plain data (not as outputs of the shared pipeline),
+ *     such that no pipeline update crosses from one worker to another;
+ *   - the fixed costs are only changed between two parallel rounds;
+ *   - each linear solver owns its backend, and each Gurobi backend its own
+ *     environment;
+ *   - the only global state written, the segment and slice ids, is
+ *     protected by mutexes.
+ *
+ * Each solver is limited to its share of the CPUs (see getNumThreads()), such
+ * that the workers do not oversubscribe the machine.
+ *
+ * The Options select the same parts of the inference as in Sopnet's
+ * pipeline: whether the prior cost function is used, whether the problem is
+ * presolved, and whether it is split into components.
+ *
+ * Inputs:
+ *
+ *   segments               : Segments
+ *   linear constraints     : LinearConstraints
+ *   parameters             : LinearSolverParameters (optional)
+ *   cost functions         : parameter independent cost functions
+ *   membranes              : ImageStack (optional, enables the segmentation
+ *                            cost function)
+ *   ground truth           : ImageStack
+ *   ground truth segments  : Segments
+ *   gold standard segments : Segments
+ */
+class ParallelGridSearch : public pipeline::SimpleProcessNode<> {
+
+	typedef boost::function<
+			void
+			(const std::vector<boost::shared_ptr<EndSegment> >&          ends,
+			 const std::vector<boost::shared_ptr<ContinuationSegment> >& continuations,
+			 const std::vector<boost::shared_ptr<BranchSegment> >&       branches,
+			 std::vector<double>& costs)>
+			costs_function_type;
+
+public:
+
+	/**
+	 * The parts of the inference to use for each grid point.
+	 */
+	struct Options {
+
+		Options() :
+			priorCostFunction(true),
+			presolve(false),
+			splitComponents(false) {}
+
+		// add the prior cost function, whose parameters are part of the grid
+		bool priorCostFunction;
+
+		// reduce the problem with the Presolver before solving it
+		bool presolve;
+
+		// solve with the ComponentSolver instead of the LinearSolver
+		bool splitComponents;
+	};
+
+	ParallelGridSearch(const Options& options = Options());
+
+	/**
+	 * Evaluate all grid points and write the parameters and error report of
+	 * each of them as one line to the given file.
+	 */
+	void run(const std::string& filename);
+
+private:
+
+	class Worker;
+
+	struct GridPoint {
+
+		PriorCostFunctionParameters        priorCostFunctionParameters;
+		SegmentationCostFunctionParameters segmentationCostFunctionParameters;
+	};
+
+	// a range of consecutive grid points that only differ in the end prior
+	struct Row {
+
+		unsigned int begin;
+		unsigned int end;
+	};
+
+	void updateOutputs() {}
+
+	// enumerate the grid points in the order of GridSearch
+	void createGridPoints();
+
+	// set the costs that are the same for all grid points with the given
+	// segmentation parameters
+	void updateFixedCosts(
+			const std::vector<double>&                staticCosts,
+			const SegmentationCostFunctionParameters& parameters);
+
+	// evaluate the grid points of row r with the worker of the given thread
+	void processRow(unsigned int r, unsigned int thread);
+
+	// cost function adding the fixed costs, shared by all workers
+	static void addFixedCosts(
+			const std::vector<double>&                                  fixedCosts,
+			const std::vector<boost::shared_ptr<EndSegment> >&          ends,
+			const std::vector<boost::shared_ptr<ContinuationSegment> >& continuations,
+			const std::vector<boost::shared_ptr<BranchSegment> >&       branches,
+			std::vector<double>& costs);
+
+	pipeline::Input<Segments>               _segments;
+	pipeline::Input<LinearConstraints>      _linearConstraints;
+	pipeline::Input<LinearSolverParameters> _parameters;
+	pipeline::Inputs<costs_function_type>   _costFunctions;
+	pipeline::Input<ImageStack>             _membranes;
+	pipeline::Input<ImageStack>             _groundTruth;
+	pipeline::Input<Segments>               _groundTruthSegments;
+	pipeline::Input<Segments>               _goldStandard;
+
+	Options _options;
+
+	boost::shared_ptr<SegmentationCostFunction> _segmentationCostFunction;
+
+	std::vector<GridPoint> _gridPoints;
+
+	// the error report for each grid point
+	std::vector<std::string> _results;
+
+	std::string _reportHeader;
+
+	// the costs of the parameter independent cost functions and the
+	// segmentation cost function for the current segmentation parameters
+	std::vector<double> _fixedCosts;
+
+	// one worker per thread
+	std::vector<boost::shared_ptr<Worker> > _workers;
+
+	// the rows of the current segmentation parameters
+	std::vector<Row> _rows;
+
+	// protects _reportHeader
+	boost::mutex _mutex;
+};
+
+#endif // SOPNET_INFERENCE_PARALLEL_GRID_SEARCH_H__
+
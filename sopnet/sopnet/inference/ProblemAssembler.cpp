@@ -1,10 +1,22 @@
+#include <algorithm>
+#include <limits>
+
+#include <boost/bind.hpp>
+
 #include <util/foreach.h>
 #include <util/ProgramOptions.h>
+#include <util/ParallelFor.h>
 #include <sopnet/segments/EndSegment.h>
 #include <sopnet/segments/ContinuationSegment.h>
 #include <sopnet/segments/BranchSegment.h>
 #include "ProblemAssembler.h"
 
+util::ProgramOption optionProblemAssemblerNumThreads(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "problemAssemblerNumThreads",
+		util::_description_text = "The number of threads to assemble the linear constraints with. The default (0) uses all available CPUs.",
+		util::_default_value    = 0);
+
 util::ProgramOption optionMaxMitochondriaNeuronDistance(
 		util::_module           = "sopnet.segments",
 		util::_long_name        = "maxMitochondriaNeuronDistance",
@@ -31,12 +43,17 @@ util::ProgramOption optionSynapseEnclosingThreshold(
 
 static logger::LogChannel problemassemblerlog("problemassemblerlog", "[ProblemAssembler] ");
 
+// marks slice ids that are not used by any segment
+static const unsigned int NoSlice = std::numeric_limits<unsigned int>::max();
+
 ProblemAssembler::ProblemAssembler() :
 	_allSegments(new Segments()),
 	_allNeuronSegments(new Segments()),
 	_allMitochondriaSegments(new Segments()),
 	_allSynapseSegments(new Segments()),
 	_allLinearConstraints(new LinearConstraints()),
+	_explanationConstraints(new LinearConstraints()),
+	_conflictConstraints(new LinearConstraints()),
 	_problemConfiguration(new ProblemConfiguration()),
 	_overlap(false, false) {
 
@@ -52,6 +69,8 @@ ProblemAssembler::ProblemAssembler() :
 	registerOutput(_allMitochondriaSegments, "mitochondria segments");
 	registerOutput(_allSynapseSegments, "synapse segments");
 	registerOutput(_allLinearConstraints, "linear constraints");
+	registerOutput(_explanationConstraints, "explanation constraints");
+	registerOutput(_conflictConstraints, "conflict constraints");
 	registerOutput(_problemConfiguration, "problem configuration");
 }
 
@@ -60,17 +79,30 @@ ProblemAssembler::updateOutputs() {
 
 	collectSegments();
 
+	// number the segments and slices
+	assignVariables();
+
+	// reserve space for all constraints
+	allocateConstraints();
+
 	// make sure slices are used from both sides
 	addExplanationConstraints();
 
 	// make sure segments don't overlap
 	addConsistencyConstraints();
 
+	// find enclosing neuron segments quickly
+	createNeuronIndex();
+
 	// make sure mitochondria are enclosed by a single neuron
 	addMitochondriaConstraints();
 
 	// make sure synapses are enclosed by a single neuron
 	addSynapseConstraints();
+
+	// provide the explanation constraints separately, such that they can be
+	// added lazily
+	splitConstraints();
 }
 
 void
@@ -129,19 +161,91 @@ ProblemAssembler::collectSegments() {
 }
 
 void
-ProblemAssembler::addExplanationConstraints() {
+ProblemAssembler::assignVariables() {
 
-	LOG_DEBUG(problemassemblerlog) << "adding explanation constraints..." << std::endl;
-
-	_allLinearConstraints->clear();
+	LOG_DEBUG(problemassemblerlog) << "assigning variables..." << std::endl;
 
 	/* Get a map from slice ids to slice numbers in [0, numSlices-1]. We need this
 	 * map to find the correct linear constraint for each slice.
 	 */
-	extractSliceIdsMap();
+	extractSliceNums();
+
+	unsigned int numIntervals = _allSegments->getNumInterSectionIntervals();
 
+	_endOffsets.resize(numIntervals);
+	_continuationOffsets.resize(numIntervals);
+	_branchOffsets.resize(numIntervals);
+
+	/* Assign a variable number to every segment: all ends first, then all
+	 * continuations, then all branches, each ordered by inter-section interval.
+	 * Remember this mapping -- we will need it to transform the linear
+	 * constraints on the segments and to reconstruct the result.
+	 */
 	_numSegments = 0;
 
+	for (unsigned int i = 0; i < numIntervals; i++) {
+
+		_endOffsets[i] = _numSegments;
+		foreach (boost::shared_ptr<EndSegment> segment, _allSegments->getEnds(i))
+			_problemConfiguration->setVariable(*segment, _numSegments++);
+	}
+
+	for (unsigned int i = 0; i < numIntervals; i++) {
+
+		_continuationOffsets[i] = _numSegments;
+		foreach (boost::shared_ptr<ContinuationSegment> segment, _allSegments->getContinuations(i))
+			_problemConfiguration->setVariable(*segment, _numSegments++);
+	}
+
+	for (unsigned int i = 0; i < numIntervals; i++) {
+
+		_branchOffsets[i] = _numSegments;
+		foreach (boost::shared_ptr<BranchSegment> segment, _allSegments->getBranches(i))
+			_problemConfiguration->setVariable(*segment, _numSegments++);
+	}
+
+	LOG_DEBUG(problemassemblerlog)
+			<< "assigned " << _numSegments << " variables to segments using "
+			<< _numSlices << " slices" << std::endl;
+}
+
+void
+ProblemAssembler::allocateConstraints() {
+
+	_conflictSources.clear();
+
+	foreach (boost::shared_ptr<LinearConstraints> linearConstraints, _neuronLinearConstraints)
+		_conflictSources.push_back(linearConstraints);
+	foreach (boost::shared_ptr<LinearConstraints> linearConstraints, _mitochondriaLinearConstraints)
+		_conflictSources.push_back(linearConstraints);
+
+	// the explanation constraints come first, one per slice
+	unsigned int numConstraints = _numSlices;
+
+	_conflictOffsets.resize(_conflictSources.size());
+	for (unsigned int i = 0; i < _conflictSources.size(); i++) {
+
+		_conflictOffsets[i] = numConstraints;
+		numConstraints += _conflictSources[i]->size();
+	}
+
+	_mitochondriaOffset = numConstraints;
+	numConstraints += _numMitochondriaSegments;
+
+	_synapseOffset = numConstraints;
+	numConstraints += _numSynapseSegments;
+
+	_allLinearConstraints->clear();
+	_allLinearConstraints->resize(numConstraints);
+
+	LOG_DEBUG(problemassemblerlog) << "allocated " << numConstraints << " linear constraints" << std::endl;
+}
+
+void
+ProblemAssembler::addExplanationConstraints() {
+
+	LOG_DEBUG(problemassemblerlog) << "adding explanation constraints..." << std::endl;
+
 	/* Make sure that the number of accepted segments having a certain slice at
 	 * the right side is equal to the number of accepted segments having this
 	 * slice on the left side.
@@ -151,32 +255,26 @@ ProblemAssembler::addExplanationConstraints() {
 	 * [sum of segments with slice right] - [sum of segments with slice left] = 0
 	 */
 
-	// allocate a set of linear constraints
-	_consistencyConstraints = LinearConstraints(_numSlices);
-
 	// set the relation and value
-	foreach (LinearConstraint& constraint, _consistencyConstraints) {
+	for (unsigned int i = 0; i < _numSlices; i++) {
 
-		constraint.setValue(0);
-		constraint.setRelation(Equal);
+		_allLinearConstraints->getMutableConstraint(i).setValue(0);
+		_allLinearConstraints->getMutableConstraint(i).setRelation(Equal);
 	}
 
-	// set the coefficients
-	foreach (boost::shared_ptr<EndSegment> segment, _allSegments->getEnds())
-		setCoefficient(*segment);
-
-	foreach (boost::shared_ptr<ContinuationSegment> segment, _allSegments->getContinuations())
-		setCoefficient(*segment);
-
-	foreach (boost::shared_ptr<BranchSegment> segment, _allSegments->getBranches())
-		setCoefficient(*segment);
+	/* Set the coefficients. Neighboring inter-section intervals share the
+	 * slices of the section between them, so we process the even and the odd
+	 * intervals one after another, each of them in parallel.
+	 */
+	unsigned int numIntervals = _allSegments->getNumInterSectionIntervals();
 
-	LOG_DEBUG(problemassemblerlog) << "created " << _consistencyConstraints.size() << " linear constraints" << std::endl;
+	parallelFor((numIntervals + 1)/2, optionProblemAssemblerNumThreads.as<unsigned int>(), boost::bind(&ProblemAssembler::setCoefficients, this, _1, 0));
+	parallelFor(numIntervals/2, optionProblemAssemblerNumThreads.as<unsigned int>(), boost::bind(&ProblemAssembler::setCoefficients, this, _1, 1));
 
-	foreach (const LinearConstraint& constraint, _consistencyConstraints)
-		LOG_ALL(problemassemblerlog) << constraint << std::endl;
+	LOG_DEBUG(problemassemblerlog) << "created " << _numSlices << " linear constraints" << std::endl;
 
-	_allLinearConstraints->addAll(_consistencyConstraints);
+	for (unsigned int i = 0; i < _numSlices; i++)
+		LOG_ALL(problemassemblerlog) << (*_allLinearConstraints)[i] << std::endl;
 }
 
 void
@@ -184,12 +282,9 @@ ProblemAssembler::addConsistencyConstraints() {
 
 	LOG_DEBUG(problemassemblerlog) << "adding consistency constraints..." << std::endl;
 
-	foreach (boost::shared_ptr<LinearConstraints> linearConstraints, _neuronLinearConstraints)
-		mapConstraints(linearConstraints);
-	foreach (boost::shared_ptr<LinearConstraints> linearConstraints, _mitochondriaLinearConstraints)
-		mapConstraints(linearConstraints);
+	parallelFor(_conflictSources.size(), optionProblemAssemblerNumThreads.as<unsigned int>(), boost::bind(&ProblemAssembler::mapConstraints, this, _1));
 
-	LOG_DEBUG(problemassemblerlog) << "collected " << _allLinearConstraints->size() << " linear constraints" << std::endl;
+	LOG_DEBUG(problemassemblerlog) << "collected " << (_mitochondriaOffset - _numSlices) << " linear constraints" << std::endl;
 }
 
 void
@@ -199,8 +294,17 @@ ProblemAssembler::addMitochondriaConstraints() {
 
 	LOG_ALL(problemassemblerlog) << "got " << _numMitochondriaSegments << " mitochondria segments" << std::endl;
 
-	// build a map of mitochondria segments to enclosing neuron segments
-	extractMitochondriaEnclosingNeuronSegments();
+	std::vector<boost::shared_ptr<Segment> > mitochondriaSegments = _allMitochondriaSegments->getSegments();
+
+	double maxMitochondriaNeuronDistance  = optionMaxMitochondriaNeuronDistance;
+	double mitochondriaEnclosingThreshold = optionMitochondriaEnclosingThreshold;
+
+	// find the enclosing neuron segments of each mitochondria segment
+	extractEnclosingNeuronVariables(
+			mitochondriaSegments,
+			maxMitochondriaNeuronDistance,
+			mitochondriaEnclosingThreshold,
+			_mitochondriaEnclosingNeuronVariables);
 
 	/* Make sure that for each picked mitochondria segment, one of the enclosing
 	 * neuron segments gets chosen as well.
@@ -208,32 +312,22 @@ ProblemAssembler::addMitochondriaConstraints() {
 	 * [mitochondria segment] - [sum of enclosing neuron segments] <= 0
 	 */
 
-	// allocate a set of linear constraints
-	_mitochondriaConstraints = LinearConstraints(_numMitochondriaSegments);
+	unsigned int numConstraints = std::min(_numMitochondriaSegments, (unsigned int)mitochondriaSegments.size());
 
-	// set the relation and value
-	foreach (LinearConstraint& constraint, _mitochondriaConstraints) {
+	for (unsigned int i = 0; i < numConstraints; i++) {
+
+		LinearConstraint& constraint = _allLinearConstraints->getMutableConstraint(_mitochondriaOffset + i);
 
 		constraint.setValue(0);
 		constraint.setRelation(LessEqual);
-	}
 
-	LinearConstraints::iterator constraint = _mitochondriaConstraints.begin();
-	foreach (boost::shared_ptr<Segment> mitochondriaSegment, _allMitochondriaSegments->getSegments()) {
+		constraint.setCoefficient(_problemConfiguration->getVariable(mitochondriaSegments[i]->getId()), 1);
 
-		unsigned int mitochondriaSegmentId = mitochondriaSegment->getId();
-
-		constraint->setCoefficient(_problemConfiguration->getVariable(mitochondriaSegmentId), 1);
-
-		foreach (unsigned int neuronSegmentId, getMitochondriaEnclosingNeuronSegments(mitochondriaSegmentId))
-			constraint->setCoefficient(_problemConfiguration->getVariable(neuronSegmentId), -1);
-
-		constraint++;
+		foreach (unsigned int neuronVariable, _mitochondriaEnclosingNeuronVariables[i])
+			constraint.setCoefficient(neuronVariable, -1);
 	}
 
-	LOG_DEBUG(problemassemblerlog) << "created " << _mitochondriaConstraints.size() << " linear constraints" << std::endl;
-
-	_allLinearConstraints->addAll(_mitochondriaConstraints);
+	LOG_DEBUG(problemassemblerlog) << "created " << numConstraints << " linear constraints" << std::endl;
 }
 
 void
@@ -243,8 +337,17 @@ ProblemAssembler::addSynapseConstraints() {
 
 	LOG_ALL(problemassemblerlog) << "got " << _numSynapseSegments << " synapse segments" << std::endl;
 
-	// build a map of synapse segments to enclosing neuron segments
-	extractSynapseEnclosingNeuronSegments();
+	std::vector<boost::shared_ptr<Segment> > synapseSegments = _allSynapseSegments->getSegments();
+
+	double maxSynapseNeuronDistance  = optionMaxSynapseNeuronDistance;
+	double synapseEnclosingThreshold = optionSynapseEnclosingThreshold;
+
+	// find the enclosing neuron segments of each synapse segment
+	extractEnclosingNeuronVariables(
+			synapseSegments,
+			maxSynapseNeuronDistance,
+			synapseEnclosingThreshold,
+			_synapseEnclosingNeuronVariables);
 
 	/* Make sure that for each picked synapse segment, none of the n enclosing
 	 * neuron segments gets chosen as well.
@@ -252,70 +355,76 @@ ProblemAssembler::addSynapseConstraints() {
 	 * [synapse segment]*n + [sum of enclosing neuron segments] <= n
 	 */
 
-	// allocate a set of linear constraints
-	_synapseConstraints = LinearConstraints(_numSynapseSegments);
+	unsigned int numConstraints = std::min(_numSynapseSegments, (unsigned int)synapseSegments.size());
+
+	for (unsigned int i = 0; i < numConstraints; i++) {
 
-	LinearConstraints::iterator constraint = _synapseConstraints.begin();
-	foreach (boost::shared_ptr<Segment> synapseSegment, _allSynapseSegments->getSegments()) {
+		LinearConstraint& constraint = _allLinearConstraints->getMutableConstraint(_synapseOffset + i);
 
-		LOG_ALL(problemassemblerlog) << "processing synapse segment " << synapseSegment->getId() << std::endl;
+		unsigned int n = _synapseEnclosingNeuronVariables[i].size();
 
-		unsigned int synapseSegmentId = synapseSegment->getId();
-		unsigned int n = getSynapseEnclosingNeuronSegments(synapseSegmentId).size();
+		LOG_ALL(problemassemblerlog)
+				<< "synapse segment " << synapseSegments[i]->getId() << " has "
+				<< n << " enclosing neuron segments" << std::endl;
 
-		LOG_ALL(problemassemblerlog) << "synapse segment has " << n << " enclosing neuron segments" << std::endl;
+		// leave a trivial constraint for synapses without enclosing neurons
+		constraint.setValue(n);
+		constraint.setRelation(LessEqual);
 
 		if (n == 0)
 			continue;
 
-		constraint->setValue(n);
-		constraint->setRelation(LessEqual);
-
-		LOG_ALL(problemassemblerlog) << "corresponding variable id is " << _problemConfiguration->getVariable(synapseSegmentId) << std::endl;
-
-		constraint->setCoefficient(_problemConfiguration->getVariable(synapseSegmentId), n);
-
-		LOG_ALL(problemassemblerlog) << "setting enclosing segments coefficients" << std::endl;
-
-		foreach (unsigned int neuronSegmentId, getSynapseEnclosingNeuronSegments(synapseSegmentId)) {
-
-			LOG_ALL(problemassemblerlog) << "setting coefficient for segment " << neuronSegmentId << std::endl;
-			constraint->setCoefficient(_problemConfiguration->getVariable(neuronSegmentId), 1);
-		}
+		constraint.setCoefficient(_problemConfiguration->getVariable(synapseSegments[i]->getId()), n);
 
-		LOG_ALL(problemassemblerlog) << "finished constraint for synapse segment " << synapseSegment->getId() << std::endl;
-
-		constraint++;
+		foreach (unsigned int neuronVariable, _synapseEnclosingNeuronVariables[i])
+			constraint.setCoefficient(neuronVariable, 1);
 	}
 
-	LOG_DEBUG(problemassemblerlog) << "created " << _synapseConstraints.size() << " linear constraints" << std::endl;
-
-	_allLinearConstraints->addAll(_synapseConstraints);
+	LOG_DEBUG(problemassemblerlog) << "created " << numConstraints << " linear constraints" << std::endl;
 }
 
 void
-ProblemAssembler::mapConstraints(boost::shared_ptr<LinearConstraints> linearConstraints) {
+ProblemAssembler::splitConstraints() {
+
+	_explanationConstraints->clear();
+	_conflictConstraints->clear();
+
+	// the explanation constraints are the first ones in all linear constraints
+	for (unsigned int i = 0; i < _allLinearConstraints->size(); i++)
+		if (i < _numSlices)
+			_explanationConstraints->add((*_allLinearConstraints)[i]);
+		else
+			_conflictConstraints->add((*_allLinearConstraints)[i]);
+
+	LOG_DEBUG(problemassemblerlog)
+			<< "split linear constraints into " << _explanationConstraints->size()
+			<< " explanation and " << _conflictConstraints->size()
+			<< " conflict constraints" << std::endl;
+}
 
-	foreach (const LinearConstraint& linearConstraint, *linearConstraints) {
+void
+ProblemAssembler::setCoefficients(unsigned int i, unsigned int firstInterval) {
 
-		LinearConstraint mappedConstraint;
+	unsigned int interval = firstInterval + 2*i;
 
-		unsigned int id;
-		double value;
+	std::vector<boost::shared_ptr<EndSegment> >&          ends          = _allSegments->getEnds(interval);
+	std::vector<boost::shared_ptr<ContinuationSegment> >& continuations = _allSegments->getContinuations(interval);
+	std::vector<boost::shared_ptr<BranchSegment> >&       branches      = _allSegments->getBranches(interval);
 
-		foreach(boost::tie(id, value), linearConstraint.getCoefficients())
-			mappedConstraint.setCoefficient(_problemConfiguration->getVariable(id), value);
+	for (unsigned int j = 0; j < ends.size(); j++)
+		setCoefficient(*ends[j], _endOffsets[interval] + j);
 
-		mappedConstraint.setRelation(linearConstraint.getRelation());
+	for (unsigned int j = 0; j < continuations.size(); j++)
+		setCoefficient(*continuations[j], _continuationOffsets[interval] + j);
 
-		mappedConstraint.setValue(linearConstraint.getValue());
-
-		_allLinearConstraints->add(mappedConstraint);
-	}
+	for (unsigned int j = 0; j < branches.size(); j++)
+		setCoefficient(*branches[j], _branchOffsets[interval] + j);
 }
 
 void
-ProblemAssembler::setCoefficient(const EndSegment& end) {
+ProblemAssembler::setCoefficient(const EndSegment& end, unsigned int variable) {
+
+	LinearConstraints& constraints = *_allLinearConstraints;
 
 	unsigned int sliceId = end.getSlice()->getId();
 
@@ -323,22 +432,15 @@ ProblemAssembler::setCoefficient(const EndSegment& end) {
 	 * the number of the slice in the problem.
 	 */
 	if (end.getDirection() == Left) // slice is on the right
-		_consistencyConstraints[getSliceNum(sliceId)].setCoefficient(_numSegments,  1.0);
+		constraints.getMutableConstraint(getSliceNum(sliceId)).setCoefficient(variable,  1.0);
 	else                            // slice is on the left
-		_consistencyConstraints[getSliceNum(sliceId)].setCoefficient(_numSegments, -1.0);
-
-	/* Sneakily we assigned a variable number (_numSegments) to every
-	 * segment we found. Remember this mapping -- we will need it to
-	 * transform the linear constraints on the segments and to
-	 * reconstruct the result.
-	 */
-	_problemConfiguration->setVariable(end, _numSegments);
-
-	_numSegments++;
+		constraints.getMutableConstraint(getSliceNum(sliceId)).setCoefficient(variable, -1.0);
 }
 
 void
-ProblemAssembler::setCoefficient(const ContinuationSegment& continuation) {
+ProblemAssembler::setCoefficient(const ContinuationSegment& continuation, unsigned int variable) {
+
+	LinearConstraints& constraints = *_allLinearConstraints;
 
 	unsigned int sourceSliceId = continuation.getSourceSlice()->getId();
 	unsigned int targetSliceId = continuation.getTargetSlice()->getId();
@@ -348,27 +450,20 @@ ProblemAssembler::setCoefficient(const ContinuationSegment& continuation) {
 	 */
 	if (continuation.getDirection() == Left) { // target is left
 
-		_consistencyConstraints[getSliceNum(targetSliceId)].setCoefficient(_numSegments, -1.0);
-		_consistencyConstraints[getSliceNum(sourceSliceId)].setCoefficient(_numSegments,  1.0);
+		constraints.getMutableConstraint(getSliceNum(targetSliceId)).setCoefficient(variable, -1.0);
+		constraints.getMutableConstraint(getSliceNum(sourceSliceId)).setCoefficient(variable,  1.0);
 
 	} else  {                                  // target is right
 
-		_consistencyConstraints[getSliceNum(targetSliceId)].setCoefficient(_numSegments,  1.0);
-		_consistencyConstraints[getSliceNum(sourceSliceId)].setCoefficient(_numSegments, -1.0);
+		constraints.getMutableConstraint(getSliceNum(targetSliceId)).setCoefficient(variable,  1.0);
+		constraints.getMutableConstraint(getSliceNum(sourceSliceId)).setCoefficient(variable, -1.0);
 	}
-
-	/* Sneakily we assigned a variable number (_numSegments) to every
-	 * segment we found. Remember this mapping -- we will need it to
-	 * transform the linear constraints on the segments and to
-	 * reconstruct the result.
-	 */
-	_problemConfiguration->setVariable(continuation, _numSegments);
-
-	_numSegments++;
 }
 
 void
-ProblemAssembler::setCoefficient(const BranchSegment& branch) {
+ProblemAssembler::setCoefficient(const BranchSegment& branch, unsigned int variable) {
+
+	LinearConstraints& constraints = *_allLinearConstraints;
 
 	unsigned int sourceSliceId  = branch.getSourceSlice()->getId();
 	unsigned int targetSlice1Id = branch.getTargetSlice1()->getId();
@@ -379,32 +474,63 @@ ProblemAssembler::setCoefficient(const BranchSegment& branch) {
 	 */
 	if (branch.getDirection() == Left) { // targets are left
 
-		_consistencyConstraints[getSliceNum(targetSlice1Id)].setCoefficient(_numSegments, -1.0);
-		_consistencyConstraints[getSliceNum(targetSlice2Id)].setCoefficient(_numSegments, -1.0);
-		_consistencyConstraints[getSliceNum(sourceSliceId)].setCoefficient(_numSegments,   1.0);
+		constraints.getMutableConstraint(getSliceNum(targetSlice1Id)).setCoefficient(variable, -1.0);
+		constraints.getMutableConstraint(getSliceNum(targetSlice2Id)).setCoefficient(variable, -1.0);
+		constraints.getMutableConstraint(getSliceNum(sourceSliceId)).setCoefficient(variable,   1.0);
 
 	} else  {                                  // target is right
 
-		_consistencyConstraints[getSliceNum(targetSlice1Id)].setCoefficient(_numSegments,  1.0);
-		_consistencyConstraints[getSliceNum(targetSlice2Id)].setCoefficient(_numSegments,  1.0);
-		_consistencyConstraints[getSliceNum(sourceSliceId)].setCoefficient(_numSegments,  -1.0);
+		constraints.getMutableConstraint(getSliceNum(targetSlice1Id)).setCoefficient(variable,  1.0);
+		constraints.getMutableConstraint(getSliceNum(targetSlice2Id)).setCoefficient(variable,  1.0);
+		constraints.getMutableConstraint(getSliceNum(sourceSliceId)).setCoefficient(variable,  -1.0);
 	}
+}
 
-	/* Sneakily we assigned a variable number (_numSegments) to every
-	 * segment we found. Remember this mapping -- we will need it to
-	 * transform the linear constraints on the segments and to
-	 * reconstruct the result.
-	 */
-	_problemConfiguration->setVariable(branch, _numSegments);
+void
+ProblemAssembler::mapConstraints(unsigned int i) {
 
-	_numSegments++;
+	const LinearConstraints& linearConstraints = *_conflictSources[i];
+
+	for (unsigned int j = 0; j < linearConstraints.size(); j++) {
+
+		const LinearConstraint& linearConstraint = linearConstraints[j];
+
+		// write directly into the preallocated constraint
+		LinearConstraint& mappedConstraint = _allLinearConstraints->getMutableConstraint(_conflictOffsets[i] + j);
+
+		unsigned int id;
+		double value;
+
+		foreach(boost::tie(id, value), linearConstraint.getCoefficients())
+			mappedConstraint.setCoefficient(_problemConfiguration->getVariable(id), value);
+
+		mappedConstraint.setRelation(linearConstraint.getRelation());
+
+		mappedConstraint.setValue(linearConstraint.getValue());
+	}
 }
 
 void
-ProblemAssembler::extractSliceIdsMap() {
+ProblemAssembler::extractSliceNums() {
 
 	_numSlices = 0;
-	_sliceIdsMap.clear();
+	_sliceNums.clear();
+
+	if (_allSegments->size() == 0)
+		return;
+
+	// find the range of slice ids to allocate the dense mapping
+	_minSliceId = std::numeric_limits<unsigned int>::max();
+	unsigned int maxSliceId = 0;
+
+	foreach (boost::shared_ptr<Segment> segment, _allSegments->getSegments())
+		foreach (boost::shared_ptr<Slice> slice, segment->getSlices()) {
+
+			_minSliceId = std::min(_minSliceId, slice->getId());
+			maxSliceId  = std::max(maxSliceId,  slice->getId());
+		}
+
+	_sliceNums.assign(maxSliceId - _minSliceId + 1, NoSlice);
 
 	/* Collect all slice ids and assign them uniquely to a number between 0 and
 	 * the number of slices in the problem.
@@ -443,10 +569,12 @@ ProblemAssembler::addSlices(const BranchSegment& branch) {
 void
 ProblemAssembler::addId(unsigned int id) {
 
-	if (_sliceIdsMap.find(id) == _sliceIdsMap.end()) {
+	unsigned int& sliceNum = _sliceNums[id - _minSliceId];
+
+	if (sliceNum == NoSlice) {
 
-		// map does not contain prevSliceId yet
-		_sliceIdsMap[id] = _numSlices;
+		// slice id was not seen yet
+		sliceNum = _numSlices;
 		_numSlices++;
 	}
 }
@@ -454,85 +582,76 @@ ProblemAssembler::addId(unsigned int id) {
 unsigned int
 ProblemAssembler::getSliceNum(unsigned int sliceId) {
 
-	if (_sliceIdsMap.count(sliceId) == 0)
+	if (sliceId < _minSliceId || sliceId - _minSliceId >= _sliceNums.size() || _sliceNums[sliceId - _minSliceId] == NoSlice) {
+
 		LOG_ERROR(problemassemblerlog) << "unknown slice id!" << std::endl;
+		return 0;
+	}
 
-	return _sliceIdsMap[sliceId];
+	return _sliceNums[sliceId - _minSliceId];
 }
 
 void
-ProblemAssembler::extractMitochondriaEnclosingNeuronSegments() {
-
-	unsigned int maxMitochondriaNeuronDistance = optionMaxMitochondriaNeuronDistance;
-	_enclosingMitochondriaThreshold = optionMitochondriaEnclosingThreshold;
-
-	foreach (boost::shared_ptr<Segment> mitochondriaSegment, _allMitochondriaSegments->getSegments()) {
-
-		unsigned int mitochondriaSegmentId = mitochondriaSegment->getId();
-
-		boost::shared_ptr<EndSegment>          end;
-		boost::shared_ptr<ContinuationSegment> continuation;
-		boost::shared_ptr<BranchSegment>       branch;
-		double distance;
-
-		foreach (boost::tie(end, distance), _allNeuronSegments->findEnds(
-				mitochondriaSegment->getCenter(),
-				mitochondriaSegment->getInterSectionInterval(),
-				maxMitochondriaNeuronDistance))
-			if (encloses(end, mitochondriaSegment, _enclosingMitochondriaThreshold))
-				_mitochondriaEnclosingNeuronSegments[mitochondriaSegmentId].push_back(end->getId());
-
-		foreach (boost::tie(continuation, distance), _allNeuronSegments->findContinuations(
-				mitochondriaSegment->getCenter(),
-				mitochondriaSegment->getInterSectionInterval(),
-				maxMitochondriaNeuronDistance))
-			if (encloses(continuation, mitochondriaSegment, _enclosingMitochondriaThreshold))
-				_mitochondriaEnclosingNeuronSegments[mitochondriaSegmentId].push_back(continuation->getId());
-
-		foreach (boost::tie(branch, distance), _allNeuronSegments->findBranches(
-				mitochondriaSegment->getCenter(),
-				mitochondriaSegment->getInterSectionInterval(),
-				maxMitochondriaNeuronDistance))
-			if (encloses(branch, mitochondriaSegment, _enclosingMitochondriaThreshold))
-				_mitochondriaEnclosingNeuronSegments[mitochondriaSegmentId].push_back(branch->getId());
+ProblemAssembler::createNeuronIndex() {
+
+	_neuronSegmentsList = _allNeuronSegments->getSegments();
+
+	_neuronIndices.clear();
+	_neuronIndices.resize(_allNeuronSegments->getNumInterSectionIntervals());
+
+	for (unsigned int i = 0; i < _neuronSegmentsList.size(); i++) {
+
+		const Segment& segment = *_neuronSegmentsList[i];
+
+		unsigned int variable = _problemConfiguration->getVariable(segment.getId());
+
+		_neuronIndices[segment.getInterSectionInterval()].add(i, _problemConfiguration->getBoundingBox(variable));
 	}
 }
 
 void
-ProblemAssembler::extractSynapseEnclosingNeuronSegments() {
-
-	unsigned int maxSynapseNeuronDistance = optionMaxSynapseNeuronDistance;
-	_enclosingSynapseThreshold = optionSynapseEnclosingThreshold;
-
-	foreach (boost::shared_ptr<Segment> synapseSegment, _allSynapseSegments->getSegments()) {
-
-		unsigned int synapseSegmentId = synapseSegment->getId();
-
-		boost::shared_ptr<EndSegment> end;
-		boost::shared_ptr<ContinuationSegment> continuation;
-		boost::shared_ptr<BranchSegment> branch;
-		double distance;
-
-		foreach (boost::tie(end, distance), _allNeuronSegments->findEnds(
-				synapseSegment->getCenter(),
-				synapseSegment->getInterSectionInterval(),
-				maxSynapseNeuronDistance))
-			if (encloses(end, synapseSegment, _enclosingSynapseThreshold))
-				_synapseEnclosingNeuronSegments[synapseSegmentId].push_back(end->getId());
-
-		foreach (boost::tie(continuation, distance), _allNeuronSegments->findContinuations(
-				synapseSegment->getCenter(),
-				synapseSegment->getInterSectionInterval(),
-				maxSynapseNeuronDistance))
-			if (encloses(continuation, synapseSegment, _enclosingSynapseThreshold))
-				_synapseEnclosingNeuronSegments[synapseSegmentId].push_back(continuation->getId());
-
-		foreach (boost::tie(branch, distance), _allNeuronSegments->findBranches(
-				synapseSegment->getCenter(),
-				synapseSegment->getInterSectionInterval(),
-				maxSynapseNeuronDistance))
-			if (encloses(branch, synapseSegment, _enclosingSynapseThreshold))
-				_synapseEnclosingNeuronSegments[synapseSegmentId].push_back(branch->getId());
+ProblemAssembler::extractEnclosingNeuronVariables(
+		const std::vector<boost::shared_ptr<Segment> >& otherSegments,
+		double maxDistance,
+		double enclosingThreshold,
+		std::vector<std::vector<unsigned int> >& enclosingNeuronVariables) {
+
+	enclosingNeuronVariables.clear();
+	enclosingNeuronVariables.resize(otherSegments.size());
+
+	std::vector<unsigned int> candidates;
+
+	for (unsigned int i = 0; i < otherSegments.size(); i++) {
+
+		boost::shared_ptr<Segment> otherSegment = otherSegments[i];
+
+		unsigned int interval = otherSegment->getInterSectionInterval();
+
+		if (interval >= _neuronIndices.size())
+			continue;
+
+		// only neuron segments with intersecting bounding boxes can overlap
+		const util::rect<int>& boundingBox =
+				_problemConfiguration->getBoundingBox(
+						_problemConfiguration->getVariable(otherSegment->getId()));
+
+		_neuronIndices[interval].find(boundingBox, candidates);
+
+		foreach (unsigned int candidate, candidates) {
+
+			boost::shared_ptr<Segment> neuronSegment = _neuronSegmentsList[candidate];
+
+			// the maximal distance refers to the squared distance of the
+			// centers (as in Segments::findEnds())
+			double dx = neuronSegment->getCenter().x - otherSegment->getCenter().x;
+			double dy = neuronSegment->getCenter().y - otherSegment->getCenter().y;
+
+			if (dx*dx + dy*dy > maxDistance)
+				continue;
+
+			if (encloses(neuronSegment, otherSegment, enclosingThreshold))
+				enclosingNeuronVariables[i].push_back(_problemConfiguration->getVariable(neuronSegment->getId()));
+		}
 	}
 }
 
@@ -587,15 +706,3 @@ ProblemAssembler::getOverlap(
 			_overlap(*slices1[0], *slices2[0]) + _overlap(*slices1[1], *slices2[1]),
 			_overlap(*slices1[0], *slices2[1]) + _overlap(*slices1[1], *slices2[0]));
 }
-
-std::vector<unsigned int>&
-ProblemAssembler::getMitochondriaEnclosingNeuronSegments(unsigned int mitochondriaSegmentId) {
-
-	return _mitochondriaEnclosingNeuronSegments[mitochondriaSegmentId];
-}
-
-std::vector<unsigned int>&
-ProblemAssembler::getSynapseEnclosingNeuronSegments(unsigned int synapseSegmentId) {
-
-	return _synapseEnclosingNeuronSegments[synapseSegmentId];
-}
@@ -5,8 +5,15 @@
 #include <inference/LinearConstraints.h>
 #include <sopnet/features/Overlap.h>
 #include <sopnet/segments/Segments.h>
+#include "BoundingBoxIndex.h"
 #include "ProblemConfiguration.h"
 
+/**
+ * Collects the segments and linear constraints of all inter-section
+ * intervals and assembles the linear constraints of the whole problem. The
+ * constraints are written in-place into a preallocated set of linear
+ * constraints, several inter-section intervals (or inputs) in parallel.
+ */
 class ProblemAssembler : public pipeline::SimpleProcessNode<> {
 
 public:
@@ -19,6 +26,12 @@ private:
 
 	void collectSegments();
 
+	// assign variable numbers to the segments and slice numbers to the slices
+	void assignVariables();
+
+	// allocate all linear constraints and remember where each part starts
+	void allocateConstraints();
+
 	void addExplanationConstraints();
 
 	void addConsistencyConstraints();
@@ -27,15 +40,23 @@ private:
 
 	void addSynapseConstraints();
 
-	void mapConstraints(boost::shared_ptr<LinearConstraints> linearConstraints);
+	void splitConstraints();
+
+	// set the explanation coefficients of the segments in every second
+	// inter-section interval, starting with the given one -- these intervals
+	// do not share slices and can be processed in parallel
+	void setCoefficients(unsigned int i, unsigned int firstInterval);
 
-	void setCoefficient(const EndSegment& end);
+	void setCoefficient(const EndSegment& end, unsigned int variable);
 
-	void setCoefficient(const ContinuationSegment& continuation);
+	void setCoefficient(const ContinuationSegment& continuation, unsigned int variable);
 
-	void setCoefficient(const BranchSegment& branch);
+	void setCoefficient(const BranchSegment& branch, unsigned int variable);
 
-	void extractSliceIdsMap();
+	// map the constraints of one input from segment ids to variables
+	void mapConstraints(unsigned int i);
+
+	void extractSliceNums();
 
 	void addSlices(const EndSegment& end);
 
@@ -45,9 +66,16 @@ private:
 
 	void addId(unsigned int id);
 
-	void extractMitochondriaEnclosingNeuronSegments();
+	// create the spatial index of the neuron segments
+	void createNeuronIndex();
 
-	void extractSynapseEnclosingNeuronSegments();
+	// find the neuron segments enclosing each of the given segments and store
+	// their variable numbers
+	void extractEnclosingNeuronVariables(
+			const std::vector<boost::shared_ptr<Segment> >& otherSegments,
+			double maxDistance,
+			double enclosingThreshold,
+			std::vector<std::vector<unsigned int> >& enclosingNeuronVariables);
 
 	bool encloses(
 			boost::shared_ptr<Segment> neuronSegment,
@@ -58,10 +86,6 @@ private:
 			const std::vector<boost::shared_ptr<Slice> >& slices1,
 			const std::vector<boost::shared_ptr<Slice> >& slices2);
 
-	std::vector<unsigned int>& getMitochondriaEnclosingNeuronSegments(unsigned int otherSegmentId);
-
-	std::vector<unsigned int>& getSynapseEnclosingNeuronSegments(unsigned int otherSegmentId);
-
 	unsigned int getSliceNum(unsigned int sliceId);
 
 	// a list of neuron segments for each pair of frames
@@ -97,27 +121,43 @@ private:
 	// all linear constraints on all segments
 	pipeline::Output<LinearConstraints> _allLinearConstraints;
 
+	// the explanation constraints only (a subset of all linear constraints)
+	pipeline::Output<LinearConstraints> _explanationConstraints;
+
+	// all but the explanation constraints
+	pipeline::Output<LinearConstraints> _conflictConstraints;
+
 	// mapping of segment ids to a continous range of variable numbers
 	pipeline::Output<ProblemConfiguration> _problemConfiguration;
 
-	// the consistency constraints extracted for the segments
-	LinearConstraints _consistencyConstraints;
+	// the constraints on neuron and mitochondria segments of all inputs
+	std::vector<boost::shared_ptr<LinearConstraints> > _conflictSources;
 
-	// the mitochondria constraints
-	LinearConstraints _mitochondriaConstraints;
+	// the first variable of each inter-section interval and segment type
+	std::vector<unsigned int> _endOffsets;
+	std::vector<unsigned int> _continuationOffsets;
+	std::vector<unsigned int> _branchOffsets;
 
-	// the synapse constraints
-	LinearConstraints _synapseConstraints;
+	// the first constraint of each conflict source, the mitochondria, and the
+	// synapse constraints in all linear constraints
+	std::vector<unsigned int> _conflictOffsets;
+	unsigned int              _mitochondriaOffset;
+	unsigned int              _synapseOffset;
 
-	// a mapping from slice ids to the number of the consistency constraint it
-	// is used in
-	std::map<unsigned int, unsigned int> _sliceIdsMap;
+	// dense mapping from slice ids (minus the smallest slice id) to the
+	// number of the explanation constraint they are used in
+	std::vector<unsigned int> _sliceNums;
+	unsigned int              _minSliceId;
 
-	// map from mitochondria semgment ids to enclosing neuron segment ids
-	std::map<unsigned int, std::vector<unsigned int> > _mitochondriaEnclosingNeuronSegments;
+	// all neuron segments and a spatial index of their bounding boxes (one
+	// per inter-section interval) with their positions in _neuronSegmentsList
+	std::vector<boost::shared_ptr<Segment> > _neuronSegmentsList;
+	std::vector<BoundingBoxIndex>            _neuronIndices;
 
-	// map from synapse semgment ids to enclosing neuron segment ids
-	std::map<unsigned int, std::vector<unsigned int> > _synapseEnclosingNeuronSegments;
+	// variable numbers of the neuron segments enclosing each mitochondria and
+	// synapse segment
+	std::vector<std::vector<unsigned int> > _mitochondriaEnclosingNeuronVariables;
+	std::vector<std::vector<unsigned int> > _synapseEnclosingNeuronVariables;
 
 	// a counter for the number of segments that came in
 	unsigned int _numSegments;
@@ -133,14 +173,6 @@ private:
 
 	// functor to compute the overlap between slices
 	Overlap _overlap;
-
-	// min ratio of overlap to size to consider a mitochondria or synapse 
-	// segment to be enclosed by a neuron segment
-	double _enclosingMitochondriaThreshold;
-
-	// min ratio of overlap to size to consider a mitochondria or synapse 
-	// segment to be enclosed by a neuron segment
-	double _enclosingSynapseThreshold;
 };
 
 #endif // CELLTRACKER_PROBLEM_ASSEMBLER_H__
@@ -1,8 +1,14 @@
+#include <limits>
+
+#include <imageprocessing/ConnectedComponent.h>
+#include <util/foreach.h>
 #include <util/Logger.h>
 #include "ProblemConfiguration.h"
 
 logger::LogChannel problemconfigurationlog("problemconfigurationlog", "[ProblemConfiguration] ");
 
+const unsigned int ProblemConfiguration::NoEntry = std::numeric_limits<unsigned int>::max();
+
 ProblemConfiguration::ProblemConfiguration() {
 
 	clear();
@@ -12,21 +18,41 @@ void
 ProblemConfiguration::setVariable(const Segment& segment, unsigned int variable) {
 
 	setVariable(segment.getId(), variable);
-	fit(segment);
+
+	util::rect<int> boundingBox(0, 0, 0, 0);
+	foreach (boost::shared_ptr<Slice> slice, segment.getSlices())
+		if (boundingBox.isZero())
+			boundingBox = slice->getComponent()->getBoundingBox();
+		else
+			boundingBox.fit(slice->getComponent()->getBoundingBox());
+
+	fit(segment, boundingBox);
 	_interSectionIntervals[variable] = segment.getInterSectionInterval();
+	_boundingBoxes[variable]         = boundingBox;
 }
 
 void
 ProblemConfiguration::setVariable(unsigned int segmentId, unsigned int variable) {
 
+	if (variable >= _segmentIds.size()) {
+
+		_segmentIds.resize(variable + 1, NoEntry);
+		_interSectionIntervals.resize(variable + 1, NoEntry);
+		_boundingBoxes.resize(variable + 1, util::rect<int>(0, 0, 0, 0));
+	}
+
 	_variables[segmentId] = variable;
 	_segmentIds[variable] = segmentId;
+
+	_indexDirty = true;
 }
 
 unsigned int
 ProblemConfiguration::getVariable(unsigned int segmentId) {
 
-	if (!_variables.count(segmentId))
+	boost::unordered_map<unsigned int, unsigned int>::const_iterator i = _variables.find(segmentId);
+
+	if (i == _variables.end())
 		BOOST_THROW_EXCEPTION(
 				NoSuchSegment()
 				<< error_message(
@@ -34,13 +60,13 @@ ProblemConfiguration::getVariable(unsigned int segmentId) {
 						boost::lexical_cast<std::string>(segmentId))
 				<< STACK_TRACE);
 
-	return _variables[segmentId];
+	return i->second;
 }
 
 unsigned int
 ProblemConfiguration::getSegmentId(unsigned int variable) {
 
-	if (!_segmentIds.count(variable))
+	if (variable >= _segmentIds.size() || _segmentIds[variable] == NoEntry)
 		BOOST_THROW_EXCEPTION(
 				NoSuchSegment()
 				<< error_message(
@@ -51,34 +77,63 @@ ProblemConfiguration::getSegmentId(unsigned int variable) {
 	return _segmentIds[variable];
 }
 
-std::vector<unsigned int>
+unsigned int
+ProblemConfiguration::getInterSectionInterval(unsigned int variable) {
+
+	checkVariable(variable);
+
+	return _interSectionIntervals[variable];
+}
+
+const util::rect<int>&
+ProblemConfiguration::getBoundingBox(unsigned int variable) {
+
+	checkVariable(variable);
+
+	return _boundingBoxes[variable];
+}
+
+ProblemConfiguration::variable_range
 ProblemConfiguration::getVariables(unsigned int minInterSectionInterval, unsigned int maxInterSectionInterval) {
 
-	std::vector<unsigned int> variables;
-	unsigned int variableId;
-	unsigned int interSectionInterval;
+	updateIndex();
 
-	foreach (boost::tie(variableId, interSectionInterval), _interSectionIntervals) {
+	if (_minInterSectionInterval < 0)
+		return variable_range(_intervalVariables.end(), _intervalVariables.end());
 
-		if (interSectionInterval >= minInterSectionInterval && interSectionInterval < maxInterSectionInterval)
-			variables.push_back(variableId);
-	}
+	// clip the requested range to the extents of the problem
+	unsigned int numIntervals = _intervalOffsets.size() - 1;
+	unsigned int begin = std::max(minInterSectionInterval, (unsigned int)_minInterSectionInterval) - _minInterSectionInterval;
+	unsigned int end   = std::max(maxInterSectionInterval, (unsigned int)_minInterSectionInterval) - _minInterSectionInterval;
 
-	return variables;
+	begin = std::min(begin, numIntervals);
+	end   = std::max(begin, std::min(end, numIntervals));
+
+	return variable_range(
+			_intervalVariables.begin() + _intervalOffsets[begin],
+			_intervalVariables.begin() + _intervalOffsets[end]);
 }
 
-std::set<unsigned int>
-ProblemConfiguration::getVariables() {
+void
+ProblemConfiguration::getVariables(
+		unsigned int minInterSectionInterval,
+		unsigned int maxInterSectionInterval,
+		const util::rect<int>& region,
+		std::vector<unsigned int>& variables) {
 
-	unsigned int variable;
-	unsigned int segmentId;
+	variables.clear();
 
-	std::set<unsigned int> variables;
+	foreach (unsigned int variable, getVariables(minInterSectionInterval, maxInterSectionInterval))
+		if (_boundingBoxes[variable].intersects(region))
+			variables.push_back(variable);
+}
+
+const std::vector<unsigned int>&
+ProblemConfiguration::getVariables() {
 
-	foreach (boost::tie(variable, segmentId), _segmentIds)
-		variables.insert(variable);
+	updateIndex();
 
-	return variables;
+	return _assignedVariables;
 }
 
 void
@@ -86,6 +141,13 @@ ProblemConfiguration::clear() {
 
 	_variables.clear();
 	_segmentIds.clear();
+	_interSectionIntervals.clear();
+	_boundingBoxes.clear();
+	_assignedVariables.clear();
+	_intervalVariables.clear();
+	_intervalOffsets.clear();
+
+	_indexDirty = true;
 
 	_minInterSectionInterval = -1;
 	_maxInterSectionInterval = -1;
@@ -95,7 +157,48 @@ ProblemConfiguration::clear() {
 }
 
 void
-ProblemConfiguration::fit(const Segment& segment) {
+ProblemConfiguration::updateIndex() {
+
+	if (!_indexDirty)
+		return;
+
+	unsigned int numVariables = _segmentIds.size();
+
+	_assignedVariables.clear();
+	for (unsigned int v = 0; v < numVariables; v++)
+		if (_segmentIds[v] != NoEntry)
+			_assignedVariables.push_back(v);
+
+	_intervalVariables.clear();
+	_intervalOffsets.clear();
+
+	if (_minInterSectionInterval >= 0) {
+
+		unsigned int numIntervals = _maxInterSectionInterval - _minInterSectionInterval + 1;
+
+		// count the variables per interval
+		_intervalOffsets.assign(numIntervals + 1, 0);
+		for (unsigned int v = 0; v < numVariables; v++)
+			if (_segmentIds[v] != NoEntry && _interSectionIntervals[v] != NoEntry)
+				_intervalOffsets[_interSectionIntervals[v] - _minInterSectionInterval + 1]++;
+
+		for (unsigned int i = 0; i < numIntervals; i++)
+			_intervalOffsets[i + 1] += _intervalOffsets[i];
+
+		// sort the variables into their buckets (in ascending order)
+		_intervalVariables.resize(_intervalOffsets[numIntervals]);
+		std::vector<unsigned int> next(_intervalOffsets.begin(), _intervalOffsets.end() - 1);
+
+		for (unsigned int v = 0; v < numVariables; v++)
+			if (_segmentIds[v] != NoEntry && _interSectionIntervals[v] != NoEntry)
+				_intervalVariables[next[_interSectionIntervals[v] - _minInterSectionInterval]++] = v;
+	}
+
+	_indexDirty = false;
+}
+
+void
+ProblemConfiguration::fit(const Segment& segment, const util::rect<int>& boundingBox) {
 
 	LOG_ALL(problemconfigurationlog) << "fitting segment " << segment.getId() << " with inter-section interval " << segment.getInterSectionInterval() << std::endl;
 
@@ -103,20 +206,33 @@ ProblemConfiguration::fit(const Segment& segment) {
 
 		_minInterSectionInterval = segment.getInterSectionInterval();
 		_maxInterSectionInterval = segment.getInterSectionInterval();
-		_minX = (int)segment.getCenter().x;
-		_maxX = (int)segment.getCenter().x;
-		_minY = (int)segment.getCenter().y;
-		_maxY = (int)segment.getCenter().y;
+		_minX = boundingBox.minX;
+		_maxX = boundingBox.maxX;
+		_minY = boundingBox.minY;
+		_maxY = boundingBox.maxY;
 
 	} else {
 
 		_minInterSectionInterval = std::min(_minInterSectionInterval, (int)segment.getInterSectionInterval());
 		_maxInterSectionInterval = std::max(_maxInterSectionInterval, (int)segment.getInterSectionInterval());
-		_minX = std::min(_minX, (int)segment.getCenter().x);
-		_maxX = std::max(_maxX, (int)segment.getCenter().x);
-		_minY = std::min(_minY, (int)segment.getCenter().y);
-		_maxY = std::max(_maxY, (int)segment.getCenter().y);
+		_minX = std::min(_minX, boundingBox.minX);
+		_maxX = std::max(_maxX, boundingBox.maxX);
+		_minY = std::min(_minY, boundingBox.minY);
+		_maxY = std::max(_maxY, boundingBox.maxY);
 	}
 
 	LOG_ALL(problemconfigurationlog) << "extents are now " << _minInterSectionInterval << "-" << _maxInterSectionInterval << std::endl;
 }
+
+void
+ProblemConfiguration::checkVariable(unsigned int variable) {
+
+	// only variables that were set with a segment have an interval
+	if (variable >= _interSectionIntervals.size() || _interSectionIntervals[variable] == NoEntry)
+		BOOST_THROW_EXCEPTION(
+				NoSuchSegment()
+				<< error_message(
+						std::string("problem configuration does not contain a segment for variable ") +
+						boost::lexical_cast<std::string>(variable))
+				<< STACK_TRACE);
+}
@@ -2,8 +2,10 @@
 #define SOPNET_INFERENCE_PROBLEM_CONFIGURATION_H__
 
 #include <boost/lexical_cast.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <pipeline/all.h>
+#include <util/rect.hpp>
 #include <sopnet/exceptions.h>
 #include <sopnet/segments/Segments.h>
 
@@ -11,6 +13,10 @@ class ProblemConfiguration : public pipeline::Data {
 
 public:
 
+	typedef std::vector<unsigned int>::const_iterator variable_iterator;
+
+	typedef std::pair<variable_iterator, variable_iterator> variable_range;
+
 	ProblemConfiguration();
 
 	/**
@@ -35,9 +41,23 @@ public:
 	unsigned int getSegmentId(unsigned int variable);
 
 	/**
-	 * Get the inter-section interval that corresponds to a variable.
+	 * Get the inter-section interval that corresponds to a variable. Throws 
+	 * NoSuchSegment, if no segment was assigned to the variable.
+	 */
+	unsigned int getInterSectionInterval(unsigned int variable);
+
+	/**
+	 * Get the bounding box in x and y of the slices of the segment that 
+	 * corresponds to a variable. Throws NoSuchSegment, if no segment was 
+	 * assigned to the variable.
 	 */
-	unsigned int getInterSectionInterval(unsigned int variable) { return _interSectionIntervals[variable]; }
+	const util::rect<int>& getBoundingBox(unsigned int variable);
+
+	/**
+	 * Get the number of variables, i.e., the largest assigned variable id plus 
+	 * one.
+	 */
+	unsigned int getNumVariables() { return _segmentIds.size(); }
 
 	unsigned int getMinInterSectionInterval() { return _minInterSectionInterval; }
 	unsigned int getMaxInterSectionInterval() { return _maxInterSectionInterval; }
@@ -49,14 +69,28 @@ public:
 	/**
 	 * Get all the variables that are assigned to the intersection intervals 
 	 * between (including) minInterSectionInterval and (excluding) 
-	 * maxInterSectionInterval.
+	 * maxInterSectionInterval. The variables are sorted by inter-section 
+	 * interval and variable id. The returned range is valid until the next 
+	 * call to setVariable() or clear().
+	 */
+	variable_range getVariables(unsigned int minInterSectionInterval, unsigned int maxInterSectionInterval);
+
+	/**
+	 * Same as getVariables(minInterSectionInterval, maxInterSectionInterval), 
+	 * but only the variables whose bounding box intersects the given region 
+	 * are stored in variables.
 	 */
-	std::vector<unsigned int> getVariables(unsigned int minInterSectionInterval, unsigned int maxInterSectionInterval);
+	void getVariables(
+			unsigned int minInterSectionInterval,
+			unsigned int maxInterSectionInterval,
+			const util::rect<int>& region,
+			std::vector<unsigned int>& variables);
 
 	/**
-	 * Get all variables that have been assigned to segments.
+	 * Get all variables that have been assigned to segments in ascending 
+	 * order.
 	 */
-	std::set<unsigned int> getVariables();
+	const std::vector<unsigned int>& getVariables();
 
 	/**
 	 * Clear the mapping.
@@ -65,16 +99,41 @@ public:
 
 private:
 
-	void fit(const Segment& segment);
+	void fit(const Segment& segment, const util::rect<int>& boundingBox);
+
+	// throw NoSuchSegment, if there is no interval and bounding box for the 
+	// given variable
+	void checkVariable(unsigned int variable);
+
+	// sort the variables into inter-section interval buckets
+	void updateIndex();
+
+	// marks unassigned entries in the dense vectors below
+	static const unsigned int NoEntry;
 
 	// mapping of segment ids to variable numbers
-	std::map<unsigned int, unsigned int> _variables;
+	boost::unordered_map<unsigned int, unsigned int> _variables;
+
+	// reverse mapping, indexed by variable
+	std::vector<unsigned int> _segmentIds;
+
+	// mapping from variable ids to inter-section intervals, indexed by variable
+	std::vector<unsigned int> _interSectionIntervals;
+
+	// the bounding boxes of the segments, indexed by variable
+	std::vector<util::rect<int> > _boundingBoxes;
+
+	// all assigned variables in ascending order
+	std::vector<unsigned int> _assignedVariables;
 
-	// reverse mapping
-	std::map<unsigned int, unsigned int> _segmentIds;
+	// the variables with an inter-section interval, sorted by inter-section 
+	// interval, such that the variables of interval i are 
+	// _intervalVariables[_intervalOffsets[i - _minInterSectionInterval]...]
+	std::vector<unsigned int> _intervalVariables;
+	std::vector<unsigned int> _intervalOffsets;
 
-	// mapping from variable ids to inter-section intervals
-	std::map<unsigned int, unsigned int> _interSectionIntervals;
+	// is the above index up-to-date?
+	bool _indexDirty;
 
 	// the boundary of the problem in volume space
 	int _minInterSectionInterval;
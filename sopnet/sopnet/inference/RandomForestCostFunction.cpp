@@ -35,8 +35,8 @@ RandomForestCostFunction::RandomForestCostFunction() :
 void
 RandomForestCostFunction::updateOutputs() {
 
-	// invalidate cache
-	_cache.clear();
+	// features or random forest changed
+	_cache.invalidate();
 }
 
 void
@@ -62,64 +62,89 @@ RandomForestCostFunction::costs(
 
 	segmentCosts.resize(ends.size() + continuations.size() + branches.size(), 0);
 
-	if (segmentCosts.size() == _cache.size()) {
+	// collect all segments that have not been seen since the last change of
+	// the features or the random forest
+	std::vector<unsigned int> segmentIds;
 
-		for (unsigned int i = 0; i < segmentCosts.size(); i++)
-			segmentCosts[i] += _cache[i];
+	foreach (boost::shared_ptr<EndSegment> end, ends)
+		if (!_cache.contains(end->getId()))
+			segmentIds.push_back(end->getId());
+	foreach (boost::shared_ptr<ContinuationSegment> continuation, continuations)
+		if (!_cache.contains(continuation->getId()))
+			segmentIds.push_back(continuation->getId());
+	foreach (boost::shared_ptr<BranchSegment> branch, branches)
+		if (!_cache.contains(branch->getId()))
+			segmentIds.push_back(branch->getId());
 
-		return;
-	}
+	LOG_DEBUG(randomforestcostfunctionlog)
+			<< "computing costs for " << segmentIds.size() << " of "
+			<< segmentCosts.size() << " segments" << std::endl;
 
-	_cache.resize(ends.size() + continuations.size() + branches.size());
+	if (!segmentIds.empty())
+		updateCache(segmentIds);
 
 	unsigned int i = 0;
 
+	// end segments are never excluded
 	foreach (boost::shared_ptr<EndSegment> end, ends) {
 
-		double c = costs(*end);
-
-		segmentCosts[i] += c;
-		_cache[i] = c;
-
+		segmentCosts[i] += _cache.get(end->getId());
 		i++;
 	}
 
 	foreach (boost::shared_ptr<ContinuationSegment> continuation, continuations) {
 
-		double c = costs(*continuation);
-
-		if (c >= _maxSegmentCosts)
-			c = std::numeric_limits<double>::infinity();
+		segmentCosts[i] += limitCosts(_cache.get(continuation->getId()));
+		i++;
+	}
 
-		segmentCosts[i] += c;
-		_cache[i] = c;
+	foreach (boost::shared_ptr<BranchSegment> branch, branches) {
 
+		segmentCosts[i] += limitCosts(_cache.get(branch->getId()));
 		i++;
 	}
 
-	foreach (boost::shared_ptr<BranchSegment> branch, branches) {
+	// forget about segments that are not part of the problem anymore
+	_cache.removeUnused();
+}
 
-		double c = costs(*branch);
+void
+RandomForestCostFunction::updateCache(const std::vector<unsigned int>& segmentIds) {
 
-		if (c >= _maxSegmentCosts)
-			c = std::numeric_limits<double>::infinity();
+	if (_useOverlapOnly) {
 
-		segmentCosts[i] += c;
-		_cache[i] = c;
+		foreach (unsigned int id, segmentIds)
+			_cache.set(id, -_features->get(id)[_overlapFeature]);
 
-		i++;
+		return;
 	}
-}
 
-double
-RandomForestCostFunction::costs(const Segment& segment) {
+	unsigned int numFeatures = _randomForest->getNumFeatures();
 
-	if (_useOverlapOnly)
-		return -_features->get(segment.getId())[_overlapFeature];
+	// collect the features of all segments in one sample matrix
+	RandomForest::SamplesType samples(RandomForest::SamplesSize(segmentIds.size(), numFeatures));
 
-	double prob = _randomForest->getProbabilities(_features->get(segment.getId()))[1];
+	for (unsigned int i = 0; i < segmentIds.size(); i++) {
+
+		const std::vector<double>& features = _features->get(segmentIds[i]);
+
+		for (unsigned int f = 0; f < numFeatures; f++)
+			samples(i, f) = features[f];
+	}
+
+	std::vector<double> probabilities;
+	_randomForest->getProbabilities(samples, probabilities);
 
 	//[23.02, 0.0]
-	return -log(std::max(1e-10, prob));
+	for (unsigned int i = 0; i < segmentIds.size(); i++)
+		_cache.set(segmentIds[i], -log(std::max(1e-10, probabilities[i])));
 }
 
+double
+RandomForestCostFunction::limitCosts(double costs) {
+
+	if (costs >= _maxSegmentCosts)
+		return std::numeric_limits<double>::infinity();
+
+	return costs;
+}
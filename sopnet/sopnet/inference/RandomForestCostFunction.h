@@ -5,6 +5,7 @@
 #include <inference/RandomForest.h>
 #include <sopnet/features/Features.h>
 #include <sopnet/segments/Segment.h>
+#include "SegmentCostsCache.h"
 
 class RandomForestCostFunction : public pipeline::SimpleProcessNode<> {
 
@@ -30,7 +31,12 @@ private:
 			const std::vector<boost::shared_ptr<BranchSegment> >&       branches,
 			std::vector<double>& costs);
 
-	double costs(const Segment& segment);
+	// compute the costs of all segments with the given ids and store them in
+	// the cache
+	void updateCache(const std::vector<unsigned int>& segmentIds);
+
+	// the costs of a segment that is not an end segment
+	double limitCosts(double costs);
 
 	pipeline::Input<Features> _features;
 
@@ -38,7 +44,8 @@ private:
 
 	pipeline::Output<costs_function_type> _costFunction;
 
-	std::vector<double> _cache;
+	// the costs of each segment, keyed by segment id
+	SegmentCostsCache _cache;
 
 	// segments above this value will have infinite costs
 	double _maxSegmentCosts;
@@ -0,0 +1,96 @@
+#ifndef SOPNET_INFERENCE_SEGMENT_COSTS_CACHE_H__
+#define SOPNET_INFERENCE_SEGMENT_COSTS_CACHE_H__
+
+#include <boost/unordered_map.hpp>
+
+/**
+ * The cached contribution of a cost function, keyed by segment id. Cost
+ * functions use it to compute their (possibly expensive) per-segment terms
+ * only for segments they have not seen since their last invalidation.
+ *
+ * Segment ids are global and grow with every extraction. To keep the cache
+ * bounded by the size of the current problem, cost functions call
+ * removeUnused() after each evaluation, which drops the values of all
+ * segments that were not part of it.
+ */
+class SegmentCostsCache {
+
+	typedef boost::unordered_map<unsigned int, double> values_type;
+
+public:
+
+	/**
+	 * Remove all cached values.
+	 */
+	void invalidate() {
+
+		_used.clear();
+		_unused.clear();
+	}
+
+	/**
+	 * Check whether there is a valid value for the given segment.
+	 */
+	bool contains(unsigned int segmentId) const {
+
+		return _used.count(segmentId) > 0 || _unused.count(segmentId) > 0;
+	}
+
+	/**
+	 * Get the cached value of a segment. The value has to be valid.
+	 */
+	double get(unsigned int segmentId) {
+
+		values_type::iterator i = _used.find(segmentId);
+
+		if (i != _used.end())
+			return i->second;
+
+		i = _unused.find(segmentId);
+
+		double value = i->second;
+
+		_unused.erase(i);
+		_used[segmentId] = value;
+
+		return value;
+	}
+
+	/**
+	 * Set the value of a segment.
+	 */
+	void set(unsigned int segmentId, double value) {
+
+		_unused.erase(segmentId);
+		_used[segmentId] = value;
+	}
+
+	/**
+	 * Remove the values of all segments that have not been accessed (by get()
+	 * or set()) since the last call to this method.
+	 */
+	void removeUnused() {
+
+		_unused.clear();
+		_unused.swap(_used);
+	}
+
+	/**
+	 * The number of cached values.
+	 */
+	unsigned int size() const {
+
+		return _used.size() + _unused.size();
+	}
+
+private:
+
+	// values accessed since the last call to removeUnused()
+	values_type _used;
+
+	// values not accessed since the last call to removeUnused()
+	values_type _unused;
+};
+
+#endif // SOPNET_INFERENCE_SEGMENT_COSTS_CACHE_H__
+
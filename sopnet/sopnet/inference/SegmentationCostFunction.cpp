@@ -1,3 +1,4 @@
+#include <set>
 #include "SegmentationCostFunction.h"
 #include <imageprocessing/ConnectedComponent.h>
 #include <sopnet/segments/EndSegment.h>
@@ -6,8 +7,38 @@
 #include <sopnet/slices/Slice.h>
 #include <util/ProgramOptions.h>
 
+// The number of bins to quantize membrane probabilities. With 8-bit membrane
+// maps, this is exact.
+static const unsigned int NumHistogramBins = 256;
+
 logger::LogChannel segmentationcostfunctionlog("segmentationcostfunctionlog", "[SegmentationCostFunction] ");
 
+/**
+ * Remove all entries of a per-slice cache whose slice id is not in the given
+ * set. Returns the number of removed entries.
+ */
+template <typename Map>
+unsigned int eraseUnused(Map& cache, const std::set<unsigned int>& used) {
+
+	unsigned int numErased = 0;
+
+	typename Map::iterator i = cache.begin();
+	while (i != cache.end()) {
+
+		if (used.count(i->first)) {
+
+			++i;
+
+		} else {
+
+			cache.erase(i++);
+			numErased++;
+		}
+	}
+
+	return numErased;
+}
+
 util::ProgramOption optionInvertMembraneMaps(
 		util::_module           = "sopnet",
 		util::_long_name        = "invertMembraneMaps",
@@ -15,12 +46,17 @@ util::ProgramOption optionInvertMembraneMaps(
 		                          "(not inverting) is: bright pixel = hight membrane probability.");
 
 SegmentationCostFunction::SegmentationCostFunction() :
-	_costFunction(new costs_function_type(boost::bind(&SegmentationCostFunction::costs, this, _1, _2, _3, _4))) {
+	_costFunction(new costs_function_type(boost::bind(&SegmentationCostFunction::costs, this, _1, _2, _3, _4))),
+	_binCosts(NumHistogramBins),
+	_binCostsPriorForeground(-1),
+	_binCounts(NumHistogramBins, 0) {
 
 	registerInput(_membranes, "membranes");
 	registerInput(_parameters, "parameters");
 
 	registerOutput(_costFunction, "cost function");
+
+	_membranes.registerCallback(&SegmentationCostFunction::onMembranesModified, this);
 }
 
 void
@@ -29,6 +65,14 @@ SegmentationCostFunction::updateOutputs() {
 	// nothing to do here
 }
 
+void
+SegmentationCostFunction::onMembranesModified(const pipeline::Modified&) {
+
+	_segmentationCosts.invalidate();
+	_sliceSegmentationCosts.clear();
+	_sliceHistograms.clear();
+}
+
 void
 SegmentationCostFunction::costs(
 		const std::vector<boost::shared_ptr<EndSegment> >&          ends,
@@ -38,58 +82,88 @@ SegmentationCostFunction::costs(
 
 	segmentCosts.resize(ends.size() + continuations.size() + branches.size(), 0);
 
-	if (_segmentationCosts.size() != segmentCosts.size() ||
-	    _parameters->priorForeground != _prevParameters.priorForeground) {
+	if (_parameters->priorForeground != _prevParameters.priorForeground) {
 
-		LOG_DEBUG(segmentationcostfunctionlog)
-				<< "updating segmentation costs (number of segments: "
-				<< segmentCosts.size() << ", number of cached values "
-				<< _segmentationCosts.size() << ")" << std::endl;
+		LOG_DEBUG(segmentationcostfunctionlog) << "foreground prior changed, invalidating segmentation costs" << std::endl;
 
+		_segmentationCosts.invalidate();
 		_sliceSegmentationCosts.clear();
-		_segmentationCosts.clear();
-		_segmentationCosts.reserve(ends.size() + continuations.size() + branches.size());
-
-		computeSegmentationCosts(ends, continuations, branches);
-
-		LOG_DEBUG(segmentationcostfunctionlog)
-				<< "computed " << _segmentationCosts.size() << " segmentation cost values" << std::endl;
 	}
 
-	if (_boundaryLengths.size() != segmentCosts.size()) {
+	_prevParameters = *_parameters;
 
-		LOG_DEBUG(segmentationcostfunctionlog) << "updating boundary lengths..." << std::endl;
+	if (_binCostsPriorForeground != _parameters->priorForeground)
+		updateBinCosts();
 
-		_boundaryLengths.clear();
-		_boundaryLengths.reserve(ends.size() + continuations.size() + branches.size());
+	pruneSliceCaches(ends, continuations, branches);
 
-		computeBoundaryLengths(ends, continuations, branches);
-	}
-
-	_prevParameters = *_parameters;
+	// compute the terms of segments that have not been seen before
+	computeSegmentationCosts(ends, continuations, branches);
+	computeBoundaryLengths(ends, continuations, branches);
 
 	unsigned int i = 0;
 
 	foreach (boost::shared_ptr<EndSegment> end, ends) {
 
-		segmentCosts[i] += _parameters->weight*(_segmentationCosts[i] + _parameters->weightPotts*_boundaryLengths[i]);
+		unsigned int id = end->getId();
+
+		segmentCosts[i] += _parameters->weight*(_segmentationCosts.get(id) + _parameters->weightPotts*_boundaryLengths.get(id));
 
 		i++;
 	}
 
 	foreach (boost::shared_ptr<ContinuationSegment> continuation, continuations) {
 
-		segmentCosts[i] += _parameters->weight*(_segmentationCosts[i] + _parameters->weightPotts*_boundaryLengths[i]);
+		unsigned int id = continuation->getId();
+
+		segmentCosts[i] += _parameters->weight*(_segmentationCosts.get(id) + _parameters->weightPotts*_boundaryLengths.get(id));
 
 		i++;
 	}
 
 	foreach (boost::shared_ptr<BranchSegment> branch, branches) {
 
-		segmentCosts[i] += _parameters->weight*(_segmentationCosts[i] + _parameters->weightPotts*_boundaryLengths[i]);
+		unsigned int id = branch->getId();
+
+		segmentCosts[i] += _parameters->weight*(_segmentationCosts.get(id) + _parameters->weightPotts*_boundaryLengths.get(id));
 
 		i++;
 	}
+
+	// forget about segments that are not part of the problem anymore
+	_segmentationCosts.removeUnused();
+	_boundaryLengths.removeUnused();
+}
+
+void
+SegmentationCostFunction::pruneSliceCaches(
+		const std::vector<boost::shared_ptr<EndSegment> >&          ends,
+		const std::vector<boost::shared_ptr<ContinuationSegment> >& continuations,
+		const std::vector<boost::shared_ptr<BranchSegment> >&       branches) {
+
+	std::set<unsigned int> used;
+
+	foreach (boost::shared_ptr<EndSegment> end, ends)
+		foreach (boost::shared_ptr<Slice> slice, end->getSlices())
+			used.insert(slice->getId());
+
+	foreach (boost::shared_ptr<ContinuationSegment> continuation, continuations)
+		foreach (boost::shared_ptr<Slice> slice, continuation->getSlices())
+			used.insert(slice->getId());
+
+	foreach (boost::shared_ptr<BranchSegment> branch, branches)
+		foreach (boost::shared_ptr<Slice> slice, branch->getSlices())
+			used.insert(slice->getId());
+
+	unsigned int numErased = 0;
+
+	numErased += eraseUnused(_sliceSegmentationCosts, used);
+	numErased += eraseUnused(_sliceHistograms, used);
+	numErased += eraseUnused(_sliceBoundaryLengths, used);
+
+	LOG_DEBUG(segmentationcostfunctionlog)
+			<< "removed " << numErased << " cached slice terms of slices that are not part of the problem anymore"
+			<< std::endl;
 }
 
 void
@@ -127,13 +201,20 @@ SegmentationCostFunction::computeBoundaryLengths(
 void
 SegmentationCostFunction::computeSegmentationCost(const EndSegment& end) {
 
-	_segmentationCosts.push_back(computeSegmentationCost(*end.getSlice()));
+	if (_segmentationCosts.contains(end.getId()))
+		return;
+
+	_segmentationCosts.set(end.getId(), computeSegmentationCost(*end.getSlice()));
 }
 
 void
 SegmentationCostFunction::computeSegmentationCost(const ContinuationSegment& continuation) {
 
-	_segmentationCosts.push_back(
+	if (_segmentationCosts.contains(continuation.getId()))
+		return;
+
+	_segmentationCosts.set(
+			continuation.getId(),
 			computeSegmentationCost(*continuation.getSourceSlice()) +
 			computeSegmentationCost(*continuation.getTargetSlice()));
 }
@@ -141,7 +222,11 @@ SegmentationCostFunction::computeSegmentationCost(const ContinuationSegment& con
 void
 SegmentationCostFunction::computeSegmentationCost(const BranchSegment& branch) {
 
-	_segmentationCosts.push_back(
+	if (_segmentationCosts.contains(branch.getId()))
+		return;
+
+	_segmentationCosts.set(
+			branch.getId(),
 			computeSegmentationCost(*branch.getSourceSlice()) +
 			computeSegmentationCost(*branch.getTargetSlice1()) +
 			computeSegmentationCost(*branch.getTargetSlice2()));
@@ -150,13 +235,20 @@ SegmentationCostFunction::computeSegmentationCost(const BranchSegment& branch) {
 void
 SegmentationCostFunction::computeBoundaryLength(const EndSegment& end) {
 
-	_boundaryLengths.push_back(computeBoundaryLength(*end.getSlice()));
+	if (_boundaryLengths.contains(end.getId()))
+		return;
+
+	_boundaryLengths.set(end.getId(), computeBoundaryLength(*end.getSlice()));
 }
 
 void
 SegmentationCostFunction::computeBoundaryLength(const ContinuationSegment& continuation) {
 
-	_boundaryLengths.push_back(
+	if (_boundaryLengths.contains(continuation.getId()))
+		return;
+
+	_boundaryLengths.set(
+			continuation.getId(),
 			computeBoundaryLength(*continuation.getSourceSlice()) +
 			computeBoundaryLength(*continuation.getTargetSlice()));
 }
@@ -164,7 +256,11 @@ SegmentationCostFunction::computeBoundaryLength(const ContinuationSegment& conti
 void
 SegmentationCostFunction::computeBoundaryLength(const BranchSegment& branch) {
 
-	_boundaryLengths.push_back(
+	if (_boundaryLengths.contains(branch.getId()))
+		return;
+
+	_boundaryLengths.set(
+			branch.getId(),
 			computeBoundaryLength(*branch.getSourceSlice()) +
 			computeBoundaryLength(*branch.getTargetSlice1()) +
 			computeBoundaryLength(*branch.getTargetSlice2()));
@@ -176,19 +272,66 @@ SegmentationCostFunction::computeSegmentationCost(const Slice& slice) {
 	if (_sliceSegmentationCosts.count(slice.getId()))
 		return _sliceSegmentationCosts[slice.getId()];
 
-	unsigned int section = slice.getSection();
-
 	double costs = 0.0;
 
-	// for each pixel in the slice
+	unsigned int bin, count;
+	foreach (boost::tie(bin, count), getHistogram(slice))
+		costs += count*_binCosts[bin];
+
+	_sliceSegmentationCosts[slice.getId()] = costs;
+
+	return costs;
+}
+
+const SegmentationCostFunction::histogram_type&
+SegmentationCostFunction::getHistogram(const Slice& slice) {
+
+	std::map<unsigned int, histogram_type>::iterator i = _sliceHistograms.find(slice.getId());
+
+	if (i != _sliceHistograms.end())
+		return i->second;
+
+	const Image& membranes = *(*_membranes)[slice.getSection()];
+
+	bool invert = optionInvertMembraneMaps;
+
 	foreach (const util::point<unsigned int>& pixel, slice.getComponent()->getPixels()) {
 
 		// get the membrane data probability p(x|y=membrane)
-		double probMembrane = (*(*_membranes)[section])(pixel.x, pixel.y);
+		double probMembrane = membranes(pixel.x, pixel.y);
 
-		if (optionInvertMembraneMaps)
+		if (invert)
 			probMembrane = 1.0 - probMembrane;
 
+		probMembrane = std::max(0.0, std::min(1.0, probMembrane));
+
+		_binCounts[(unsigned int)(probMembrane*(NumHistogramBins - 1) + 0.5)]++;
+	}
+
+	histogram_type& histogram = _sliceHistograms[slice.getId()];
+
+	for (unsigned int bin = 0; bin < NumHistogramBins; bin++)
+		if (_binCounts[bin] > 0) {
+
+			histogram.push_back(std::make_pair(bin, _binCounts[bin]));
+			_binCounts[bin] = 0;
+		}
+
+	return histogram;
+}
+
+void
+SegmentationCostFunction::updateBinCosts() {
+
+	LOG_DEBUG(segmentationcostfunctionlog)
+			<< "computing pixel costs for foreground prior "
+			<< _parameters->priorForeground << std::endl;
+
+	for (unsigned int bin = 0; bin < NumHistogramBins; bin++) {
+
+		// get the membrane data probability p(x|y=membrane)
+		double probMembrane = (double)bin/(NumHistogramBins - 1);
+
 		// get the neuron data probability p(x|y=neuron)
 		double probNeuron = 1.0 - probMembrane;
 
@@ -211,12 +354,10 @@ SegmentationCostFunction::computeSegmentationCost(const Slice& slice) {
 		// costs for accepting the segmentation is the cost difference between
 		// segmenting the region as background and segmenting the region as
 		// foreground
-		costs += costsNeuron - costsMembrane;
+		_binCosts[bin] = costsNeuron - costsMembrane;
 	}
 
-	_sliceSegmentationCosts[slice.getId()] = costs;
-
-	return costs;
+	_binCostsPriorForeground = _parameters->priorForeground;
 }
 
 unsigned int
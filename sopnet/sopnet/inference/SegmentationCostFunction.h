@@ -3,6 +3,7 @@
 
 #include <imageprocessing/ImageStack.h>
 #include "SegmentationCostFunctionParameters.h"
+#include "SegmentCostsCache.h"
 
 // forward declarations
 class EndSegment;
@@ -12,6 +13,10 @@ class Slice;
 
 class SegmentationCostFunction : public pipeline::SimpleProcessNode<> {
 
+	// sparse histogram of the membrane probabilities of a slice as pairs of
+	// bin and count
+	typedef std::vector<std::pair<unsigned int, unsigned int> > histogram_type;
+
 	typedef boost::function<
 			void
 			(const std::vector<boost::shared_ptr<EndSegment> >&          ends,
@@ -28,6 +33,8 @@ private:
 
 	void updateOutputs();
 
+	void onMembranesModified(const pipeline::Modified& signal);
+
 	void costs(
 			const std::vector<boost::shared_ptr<EndSegment> >&          ends,
 			const std::vector<boost::shared_ptr<ContinuationSegment> >& continuations,
@@ -44,6 +51,12 @@ private:
 			const std::vector<boost::shared_ptr<ContinuationSegment> >& continuations,
 			const std::vector<boost::shared_ptr<BranchSegment> >&       branches);
 
+	// forget about slices that are not part of the problem anymore
+	void pruneSliceCaches(
+			const std::vector<boost::shared_ptr<EndSegment> >&          ends,
+			const std::vector<boost::shared_ptr<ContinuationSegment> >& continuations,
+			const std::vector<boost::shared_ptr<BranchSegment> >&       branches);
+
 	void computeSegmentationCost(const EndSegment& end);
 
 	void computeSegmentationCost(const ContinuationSegment& continuation);
@@ -58,6 +71,12 @@ private:
 
 	double computeSegmentationCost(const Slice& slice);
 
+	const histogram_type& getHistogram(const Slice& slice);
+
+	// compute the costs of a pixel in each histogram bin for the current
+	// foreground prior
+	void updateBinCosts();
+
 	unsigned int computeBoundaryLength(const Slice& slice);
 
 	pipeline::Input<ImageStack> _membranes;
@@ -66,14 +85,27 @@ private:
 
 	pipeline::Output<costs_function_type> _costFunction;
 
-	std::vector<double> _segmentationCosts;
-
-	std::vector<unsigned int> _boundaryLengths;
+	// the segmentation costs and boundary lengths of each segment, keyed by
+	// segment id
+	SegmentCostsCache _segmentationCosts;
+	SegmentCostsCache _boundaryLengths;
 
 	SegmentationCostFunctionParameters _prevParameters;
 
 	std::map<unsigned int, double> _sliceSegmentationCosts;
 
+	// the membrane probability histogram of each slice
+	std::map<unsigned int, histogram_type> _sliceHistograms;
+
+	// the costs of a pixel in each histogram bin
+	std::vector<double> _binCosts;
+
+	// the foreground prior _binCosts was computed for
+	double _binCostsPriorForeground;
+
+	// scratch space for the creation of histograms
+	std::vector<unsigned int> _binCounts;
+
 	std::map<unsigned int, unsigned int> _sliceBoundaryLengths;
 };
 
@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <limits>
+
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+#include <pipeline/Value.h>
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include <sopnet/exceptions.h>
+#include "SlidingWindowSolver.h"
+
+static logger::LogChannel slidingwindowsolverlog("slidingwindowsolverlog", "[SlidingWindowSolver] ");
+
+util::ProgramOption optionSlidingWindowSize(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "slidingWindowSize",
+		util::_description_text = "The size of the sliding window in inter-section intervals.",
+		util::_default_value    = 10);
+
+util::ProgramOption optionSlidingWindowOverlap(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "slidingWindowOverlap",
+		util::_description_text = "The number of inter-section intervals that are solved again in the next window.",
+		util::_default_value    = 2);
+
+util::ProgramOption optionSlidingWindowCacheSize(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "slidingWindowCacheSize",
+		util::_description_text = "The maximal number of window solutions to keep for warm starts.",
+		util::_default_value    = 1000);
+
+util::ProgramOption optionPartialSolutionFile(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "partialSolutionFile",
+		util::_description_text = "The file to write the committed segment ids of the sliding window solver to.",
+		util::_default_value    = "partial_solution.txt");
+
+const unsigned int SlidingWindowSolver::NoWindowVariable = std::numeric_limits<unsigned int>::max();
+
+SlidingWindowSolver::SlidingWindowSolver() :
+	_solution(new Solution()) {
+
+	registerInput(_objective, "objective");
+	registerInput(_linearConstraints, "linear constraints");
+	registerInput(_configuration, "problem configuration");
+	registerInput(_parameters, "parameters", pipeline::Optional);
+
+	registerOutput(_solution, "solution");
+}
+
+void
+SlidingWindowSolver::updateOutputs() {
+
+	unsigned int windowSize    = optionSlidingWindowSize;
+	unsigned int windowOverlap = optionSlidingWindowOverlap;
+
+	// constraints span at most two neighboring intervals, with an overlap of
+	// at least one interval no constraint is lost between windows
+	if (windowOverlap < 1 || windowOverlap >= windowSize)
+		BOOST_THROW_EXCEPTION(
+				InvalidParameters()
+				<< error_message("the sliding window overlap has to be at least one and smaller than the window size")
+				<< STACK_TRACE);
+
+	unsigned int numVariables = _objective->size();
+
+	_solution->resize(numVariables);
+	std::fill(_solution->getVector().begin(), _solution->getVector().end(), 0.0);
+
+	_windowVariableNums.assign(numVariables, NoWindowVariable);
+	_solved.assign(numVariables, false);
+	_committed.assign(numVariables, false);
+
+	if (_configuration->getVariables().empty())
+		return;
+
+	_partialSolutionFile.close();
+	_partialSolutionFile.clear();
+	_partialSolutionFile.open(optionPartialSolutionFile.as<std::string>().c_str());
+
+	unsigned int minInterSectionInterval = _configuration->getMinInterSectionInterval();
+	unsigned int endInterSectionInterval = _configuration->getMaxInterSectionInterval() + 1;
+
+	LOG_USER(slidingwindowsolverlog)
+			<< "solving inter-section intervals " << minInterSectionInterval
+			<< "-" << (endInterSectionInterval - 1) << " in windows of "
+			<< windowSize << " with overlap of " << windowOverlap << std::endl;
+
+	_windowSolver = boost::make_shared<LinearSolver>();
+
+	unsigned int begin = minInterSectionInterval;
+	while (true) {
+
+		unsigned int end = std::min(begin + windowSize, endInterSectionInterval);
+
+		// the last window commits everything
+		unsigned int commitEnd = (end == endInterSectionInterval ? end : end - windowOverlap);
+
+		solveWindow(begin, end, commitEnd);
+
+		if (end == endInterSectionInterval)
+			break;
+
+		begin = commitEnd;
+	}
+
+	// everything is committed, release the model of the last window
+	_windowSolver.reset();
+
+	_partialSolutionFile.close();
+}
+
+void
+SlidingWindowSolver::solveWindow(unsigned int begin, unsigned int end, unsigned int commitEnd) {
+
+	ProblemConfiguration::variable_range range = _configuration->getVariables(begin, end);
+
+	_windowVariables.assign(range.first, range.second);
+
+	for (unsigned int i = 0; i < _windowVariables.size(); i++)
+		_windowVariableNums[_windowVariables[i]] = i;
+
+	LOG_DEBUG(slidingwindowsolverlog)
+			<< "solving window " << begin << "-" << (end - 1) << " with "
+			<< _windowVariables.size() << " variables" << std::endl;
+
+	if (!_windowVariables.empty()) {
+
+		boost::shared_ptr<LinearObjective>   objective   = boost::make_shared<LinearObjective>(_windowVariables.size());
+		boost::shared_ptr<LinearConstraints> constraints = boost::make_shared<LinearConstraints>();
+		boost::shared_ptr<Solution>          initial     = boost::make_shared<Solution>(_windowVariables.size());
+
+		createWindowProblem(*objective, *constraints);
+
+		window_hash hash = getWindowHash();
+
+		getInitialSolution(*initial, hash);
+
+		_windowSolver->setInput("objective", objective);
+		_windowSolver->setInput("linear constraints", constraints);
+		_windowSolver->setInput("parameters", createWindowParameters());
+		_windowSolver->setInput("initial solution", initial);
+
+		pipeline::Value<Solution>         windowSolution = _windowSolver->getOutput("solution");
+		pipeline::Value<SolverStatistics> statistics     = _windowSolver->getOutput("statistics");
+
+		// committed windows can not be changed anymore, don't commit 
+		// anything without a solution
+		if ((statistics->getStatus() != SolverStatistics::Optimal &&
+		     statistics->getStatus() != SolverStatistics::TimeLimit) ||
+		    windowSolution->size() < _windowVariables.size()) {
+
+			_windowSolver.reset();
+			_partialSolutionFile.close();
+
+			BOOST_THROW_EXCEPTION(
+					WindowNotSolved()
+					<< error_message(
+							std::string("no solution for the window of inter-section intervals ") +
+							boost::lexical_cast<std::string>(begin) + "-" +
+							boost::lexical_cast<std::string>(end - 1))
+					<< STACK_TRACE);
+		}
+
+		for (unsigned int i = 0; i < _windowVariables.size(); i++) {
+
+			(*_solution)[_windowVariables[i]] = (*windowSolution)[i];
+			_solved[_windowVariables[i]] = true;
+		}
+
+		storeWindowState(*windowSolution, hash);
+	}
+
+	commit(commitEnd);
+
+	foreach (unsigned int var, _windowVariables)
+		_windowVariableNums[var] = NoWindowVariable;
+}
+
+void
+SlidingWindowSolver::createWindowProblem(
+		LinearObjective&   objective,
+		LinearConstraints& constraints) {
+
+	const std::vector<double>& coefs = _objective->getCoefficients();
+
+	for (unsigned int i = 0; i < _windowVariables.size(); i++)
+		objective.setCoefficient(i, coefs[_windowVariables[i]]);
+
+	objective.setSense(_objective->getSense());
+
+	std::vector<unsigned int> constraintIds = _linearConstraints->getConstraints(_windowVariables);
+
+	foreach (unsigned int id, constraintIds) {
+
+		const LinearConstraint& constraint = (*_linearConstraints)[id];
+
+		LinearConstraint windowConstraint;
+		windowConstraint.setRelation(constraint.getRelation());
+
+		double value = constraint.getValue();
+		bool   valid = true;
+
+		unsigned int var;
+		double coef;
+		foreach (boost::tie(var, coef), constraint.getCoefficients()) {
+
+			if (_windowVariableNums[var] != NoWindowVariable) {
+
+				windowConstraint.setCoefficient(_windowVariableNums[var], coef);
+
+			} else if (_committed[var]) {
+
+				// substitute the committed value
+				value -= coef*(*_solution)[var];
+
+			} else {
+
+				// the constraint reaches into intervals after the window, it
+				// will be considered by the next window
+				valid = false;
+				break;
+			}
+		}
+
+		if (!valid || windowConstraint.getCoefficients().empty())
+			continue;
+
+		windowConstraint.setValue(value);
+		constraints.add(windowConstraint);
+	}
+
+	LOG_DEBUG(slidingwindowsolverlog)
+			<< "window has " << constraints.size() << " of "
+			<< constraintIds.size() << " involved constraints" << std::endl;
+}
+
+boost::shared_ptr<LinearSolverParameters>
+SlidingWindowSolver::createWindowParameters() {
+
+	boost::shared_ptr<LinearSolverParameters> parameters = boost::make_shared<LinearSolverParameters>(Binary);
+
+	// the termination criteria apply to each window
+	if (_parameters.isSet()) {
+
+		parameters->setTimeLimit(_parameters->getTimeLimit());
+		parameters->setOptimalityGap(_parameters->getOptimalityGap());
+	}
+
+	return parameters;
+}
+
+void
+SlidingWindowSolver::getInitialSolution(Solution& initialSolution, window_hash hash) {
+
+	std::map<window_hash, WindowState>::const_iterator i = _windowStates.find(hash);
+
+	if (i != _windowStates.end() && i->second.values.size() == _windowVariables.size()) {
+
+		// make sure this is not a hash collision
+		bool same = true;
+		for (unsigned int j = 0; j < _windowVariables.size(); j++)
+			if (i->second.segmentIds[j] != _configuration->getSegmentId(_windowVariables[j])) {
+
+				same = false;
+				break;
+			}
+
+		if (same) {
+
+			LOG_DEBUG(slidingwindowsolverlog) << "restoring solution of previous window" << std::endl;
+
+			initialSolution.getVector() = i->second.values;
+			return;
+		}
+	}
+
+	// start from the solution of the overlap band in the previous window
+	for (unsigned int j = 0; j < _windowVariables.size(); j++)
+		initialSolution[j] = (_solved[_windowVariables[j]] ? (*_solution)[_windowVariables[j]] : 0.0);
+}
+
+void
+SlidingWindowSolver::storeWindowState(const Solution& windowSolution, window_hash hash) {
+
+	unsigned int cacheSize = optionSlidingWindowCacheSize;
+
+	if (cacheSize == 0)
+		return;
+
+	if (_windowStates.count(hash) == 0) {
+
+		while (_windowStatesOrder.size() >= cacheSize) {
+
+			_windowStates.erase(_windowStatesOrder.front());
+			_windowStatesOrder.pop_front();
+		}
+
+		_windowStatesOrder.push_back(hash);
+	}
+
+	WindowState& state = _windowStates[hash];
+
+	state.segmentIds.resize(_windowVariables.size());
+	state.values.resize(_windowVariables.size());
+
+	for (unsigned int i = 0; i < _windowVariables.size(); i++) {
+
+		state.segmentIds[i] = _configuration->getSegmentId(_windowVariables[i]);
+		state.values[i]     = windowSolution[i];
+	}
+}
+
+void
+SlidingWindowSolver::commit(unsigned int commitEnd) {
+
+	unsigned int numCommitted = 0;
+
+	foreach (unsigned int var, _windowVariables) {
+
+		if (_configuration->getInterSectionInterval(var) >= commitEnd)
+			continue;
+
+		_committed[var] = true;
+
+		if ((*_solution)[var] > 0.5) {
+
+			_partialSolutionFile << _configuration->getSegmentId(var) << std::endl;
+			numCommitted++;
+		}
+	}
+
+	_partialSolutionFile.flush();
+
+	LOG_DEBUG(slidingwindowsolverlog)
+			<< "committed " << numCommitted << " segments up to inter-section interval "
+			<< commitEnd << std::endl;
+}
+
+SlidingWindowSolver::window_hash
+SlidingWindowSolver::getWindowHash() {
+
+	window_hash hash = 0;
+
+	foreach (unsigned int var, _windowVariables)
+		boost::hash_combine(hash, _configuration->getSegmentId(var));
+
+	return hash;
+}
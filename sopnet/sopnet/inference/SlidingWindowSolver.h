@@ -0,0 +1,135 @@
+#ifndef SOPNET_INFERENCE_SLIDING_WINDOW_SOLVER_H__
+#define SOPNET_INFERENCE_SLIDING_WINDOW_SOLVER_H__
+
+#include <deque>
+#include <fstream>
+#include <map>
+
+#include <pipeline/all.h>
+#include <inference/LinearConstraints.h>
+#include <inference/LinearObjective.h>
+#include <inference/LinearSolver.h>
+#include <inference/LinearSolverParameters.h>
+#include <inference/Solution.h>
+#include <util/exceptions.h>
+#include "ProblemConfiguration.h"
+
+struct WindowNotSolved : virtual Exception {};
+
+/**
+ * Solves a working problem by moving a window of inter-section intervals
+ * along z. Each window consists of the intervals that are new to it and an
+ * overlap band with the previous window. Only the window is passed to the
+ * linear solver, with the values of already committed variables substituted
+ * into the constraints. After a window is solved, the part of it that is not
+ * shared with the next window is committed: its selected segment ids are
+ * appended to a file and it is not changed anymore.
+ *
+ * The solution of each window is stored by the hash of the involved segment
+ * ids. If a window with the same segments is solved again (for example,
+ * after the costs changed), the stored solution is used as the initial
+ * solution of the solver. Otherwise, the solution of the overlap band in the
+ * previous window is used.
+ *
+ * Note that the working problem itself is still assembled for the whole
+ * stack: the slices, segments, and costs are extracted upstream for all
+ * sections, and the objective and linear constraints are inputs of this
+ * node. What the windows bound is the size of the problem that is passed to
+ * the linear solver at a time, which dominates the memory in practice. The
+ * solver backend of the windows is created for each run and released after
+ * the last window was committed, such that its model does not outlive the
+ * solving. The time limit and optimality gap of the optional parameters
+ * apply to each window. If the solver does not find a solution for a
+ * window, a WindowNotSolved exception is thrown, such that nothing of the
+ * window gets committed.
+ *
+ * Inputs:
+ *
+ *   objective             : LinearObjective
+ *   linear constraints    : LinearConstraints
+ *   problem configuration : ProblemConfiguration
+ *   parameters            : LinearSolverParameters (optional)
+ *
+ * Outputs:
+ *
+ *   solution              : Solution
+ */
+class SlidingWindowSolver : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	SlidingWindowSolver();
+
+private:
+
+	typedef std::size_t window_hash;
+
+	// the solution of a window, independent of the working problem variable
+	// numbers
+	struct WindowState {
+
+		std::vector<unsigned int> segmentIds;
+		std::vector<double>       values;
+	};
+
+	void updateOutputs();
+
+	// solve the inter-section intervals [begin, end) and commit the variables
+	// of the intervals [begin, commitEnd)
+	void solveWindow(unsigned int begin, unsigned int end, unsigned int commitEnd);
+
+	// create the objective and constraints of the current window
+	void createWindowProblem(
+			LinearObjective&   objective,
+			LinearConstraints& constraints);
+
+	// get the initial solution for the current window
+	void getInitialSolution(Solution& initialSolution, window_hash hash);
+
+	// create the parameters for the solver of a window
+	boost::shared_ptr<LinearSolverParameters> createWindowParameters();
+
+	// remember the solution of the current window
+	void storeWindowState(const Solution& windowSolution, window_hash hash);
+
+	// mark the variables of the current window in the intervals before
+	// commitEnd as committed and write their selected segment ids
+	void commit(unsigned int commitEnd);
+
+	window_hash getWindowHash();
+
+	// marks working problem variables that are not part of the current window
+	static const unsigned int NoWindowVariable;
+
+	pipeline::Input<LinearObjective>        _objective;
+	pipeline::Input<LinearConstraints>      _linearConstraints;
+	pipeline::Input<ProblemConfiguration>   _configuration;
+	pipeline::Input<LinearSolverParameters> _parameters;
+
+	pipeline::Output<Solution> _solution;
+
+	// the solver for the individual windows, only set during 
+	// updateOutputs()
+	boost::shared_ptr<LinearSolver> _windowSolver;
+
+	// the working problem variables of the current window
+	std::vector<unsigned int> _windowVariables;
+
+	// mapping from working problem variables to window variables
+	std::vector<unsigned int> _windowVariableNums;
+
+	// per working problem variable: was it part of a solved window, is it
+	// committed
+	std::vector<bool> _solved;
+	std::vector<bool> _committed;
+
+	// the stored window solutions and the order in which they were added
+	std::map<window_hash, WindowState> _windowStates;
+	std::deque<window_hash>            _windowStatesOrder;
+
+	// the file to write the committed segment ids to
+	std::ofstream _partialSolutionFile;
+};
+
+#endif // SOPNET_INFERENCE_SLIDING_WINDOW_SOLVER_H__
+
@@ -1,6 +1,8 @@
 #ifndef SOPNET_INFERENCE_SUBPROBLEMS_H__
 #define SOPNET_INFERENCE_SUBPROBLEMS_H__
 
+#include <algorithm>
+
 #include <pipeline/Data.h>
 #include "Problem.h"
 
@@ -31,7 +33,7 @@ public:
 	 */
 	void assignVariable(unsigned int variable, unsigned int subproblem) {
 
-		_variablesToSubproblems[variable].insert(subproblem);
+		insert(getVariableSubproblems(variable), subproblem);
 	}
 
 	/**
@@ -39,18 +41,50 @@ public:
 	 */
 	void assignConstraint(unsigned int constraint, unsigned int subproblem) {
 
-		_constraintsToSubproblems[constraint].insert(subproblem);
+		insert(getConstraintSubproblems(constraint), subproblem);
 	}
 
 	/**
-	 * Get all subproblems that a variable is assigned to.
+	 * Test whether a variable is assigned to the given subproblem.
 	 */
-	std::set<unsigned int>& getVariableSubproblems(unsigned int variable) { return _variablesToSubproblems[variable]; }
+	bool isVariableAssigned(unsigned int variable, unsigned int subproblem) {
+
+		const std::vector<unsigned int>& subproblems = getVariableSubproblems(variable);
+
+		return std::binary_search(subproblems.begin(), subproblems.end(), subproblem);
+	}
 
 	/**
-	 * Get all subproblems that a constraint is assigned to.
+	 * Get all subproblems that a variable is assigned to, in ascending order.
 	 */
-	std::set<unsigned int>& getConstraintSubproblems(unsigned int constraint) { return _constraintsToSubproblems[constraint]; }
+	std::vector<unsigned int>& getVariableSubproblems(unsigned int variable) {
+
+		if (variable >= _variablesToSubproblems.size())
+			_variablesToSubproblems.resize(variable + 1);
+
+		return _variablesToSubproblems[variable];
+	}
+
+	/**
+	 * Get all subproblems that a constraint is assigned to, in ascending order.
+	 */
+	std::vector<unsigned int>& getConstraintSubproblems(unsigned int constraint) {
+
+		if (constraint >= _constraintsToSubproblems.size())
+			_constraintsToSubproblems.resize(constraint + 1);
+
+		return _constraintsToSubproblems[constraint];
+	}
+
+	/**
+	 * Allocate memory for the given number of working problem variables and 
+	 * constraints.
+	 */
+	void resize(unsigned int numVariables, unsigned int numConstraints) {
+
+		_variablesToSubproblems.resize(numVariables);
+		_constraintsToSubproblems.resize(numConstraints);
+	}
 
 	/**
 	 * Reset the decomposition.
@@ -64,9 +98,26 @@ public:
 
 private:
 
-	std::map<unsigned int, std::set<unsigned int> > _variablesToSubproblems;
+	// insert a subproblem into a sorted list of subproblems
+	void insert(std::vector<unsigned int>& subproblems, unsigned int subproblem) {
+
+		// subproblems are usually assigned in ascending order
+		if (subproblems.empty() || subproblems.back() < subproblem) {
+
+			subproblems.push_back(subproblem);
+			return;
+		}
+
+		std::vector<unsigned int>::iterator i = std::lower_bound(subproblems.begin(), subproblems.end(), subproblem);
+		if (*i != subproblem)
+			subproblems.insert(i, subproblem);
+	}
+
+	// dense mapping from working problem variables to subproblems
+	std::vector<std::vector<unsigned int> > _variablesToSubproblems;
 
-	std::map<unsigned int, std::set<unsigned int> > _constraintsToSubproblems;
+	// dense mapping from working problem constraints to subproblems
+	std::vector<std::vector<unsigned int> > _constraintsToSubproblems;
 
 	// the problem that is decomposed into these subproblems
 	boost::shared_ptr<Problem> _problem;
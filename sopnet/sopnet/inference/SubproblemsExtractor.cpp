@@ -1,5 +1,9 @@
+#include <map>
+
+#include <util/foreach.h>
 #include <util/ProgramOptions.h>
 #include <util/Logger.h>
+#include <sopnet/exceptions.h>
 #include "SubproblemsExtractor.h"
 
 util::ProgramOption optionSubproblemsSize(
@@ -12,6 +16,18 @@ util::ProgramOption optionSubproblemsOverlap(
 		util::_long_name        = "subproblemsOverlap",
 		util::_description_text = "The overlap between neighboring subproblems in sections.");
 
+util::ProgramOption optionSubproblemsTileSize(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "subproblemsTileSize",
+		util::_description_text = "The size of the subproblems in x and y in pixels. The default (0) does not split the sections.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionSubproblemsTileOverlap(
+		util::_module           = "sopnet.inference",
+		util::_long_name        = "subproblemsTileOverlap",
+		util::_description_text = "The overlap between neighboring subproblems in x and y in pixels.",
+		util::_default_value    = 0);
+
 logger::LogChannel subproblemsextractorlog("subproblemsextractorlog", "[SubproblemsExtractor] ");
 
 SubproblemsExtractor::SubproblemsExtractor() :
@@ -97,9 +113,17 @@ SubproblemsExtractor::updateOutputs() {
 
 	unsigned int subproblemsSize    = optionSubproblemsSize;
 	unsigned int subproblemsOverlap = optionSubproblemsOverlap;
+	unsigned int tileSize           = optionSubproblemsTileSize;
+	unsigned int tileOverlap        = optionSubproblemsTileOverlap;
 	unsigned int minInterSectionInterval = _configuration->getMinInterSectionInterval();
 	unsigned int maxInterSectionInterval = _configuration->getMaxInterSectionInterval();
 
+	if (tileSize > 0 && tileOverlap >= tileSize)
+		BOOST_THROW_EXCEPTION(
+				InvalidParameters()
+				<< error_message("the subproblems tile overlap has to be smaller than the tile size")
+				<< STACK_TRACE);
+
 	// collect the working problem in a single problem
 	boost::shared_ptr<Problem> problem = boost::make_shared<Problem>();
 	problem->setObjective(_objective);
@@ -109,80 +133,203 @@ SubproblemsExtractor::updateOutputs() {
 	// create the subproblem data structure
 	_subproblems->clear();
 	_subproblems->setProblem(problem);
+	_subproblems->resize(_objective->size(), _constraints->size());
+
+	// the start positions of the tiles in x and y
+	std::vector<int> tilesX = getTileStarts(_configuration->getMinX(), _configuration->getMaxX(), tileSize, tileOverlap);
+	std::vector<int> tilesY = getTileStarts(_configuration->getMinY(), _configuration->getMaxY(), tileSize, tileOverlap);
 
 	LOG_DEBUG(subproblemsextractorlog)
 			<< "decomposing problem with extents " << minInterSectionInterval
 			<< "-" << maxInterSectionInterval << " into pieces of "
 			<< subproblemsSize << " with overlap of "
-			<< subproblemsOverlap << std::endl;
+			<< subproblemsOverlap << " and " << tilesX.size() << "x"
+			<< tilesY.size() << " tiles" << std::endl;
 
-	// 1D decomposition of the working problem
+	// 3D decomposition of the working problem
 	unsigned int subproblemId = 0;
+	std::vector<unsigned int> workingVarIds;
 	for (unsigned int startSubproblem = minInterSectionInterval; startSubproblem < maxInterSectionInterval; startSubproblem += subproblemsSize - subproblemsOverlap) {
 
 		// the first inter-section interval that is not part of the subproblem
 		unsigned int endSubproblem = startSubproblem + subproblemsSize;
 
-		LOG_DEBUG(subproblemsextractorlog) << "creating subproblem " << subproblemId << " for inter-section intervals " << startSubproblem << "-" << (endSubproblem-1) << std::endl;
+		foreach (int startY, tilesY) {
+			foreach (int startX, tilesX) {
 
-		// get all working problem variable ids for this subproblem
-		std::vector<unsigned int> workingVarIds = _configuration->getVariables(startSubproblem, endSubproblem);
+				util::rect<int> tile(
+						startX,
+						startY,
+						(tileSize > 0 ? startX + (int)tileSize : _configuration->getMaxX() + 1),
+						(tileSize > 0 ? startY + (int)tileSize : _configuration->getMaxY() + 1));
 
-		LOG_DEBUG(subproblemsextractorlog) << "this subproblem contains " << workingVarIds.size() << " variables" << std::endl;
+				// get all working problem variable ids for this subproblem
+				_configuration->getVariables(startSubproblem, endSubproblem, tile, workingVarIds);
 
-		// remember mapping of subproblem variable ids to this subproblem 
-		// (needed for unary terms)
-		foreach (unsigned int workingVarId, workingVarIds) {
+				// skip empty tiles (but keep the numbering of the subproblems 
+				// without tiles)
+				if (tileSize > 0 && workingVarIds.empty())
+					continue;
 
-			LOG_ALL(subproblemsextractorlog) << "assigning variable " << workingVarId << " to subproblem " << subproblemId << std::endl;
-			_subproblems->assignVariable(workingVarId, subproblemId);
-		}
+				LOG_DEBUG(subproblemsextractorlog)
+						<< "creating subproblem " << subproblemId << " for inter-section intervals "
+						<< startSubproblem << "-" << (endSubproblem-1) << " and tile ("
+						<< tile.minX << ", " << tile.minY << ")-(" << tile.maxX << ", " << tile.maxY << ")" << std::endl;
+
+				LOG_DEBUG(subproblemsextractorlog) << "this subproblem contains " << workingVarIds.size() << " variables" << std::endl;
 
-		// find all working problem constraints that involve the subproblem 
-		// variable ids
-		std::vector<unsigned int> constraints = _constraints->getConstraints(workingVarIds);
-
-		// remember mapping of constraints to this subproblem
-		foreach (unsigned int i, constraints) {
-
-			LinearConstraint& constraint = (*_constraints)[i];
-
-			// There are two types of constraints: [expr]≤1 and [expr]=0.  The 
-			// first is defined within one inter-section interval and ensures 
-			// that at most one of conflicting segments is picked.  The second 
-			// is defined between two inter-section intervals and
-			// ensures continuation.
-			//
-			// Always accept the first type. Accept the second type only if 
-			// it is fully contained in our problems variables. To simplify 
-			// things (and be more general), accept constraints only if they
-			// are fully contained in our variables.
-
-			// Working variable ids have already been assigned to subproblem 
-			// ids. We can thus just ask for that.
-			unsigned int workingVarId;
-			double _;
-			bool addConstraint = true;
-			foreach (boost::tie(workingVarId, _), constraint.getCoefficients()) {
-
-				// get all subproblems that are assigned to the working variable
-				std::set<unsigned int>& assignedSubproblems = _subproblems->getVariableSubproblems(workingVarId);
-
-				// does it containt the current subproblem?
-				if (!assignedSubproblems.count(subproblemId)) {
-
-					addConstraint = false;
-					break;
-				}
+				assignSubproblem(workingVarIds, subproblemId);
+
+				subproblemId++;
 			}
+		}
+	}
+
+	// without tiles, this is the decomposition in inter-section intervals 
+	// only
+	if (tileSize == 0)
+		return;
+
+	// constraints between neighboring tiles are not fully contained in 
+	// either of them
+	unsigned int numStitched = stitchConstraints();
+
+	if (numStitched > 0)
+		LOG_USER(subproblemsextractorlog)
+				<< numStitched << " of " << _constraints->size()
+				<< " constraints span tiles, added them to neighboring subproblems" << std::endl;
+}
+
+std::vector<int>
+SubproblemsExtractor::getTileStarts(int min, int max, unsigned int tileSize, unsigned int tileOverlap) {
+
+	std::vector<int> starts;
+
+	starts.push_back(min);
+
+	if (tileSize == 0)
+		return starts;
+
+	while (starts.back() + (int)tileSize <= max)
+		starts.push_back(starts.back() + (int)(tileSize - tileOverlap));
+
+	return starts;
+}
+
+void
+SubproblemsExtractor::assignSubproblem(const std::vector<unsigned int>& workingVarIds, unsigned int subproblemId) {
+
+	// remember mapping of subproblem variable ids to this subproblem 
+	// (needed for unary terms)
+	foreach (unsigned int workingVarId, workingVarIds) {
 
-			if (addConstraint) {
+		LOG_ALL(subproblemsextractorlog) << "assigning variable " << workingVarId << " to subproblem " << subproblemId << std::endl;
+		_subproblems->assignVariable(workingVarId, subproblemId);
+	}
 
-				LOG_ALL(subproblemsextractorlog) << "assigning constraint " << i << " to subproblem " << subproblemId << std::endl;
-				_subproblems->assignConstraint(i, subproblemId);
+	// find all working problem constraints that involve the subproblem 
+	// variable ids (the inverted index of the constraints is built only 
+	// once for the working problem)
+	std::vector<unsigned int> constraints = _constraints->getConstraints(workingVarIds);
+
+	// remember mapping of constraints to this subproblem
+	foreach (unsigned int i, constraints) {
+
+		const LinearConstraint& constraint = (*_constraints)[i];
+
+		// There are two types of constraints: [expr]≤1 and [expr]=0.  The 
+		// first is defined within one inter-section interval and ensures 
+		// that at most one of conflicting segments is picked.  The second 
+		// is defined between two inter-section intervals and
+		// ensures continuation.
+		//
+		// Always accept the first type. Accept the second type only if 
+		// it is fully contained in our problems variables. To simplify 
+		// things (and be more general), accept constraints only if they
+		// are fully contained in our variables.
+
+		// Working variable ids have already been assigned to subproblem 
+		// ids. Since subproblems are created in ascending order, the 
+		// current subproblem is the last one assigned to a variable (if 
+		// at all).
+		unsigned int workingVarId;
+		double _;
+		bool addConstraint = true;
+		foreach (boost::tie(workingVarId, _), constraint.getCoefficients()) {
+
+			// get all subproblems that are assigned to the working variable
+			const std::vector<unsigned int>& assignedSubproblems = _subproblems->getVariableSubproblems(workingVarId);
+
+			// does it containt the current subproblem?
+			if (assignedSubproblems.empty() || assignedSubproblems.back() != subproblemId) {
+
+				addConstraint = false;
+				break;
 			}
 		}
 
-		subproblemId++;
+		if (addConstraint) {
+
+			LOG_ALL(subproblemsextractorlog) << "assigning constraint " << i << " to subproblem " << subproblemId << std::endl;
+			_subproblems->assignConstraint(i, subproblemId);
+		}
+	}
+}
+
+unsigned int
+SubproblemsExtractor::stitchConstraints() {
+
+	unsigned int numStitched = 0;
+	unsigned int numDropped  = 0;
+
+	for (unsigned int i = 0; i < _constraints->size(); i++) {
+
+		if (!_subproblems->getConstraintSubproblems(i).empty())
+			continue;
+
+		const LinearConstraint& constraint = (*_constraints)[i];
+
+		// count the variables of the constraint per subproblem
+		std::map<unsigned int, unsigned int> numContained;
+
+		unsigned int workingVarId;
+		double _;
+		foreach (boost::tie(workingVarId, _), constraint.getCoefficients())
+			foreach (unsigned int subproblem, _subproblems->getVariableSubproblems(workingVarId))
+				numContained[subproblem]++;
+
+		if (numContained.empty()) {
+
+			numDropped++;
+			continue;
+		}
+
+		// the subproblem that contains most of the variables (the first one, 
+		// if there are several)
+		unsigned int subproblem;
+		unsigned int num;
+		unsigned int best   = 0;
+		unsigned int maxNum = 0;
+		foreach (boost::tie(subproblem, num), numContained)
+			if (num > maxNum) {
+
+				best   = subproblem;
+				maxNum = num;
+			}
+
+		foreach (boost::tie(workingVarId, _), constraint.getCoefficients())
+			_subproblems->assignVariable(workingVarId, best);
+
+		LOG_ALL(subproblemsextractorlog) << "stitching constraint " << i << " to subproblem " << best << std::endl;
+		_subproblems->assignConstraint(i, best);
+
+		numStitched++;
 	}
+
+	if (numDropped > 0)
+		LOG_ERROR(subproblemsextractorlog)
+				<< numDropped << " constraints involve only variables that are not part of any subproblem, "
+				<< "they are not considered" << std::endl;
+
+	return numStitched;
 }
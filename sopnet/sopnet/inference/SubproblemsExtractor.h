@@ -4,9 +4,13 @@
 #include <pipeline/SimpleProcessNode.h>
 #include <inference/LinearObjective.h>
 #include <inference/LinearConstraints.h>
+#include <util/ProgramOptions.h>
 #include "ProblemConfiguration.h"
 #include "Subproblems.h"
 
+extern util::ProgramOption optionSubproblemsSize;
+extern util::ProgramOption optionSubproblemsOverlap;
+
 class SubproblemsExtractor : public pipeline::SimpleProcessNode<> {
 
 public:
@@ -17,6 +21,20 @@ private:
 
 	void updateOutputs();
 
+	// get the start positions of tiles of the given size and overlap that 
+	// cover [min, max]
+	std::vector<int> getTileStarts(int min, int max, unsigned int tileSize, unsigned int tileOverlap);
+
+	// assign the given working problem variables and the constraints that 
+	// are fully contained in them to a subproblem
+	void assignSubproblem(const std::vector<unsigned int>& workingVarIds, unsigned int subproblemId);
+
+	// assign each constraint that is not fully contained in any subproblem 
+	// (because it spans tiles) to the subproblem that contains most of its 
+	// variables, together with its missing variables, returns the number of 
+	// such constraints
+	unsigned int stitchConstraints();
+
 	pipeline::Input<LinearObjective>      _objective;
 	pipeline::Input<LinearConstraints>    _constraints;
 	pipeline::Input<ProblemConfiguration> _configuration;
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include "WarmStartReader.h"
+
+static logger::LogChannel warmstartreaderlog("warmstartreaderlog", "[WarmStartReader] ");
+
+// tolerance for the comparison of activities and right hand sides
+static const double Epsilon = 1e-6;
+
+WarmStartReader::WarmStartReader(const std::string& filename) :
+	_initialSolution(new Solution()),
+	_filename(filename) {
+
+	registerInput(_segments, "segments");
+	registerInput(_configuration, "problem configuration");
+	registerInput(_linearConstraints, "linear constraints");
+	registerInput(_mapping, "mapping", pipeline::Optional);
+
+	registerOutput(_initialSolution, "initial solution");
+}
+
+void
+WarmStartReader::updateOutputs() {
+
+	boost::unordered_map<SegmentHash, double> values;
+
+	if (!readValues(values)) {
+
+		// no initial values at all
+		_initialSolution->resize(0);
+		return;
+	}
+
+	// get the values of the current variables by their segment's hash
+
+	boost::unordered_map<unsigned int, SegmentHash> hashes;
+	foreach (boost::shared_ptr<Segment> segment, _segments->getSegments())
+		hashes[segment->getId()] = segment->hashValue();
+
+	Solution solution(_configuration->getNumVariables());
+	std::fill(solution.getVector().begin(), solution.getVector().end(), std::numeric_limits<double>::quiet_NaN());
+
+	unsigned int numKnown = 0;
+	foreach (unsigned int i, _configuration->getVariables()) {
+
+		boost::unordered_map<unsigned int, SegmentHash>::const_iterator hash = hashes.find(_configuration->getSegmentId(i));
+		if (hash == hashes.end())
+			continue;
+
+		boost::unordered_map<SegmentHash, double>::const_iterator value = values.find(hash->second);
+		if (value == values.end())
+			continue;
+
+		solution[i] = value->second;
+		numKnown++;
+	}
+
+	LOG_USER(warmstartreaderlog)
+			<< "found previous values for " << numKnown << " of "
+			<< solution.size() << " variables" << std::endl;
+
+	reportFeasibility(solution);
+
+	if (_mapping.isSet()) {
+
+		// variables that are not part of the original solution stay undefined
+		_initialSolution->resize(_mapping->getNumReducedVariables());
+		std::fill(
+				_initialSolution->getVector().begin(),
+				_initialSolution->getVector().end(),
+				std::numeric_limits<double>::quiet_NaN());
+
+		_mapping->reduce(solution, *_initialSolution);
+
+	} else {
+
+		*_initialSolution = solution;
+	}
+}
+
+bool
+WarmStartReader::readValues(boost::unordered_map<SegmentHash, double>& values) {
+
+	std::ifstream in(_filename.c_str());
+
+	if (!in.good()) {
+
+		LOG_USER(warmstartreaderlog)
+				<< "no previous solution in " << _filename
+				<< ", starting from scratch" << std::endl;
+
+		return false;
+	}
+
+	SegmentHash hash;
+	double      value;
+	while (in >> hash >> value)
+		values[hash] = value;
+
+	LOG_DEBUG(warmstartreaderlog)
+			<< "read " << values.size() << " values from " << _filename << std::endl;
+
+	return true;
+}
+
+void
+WarmStartReader::reportFeasibility(const Solution& solution) {
+
+	unsigned int numCovered   = 0;
+	unsigned int numSatisfied = 0;
+
+	foreach (const LinearConstraint& constraint, *_linearConstraints) {
+
+		double activity = 0;
+		bool   covered  = true;
+
+		unsigned int varNum;
+		double coef;
+		foreach (boost::tie(varNum, coef), constraint.getCoefficients()) {
+
+			if (varNum >= solution.size() || std::isnan(solution[varNum])) {
+
+				covered = false;
+				break;
+			}
+
+			activity += coef*solution[varNum];
+		}
+
+		if (!covered)
+			continue;
+
+		numCovered++;
+
+		bool satisfied = false;
+		switch (constraint.getRelation()) {
+
+			case LessEqual:
+				satisfied = (activity <= constraint.getValue() + Epsilon);
+				break;
+			case Equal:
+				satisfied = (std::abs(activity - constraint.getValue()) <= Epsilon);
+				break;
+			case GreaterEqual:
+				satisfied = (activity >= constraint.getValue() - Epsilon);
+				break;
+		}
+
+		if (satisfied)
+			numSatisfied++;
+	}
+
+	LOG_USER(warmstartreaderlog)
+			<< "previous solution covers " << numCovered << " of "
+			<< _linearConstraints->size() << " constraints, "
+			<< numSatisfied << " of them are still satisfied" << std::endl;
+}
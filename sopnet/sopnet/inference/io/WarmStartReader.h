@@ -0,0 +1,63 @@
+#ifndef SOPNET_INFERENCE_IO_WARM_START_READER_H__
+#define SOPNET_INFERENCE_IO_WARM_START_READER_H__
+
+#include <string>
+
+#include <boost/unordered_map.hpp>
+
+#include <pipeline/SimpleProcessNode.h>
+#include <inference/LinearConstraints.h>
+#include <inference/PresolveMapping.h>
+#include <inference/Solution.h>
+#include <sopnet/inference/ProblemConfiguration.h>
+#include <sopnet/segments/Segments.h>
+
+/**
+ * Reads the solution of a previous run, stored by the WarmStartWriter as
+ * segment hashes and values, and creates an initial solution for the linear
+ * solver from it. Variables of segments that were not part of the previous
+ * run are set to NaN, i.e., they have no initial value.
+ *
+ * If a presolve mapping is given, the initial solution is created for the
+ * reduced problem.
+ *
+ * Inputs:
+ *
+ *   segments              : Segments
+ *   problem configuration : ProblemConfiguration
+ *   linear constraints    : LinearConstraints
+ *   mapping               : PresolveMapping (optional)
+ *
+ * Outputs:
+ *
+ *   initial solution      : Solution
+ */
+class WarmStartReader : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	WarmStartReader(const std::string& filename);
+
+private:
+
+	void updateOutputs();
+
+	// read the values of the previous solution by segment hash, returns false
+	// if there is no previous solution
+	bool readValues(boost::unordered_map<SegmentHash, double>& values);
+
+	// log how many of the constraints are satisfied by the previous solution
+	void reportFeasibility(const Solution& solution);
+
+	pipeline::Input<Segments>             _segments;
+	pipeline::Input<ProblemConfiguration> _configuration;
+	pipeline::Input<LinearConstraints>    _linearConstraints;
+	pipeline::Input<PresolveMapping>      _mapping;
+
+	pipeline::Output<Solution> _initialSolution;
+
+	std::string _filename;
+};
+
+#endif // SOPNET_INFERENCE_IO_WARM_START_READER_H__
+
@@ -0,0 +1,58 @@
+#include <fstream>
+
+#include <boost/unordered_map.hpp>
+
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include "WarmStartWriter.h"
+
+static logger::LogChannel warmstartwriterlog("warmstartwriterlog", "[WarmStartWriter] ");
+
+WarmStartWriter::WarmStartWriter(const std::string& filename) :
+	_passedSolution(new Solution()),
+	_filename(filename) {
+
+	registerInput(_solution, "solution");
+	registerInput(_segments, "segments");
+	registerInput(_configuration, "problem configuration");
+
+	registerOutput(_passedSolution, "solution");
+}
+
+void
+WarmStartWriter::updateOutputs() {
+
+	*_passedSolution = *_solution;
+
+	boost::unordered_map<unsigned int, SegmentHash> hashes;
+	foreach (boost::shared_ptr<Segment> segment, _segments->getSegments())
+		hashes[segment->getId()] = segment->hashValue();
+
+	std::ofstream out(_filename.c_str());
+
+	if (!out.good()) {
+
+		LOG_ERROR(warmstartwriterlog) << "could not open " << _filename << " for writing" << std::endl;
+		return;
+	}
+
+	// write with full precision, such that the values can be read again as 
+	// they are
+	out.precision(17);
+
+	unsigned int numWritten = 0;
+	foreach (unsigned int i, _configuration->getVariables()) {
+
+		if (i >= _solution->size())
+			continue;
+
+		boost::unordered_map<unsigned int, SegmentHash>::const_iterator hash = hashes.find(_configuration->getSegmentId(i));
+		if (hash == hashes.end())
+			continue;
+
+		out << hash->second << " " << (*_solution)[i] << std::endl;
+		numWritten++;
+	}
+
+	LOG_DEBUG(warmstartwriterlog) << "wrote " << numWritten << " values to " << _filename << std::endl;
+}
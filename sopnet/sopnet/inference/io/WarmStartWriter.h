@@ -0,0 +1,46 @@
+#ifndef SOPNET_INFERENCE_IO_WARM_START_WRITER_H__
+#define SOPNET_INFERENCE_IO_WARM_START_WRITER_H__
+
+#include <string>
+
+#include <pipeline/SimpleProcessNode.h>
+#include <inference/Solution.h>
+#include <sopnet/inference/ProblemConfiguration.h>
+#include <sopnet/segments/Segments.h>
+
+/**
+ * Passes a solution on and stores it as a list of segment hashes and values,
+ * such that the WarmStartReader can use it as initial solution for the next
+ * run, even if the segment ids or the set of segments changed.
+ *
+ * Inputs:
+ *
+ *   solution              : Solution
+ *   segments              : Segments
+ *   problem configuration : ProblemConfiguration
+ *
+ * Outputs:
+ *
+ *   solution              : Solution (the same as the input)
+ */
+class WarmStartWriter : public pipeline::SimpleProcessNode<> {
+
+public:
+
+	WarmStartWriter(const std::string& filename);
+
+private:
+
+	void updateOutputs();
+
+	pipeline::Input<Solution>             _solution;
+	pipeline::Input<Segments>             _segments;
+	pipeline::Input<ProblemConfiguration> _configuration;
+
+	pipeline::Output<Solution> _passedSolution;
+
+	std::string _filename;
+};
+
+#endif // SOPNET_INFERENCE_IO_WARM_START_WRITER_H__
+
@@ -42,7 +42,7 @@ SubproblemsWriter::write(std::string filename) {
 	for (unsigned int i = 0; i < numVars; i++)
 		out << "table 1 2 0 " << problem->getObjective()->getCoefficients()[i] << std::endl;
 	// constraints
-	foreach (LinearConstraint& constraint, *problem->getLinearConstraints()) {
+	foreach (const LinearConstraint& constraint, *problem->getLinearConstraints()) {
 
 		out << "constraint " << constraint.getCoefficients().size();
 		unsigned int var;
@@ -85,7 +85,7 @@ SubproblemsWriter::write(std::string filename) {
 	// constraints
 	for (unsigned int i = 0; i < numConstraints; i++) {
 
-		LinearConstraint& constraint = (*problem->getLinearConstraints())[i];
+		const LinearConstraint& constraint = (*problem->getLinearConstraints())[i];
 
 		out << (i+numVars) /* function num */;
 		unsigned int var;
@@ -96,8 +96,17 @@ MinimalImpactTEDWriter::write(std::string filename) {
 
 	int constant = 0;
 
-	// Loop through variables
-	std::set<unsigned int> variables = _problemConfiguration->getVariables();
+	// Take a copy of the variables and their segments, the problem 
+	// configuration might change while the pipeline is updated below
+	const std::vector<unsigned int> variables = _problemConfiguration->getVariables();
+
+	std::vector<unsigned int> segmentIds;
+	std::vector<int>          interSectionIntervals;
+	foreach (unsigned int varNum, variables) {
+
+		segmentIds.push_back(_problemConfiguration->getSegmentId(varNum));
+		interSectionIntervals.push_back(_problemConfiguration->getInterSectionInterval(varNum));
+	}
 
 	LOG_USER(minimalImpactTEDlog) << "computing ted coefficients for " << variables.size() << " variables" << std::endl;
 
@@ -120,11 +129,30 @@ MinimalImpactTEDWriter::write(std::string filename) {
 	foreach (boost::shared_ptr<Segment> segment, _segments->getSegments())
 		idToSegment[segment->getId()] = segment;
 
-	for ( unsigned int varNum = 0 ; varNum < variables.size() ; varNum++ ) {
+	// if all sections are considered, the pipeline is the same for each 
+	// variable -- compute the TED of the unpinned solution once and update it 
+	// incrementally for each pinned variable
+	bool incremental = (!optionWriteTedConditions && optionNumAdjacentSections.as<int>() == 0);
+
+	if (incremental) {
+
+		updatePipeline(0, 0);
+
+		pipeline::Value<TolerantEditDistanceErrors> baselineErrors = _teDistance->getOutput("errors");
+
+		LOG_DEBUG(minimalImpactTEDlog)
+				<< "baseline has " << baselineErrors->getNumSplits() << " splits, "
+				<< baselineErrors->getNumMerges() << " merges, "
+				<< baselineErrors->getNumFalsePositives() << " false positives, and "
+				<< baselineErrors->getNumFalseNegatives() << " false negatives" << std::endl;
+	}
 
-		unsigned int segmentId = _problemConfiguration->getSegmentId(varNum);
+	for (unsigned int v = 0; v < variables.size(); v++) {
 
-		int interSectionInterval = _problemConfiguration->getInterSectionInterval(varNum);
+		unsigned int varNum    = variables[v];
+		unsigned int segmentId = segmentIds[v];
+
+		int interSectionInterval = interSectionIntervals[v];
 
 		if (limitToISI >= 0)
 			if (interSectionInterval != limitToISI)
@@ -135,7 +163,7 @@ MinimalImpactTEDWriter::write(std::string filename) {
 
 		// re-create the pipeline for the current segment and its inter-section 
 		// interval
-		if (!optionWriteTedConditions)
+		if (!optionWriteTedConditions && !incremental)
 			updatePipeline(interSectionInterval, optionNumAdjacentSections.as<int>());
 	
 		// Is the segment that corresponds to the variable part of the gold standard?
@@ -149,7 +177,19 @@ MinimalImpactTEDWriter::write(std::string filename) {
 
 		if (!optionWriteTedConditions) {
 
-			pipeline::Value<TolerantEditDistanceErrors> errors = _teDistance->getOutput("errors");
+			boost::shared_ptr<TolerantEditDistanceErrors> errors;
+
+			if (incremental) {
+
+				pipeline::Value<ImageStack> reconstruction = _rimCreator->getOutput("id map");
+				errors = _teDistance->getIncrementalErrors(reconstruction);
+
+			} else {
+
+				pipeline::Value<TolerantEditDistanceErrors> fullErrors = _teDistance->getOutput("errors");
+				errors = fullErrors;
+			}
+
 			int sumErrors = errors->getNumSplits() + errors->getNumMerges() + errors->getNumFalsePositives() + errors->getNumFalseNegatives();
 
 			outfile << "c" << varNum << " ";
@@ -178,10 +218,10 @@ MinimalImpactTEDWriter::write(std::string filename) {
 			outfile << segmentHash << ":";
 			for (unsigned int i = 0; i < variables.size(); i++) {
 
-				unsigned int id = _problemConfiguration->getSegmentId(i);
+				unsigned int id = segmentIds[i];
 
 				// was flipped?
-				if ((*solution)[i] != goldStandardIds.count(id))
+				if ((*solution)[variables[i]] != goldStandardIds.count(id))
 					outfile << " " << idToSegment[id]->hashValue();
 			}
 			outfile << std::endl;
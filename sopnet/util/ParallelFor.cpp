@@ -0,0 +1,152 @@
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "ParallelFor.h"
+
+namespace {
+
+/**
+ * The number of CPUs available to nested calls in the current thread. Not set
+ * outside of parallelFor().
+ */
+boost::thread_specific_ptr<unsigned int> threadShare;
+
+// the number of CPUs available to the current thread
+unsigned int getThreadShare() {
+
+	if (threadShare.get())
+		return *threadShare;
+
+	return std::max(1u, boost::thread::hardware_concurrency());
+}
+
+/**
+ * The shared state of the threads of one call to parallelFor().
+ */
+class JobQueue {
+
+public:
+
+	JobQueue(
+			unsigned int numJobs,
+			const boost::function<void(unsigned int, unsigned int)>& job) :
+		_numJobs(numJobs),
+		_job(job),
+		_nextJob(0) {}
+
+	// the main loop of the threads, share is the number of CPUs available to 
+	// nested calls in each thread
+	void process(unsigned int thread, unsigned int share) {
+
+		threadShare.reset(new unsigned int(share));
+
+		unsigned int i;
+
+		while (next(i)) {
+
+			try {
+
+				_job(i, thread);
+
+			} catch (...) {
+
+				boost::mutex::scoped_lock lock(_mutex);
+
+				if (!_exception)
+					_exception = boost::current_exception();
+
+				// stop the other threads
+				_nextJob = _numJobs;
+
+				return;
+			}
+		}
+	}
+
+	// rethrow the first exception of a job, if there was one
+	void rethrow() {
+
+		if (_exception)
+			boost::rethrow_exception(_exception);
+	}
+
+private:
+
+	// get the next job, returns false if there are none left
+	bool next(unsigned int& i) {
+
+		boost::mutex::scoped_lock lock(_mutex);
+
+		if (_nextJob >= _numJobs)
+			return false;
+
+		i = _nextJob;
+		_nextJob++;
+
+		return true;
+	}
+
+	unsigned int _numJobs;
+
+	const boost::function<void(unsigned int, unsigned int)>& _job;
+
+	unsigned int _nextJob;
+
+	// the first exception thrown by a job
+	boost::exception_ptr _exception;
+
+	// protects _nextJob and _exception
+	boost::mutex _mutex;
+};
+
+} // anonymous namespace
+
+unsigned int
+getNumThreads(unsigned int numThreads, unsigned int numJobs) {
+
+	if (numThreads == 0)
+		numThreads = boost::thread::hardware_concurrency();
+
+	if (threadShare.get())
+		numThreads = std::min(numThreads, *threadShare);
+
+	if (numJobs > 0)
+		numThreads = std::min(numThreads, numJobs);
+
+	return std::max(1u, numThreads);
+}
+
+void
+parallelFor(
+		unsigned int numJobs,
+		unsigned int numThreads,
+		const boost::function<void(unsigned int, unsigned int)>& job) {
+
+	if (numJobs == 0)
+		return;
+
+	numThreads = getNumThreads(numThreads, numJobs);
+
+	if (numThreads == 1) {
+
+		for (unsigned int i = 0; i < numJobs; i++)
+			job(i, 0);
+
+		return;
+	}
+
+	JobQueue queue(numJobs, job);
+
+	unsigned int share = std::max(1u, getThreadShare()/numThreads);
+
+	boost::thread_group threads;
+	for (unsigned int thread = 0; thread < numThreads; thread++)
+		threads.create_thread(boost::bind(&JobQueue::process, &queue, thread, share));
+	threads.join_all();
+
+	queue.rethrow();
+}
+
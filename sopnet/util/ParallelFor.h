@@ -0,0 +1,37 @@
+#ifndef UTIL_PARALLEL_FOR_H__
+#define UTIL_PARALLEL_FOR_H__
+
+#include <boost/function.hpp>
+
+/**
+ * Get the number of threads to use for the given number of independent jobs.
+ * A requested number of 0 uses all available CPUs. The result is at least 1
+ * and at most the number of jobs (if there are any). Inside a job of
+ * parallelFor(), the result is also at most the share of the CPUs of the
+ * executing thread, such that nested calls do not oversubscribe the CPUs.
+ */
+unsigned int getNumThreads(unsigned int numThreads, unsigned int numJobs);
+
+/**
+ * Call job(i, thread) for each i in [0, numJobs) on a pool of
+ * getNumThreads(numThreads, numJobs) threads. Jobs are handed out in
+ * increasing order. thread is the index of the executing thread in
+ * [0, getNumThreads(numThreads, numJobs)), such that callers can provide
+ * per-thread scratch space or solvers. Bind expressions that only use _1
+ * ignore it.
+ *
+ * Each thread gets an equal share of the CPUs available to the caller for
+ * nested calls to parallelFor() and getNumThreads().
+ *
+ * With a single thread, the jobs are processed in the calling thread.
+ * Otherwise, the first exception thrown by a job stops the handing out of
+ * further jobs and is rethrown in the calling thread after all threads
+ * finished.
+ */
+void parallelFor(
+		unsigned int numJobs,
+		unsigned int numThreads,
+		const boost::function<void(unsigned int, unsigned int)>& job);
+
+#endif // UTIL_PARALLEL_FOR_H__
+